@@ -272,6 +272,8 @@ void RGBController_PolychromeUSB::ResizeZone(int zone, int new_size)
 
     // unsigned char zonecmd = POLYCHROME_USB_LEDCOUNT_CFG;
     // WriteHeader(zonecmd, zonecfg, sizeof(zonecfg));
+
+    InvalidateDescription();
 }
 
 void RGBController_PolychromeUSB::DeviceUpdateLEDs()
@@ -33,7 +33,7 @@ void DetectBlinkyTapeControllers(std::vector<RGBController*> &rgb_controllers)
     }
 }
 
-REGISTER_DETECTOR("BlinkyTape", DetectBlinkyTapeControllers);
+REGISTER_SERIAL_DETECTOR("BlinkyTape", DetectBlinkyTapeControllers, BLINKINLABS_VID, BLINKYTAPE_PID);
 /*---------------------------------------------------------------------------------------------------------*\
 | Entries for dynamic UDEV rules                                                                            |
 |                                                                                                           |
@@ -124,7 +124,7 @@ void RGBController_BlinkyTape::ResizeZone(int zone, int new_size)
 
 void RGBController_BlinkyTape::DeviceUpdateLEDs()
 {
-    controller->SetLEDs(colors);
+    controller->SetLEDs(GetFrameColors());
 }
 
 void RGBController_BlinkyTape::UpdateZoneLEDs(int /*zone*/)
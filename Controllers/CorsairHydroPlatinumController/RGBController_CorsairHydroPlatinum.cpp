@@ -114,7 +114,7 @@ void RGBController_CorsairHydroPlatinum::ResizeZone(int zone, int new_size)
 
 void RGBController_CorsairHydroPlatinum::DeviceUpdateLEDs()
 {
-    controller->SetupColors(colors);
+    controller->SetupColors(GetFrameColors());
 }
 
 void RGBController_CorsairHydroPlatinum::UpdateZoneLEDs(int /*zone*/)
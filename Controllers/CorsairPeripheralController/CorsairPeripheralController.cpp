@@ -197,38 +197,36 @@ void CorsairPeripheralController::SetLEDsKeyboardFull(std::vector<RGBColor> colo
     memset(grn_val, 0x00, sizeof( grn_val ));
     memset(blu_val, 0x00, sizeof( blu_val ));
 
+    /*-----------------------------------------------------*\
+    | Select the key map for the keyboard layout            |
+    \*-----------------------------------------------------*/
+    unsigned int* key_map = keys;
+
+    if (logical_layout == CORSAIR_TYPE_K95_PLAT)
+    {
+        key_map = keys_k95_plat;
+        data_sz = 48;
+    }
+    else if (logical_layout == CORSAIR_TYPE_K95)
+    {
+        key_map = keys_k95;
+        data_sz = 48; //untested
+    }
+    else if (logical_layout == CORSAIR_TYPE_K70_MK2)
+    {
+        key_map = keys_k70_mk2;
+    }
+
     /*-----------------------------------------------------*\
     | Copy red, green, and blue components into buffers     |
     \*-----------------------------------------------------*/
     for(std::size_t color_idx = 0; color_idx < colors.size(); color_idx++)
     {
         RGBColor           color = colors[color_idx];
-        if (logical_layout == CORSAIR_TYPE_K95_PLAT)
-        {
-            red_val[keys_k95_plat[color_idx]] = RGBGetRValue(color);
-            grn_val[keys_k95_plat[color_idx]] = RGBGetGValue(color);
-            blu_val[keys_k95_plat[color_idx]] = RGBGetBValue(color);
-            data_sz = 48;
-        }
-        else if (logical_layout == CORSAIR_TYPE_K95)
-        {
-            red_val[keys_k95[color_idx]] = RGBGetRValue(color);
-            grn_val[keys_k95[color_idx]] = RGBGetGValue(color);
-            blu_val[keys_k95[color_idx]] = RGBGetBValue(color);
-            data_sz = 48; //untested
-        }
-        else if (logical_layout == CORSAIR_TYPE_K70_MK2)
-        {
-            red_val[keys_k70_mk2[color_idx]] = RGBGetRValue(color);
-            grn_val[keys_k70_mk2[color_idx]] = RGBGetGValue(color);
-            blu_val[keys_k70_mk2[color_idx]] = RGBGetBValue(color);
-        }
-        else
-        {
-            red_val[keys[color_idx]] = RGBGetRValue(color);
-            grn_val[keys[color_idx]] = RGBGetGValue(color);
-            blu_val[keys[color_idx]] = RGBGetBValue(color);
-        }
+
+        red_val[key_map[color_idx]] = RGBGetRValue(color);
+        grn_val[key_map[color_idx]] = RGBGetGValue(color);
+        blu_val[key_map[color_idx]] = RGBGetBValue(color);
     }
 
     /*-----------------------------------------------------*\
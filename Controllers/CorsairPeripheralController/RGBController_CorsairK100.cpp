@@ -346,7 +346,7 @@ void RGBController_CorsairK100::DeviceUpdateLEDs()
 {
     last_update_time = std::chrono::steady_clock::now();
 
-    controller->SetLEDs(colors);
+    controller->SetLEDs(GetFrameColors());
 }
 
 void RGBController_CorsairK100::UpdateZoneLEDs(int /*zone*/)
@@ -107,7 +107,7 @@ void RGBController_CorsairK55RGBPRO::DeviceUpdateLEDs()
 {
     last_update_time = std::chrono::steady_clock::now();
 
-    controller->SetLEDs(colors);
+    controller->SetLEDs(GetFrameColors());
 }
 
 void RGBController_CorsairK55RGBPRO::UpdateZoneLEDs(int /*zone*/)
@@ -225,7 +225,7 @@ void RGBController_CorsairK65Mini::ResizeZone(int /*zone*/, int /*new_size*/)
 void RGBController_CorsairK65Mini::DeviceUpdateLEDs()
 {
     last_update_time = std::chrono::steady_clock::now();
-    controller->SetLEDs(colors, led_positions);
+    controller->SetLEDs(GetFrameColors(), led_positions);
 }
 
 void RGBController_CorsairK65Mini::UpdateZoneLEDs(int /*zone*/)
@@ -1061,7 +1061,7 @@ void RGBController_CorsairPeripheral::ResizeZone(int /*zone*/, int /*new_size*/)
 
 void RGBController_CorsairPeripheral::DeviceUpdateLEDs()
 {
-    controller->SetLEDs(colors);
+    controller->SetLEDs(GetFrameColors());
 }
 
 void RGBController_CorsairPeripheral::UpdateZoneLEDs(int /*zone*/)
@@ -168,6 +168,8 @@ RGBController_CorsairVengeancePro::RGBController_CorsairVengeancePro(CorsairVeng
 
     SetupZones();
 
+    SetPartialUpdateFlags(PARTIAL_UPDATE_SINGLE_LED);
+
     active_mode = 9;
 }
 
@@ -213,9 +215,11 @@ void RGBController_CorsairVengeancePro::ResizeZone(int /*zone*/, int /*new_size*
 
 void RGBController_CorsairVengeancePro::DeviceUpdateLEDs()
 {
-    for(std::size_t led = 0; led < colors.size(); led++)
+    const std::vector<RGBColor>& frame_colors = GetFrameColors();
+
+    for(std::size_t led = 0; led < frame_colors.size(); led++)
     {
-        RGBColor      color = colors[led];
+        RGBColor      color = frame_colors[led];
         unsigned char red   = RGBGetRValue(color);
         unsigned char grn   = RGBGetGValue(color);
         unsigned char blu   = RGBGetBValue(color);
@@ -232,7 +236,7 @@ void RGBController_CorsairVengeancePro::UpdateZoneLEDs(int /*zone*/)
 
 void RGBController_CorsairVengeancePro::UpdateSingleLED(int led)
 {
-    RGBColor      color = colors[led];
+    RGBColor      color = GetFrameColors()[led];
     unsigned char red   = RGBGetRValue(color);
     unsigned char grn   = RGBGetGValue(color);
     unsigned char blu   = RGBGetBValue(color);
@@ -306,7 +306,7 @@ void RGBController_CorsairWireless::DeviceUpdateLEDs()
 {
     last_update_time = std::chrono::steady_clock::now();
 
-    controller->SetLEDs(colors);
+    controller->SetLEDs(GetFrameColors());
 }
 
 void RGBController_CorsairWireless::UpdateZoneLEDs(int /*zone*/)
@@ -205,7 +205,7 @@ void RGBController_DarkProjectKeyboard::ResizeZone(int /*zone*/, int /*new_size*
 
 void RGBController_DarkProjectKeyboard::DeviceUpdateLEDs()
 {
-    controller->SetLedsDirect(colors);
+    controller->SetLedsDirect(GetFrameColors());
 }
 
 void RGBController_DarkProjectKeyboard::UpdateZoneLEDs(int zone)
@@ -36,7 +36,7 @@ void DetectDygmaRaiseControllers(std::vector<RGBController*> &rgb_controllers)
     }
 }
 
-REGISTER_DETECTOR("Dygma Raise", DetectDygmaRaiseControllers);
+REGISTER_SERIAL_DETECTOR("Dygma Raise", DetectDygmaRaiseControllers, DYGMA_RAISE_VID, DYGMA_RAISE_PID);
 /*---------------------------------------------------------------------------------------------------------*\
 | Entries for dynamic UDEV rules                                                                            |
 |                                                                                                           |
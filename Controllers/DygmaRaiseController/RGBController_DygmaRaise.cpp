@@ -237,7 +237,7 @@ void RGBController_DygmaRaise::ResizeZone(int /*zone*/, int /*new_size*/)
 
 void RGBController_DygmaRaise::DeviceUpdateLEDs()
 {
-    controller->SendDirect(colors,leds.size());
+    controller->SendDirect(GetFrameColors(),leds.size());
 }
 
 void RGBController_DygmaRaise::UpdateZoneLEDs(int /*zone*/)
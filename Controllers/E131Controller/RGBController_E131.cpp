@@ -8,8 +8,10 @@
 \*-----------------------------------------*/
 
 #include "RGBController_E131.h"
+#include "RGBColorConvert.h"
 #include <e131.h>
 #include <math.h>
+#include <string.h>
 
 using namespace std::chrono_literals;
 
@@ -378,7 +380,9 @@ void RGBController_E131::ResizeZone(int /*zone*/, int /*new_size*/)
 
 void RGBController_E131::DeviceUpdateLEDs()
 {
-    int color_idx = 0;
+    const std::vector<RGBColor>& frame_colors = GetFrameColors();
+
+    unsigned int color_idx = 0;
 
     last_update_time = std::chrono::steady_clock::now();
 
@@ -387,9 +391,24 @@ void RGBController_E131::DeviceUpdateLEDs()
         float universe_size = devices[device_idx].universe_size;
         unsigned int total_universes = ceil( ( ( devices[device_idx].num_leds * 3 ) + devices[device_idx].start_channel ) / universe_size );
         unsigned int channel_idx = devices[device_idx].start_channel;
-        unsigned int led_idx = 0;
-        unsigned int rgb_idx = 0;
-        bool         done = false;
+        unsigned int data_size = devices[device_idx].num_leds * 3;
+        unsigned int data_idx = 0;
+
+        if((color_idx + devices[device_idx].num_leds) > frame_colors.size())
+        {
+            break;
+        }
+
+        /*-------------------------------------------------*\
+        | Pack this device's colors into channel data, then |
+        | copy it into the universes it spans               |
+        \*-------------------------------------------------*/
+        channel_data.resize(data_size);
+
+        if(data_size > 0)
+        {
+            RGBColorPack(&frame_colors[color_idx], devices[device_idx].num_leds, &channel_data[0], RGBCOLOR_ORDER_RGB);
+        }
 
         for (unsigned int univ_idx = 0; univ_idx < total_universes; univ_idx++)
         {
@@ -397,40 +416,26 @@ void RGBController_E131::DeviceUpdateLEDs()
 
             for(std::size_t packet_idx = 0; packet_idx < packets.size(); packet_idx++)
             {
-                if(!done && (universes[packet_idx] == universe))
+                if((data_idx < data_size) && (universes[packet_idx] == universe) && (channel_idx <= universe_size))
                 {
-                    while(!done && (channel_idx <= universe_size))
+                    unsigned int copy_size = devices[device_idx].universe_size - channel_idx + 1;
+
+                    if(copy_size > (data_size - data_idx))
                     {
-                        switch(rgb_idx)
-                        {
-                            case 0:
-                                packets[packet_idx].dmp.prop_val[channel_idx] = RGBGetRValue( colors[color_idx] );
-                                rgb_idx = 1;
-                                break;
-                            case 1:
-                                packets[packet_idx].dmp.prop_val[channel_idx] = RGBGetGValue( colors[color_idx] );
-                                rgb_idx = 2;
-                                break;
-                            case 2:
-                                packets[packet_idx].dmp.prop_val[channel_idx] = RGBGetBValue( colors[color_idx] );
-                                rgb_idx = 0;
-                                led_idx++;
-                                color_idx++;
-                                break;
-                        }
+                        copy_size = data_size - data_idx;
+                    }
 
-                        if(led_idx >= devices[device_idx].num_leds)
-                        {
-                            done = true;
-                        }
+                    memcpy(&packets[packet_idx].dmp.prop_val[channel_idx], &channel_data[data_idx], copy_size);
 
-                        channel_idx++;
-                    }
+                    data_idx    += copy_size;
+                    channel_idx += copy_size;
                 }
             }
 
             channel_idx = 1;
         }
+
+        color_idx += devices[device_idx].num_leds;
     }
 
     for(std::size_t packet_idx = 0; packet_idx < packets.size(); packet_idx++)
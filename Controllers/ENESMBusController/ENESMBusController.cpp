@@ -259,7 +259,7 @@ void ENESMBusController::SaveMode()
     ENERegisterWrite(ENE_REG_APPLY, ENE_SAVE_VAL);
 }
 
-void ENESMBusController::SetAllColorsDirect(RGBColor* colors)
+void ENESMBusController::SetAllColorsDirect(const RGBColor* colors)
 {
     unsigned char* color_buf   = new unsigned char[led_count * 3];
     unsigned int   bytes_sent  = 0;
@@ -288,7 +288,7 @@ void ENESMBusController::SetAllColorsDirect(RGBColor* colors)
     delete[] color_buf;
 }
 
-void ENESMBusController::SetAllColorsEffect(RGBColor* colors)
+void ENESMBusController::SetAllColorsEffect(const RGBColor* colors)
 {
     unsigned char* color_buf   = new unsigned char[led_count * 3];
     unsigned int   bytes_sent  = 0;
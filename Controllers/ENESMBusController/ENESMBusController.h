@@ -112,8 +112,8 @@ public:
     unsigned char GetLEDGreenEffect(unsigned int led);
     unsigned char GetLEDBlueEffect(unsigned int led);
     void          SaveMode();
-    void          SetAllColorsDirect(RGBColor* colors);
-    void          SetAllColorsEffect(RGBColor* colors);
+    void          SetAllColorsDirect(const RGBColor* colors);
+    void          SetAllColorsEffect(const RGBColor* colors);
     void          SetDirect(unsigned char direct);
     void          SetLEDColorDirect(unsigned int led, unsigned char red, unsigned char green, unsigned char blue);
     void          SetLEDColorEffect(unsigned int led, unsigned char red, unsigned char green, unsigned char blue);
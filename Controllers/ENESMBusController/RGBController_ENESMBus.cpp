@@ -141,6 +141,12 @@ RGBController_ENESMBus::RGBController_ENESMBus(ENESMBusController * controller_p
 
     SetupZones();
 
+    /*-------------------------------------------------*\
+    | Single LEDs and zones are written register by     |
+    | register, so only send what changed               |
+    \*-------------------------------------------------*/
+    SetPartialUpdateFlags(PARTIAL_UPDATE_SINGLE_LED | PARTIAL_UPDATE_ZONE);
+
     /*-------------------------------------------------*\
     | Initialize active mode                            |
     \*-------------------------------------------------*/
@@ -246,21 +252,23 @@ void RGBController_ENESMBus::DeviceUpdateLEDs()
 {
     if(GetMode() == 0)
     {
-        controller->SetAllColorsDirect(&colors[0]);
+        controller->SetAllColorsDirect(GetFrameColors().data());
     }
     else
     {
-        controller->SetAllColorsEffect(&colors[0]);
+        controller->SetAllColorsEffect(GetFrameColors().data());
     }
 
 }
 
 void RGBController_ENESMBus::UpdateZoneLEDs(int zone)
 {
+    const std::vector<RGBColor>& frame_colors = GetFrameColors();
+
     for(std::size_t led_idx = 0; led_idx < zones[zone].leds_count; led_idx++)
     {
         int           led   = zones[zone].leds[led_idx].value;
-        RGBColor      color = colors[led];
+        RGBColor      color = frame_colors[led];
         unsigned char red   = RGBGetRValue(color);
         unsigned char grn   = RGBGetGValue(color);
         unsigned char blu   = RGBGetBValue(color);
@@ -278,7 +286,7 @@ void RGBController_ENESMBus::UpdateZoneLEDs(int zone)
 
 void RGBController_ENESMBus::UpdateSingleLED(int led)
 {
-    RGBColor color    = colors[led];
+    RGBColor color    = GetFrameColors()[led];
     unsigned char red = RGBGetRValue(color);
     unsigned char grn = RGBGetGValue(color);
     unsigned char blu = RGBGetBValue(color);
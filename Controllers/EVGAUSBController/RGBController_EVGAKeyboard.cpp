@@ -478,7 +478,7 @@ void RGBController_EVGAKeyboard::ResizeZone(int /*zone*/, int /*new_size*/)
 
 void RGBController_EVGAKeyboard::DeviceUpdateLEDs()
 {
-    controller->SetLedsDirect(colors);
+    controller->SetLedsDirect(GetFrameColors());
 }
 
 void RGBController_EVGAKeyboard::UpdateZoneLEDs(int zone)
@@ -71,7 +71,7 @@ void RGBController_Espurna::ResizeZone(int /*zone*/, int /*new_size*/)
 
 void RGBController_Espurna::DeviceUpdateLEDs()
 {
-    controller->SetLEDs(colors);
+    controller->SetLEDs(GetFrameColors());
 }
 
 void RGBController_Espurna::UpdateZoneLEDs(int /*zone*/)
@@ -75,7 +75,7 @@ void RGBController_FanBus::ResizeZone(int /*zone*/, int /*new_size*/)
 
 void RGBController_FanBus::DeviceUpdateLEDs()
 {
-    controller->SetLEDs(colors);
+    controller->SetLEDs(GetFrameColors());
 }
 
 void RGBController_FanBus::UpdateZoneLEDs(int /*zone*/)
@@ -322,11 +322,11 @@ void RGBController_HyperXAlloyElite::DeviceUpdateLEDs()
 
     if(active_mode == 0)
     {
-        controller->SetLEDsDirect(colors);
+        controller->SetLEDsDirect(GetFrameColors());
     }
     else
     {
-        controller->SetLEDs(colors);
+        controller->SetLEDs(GetFrameColors());
     }
 }
 
@@ -309,7 +309,7 @@ void RGBController_HyperXAlloyElite2::DeviceUpdateLEDs()
 
     if(active_mode == 0)
     {
-        controller->SetLEDsDirect(colors);
+        controller->SetLEDsDirect(GetFrameColors());
     }
 }
 
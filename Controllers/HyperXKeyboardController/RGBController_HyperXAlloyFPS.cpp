@@ -263,7 +263,7 @@ void RGBController_HyperXAlloyFPS::DeviceUpdateLEDs()
 
     if(active_mode == 0)
     {
-        controller->SetLEDsDirect(colors);
+        controller->SetLEDsDirect(GetFrameColors());
     }
 }
 
@@ -280,7 +280,7 @@ void RGBController_HyperXAlloyOrigins::ResizeZone(int /*zone*/, int /*new_size*/
 
 void RGBController_HyperXAlloyOrigins::DeviceUpdateLEDs()
 {
-    controller->SetLEDsDirect(colors);
+    controller->SetLEDsDirect(GetFrameColors());
 }
 
 void RGBController_HyperXAlloyOrigins::UpdateZoneLEDs(int /*zone*/)
@@ -256,7 +256,7 @@ void RGBController_HyperXAlloyOriginsCore::ResizeZone(int /*zone*/, int /*new_si
 
 void RGBController_HyperXAlloyOriginsCore::DeviceUpdateLEDs()
 {
-    controller->SetLEDsDirect(colors);
+    controller->SetLEDsDirect(GetFrameColors());
 }
 
 void RGBController_HyperXAlloyOriginsCore::UpdateZoneLEDs(int /*zone*/)
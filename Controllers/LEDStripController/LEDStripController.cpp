@@ -5,6 +5,7 @@
 \*---------------------------------------------------------*/
 
 #include "LEDStripController.h"
+#include "RGBColorConvert.h"
 
 #include <fstream>
 #include <iostream>
@@ -170,14 +171,7 @@ void LEDStripController::SetLEDsKeyboardVisualizer(std::vector<RGBColor> colors)
     /*-------------------------------------------------------------*\
     | Copy in color data in RGB order                               |
     \*-------------------------------------------------------------*/
-    for(unsigned int color_idx = 0; color_idx < colors.size(); color_idx++)
-    {
-        unsigned int color_offset = color_idx * 3;
-
-        serial_buf[0x01 + color_offset]     = RGBGetRValue(colors[color_idx]);
-        serial_buf[0x02 + color_offset]     = RGBGetGValue(colors[color_idx]);
-        serial_buf[0x03 + color_offset]     = RGBGetBValue(colors[color_idx]);
-    }
+    RGBColorPack(colors.data(), (unsigned int)colors.size(), &serial_buf[0x01], RGBCOLOR_ORDER_RGB);
 
     /*-------------------------------------------------------------*\
     | Calculate the checksum                                        |
@@ -246,14 +240,7 @@ void LEDStripController::SetLEDsAdalight(std::vector<RGBColor> colors)
     /*-------------------------------------------------------------*\
     | Copy in color data in RGB order                               |
     \*-------------------------------------------------------------*/
-    for(unsigned int color_idx = 0; color_idx < led_count; color_idx++)
-    {
-        unsigned int color_offset = color_idx * 3;
-
-        serial_buf[0x06 + color_offset]     = RGBGetRValue(colors[color_idx]);
-        serial_buf[0x07 + color_offset]     = RGBGetGValue(colors[color_idx]);
-        serial_buf[0x08 + color_offset]     = RGBGetBValue(colors[color_idx]);
-    }
+    RGBColorPack(colors.data(), led_count, &serial_buf[0x06], RGBCOLOR_ORDER_RGB);
 
     /*-------------------------------------------------------------*\
     | Send the packet                                               |
@@ -299,14 +286,7 @@ void LEDStripController::SetLEDsTPM2(std::vector<RGBColor> colors)
     /*-------------------------------------------------------------*\
     | Copy in color data in RGB order                               |
     \*-------------------------------------------------------------*/
-    for(unsigned int color_idx = 0; color_idx < colors.size(); color_idx++)
-    {
-        unsigned int color_offset = color_idx * 3;
-
-        serial_buf[0x04 + color_offset]     = RGBGetRValue(colors[color_idx]);
-        serial_buf[0x05 + color_offset]     = RGBGetGValue(colors[color_idx]);
-        serial_buf[0x06 + color_offset]     = RGBGetBValue(colors[color_idx]);
-    }
+    RGBColorPack(colors.data(), (unsigned int)colors.size(), &serial_buf[0x04], RGBCOLOR_ORDER_RGB);
 
     /*-------------------------------------------------------------*\
     | Send the packet                                               |
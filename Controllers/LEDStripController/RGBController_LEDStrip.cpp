@@ -76,17 +76,17 @@ void RGBController_LEDStrip::ResizeZone(int /*zone*/, int /*new_size*/)
 
 void RGBController_LEDStrip::DeviceUpdateLEDs()
 {
-    controller->SetLEDs(colors);
+    controller->SetLEDs(GetFrameColors());
 }
 
 void RGBController_LEDStrip::UpdateZoneLEDs(int /*zone*/)
 {
-    controller->SetLEDs(colors);
+    controller->SetLEDs(GetFrameColors());
 }
 
 void RGBController_LEDStrip::UpdateSingleLED(int /*led*/)
 {
-    controller->SetLEDs(colors);
+    controller->SetLEDs(GetFrameColors());
 }
 
 void RGBController_LEDStrip::SetCustomMode()
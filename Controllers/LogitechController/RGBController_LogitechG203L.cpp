@@ -127,8 +127,8 @@ void RGBController_LogitechG203L::ResizeZone(int /*zone*/, int /*new_size*/)
 
 void RGBController_LogitechG203L::DeviceUpdateLEDs()
 {
-    controller->SetDevice(colors);
-    controller->SetDevice(colors); //dirty workaround for color lag
+    controller->SetDevice(GetFrameColors());
+    controller->SetDevice(GetFrameColors()); //dirty workaround for color lag
 }
 
 void RGBController_LogitechG203L::UpdateZoneLEDs(int /*zone*/)
@@ -100,7 +100,7 @@ void RGBController_MSI3Zone::ResizeZone(int /*zone*/, int /*new_size*/)
 
 void RGBController_MSI3Zone::DeviceUpdateLEDs()
 {
-    controller->SetLEDs(colors);
+    controller->SetLEDs(GetFrameColors());
 }
 
 void RGBController_MSI3Zone::UpdateZoneLEDs(int /*zone*/)
@@ -33,7 +33,7 @@ void DetectNZXTHuePlusControllers(std::vector<RGBController*> &rgb_controllers)
     }
 }   /* DetectHuePlusControllers() */
 
-REGISTER_DETECTOR("NZXT Hue+", DetectNZXTHuePlusControllers);
+REGISTER_SERIAL_DETECTOR("NZXT Hue+", DetectNZXTHuePlusControllers, NZXT_HUE_PLUS_VID, NZXT_HUE_PLUS_PID);
 /*---------------------------------------------------------------------------------------------------------*\
 | Entries for dynamic UDEV rules                                                                            |
 |                                                                                                           |
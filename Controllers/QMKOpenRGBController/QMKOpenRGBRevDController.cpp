@@ -99,8 +99,11 @@ QMKOpenRGBRevDController::QMKOpenRGBRevDController(hid_device *dev_handle, const
     dev         = dev_handle;
     location    = path;
 
+    /*-------------------------------------------------*\
+    | Only the device info is read here, the mode info  |
+    | is read when the RGBController is populated       |
+    \*-------------------------------------------------*/
     GetDeviceInfo();
-    GetModeInfo();
 }
 
 QMKOpenRGBRevDController::~QMKOpenRGBRevDController()
@@ -409,7 +409,7 @@ void RGBController_QMKOpenRGBRev9::ResizeZone(int /*zone*/, int /*new_size*/)
 
 void RGBController_QMKOpenRGBRev9::DeviceUpdateLEDs()
 {
-    controller->DirectModeSetLEDs(colors, controller->GetTotalNumberOfLEDs());
+    controller->DirectModeSetLEDs(GetFrameColors(), controller->GetTotalNumberOfLEDs());
 }
 
 void RGBController_QMKOpenRGBRev9::UpdateZoneLEDs(int /*zone*/)
@@ -408,7 +408,7 @@ void RGBController_QMKOpenRGBRevB::ResizeZone(int /*zone*/, int /*new_size*/)
 
 void RGBController_QMKOpenRGBRevB::DeviceUpdateLEDs()
 {
-    controller->DirectModeSetLEDs(colors, controller->GetTotalNumberOfLEDs());
+    controller->DirectModeSetLEDs(GetFrameColors(), controller->GetTotalNumberOfLEDs());
 }
 
 void RGBController_QMKOpenRGBRevB::UpdateZoneLEDs(int /*zone*/)
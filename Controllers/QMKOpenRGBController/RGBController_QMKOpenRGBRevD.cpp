@@ -22,6 +22,23 @@ RGBController_QMKOpenRGBRevD::RGBController_QMKOpenRGBRevD(QMKOpenRGBRevDControl
     location    = controller->GetLocation();
     version     = controller->GetQMKVersion();
 
+    save_modes  = save;
+
+    SetPartialUpdateFlags(PARTIAL_UPDATE_SINGLE_LED);
+
+    /*-----------------------------------------------------*\
+    | Reading the modes and LEDs takes a round trip per     |
+    | few LEDs, so it is left to DevicePopulate()           |
+    \*-----------------------------------------------------*/
+    DeferPopulate();
+}
+
+void RGBController_QMKOpenRGBRevD::DevicePopulate()
+{
+    bool save = save_modes;
+
+    controller->GetModeInfo();
+
     unsigned int current_mode = 1;
     std::vector<unsigned int> enabled_modes = controller->GetEnabledModes();
 
@@ -410,7 +427,7 @@ void RGBController_QMKOpenRGBRevD::ResizeZone(int /*zone*/, int /*new_size*/)
 
 void RGBController_QMKOpenRGBRevD::DeviceUpdateLEDs()
 {
-    controller->DirectModeSetLEDs(colors, controller->GetTotalNumberOfLEDs());
+    controller->DirectModeSetLEDs(GetFrameColors(), controller->GetTotalNumberOfLEDs());
 }
 
 void RGBController_QMKOpenRGBRevD::UpdateZoneLEDs(int /*zone*/)
@@ -420,7 +437,7 @@ void RGBController_QMKOpenRGBRevD::UpdateZoneLEDs(int /*zone*/)
 
 void RGBController_QMKOpenRGBRevD::UpdateSingleLED(int led)
 {
-    RGBColor      color = colors[led];
+    RGBColor      color = GetFrameColors()[led];
     unsigned char red   = RGBGetRValue(color);
     unsigned char grn   = RGBGetGValue(color);
     unsigned char blu   = RGBGetBValue(color);
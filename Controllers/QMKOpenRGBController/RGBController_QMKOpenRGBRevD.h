@@ -26,6 +26,8 @@ public:
     RGBController_QMKOpenRGBRevD(QMKOpenRGBRevDController* controller_ptr, bool save);
     ~RGBController_QMKOpenRGBRevD();
 
+    void                                    DevicePopulate();
+
     void                                    SetupZones();
     void                                    ResizeZone(int zone, int new_size);
 
@@ -39,6 +41,7 @@ public:
 
 private:
     QMKOpenRGBRevDController*   controller;
+    bool                        save_modes;
     std::vector<unsigned int>   flat_matrix_map;
     std::vector<unsigned int>   flat_underglow_map;
 
@@ -211,7 +211,7 @@ void RGBController_Razer::ResizeZone(int /*zone*/, int /*new_size*/)
 
 void RGBController_Razer::DeviceUpdateLEDs()
 {
-    controller->SetLEDs(&colors[0]);
+    controller->SetLEDs(GetFrameColors().data());
 }
 
 void RGBController_Razer::UpdateZoneLEDs(int /*zone*/)
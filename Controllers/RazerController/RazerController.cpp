@@ -361,7 +361,7 @@ void RazerController::SetBrightness(unsigned char brightness)
     razer_set_brightness(brightness);
 }
 
-void RazerController::SetLEDs(RGBColor* colors)
+void RazerController::SetLEDs(const RGBColor* colors)
 {
     /*---------------------------------------------------------*\
     | Get the matrix layout information from the device list    |
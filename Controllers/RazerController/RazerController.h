@@ -171,7 +171,7 @@ public:
 
     void                    SetBrightness(unsigned char brightness);
 
-    void                    SetLEDs(RGBColor* colors);
+    void                    SetLEDs(const RGBColor* colors);
     void                    SetAddressableZoneSizes(unsigned char zone_1_size, unsigned char zone_2_size, unsigned char zone_3_size, unsigned char zone_4_size, unsigned char zone_5_size, unsigned char zone_6_size);
 
     void                    SetModeBreathingRandom();
@@ -258,7 +258,7 @@ void RGBController_RoccatVulcanAimo::DeviceUpdateLEDs()
 {
     if (modes[active_mode].value == ROCCAT_VULCAN_MODE_DIRECT)
     {
-        controller->SendColors(colors);
+        controller->SendColors(GetFrameColors());
     }
     else
     {
@@ -214,7 +214,7 @@ void RGBController_Sinowealth1007::ResizeZone(int /*zone*/, int /*new_size*/)
 
 void RGBController_Sinowealth1007::DeviceUpdateLEDs()
 {
-    controller->SetLEDColors(colors);
+    controller->SetLEDColors(GetFrameColors());
 }
 
 void RGBController_Sinowealth1007::UpdateZoneLEDs(int /*zone*/)
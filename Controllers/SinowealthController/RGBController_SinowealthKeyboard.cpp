@@ -450,7 +450,7 @@ void RGBController_SinowealthKeyboard::ResizeZone(int /*zone*/, int /*new_size*/
 
 void RGBController_SinowealthKeyboard::DeviceUpdateLEDs()
 {
-    sinowealth->SetLEDsDirect(colors);
+    sinowealth->SetLEDsDirect(GetFrameColors());
 }
 
 void RGBController_SinowealthKeyboard::UpdateZoneLEDs(int /*zone*/)
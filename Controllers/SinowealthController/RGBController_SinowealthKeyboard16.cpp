@@ -406,7 +406,7 @@ void RGBController_SinowealthKeyboard16::ResizeZone(int /*zone*/, int /*new_size
 
 void RGBController_SinowealthKeyboard16::DeviceUpdateLEDs()
 {
-    sinowealth->SetLEDsDirect(colors);
+    sinowealth->SetLEDsDirect(GetFrameColors());
 }
 
 void RGBController_SinowealthKeyboard16::UpdateZoneLEDs(int /*zone*/)
@@ -290,7 +290,7 @@ void RGBController_SteelSeriesApex::ResizeZone(int /*zone*/, int /*new_size*/)
 void RGBController_SteelSeriesApex::DeviceUpdateLEDs()
 {
     last_update_time = std::chrono::steady_clock::now();
-    steelseries->SetLEDsDirect(colors);
+    steelseries->SetLEDsDirect(GetFrameColors());
 }
 
 void RGBController_SteelSeriesApex::UpdateZoneLEDs(int /*zone*/)
@@ -82,7 +82,7 @@ void RGBController_SteelSeriesApexTZone::ResizeZone(int /*zone*/, int /*new_size
 
 void RGBController_SteelSeriesApexTZone::DeviceUpdateLEDs()
 {
-    controller->SetColor(colors, modes[active_mode].brightness);
+    controller->SetColor(GetFrameColors(), modes[active_mode].brightness);
 }
 
 void RGBController_SteelSeriesApexTZone::UpdateZoneLEDs(int /*zone*/)
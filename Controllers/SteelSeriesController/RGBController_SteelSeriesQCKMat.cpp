@@ -79,7 +79,7 @@ void RGBController_SteelSeriesQCKMat::ResizeZone(int /*zone*/, int /*new_size*/)
 
 void RGBController_SteelSeriesQCKMat::DeviceUpdateLEDs()
 {
-    qck->SetColors(colors);
+    qck->SetColors(GetFrameColors());
 }
 
 void RGBController_SteelSeriesQCKMat::UpdateZoneLEDs(int /*zone*/)
@@ -268,11 +268,11 @@ void RGBController_PoseidonZRGB::DeviceUpdateLEDs()
 {
     if(active_mode == 0)
     {
-        poseidon->SetLEDsDirect(colors);
+        poseidon->SetLEDsDirect(GetFrameColors());
     }
     else
     {
-        poseidon->SetLEDs(colors);
+        poseidon->SetLEDs(GetFrameColors());
     }
 }
 
@@ -276,7 +276,9 @@ void RGBController_WootingKeyboard::ResizeZone(int /*zone*/, int /*new_size*/)
 
 void RGBController_WootingKeyboard::DeviceUpdateLEDs()
 {
-    wooting->SendDirect(&colors[0], colors.size());
+    const std::vector<RGBColor>& frame_colors = GetFrameColors();
+
+    wooting->SendDirect(frame_colors.data(), frame_colors.size());
 }
 
 void RGBController_WootingKeyboard::UpdateZoneLEDs(int /*zone*/)
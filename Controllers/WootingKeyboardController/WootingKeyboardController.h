@@ -74,7 +74,7 @@ public:
     bool                wooting_usb_send_feature(uint8_t command, uint8_t param0,
                                                  uint8_t param1, uint8_t param2, uint8_t param3);
 
-    virtual void        SendDirect(RGBColor* colors, uint8_t color_count)                           = 0;
+    virtual void        SendDirect(const RGBColor* colors, uint8_t color_count)                     = 0;
 
 private:
     virtual void        SendInitialize()                                                            = 0;
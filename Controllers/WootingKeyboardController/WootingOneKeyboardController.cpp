@@ -80,7 +80,7 @@ WootingOneKeyboardController::~WootingOneKeyboardController()
 
 }
 
-void WootingOneKeyboardController::SendDirect(RGBColor* colors, uint8_t colour_count)
+void WootingOneKeyboardController::SendDirect(const RGBColor* colors, uint8_t colour_count)
 {
     const uint8_t pwm_mem_map[48] =
     {
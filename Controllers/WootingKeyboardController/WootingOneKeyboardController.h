@@ -17,7 +17,7 @@ public:
     WootingOneKeyboardController(hid_device* dev_handle, const char *path, uint8_t wooting_type);
     ~WootingOneKeyboardController();
 
-    void                SendDirect(RGBColor* colors, uint8_t colour_count);
+    void                SendDirect(const RGBColor* colors, uint8_t colour_count);
 
 private:
     void                SendInitialize();
@@ -63,7 +63,7 @@ WootingTwoKeyboardController::~WootingTwoKeyboardController()
 
 }
 
-void WootingTwoKeyboardController::SendDirect(RGBColor* colors, uint8_t color_count)
+void WootingTwoKeyboardController::SendDirect(const RGBColor* colors, uint8_t color_count)
 {
     uint8_t rgb_buffer[WOOTING_TWO_REPORT_SIZE] = { 0, 0xD0, 0xDA, WOOTING_RAW_COLORS_REPORT};
 
@@ -17,7 +17,7 @@ public:
     WootingTwoKeyboardController(hid_device* dev_handle, const char *path, uint8_t wooting_type);
     ~WootingTwoKeyboardController();
 
-    void                SendDirect(RGBColor* colors, uint8_t colour_count);
+    void                SendDirect(const RGBColor* colors, uint8_t colour_count);
 
 private:
     void                SendInitialize();
@@ -0,0 +1,122 @@
+/*-----------------------------------------*\
+|  DetectionCache.cpp                       |
+|                                           |
+|  Remembers which detectors found devices  |
+|  so a warm start can skip the rest        |
+\*-----------------------------------------*/
+
+#include "DetectionCache.h"
+#include "LogManager.h"
+
+#include <fstream>
+
+DetectionCache::DetectionCache()
+{
+    valid = false;
+}
+
+DetectionCache::~DetectionCache()
+{
+
+}
+
+void DetectionCache::Load(std::string filename, std::string fingerprint)
+{
+    json cache_data;
+
+    cache_filename      = filename;
+    cache_fingerprint   = fingerprint;
+    valid               = false;
+
+    cached_jobs.clear();
+    detected_jobs       = json::object();
+
+    /*---------------------------------------------------------*\
+    | Open input file in binary mode                            |
+    \*---------------------------------------------------------*/
+    std::ifstream cache_file(cache_filename, std::ios::in | std::ios::binary);
+
+    if(!cache_file)
+    {
+        return;
+    }
+
+    try
+    {
+        cache_file >> cache_data;
+    }
+    catch(const std::exception& e)
+    {
+        LOG_ERROR("[DetectionCache] JSON parsing failed: %s", e.what());
+
+        cache_data.clear();
+    }
+
+    cache_file.close();
+
+    /*---------------------------------------------------------*\
+    | Only use the cache if it was saved on the same system     |
+    \*---------------------------------------------------------*/
+    if(cache_data.contains("fingerprint") && cache_data["fingerprint"].is_string()
+    && (cache_data["fingerprint"] == cache_fingerprint)
+    && cache_data.contains("jobs") && cache_data["jobs"].is_object())
+    {
+        cached_jobs = cache_data["jobs"];
+        valid       = true;
+    }
+    else
+    {
+        LOG_INFO("[DetectionCache] System changed since the cache was saved, ignoring it");
+    }
+}
+
+/*---------------------------------------------------------*\
+| Replaces the cache file with the counts set since Load    |
+\*---------------------------------------------------------*/
+void DetectionCache::Save()
+{
+    json cache_data;
+
+    cache_data["fingerprint"]   = cache_fingerprint;
+    cache_data["jobs"]          = detected_jobs;
+
+    std::ofstream cache_file(cache_filename, std::ios::out | std::ios::binary);
+
+    if(cache_file)
+    {
+        try
+        {
+            cache_file << cache_data.dump(4);
+        }
+        catch(const std::exception& e)
+        {
+            LOG_ERROR("[DetectionCache] Cannot write to file: %s", e.what());
+        }
+
+        cache_file.close();
+    }
+}
+
+bool DetectionCache::GetValid()
+{
+    return(valid);
+}
+
+/*---------------------------------------------------------*\
+| Returns the number of controllers the job found last      |
+| time, or -1 if it is not in the cache                     |
+\*---------------------------------------------------------*/
+int DetectionCache::GetControllerCount(std::string job_key)
+{
+    if(valid && cached_jobs.contains(job_key) && cached_jobs[job_key].is_number_unsigned())
+    {
+        return(cached_jobs[job_key]);
+    }
+
+    return(-1);
+}
+
+void DetectionCache::SetControllerCount(std::string job_key, unsigned int count)
+{
+    detected_jobs[job_key] = count;
+}
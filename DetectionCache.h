@@ -0,0 +1,41 @@
+/*-----------------------------------------*\
+|  DetectionCache.h                         |
+|                                           |
+|  Remembers which detectors found devices  |
+|  so a warm start can skip the rest        |
+\*-----------------------------------------*/
+
+#pragma once
+
+#include "json.hpp"
+#include <string>
+
+using json = nlohmann::json;
+
+/*---------------------------------------------------------*\
+| Stores the number of controllers each detection job       |
+| found, keyed by detector and resource.  The counts are    |
+| only used while the system fingerprint (board, I2C busses,|
+| populated DIMM slots and OpenRGB version) matches the one |
+| they were saved with.                                     |
+\*---------------------------------------------------------*/
+class DetectionCache
+{
+public:
+    DetectionCache();
+    ~DetectionCache();
+
+    void                                Load(std::string filename, std::string fingerprint);
+    void                                Save();
+
+    bool                                GetValid();
+    int                                 GetControllerCount(std::string job_key);
+    void                                SetControllerCount(std::string job_key, unsigned int count);
+
+private:
+    std::string                         cache_filename;
+    std::string                         cache_fingerprint;
+    json                                cached_jobs;
+    json                                detected_jobs;
+    bool                                valid;
+};
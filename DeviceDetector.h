@@ -15,6 +15,15 @@ public:
 	}
 };
 
+class SerialDeviceDetector
+{
+public:
+    SerialDeviceDetector(std::string name, DeviceDetectorFunction detector, uint16_t vid, uint16_t pid)
+    {
+        ResourceManager::get()->RegisterSerialDeviceDetector(name, detector, vid, pid);
+    }
+};
+
 class I2CDeviceDetector
 {
 public:
@@ -0,0 +1,59 @@
+/*-----------------------------------------*\
+|  HotplugMonitor.h                         |
+|                                           |
+|  Watches for devices being plugged in and |
+|  removed so detection can follow them     |
+\*-----------------------------------------*/
+
+#pragma once
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+/*---------------------------------------------------------*\
+| Events are passed on once no new event has arrived for    |
+| this long, so a device's interfaces are handled together  |
+| and udev has set up the device nodes                      |
+\*---------------------------------------------------------*/
+#define HOTPLUG_SETTLE_MS           500
+
+enum
+{
+    HOTPLUG_ACTION_ADD              = 0,    /* Device node added                */
+    HOTPLUG_ACTION_REMOVE           = 1,    /* Device node removed              */
+};
+
+typedef struct
+{
+    int                             action;
+    std::string                     subsystem;
+    std::string                     devnode;
+} HotplugEvent;
+
+typedef void (*HotplugCallback)(void *, std::vector<HotplugEvent>&);
+
+/*---------------------------------------------------------*\
+| Listens for kernel uevents on the hidraw, usb, tty and    |
+| i2c-dev subsystems.  Only built on Linux.                 |
+\*---------------------------------------------------------*/
+class HotplugMonitor
+{
+public:
+    HotplugMonitor();
+    ~HotplugMonitor();
+
+    bool                                Start(HotplugCallback new_callback, void * new_callback_arg);
+    void                                Stop();
+
+private:
+    int                                 monitor_sock;
+    std::thread *                       MonitorThread;
+    std::atomic<bool>                   monitor_running;
+
+    HotplugCallback                     callback;
+    void *                              callback_arg;
+
+    void                                MonitorThreadFunction();
+};
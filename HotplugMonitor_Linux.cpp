@@ -0,0 +1,212 @@
+/*-----------------------------------------*\
+|  HotplugMonitor_Linux.cpp                 |
+|                                           |
+|  Watches for devices being plugged in and |
+|  removed so detection can follow them     |
+\*-----------------------------------------*/
+
+#include "HotplugMonitor.h"
+#include "LogManager.h"
+
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <linux/netlink.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#define HOTPLUG_UEVENT_BUFFER_SIZE  8192
+#define HOTPLUG_POLL_MS             100
+
+/*---------------------------------------------------------*\
+| Subsystems whose device nodes detection cares about       |
+\*---------------------------------------------------------*/
+static const char* hotplug_subsystems[] =
+{
+    "hidraw",
+    "usb",
+    "tty",
+    "i2c-dev",
+};
+
+/*---------------------------------------------------------*\
+| Parses a kernel uevent of the form                        |
+|   action@devpath\0KEY=value\0KEY=value\0...               |
+| Returns false for events that are not of interest.        |
+\*---------------------------------------------------------*/
+static bool ParseUevent(const char * buf, std::size_t size, HotplugEvent& event)
+{
+    std::string action;
+    std::string devname;
+
+    event.subsystem.clear();
+
+    for(std::size_t offset = 0; offset < size; offset += strnlen(buf + offset, size - offset) + 1)
+    {
+        std::string field(buf + offset, strnlen(buf + offset, size - offset));
+
+        if(field.compare(0, 7, "ACTION=") == 0)
+        {
+            action = field.substr(7);
+        }
+        else if(field.compare(0, 10, "SUBSYSTEM=") == 0)
+        {
+            event.subsystem = field.substr(10);
+        }
+        else if(field.compare(0, 8, "DEVNAME=") == 0)
+        {
+            devname = field.substr(8);
+        }
+    }
+
+    if(action == "add")
+    {
+        event.action = HOTPLUG_ACTION_ADD;
+    }
+    else if(action == "remove")
+    {
+        event.action = HOTPLUG_ACTION_REMOVE;
+    }
+    else
+    {
+        return(false);
+    }
+
+    /*-----------------------------------------------------*\
+    | Only events with a device node can be matched against |
+    | controller locations                                  |
+    \*-----------------------------------------------------*/
+    if(devname.empty())
+    {
+        return(false);
+    }
+
+    event.devnode = (devname[0] == '/') ? devname : ("/dev/" + devname);
+
+    for(unsigned int subsystem_idx = 0; subsystem_idx < (sizeof(hotplug_subsystems) / sizeof(hotplug_subsystems[0])); subsystem_idx++)
+    {
+        if(event.subsystem == hotplug_subsystems[subsystem_idx])
+        {
+            return(true);
+        }
+    }
+
+    return(false);
+}
+
+HotplugMonitor::HotplugMonitor()
+{
+    monitor_sock    = -1;
+    MonitorThread   = nullptr;
+    monitor_running = false;
+    callback        = nullptr;
+    callback_arg    = nullptr;
+}
+
+HotplugMonitor::~HotplugMonitor()
+{
+    Stop();
+}
+
+bool HotplugMonitor::Start(HotplugCallback new_callback, void * new_callback_arg)
+{
+    if(MonitorThread != nullptr)
+    {
+        return(true);
+    }
+
+    /*-----------------------------------------------------*\
+    | Subscribe to the kernel's uevent broadcasts           |
+    \*-----------------------------------------------------*/
+    struct sockaddr_nl addr;
+
+    memset(&addr, 0, sizeof(addr));
+
+    addr.nl_family  = AF_NETLINK;
+    addr.nl_pid     = 0;
+    addr.nl_groups  = 1;
+
+    monitor_sock = socket(AF_NETLINK, SOCK_DGRAM | SOCK_CLOEXEC, NETLINK_KOBJECT_UEVENT);
+
+    if(monitor_sock < 0)
+    {
+        LOG_WARNING("[HotplugMonitor] Failed to open uevent socket: %s", strerror(errno));
+        return(false);
+    }
+
+    if(bind(monitor_sock, (struct sockaddr *)&addr, sizeof(addr)) < 0)
+    {
+        LOG_WARNING("[HotplugMonitor] Failed to bind uevent socket: %s", strerror(errno));
+
+        close(monitor_sock);
+        monitor_sock = -1;
+        return(false);
+    }
+
+    callback        = new_callback;
+    callback_arg    = new_callback_arg;
+    monitor_running = true;
+    MonitorThread   = new std::thread(&HotplugMonitor::MonitorThreadFunction, this);
+
+    LOG_INFO("[HotplugMonitor] Watching for device changes");
+
+    return(true);
+}
+
+void HotplugMonitor::Stop()
+{
+    if(MonitorThread == nullptr)
+    {
+        return;
+    }
+
+    monitor_running = false;
+
+    MonitorThread->join();
+    delete MonitorThread;
+    MonitorThread = nullptr;
+
+    close(monitor_sock);
+    monitor_sock = -1;
+}
+
+void HotplugMonitor::MonitorThreadFunction()
+{
+    char                                    buf[HOTPLUG_UEVENT_BUFFER_SIZE];
+    std::vector<HotplugEvent>               pending_events;
+    std::chrono::steady_clock::time_point   last_event_time;
+
+    while(monitor_running.load())
+    {
+        struct pollfd poll_fd;
+
+        poll_fd.fd      = monitor_sock;
+        poll_fd.events  = POLLIN;
+        poll_fd.revents = 0;
+
+        if(poll(&poll_fd, 1, HOTPLUG_POLL_MS) > 0)
+        {
+            ssize_t         bytes_read = recv(monitor_sock, buf, sizeof(buf), 0);
+            HotplugEvent    event;
+
+            if((bytes_read > 0) && ParseUevent(buf, (std::size_t)bytes_read, event))
+            {
+                LOG_DEBUG("[HotplugMonitor] %s %s (%s)", ((event.action == HOTPLUG_ACTION_ADD) ? "Added" : "Removed"), event.devnode.c_str(), event.subsystem.c_str());
+
+                pending_events.push_back(event);
+                last_event_time = std::chrono::steady_clock::now();
+            }
+        }
+
+        /*-------------------------------------------------*\
+        | Pass events on once things have settled           |
+        \*-------------------------------------------------*/
+        if(!pending_events.empty() && ((std::chrono::steady_clock::now() - last_event_time) >= std::chrono::milliseconds(HOTPLUG_SETTLE_MS)))
+        {
+            callback(callback_arg, pending_events);
+
+            pending_events.clear();
+        }
+    }
+}
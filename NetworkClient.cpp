@@ -7,8 +7,13 @@
 \*-----------------------------------------*/
 
 #include "NetworkClient.h"
+#include "NetworkPacketReader.h"
 #include "RGBController_Network.h"
+#include "RGBControllerBuffer.h"
+#include <algorithm>
 #include <cstring>
+#include <map>
+#include <set>
 
 #ifdef _WIN32
 #include <Windows.h>
@@ -27,6 +32,31 @@
 
 using namespace std::chrono_literals;
 
+/*---------------------------------------------------------*\
+| How long the initial sync waits for each reply before it  |
+| gives up and tries again                                  |
+\*---------------------------------------------------------*/
+#define NET_CLIENT_SYNC_TIMEOUT_MS  5000
+
+/*---------------------------------------------------------*\
+| Statistics filled in by the GetControllerStats callback   |
+\*---------------------------------------------------------*/
+typedef struct
+{
+    RGBControllerStats  stats;
+    bool                received;
+} NetworkClientStatsReply;
+
+static void ControllerStatsCallback(void * callback_arg, unsigned int /*request_id*/, unsigned int /*dev_idx*/, unsigned int data_size, char * data)
+{
+    NetworkClientStatsReply * reply = (NetworkClientStatsReply *)callback_arg;
+
+    if(data != NULL)
+    {
+        reply->received = RGBController::ReadStatsDescription((unsigned char *)data, data_size, reply->stats);
+    }
+}
+
 NetworkClient::NetworkClient(std::vector<RGBController *>& control) : controllers(control)
 {
     strcpy(port_ip, "127.0.0.1");
@@ -35,6 +65,17 @@ NetworkClient::NetworkClient(std::vector<RGBController *>& control) : controller
     server_connected        = false;
     server_controller_count = 0;
     change_in_progress      = false;
+    next_request_id         = 1;
+    active_request_id       = 0;
+    udp_enabled             = false;
+    udp_reply_received      = false;
+    udp_ready               = false;
+    udp_port                = 0;
+    udp_token               = 0;
+    udp_frame_seq           = 0;
+    udp_sock                = INVALID_SOCKET;
+    color_subscription_rate = 0;
+    server_device_list_seq  = 0;
 
     ListenThread            = NULL;
     ConnectionThread        = NULL;
@@ -155,6 +196,118 @@ void NetworkClient::StartClient()
     ClientInfoChanged();
 }
 
+void NetworkClient::SetUDPChannel(bool enable)
+{
+    udp_enabled = enable;
+}
+
+bool NetworkClient::GetUDPChannel()
+{
+    return(udp_ready);
+}
+
+void NetworkClient::SetColorSubscription(unsigned int max_rate)
+{
+    color_subscription_rate = max_rate;
+
+    if(GetOnline() && (GetProtocolVersion() >= 8))
+    {
+        SubscribeColors();
+    }
+}
+
+unsigned int NetworkClient::GetColorSubscription()
+{
+    return(color_subscription_rate);
+}
+
+/*---------------------------------------------------------*\
+| Subscribes to the colors of every server device, or ends  |
+| the subscription if the rate is 0                         |
+\*---------------------------------------------------------*/
+void NetworkClient::SubscribeColors()
+{
+    std::vector<unsigned int>   dev_idxs;
+    unsigned int                max_rate = color_subscription_rate;
+
+    if(max_rate > 0)
+    {
+        ControllerListMutex.lock();
+
+        for(unsigned int dev_idx = 0; dev_idx < server_controllers.size(); dev_idx++)
+        {
+            dev_idxs.push_back(dev_idx);
+        }
+
+        ControllerListMutex.unlock();
+    }
+
+    SendRequest_ColorSubscription(dev_idxs, max_rate);
+}
+
+/*---------------------------------------------------------*\
+| Asks the server for a UDP channel and connects a UDP      |
+| socket to it.  LED updates stay on TCP if the server does |
+| not reply or has no UDP channel.                          |
+\*---------------------------------------------------------*/
+void NetworkClient::OpenUDPChannel()
+{
+    udp_reply_received = false;
+
+    WaitOnRequest(SendRequest_UDPChannel(), 1000);
+
+    if(!udp_reply_received || (udp_port == 0))
+    {
+        return;
+    }
+
+    /*-----------------------------------------------------*\
+    | Send to the address of the TCP connection             |
+    \*-----------------------------------------------------*/
+    sockaddr_in server_addr;
+    socklen_t   server_addr_len = sizeof(server_addr);
+
+    if(getpeername(client_sock, (sockaddr *)&server_addr, &server_addr_len) == SOCKET_ERROR)
+    {
+        return;
+    }
+
+    server_addr.sin_port = htons(udp_port);
+
+    SOCKET new_sock = socket(AF_INET, SOCK_DGRAM, 0);
+
+    if(new_sock == INVALID_SOCKET)
+    {
+        return;
+    }
+
+    if(connect(new_sock, (sockaddr *)&server_addr, sizeof(server_addr)) == SOCKET_ERROR)
+    {
+        closesocket(new_sock);
+        return;
+    }
+
+    UDPMutex.lock();
+    udp_sock  = new_sock;
+    udp_ready = true;
+    UDPMutex.unlock();
+}
+
+void NetworkClient::CloseUDPChannel()
+{
+    UDPMutex.lock();
+
+    udp_ready = false;
+
+    if(udp_sock != INVALID_SOCKET)
+    {
+        closesocket(udp_sock);
+        udp_sock = INVALID_SOCKET;
+    }
+
+    UDPMutex.unlock();
+}
+
 void NetworkClient::StopClient()
 {
     if(server_connected)
@@ -187,8 +340,6 @@ void NetworkClient::StopClient()
 
 void NetworkClient::ConnectionThreadFunction()
 {
-    unsigned int requested_controllers;
-
     //This thread manages the connection to the server
     while(client_active == true)
     {
@@ -201,6 +352,12 @@ void NetworkClient::ConnectionThreadFunction()
             if(port.tcp_client_connect() == true)
             {
                 client_sock = port.sock;
+
+                NetworkPacketWriter::SetNoDelay(client_sock, true);
+
+                SendMutex.lock();
+                writer.Reset();
+                SendMutex.unlock();
                 printf( "Connected to server\n" );
 
                 //Server is now connected
@@ -225,8 +382,6 @@ void NetworkClient::ConnectionThreadFunction()
 
         if(server_initialized == false && server_connected == true)
         {
-            unsigned int timeout_counter     = 0;
-            requested_controllers            = 0;
             server_controller_count          = 0;
             server_controller_count_received = false;
             server_protocol_version_received = false;
@@ -234,73 +389,115 @@ void NetworkClient::ConnectionThreadFunction()
             //Wait for server to connect
             std::this_thread::sleep_for(100ms);
 
-            //Request protocol version
-            SendRequest_ProtocolVersion();
+            //Request protocol version and wait up to 1s for the reply
+            WaitOnRequest(SendRequest_ProtocolVersion(), 1000);
 
-            //Wait up to 1s for protocol version reply
-
-            while(!server_protocol_version_received)
+            /*-------------------------------------------------*\
+            | If no protocol version received within 1s, assume |
+            | the server doesn't support protocol versioning    |
+            | and use protocol version 0                        |
+            \*-------------------------------------------------*/
+            if(!server_protocol_version_received)
             {
-                std::this_thread::sleep_for(5ms);
-
-                timeout_counter++;
-
-                /*-------------------------------------------------*\
-                | If no protocol version received within 1s, assume |
-                | the server doesn't support protocol versioning    |
-                | and use protocol version 0                        |
-                \*-------------------------------------------------*/
-                if(timeout_counter > 200)
-                {
-                    server_protocol_version          = 0;
-                    server_protocol_version_received = true;
-                }
+                server_protocol_version          = 0;
+                server_protocol_version_received = true;
             }
 
             //Once server is connected, send client string
             SendData_ClientString();
 
-            //Request number of controllers
-            SendRequest_ControllerCount();
+            //Open the UDP channel if enabled and the server supports it
+            if(udp_enabled && (GetProtocolVersion() >= 7))
+            {
+                OpenUDPChannel();
+            }
+
+            //Request device IDs if the server supports device list diffs
+            if(GetProtocolVersion() >= 9)
+            {
+                SendRequest_DeviceIDs();
+            }
+
+            //Request number of controllers and wait for the reply
+            WaitOnRequest(SendRequest_ControllerCount(), NET_CLIENT_SYNC_TIMEOUT_MS);
 
-            //Wait for server controller count
-            while(!server_controller_count_received)
+            if(!server_controller_count_received)
             {
-                std::this_thread::sleep_for(5ms);
+                std::this_thread::sleep_for(1s);
+                continue;
             }
 
             printf("Client: Received controller count from server: %d\r\n", server_controller_count);
 
-            //Once count is received, request controllers
-            while(requested_controllers < server_controller_count)
+            /*-------------------------------------------------*\
+            | Request all controllers at once.  The replies are |
+            | handled as they arrive, so the sync takes about   |
+            | one round trip instead of one per controller      |
+            \*-------------------------------------------------*/
+            std::vector<unsigned int> request_ids(server_controller_count);
+
+            sync_controllers.assign(server_controller_count, NULL);
+
+            printf("Client: Requesting %d controllers\r\n", server_controller_count);
+
+            StartBatch();
+
+            for(unsigned int controller_idx = 0; controller_idx < server_controller_count; controller_idx++)
+            {
+                request_ids[controller_idx] = SendRequestAsync_ControllerData(controller_idx, SyncControllerDataCallback, this);
+            }
+
+            FinishBatch();
+
+            //Wait until all controllers are received, once one times out the rest are cancelled
+            bool sync_complete = true;
+
+            for(unsigned int controller_idx = 0; controller_idx < server_controller_count; controller_idx++)
             {
-                printf("Client: Requesting controller %d\r\n", requested_controllers);
+                if(!WaitOnRequest(request_ids[controller_idx], sync_complete ? NET_CLIENT_SYNC_TIMEOUT_MS : 0)
+                || (sync_controllers[controller_idx] == NULL))
+                {
+                    sync_complete = false;
+                }
+            }
 
-                controller_data_received = false;
-                SendRequest_ControllerData(requested_controllers);
+            if(!sync_complete)
+            {
+                printf("Client: Not all controllers received, retrying\r\n");
 
-                //Wait until controller is received
-                while(controller_data_received == false)
+                for(std::size_t controller_idx = 0; controller_idx < sync_controllers.size(); controller_idx++)
                 {
-                    std::this_thread::sleep_for(5ms);
+                    delete sync_controllers[controller_idx];
                 }
 
-                requested_controllers++;
+                sync_controllers.clear();
+
+                std::this_thread::sleep_for(1s);
+                continue;
             }
 
             ControllerListMutex.lock();
 
             //All controllers received, add them to master list
             printf("Client: All controllers received, adding them to master list\r\n");
-            for(std::size_t controller_idx = 0; controller_idx < server_controllers.size(); controller_idx++)
+            for(std::size_t controller_idx = 0; controller_idx < sync_controllers.size(); controller_idx++)
             {
-                controllers.push_back(server_controllers[controller_idx]);
+                server_controllers.push_back(sync_controllers[controller_idx]);
+                controllers.push_back(sync_controllers[controller_idx]);
             }
 
             ControllerListMutex.unlock();
 
+            sync_controllers.clear();
+
             server_initialized = true;
 
+            //Subscribe to device colors if enabled and the server supports it
+            if((color_subscription_rate > 0) && (GetProtocolVersion() >= 8))
+            {
+                SubscribeColors();
+            }
+
             /*-------------------------------------------------*\
             | Client info has changed, call the callbacks       |
             \*-------------------------------------------------*/
@@ -345,130 +542,96 @@ int NetworkClient::recv_select(SOCKET s, char *buf, int len, int flags)
 
 void NetworkClient::ListenThreadFunction()
 {
+    /*---------------------------------------------------------*\
+    | Everything available is received at once and then split  |
+    | into packets, so a burst of replies costs one receive     |
+    \*---------------------------------------------------------*/
+    NetworkPacketReader reader;
+
     printf("Network client listener started\n");
     //This thread handles messages received from the server
     while(server_connected == true)
     {
         NetPacketHeader header;
-        int             bytes_read  = 0;
+        std::size_t     recv_size;
+        char *          recv_buf    = reader.GetRecvBuffer(recv_size);
         char *          data        = NULL;
-
-        //Read first byte of magic
-        bytes_read = recv_select(client_sock, &header.pkt_magic[0], 1, 0);
+        int             bytes_read  = recv_select(client_sock, recv_buf, (int)recv_size, 0);
+        int             result;
 
         if(bytes_read <= 0)
         {
             goto listen_done;
         }
 
-        //Test first character of magic - 'O'
-        if(header.pkt_magic[0] != 'O')
-        {
-            continue;
-        }
-
-        //Read second byte of magic
-        bytes_read = recv_select(client_sock, &header.pkt_magic[1], 1, 0);
-
-        if(bytes_read <= 0)
-        {
-            goto listen_done;
-        }
+        reader.Received(bytes_read);
 
-        //Test second character of magic - 'R'
-        if(header.pkt_magic[1] != 'R')
+        //Handle every complete request received, select functionality based on request ID
+        while((result = reader.ReadPacket(header, data)) == NET_PACKET_READER_PACKET)
         {
-            continue;
-        }
+            /*-------------------------------------------------*\
+            | Replies to requests sent with a callback go to    |
+            | the callback, the rest are handled here           |
+            \*-------------------------------------------------*/
+            NetworkClientRequest    request;
+            bool                    tracked = TakeRequest(header.pkt_id, header.pkt_dev_idx, request);
 
-        //Read third byte of magic
-        bytes_read = recv_select(client_sock, &header.pkt_magic[2], 1, 0);
+            if(tracked && ((request.callback != NULL) || request.cancelled))
+            {
+                if(request.callback != NULL)
+                {
+                    request.callback(request.callback_arg, request.request_id, request.dev_idx, header.pkt_size, data);
+                }
 
-        if(bytes_read <= 0)
-        {
-            goto listen_done;
-        }
+                FinishRequest();
+                continue;
+            }
 
-        //Test third character of magic - 'G'
-        if(header.pkt_magic[2] != 'G')
-        {
-            continue;
-        }
+            switch(header.pkt_id)
+            {
+                case NET_PACKET_ID_REQUEST_CONTROLLER_COUNT:
+                    ProcessReply_ControllerCount(header.pkt_size, data);
+                    break;
 
-        //Read fourth byte of magic
-        bytes_read = recv_select(client_sock, &header.pkt_magic[3], 1, 0);
+                case NET_PACKET_ID_REQUEST_CONTROLLER_DATA:
+                    ProcessReply_ControllerData(header.pkt_size, data, header.pkt_dev_idx);
+                    break;
 
-        if(bytes_read <= 0)
-        {
-            goto listen_done;
-        }
+                case NET_PACKET_ID_REQUEST_PROTOCOL_VERSION:
+                    ProcessReply_ProtocolVersion(header.pkt_size, data);
+                    break;
 
-        //Test fourth character of magic - 'B'
-        if(header.pkt_magic[3] != 'B')
-        {
-            continue;
-        }
+                case NET_PACKET_ID_DEVICE_LIST_UPDATED:
+                    ProcessRequest_DeviceListChanged();
+                    break;
 
-        //If we get to this point, the magic is correct.  Read the rest of the header
-        bytes_read = 0;
-        do
-        {
-            int tmp_bytes_read = 0;
+                case NET_PACKET_ID_DEVICE_COLORS_UPDATED:
+                    ProcessRequest_DeviceColorsUpdated(header.pkt_size, data);
+                    break;
 
-            tmp_bytes_read = recv_select(client_sock, (char *)&header.pkt_dev_idx + bytes_read, sizeof(header) - sizeof(header.pkt_magic) - bytes_read, 0);
+                case NET_PACKET_ID_DEVICE_LIST_DIFF:
+                    ProcessRequest_DeviceListDiff(header.pkt_size, data);
+                    break;
 
-            bytes_read += tmp_bytes_read;
+                case NET_PACKET_ID_REQUEST_DEVICE_IDS:
+                    ProcessReply_DeviceIDs(header.pkt_size, data);
+                    break;
 
-            if(tmp_bytes_read <= 0)
-            {
-                goto listen_done;
+                case NET_PACKET_ID_REQUEST_UDP_CHANNEL:
+                    ProcessReply_UDPChannel(header.pkt_size, data);
+                    break;
             }
 
-        } while(bytes_read != sizeof(header) - sizeof(header.pkt_magic));
-
-        //Header received, now receive the data
-        if(header.pkt_size > 0)
-        {
-            bytes_read = 0;
-
-            data = new char[header.pkt_size];
-
-            do
+            if(tracked)
             {
-                int tmp_bytes_read = 0;
-
-                tmp_bytes_read = recv_select(client_sock, &data[(unsigned int)bytes_read], header.pkt_size - bytes_read, 0);
-
-                if(tmp_bytes_read <= 0)
-                {
-                    goto listen_done;
-                }
-                bytes_read += tmp_bytes_read;
-
-            } while ((unsigned int)bytes_read < header.pkt_size);
+                FinishRequest();
+            }
         }
 
-        //Entire request received, select functionality based on request ID
-        switch(header.pkt_id)
+        if(result == NET_PACKET_READER_ERROR)
         {
-            case NET_PACKET_ID_REQUEST_CONTROLLER_COUNT:
-                ProcessReply_ControllerCount(header.pkt_size, data);
-                break;
-
-            case NET_PACKET_ID_REQUEST_CONTROLLER_DATA:
-                ProcessReply_ControllerData(header.pkt_size, data, header.pkt_dev_idx);
-                break;
-
-            case NET_PACKET_ID_REQUEST_PROTOCOL_VERSION:
-                ProcessReply_ProtocolVersion(header.pkt_size, data);
-                break;
-
-            case NET_PACKET_ID_DEVICE_LIST_UPDATED:
-                ProcessRequest_DeviceListChanged();
-                break;
+            goto listen_done;
         }
-
-        delete[] data;
     }
 
 listen_done:
@@ -476,6 +639,10 @@ listen_done:
     server_initialized = false;
     server_connected = false;
 
+    FailRequests();
+
+    CloseUDPChannel();
+
     ControllerListMutex.lock();
 
     for(size_t server_controller_idx = 0; server_controller_idx < server_controllers.size(); server_controller_idx++)
@@ -507,101 +674,716 @@ listen_done:
     ClientInfoChanged();
 }
 
-void NetworkClient::WaitOnControllerData()
+/*---------------------------------------------------------*\
+| Sends a request and queues it to be matched with its      |
+| reply.  The queue is added to while sending, so it is in  |
+| the order the server receives the requests.               |
+\*---------------------------------------------------------*/
+unsigned int NetworkClient::SendRequestAsync(unsigned int pkt_id, unsigned int dev_idx, const void * data, unsigned int size, NetClientReplyCallback callback, void * callback_arg)
 {
-    for(int i = 0; i < 1000; i++)
+    NetPacketHeader         request_hdr;
+    NetworkClientRequest    request;
+
+    if(!server_connected)
+    {
+        return(0);
+    }
+
+    request_hdr.pkt_magic[0] = 'O';
+    request_hdr.pkt_magic[1] = 'R';
+    request_hdr.pkt_magic[2] = 'G';
+    request_hdr.pkt_magic[3] = 'B';
+
+    request_hdr.pkt_dev_idx  = dev_idx;
+    request_hdr.pkt_id       = pkt_id;
+    request_hdr.pkt_size     = size;
+
+    request.pkt_id           = pkt_id;
+    request.dev_idx          = dev_idx;
+    request.callback         = callback;
+    request.callback_arg     = callback_arg;
+    request.cancelled        = false;
+
+    SendMutex.lock();
+
+    RequestMutex.lock();
+
+    request.request_id       = next_request_id++;
+
+    if(next_request_id == 0)
+    {
+        next_request_id = 1;
+    }
+
+    PendingRequests.push_back(request);
+
+    RequestMutex.unlock();
+
+    bool result = writer.SendPacket(client_sock, &request_hdr, data, size);
+
+    SendMutex.unlock();
+
+    /*-----------------------------------------------------*\
+    | No reply will come if the request was not sent        |
+    \*-----------------------------------------------------*/
+    if(!result)
     {
-        if(controller_data_received)
+        RequestMutex.lock();
+
+        for(std::size_t pending_idx = 0; pending_idx < PendingRequests.size(); pending_idx++)
         {
-            break;
+            if(PendingRequests[pending_idx].request_id == request.request_id)
+            {
+                PendingRequests.erase(PendingRequests.begin() + pending_idx);
+                break;
+            }
         }
-        std::this_thread::sleep_for(1ms);
+
+        RequestMutex.unlock();
+
+        return(0);
     }
 
-    return;
+    return(request.request_id);
 }
 
-void NetworkClient::ProcessReply_ControllerCount(unsigned int data_size, char * data)
+bool NetworkClient::WaitOnRequest(unsigned int request_id, unsigned int timeout_ms)
 {
-    if(data_size == sizeof(unsigned int))
+    if(request_id == 0)
     {
-        memcpy(&server_controller_count, data, sizeof(unsigned int));
-        server_controller_count_received = true;
+        return(false);
     }
-}
-
-void NetworkClient::ProcessReply_ControllerData(unsigned int /*data_size*/, char * data, unsigned int dev_idx)
-{
-    RGBController_Network * new_controller   = new RGBController_Network(this, dev_idx);
 
-    new_controller->ReadDeviceDescription((unsigned char *)data, GetProtocolVersion());
+    std::unique_lock<std::mutex> request_lock(RequestMutex);
 
-    ControllerListMutex.lock();
-
-    if(dev_idx >= server_controllers.size())
+    if(RequestCV.wait_for(request_lock, std::chrono::milliseconds(timeout_ms), [&]{ return(!RequestPending(request_id)); }))
     {
-        server_controllers.push_back(new_controller);
+        return(true);
     }
-    else
+
+    /*-----------------------------------------------------*\
+    | Timed out.  The caller may free the callback argument |
+    | once this returns, so drop the callback, and if it is |
+    | already running wait for it to finish                 |
+    \*-----------------------------------------------------*/
+    for(std::size_t pending_idx = 0; pending_idx < PendingRequests.size(); pending_idx++)
     {
-        server_controllers[dev_idx]->active_mode = new_controller->active_mode;
-        delete new_controller;
+        NetworkClientRequest& request = PendingRequests[pending_idx];
+
+        if((request.request_id == request_id) && (request.callback != NULL))
+        {
+            request.callback  = NULL;
+            request.cancelled = true;
+        }
     }
 
-    ControllerListMutex.unlock();
+    RequestCV.wait(request_lock, [&]{ return(active_request_id != request_id); });
 
-    controller_data_received = true;
+    return(false);
 }
 
-void NetworkClient::ProcessReply_ProtocolVersion(unsigned int data_size, char * data)
+/*---------------------------------------------------------*\
+| Must be called with RequestMutex held                     |
+\*---------------------------------------------------------*/
+bool NetworkClient::RequestPending(unsigned int request_id)
 {
-    if(data_size == sizeof(unsigned int))
+    if(active_request_id == request_id)
     {
-        memcpy(&server_protocol_version, data, sizeof(unsigned int));
-        server_protocol_version_received = true;
+        return(true);
     }
+
+    for(std::size_t pending_idx = 0; pending_idx < PendingRequests.size(); pending_idx++)
+    {
+        if(PendingRequests[pending_idx].request_id == request_id)
+        {
+            return(true);
+        }
+    }
+
+    return(false);
 }
 
-void NetworkClient::ProcessRequest_DeviceListChanged()
+/*---------------------------------------------------------*\
+| Finds the request a reply answers.  Requests sent before  |
+| it are failed, as the server would have answered them     |
+| first.  Returns false if the packet answers no request.   |
+| FinishRequest must be called once the reply is handled.   |
+\*---------------------------------------------------------*/
+bool NetworkClient::TakeRequest(unsigned int pkt_id, unsigned int dev_idx, NetworkClientRequest& request)
 {
-    change_in_progress = true;
+    std::unique_lock<std::mutex> request_lock(RequestMutex);
 
-    ControllerListMutex.lock();
+    bool found = false;
 
-    for(size_t server_controller_idx = 0; server_controller_idx < server_controllers.size(); server_controller_idx++)
+    for(std::size_t pending_idx = 0; pending_idx < PendingRequests.size(); pending_idx++)
     {
-        for(size_t controller_idx = 0; controller_idx < controllers.size(); controller_idx++)
+        if((PendingRequests[pending_idx].pkt_id == pkt_id) && (PendingRequests[pending_idx].dev_idx == dev_idx))
         {
-            if(controllers[controller_idx] == server_controllers[server_controller_idx])
-            {
-                controllers.erase(controllers.begin() + controller_idx);
-                break;
-            }
+            found = true;
+            break;
         }
     }
 
-    std::vector<RGBController *> server_controllers_copy = server_controllers;
+    while(found)
+    {
+        request = PendingRequests.front();
+        PendingRequests.pop_front();
 
-    server_controllers.clear();
+        active_request_id = request.request_id;
 
-    for(size_t server_controller_idx = 0; server_controller_idx < server_controllers_copy.size(); server_controller_idx++)
-    {
-        delete server_controllers_copy[server_controller_idx];
-    }
+        if((request.pkt_id == pkt_id) && (request.dev_idx == dev_idx))
+        {
+            break;
+        }
 
-    ControllerListMutex.unlock();
+        if(request.callback != NULL)
+        {
+            request_lock.unlock();
+            request.callback(request.callback_arg, request.request_id, request.dev_idx, 0, NULL);
+            request_lock.lock();
+        }
 
-    /*-------------------------------------------------*\
-    | Client info has changed, call the callbacks       |
-    \*-------------------------------------------------*/
-    ClientInfoChanged();
+        active_request_id = 0;
 
-    /*-------------------------------------------------*\
-    | Mark server as uninitialized and delete the list  |
-    \*-------------------------------------------------*/
-    server_initialized = false;
+        RequestCV.notify_all();
+    }
 
-    change_in_progress = false;
+    return(found);
+}
+
+void NetworkClient::FinishRequest()
+{
+    RequestMutex.lock();
+    active_request_id = 0;
+    RequestMutex.unlock();
+
+    RequestCV.notify_all();
+}
+
+/*---------------------------------------------------------*\
+| Fails every outstanding request when the connection is    |
+| lost                                                      |
+\*---------------------------------------------------------*/
+void NetworkClient::FailRequests()
+{
+    std::unique_lock<std::mutex> request_lock(RequestMutex);
+
+    while(!PendingRequests.empty())
+    {
+        NetworkClientRequest request = PendingRequests.front();
+        PendingRequests.pop_front();
+
+        active_request_id = request.request_id;
+
+        if(request.callback != NULL)
+        {
+            request_lock.unlock();
+            request.callback(request.callback_arg, request.request_id, request.dev_idx, 0, NULL);
+            request_lock.lock();
+        }
+
+        active_request_id = 0;
+
+        RequestCV.notify_all();
+    }
+}
+
+void NetworkClient::SyncControllerDataCallback(void * callback_arg, unsigned int /*request_id*/, unsigned int dev_idx, unsigned int data_size, char * data)
+{
+    NetworkClient * client = (NetworkClient *)callback_arg;
+
+    if((data == NULL) || (dev_idx >= client->sync_controllers.size()))
+    {
+        return;
+    }
+
+    RGBController_Network * new_controller = new RGBController_Network(client, dev_idx);
+
+    if(!new_controller->ReadDeviceDescription((unsigned char *)data, data_size, client->GetProtocolVersion()))
+    {
+        delete new_controller;
+        return;
+    }
+
+    client->sync_controllers[dev_idx] = new_controller;
+}
+
+bool NetworkClient::GetControllerStats(unsigned int dev_idx, RGBControllerStats& stats)
+{
+    /*---------------------------------------------------------*\
+    | Statistics were added in protocol 4                       |
+    \*---------------------------------------------------------*/
+    if(GetProtocolVersion() < 4)
+    {
+        return(false);
+    }
+
+    NetworkClientStatsReply reply;
+
+    reply.received = false;
+
+    WaitOnRequest(SendRequestAsync(NET_PACKET_ID_RGBCONTROLLER_GETSTATS, dev_idx, NULL, 0, ControllerStatsCallback, &reply), 1000);
+
+    if(reply.received)
+    {
+        stats = reply.stats;
+    }
+
+    return(reply.received);
+}
+
+void NetworkClient::ProcessReply_ControllerCount(unsigned int data_size, char * data)
+{
+    if(data_size == sizeof(unsigned int))
+    {
+        memcpy(&server_controller_count, data, sizeof(unsigned int));
+        server_controller_count_received = true;
+    }
+}
+
+void NetworkClient::ProcessReply_ControllerData(unsigned int data_size, char * data, unsigned int dev_idx)
+{
+    RGBController_Network * new_controller   = new RGBController_Network(this, dev_idx);
+
+    /*---------------------------------------------------------*\
+    | Drop a malformed description rather than adding a         |
+    | partially read controller                                 |
+    \*---------------------------------------------------------*/
+    if(!new_controller->ReadDeviceDescription((unsigned char *)data, data_size, GetProtocolVersion()))
+    {
+        delete new_controller;
+        return;
+    }
+
+    ControllerListMutex.lock();
+
+    if(dev_idx >= server_controllers.size())
+    {
+        server_controllers.push_back(new_controller);
+    }
+    else
+    {
+        server_controllers[dev_idx]->active_mode = new_controller->active_mode;
+        delete new_controller;
+    }
+
+    ControllerListMutex.unlock();
+}
+
+void NetworkClient::ProcessReply_UDPChannel(unsigned int data_size, char * data)
+{
+    if(data_size == (sizeof(unsigned short) + sizeof(unsigned int)))
+    {
+        memcpy(&udp_port, data, sizeof(unsigned short));
+        memcpy(&udp_token, data + sizeof(unsigned short), sizeof(unsigned int));
+    }
+    else
+    {
+        udp_port = 0;
+    }
+
+    udp_reply_received = true;
+}
+
+void NetworkClient::ProcessReply_DeviceIDs(unsigned int data_size, char * data)
+{
+    RGBControllerBufferReader reader((const unsigned char *)data, data_size);
+
+    unsigned int list_seq;
+    unsigned int num_devices;
+
+    reader.Skip(sizeof(unsigned int));
+    reader.Read(list_seq);
+    reader.Read(num_devices);
+
+    if(reader.Failed() || !reader.CanRead(num_devices, sizeof(unsigned int)))
+    {
+        return;
+    }
+
+    ControllerListMutex.lock();
+
+    server_controller_ids.resize(num_devices);
+    server_device_list_seq = list_seq;
+
+    reader.Read(server_controller_ids.data(), num_devices * sizeof(unsigned int));
+
+    ControllerListMutex.unlock();
+}
+
+void NetworkClient::ProcessReply_ProtocolVersion(unsigned int data_size, char * data)
+{
+    if(data_size == sizeof(unsigned int))
+    {
+        memcpy(&server_protocol_version, data, sizeof(unsigned int));
+        server_protocol_version_received = true;
+    }
+}
+
+void NetworkClient::ProcessRequest_DeviceListChanged()
+{
+    change_in_progress = true;
+
+    ControllerListMutex.lock();
+
+    for(size_t server_controller_idx = 0; server_controller_idx < server_controllers.size(); server_controller_idx++)
+    {
+        for(size_t controller_idx = 0; controller_idx < controllers.size(); controller_idx++)
+        {
+            if(controllers[controller_idx] == server_controllers[server_controller_idx])
+            {
+                controllers.erase(controllers.begin() + controller_idx);
+                break;
+            }
+        }
+    }
+
+    std::vector<RGBController *> server_controllers_copy = server_controllers;
+
+    server_controllers.clear();
+    server_controller_ids.clear();
+
+    for(size_t server_controller_idx = 0; server_controller_idx < server_controllers_copy.size(); server_controller_idx++)
+    {
+        delete server_controllers_copy[server_controller_idx];
+    }
+
+    ControllerListMutex.unlock();
+
+    /*-------------------------------------------------*\
+    | Client info has changed, call the callbacks       |
+    \*-------------------------------------------------*/
+    ClientInfoChanged();
+
+    /*-------------------------------------------------*\
+    | Mark server as uninitialized and delete the list  |
+    \*-------------------------------------------------*/
+    server_initialized = false;
+
+    change_in_progress = false;
+}
+
+/*---------------------------------------------------------*\
+| Applies a device list diff.  Added and changed devices    |
+| are created from the descriptions in the diff, the others |
+| are kept and only moved to their new index, so a single   |
+| device change does not fetch every description again.     |
+| If the diff does not follow on from the list this client  |
+| has, the whole list is fetched instead.                   |
+\*---------------------------------------------------------*/
+void NetworkClient::ProcessRequest_DeviceListDiff(unsigned int data_size, char * data)
+{
+    RGBControllerBufferReader reader((const unsigned char *)data, data_size);
+
+    std::map<unsigned int, RGBController *> new_controllers;
+    std::vector<unsigned int>               device_ids;
+    unsigned int                            old_list_seq;
+    unsigned int                            new_list_seq;
+    unsigned short                          num_removed;
+    unsigned int                            num_devices;
+    bool                                    valid = server_initialized;
+
+    reader.Skip(sizeof(unsigned int));
+    reader.Read(old_list_seq);
+    reader.Read(new_list_seq);
+
+    /*-----------------------------------------------------*\
+    | Removed devices are the ones missing from the new     |
+    | order, so their IDs are not needed here               |
+    \*-----------------------------------------------------*/
+    reader.Read(num_removed);
+    reader.Skip(num_removed * sizeof(unsigned int));
+
+    /*-----------------------------------------------------*\
+    | Read the added devices, then the changed devices      |
+    \*-----------------------------------------------------*/
+    for(unsigned int list_idx = 0; valid && (list_idx < 2); list_idx++)
+    {
+        unsigned short num_described = 0;
+
+        reader.Read(num_described);
+
+        for(unsigned short described_idx = 0; valid && (described_idx < num_described); described_idx++)
+        {
+            unsigned int    device_id;
+            unsigned int    desc_size;
+
+            reader.Read(device_id);
+
+            std::size_t     desc_offset = reader.GetPosition();
+
+            reader.Read(desc_size);
+
+            if(reader.Failed() || (desc_size < sizeof(desc_size)) || !reader.Skip(desc_size - sizeof(desc_size))
+            || (new_controllers.find(device_id) != new_controllers.end()))
+            {
+                valid = false;
+                break;
+            }
+
+            RGBController_Network * new_controller = new RGBController_Network(this, 0);
+
+            if(!new_controller->ReadDeviceDescription((unsigned char *)data + desc_offset, desc_size, GetProtocolVersion()))
+            {
+                delete new_controller;
+
+                valid = false;
+                break;
+            }
+
+            new_controllers[device_id] = new_controller;
+        }
+    }
+
+    reader.Read(num_devices);
+
+    if(valid && !reader.Failed() && reader.CanRead(num_devices, sizeof(unsigned int)))
+    {
+        device_ids.resize(num_devices);
+
+        reader.Read(device_ids.data(), num_devices * sizeof(unsigned int));
+    }
+    else
+    {
+        valid = false;
+    }
+
+    ControllerListMutex.lock();
+
+    /*-----------------------------------------------------*\
+    | Build the new list from the new and kept controllers  |
+    \*-----------------------------------------------------*/
+    std::vector<RGBController *>    new_list;
+    std::set<unsigned int>          listed_ids;
+
+    valid = valid && (old_list_seq == server_device_list_seq) && (server_controller_ids.size() == server_controllers.size());
+
+    for(std::size_t dev_idx = 0; valid && (dev_idx < device_ids.size()); dev_idx++)
+    {
+        unsigned int device_id = device_ids[dev_idx];
+
+        if(!listed_ids.insert(device_id).second)
+        {
+            valid = false;
+            break;
+        }
+
+        std::map<unsigned int, RGBController *>::iterator new_it = new_controllers.find(device_id);
+
+        if(new_it != new_controllers.end())
+        {
+            new_list.push_back(new_it->second);
+            continue;
+        }
+
+        std::vector<unsigned int>::iterator old_it = std::find(server_controller_ids.begin(), server_controller_ids.end(), device_id);
+
+        if(old_it == server_controller_ids.end())
+        {
+            valid = false;
+            break;
+        }
+
+        new_list.push_back(server_controllers[old_it - server_controller_ids.begin()]);
+    }
+
+    if(!valid)
+    {
+        ControllerListMutex.unlock();
+
+        for(std::map<unsigned int, RGBController *>::iterator new_it = new_controllers.begin(); new_it != new_controllers.end(); new_it++)
+        {
+            delete new_it->second;
+        }
+
+        ProcessRequest_DeviceListChanged();
+        return;
+    }
+
+    change_in_progress = true;
+
+    /*-----------------------------------------------------*\
+    | Take the old controllers out of the master list and   |
+    | delete those that were removed or replaced            |
+    \*-----------------------------------------------------*/
+    for(std::size_t server_controller_idx = 0; server_controller_idx < server_controllers.size(); server_controller_idx++)
+    {
+        RGBController * old_controller = server_controllers[server_controller_idx];
+
+        std::vector<RGBController *>::iterator controller_it = std::find(controllers.begin(), controllers.end(), old_controller);
+
+        if(controller_it != controllers.end())
+        {
+            controllers.erase(controller_it);
+        }
+
+        if(std::find(new_list.begin(), new_list.end(), old_controller) == new_list.end())
+        {
+            delete old_controller;
+        }
+    }
+
+    server_controllers     = new_list;
+    server_controller_ids  = device_ids;
+    server_device_list_seq = new_list_seq;
+
+    for(std::size_t server_controller_idx = 0; server_controller_idx < server_controllers.size(); server_controller_idx++)
+    {
+        ((RGBController_Network *)server_controllers[server_controller_idx])->SetDeviceIndex((unsigned int)server_controller_idx);
+
+        controllers.push_back(server_controllers[server_controller_idx]);
+    }
+
+    server_controller_count = (unsigned int)server_controllers.size();
+
+    ControllerListMutex.unlock();
+
+    change_in_progress = false;
+
+    /*-------------------------------------------------*\
+    | Client info has changed, call the callbacks       |
+    \*-------------------------------------------------*/
+    ClientInfoChanged();
+
+    /*-------------------------------------------------*\
+    | The server ended the color subscription as device |
+    | indices changed, subscribe again                  |
+    \*-------------------------------------------------*/
+    if(color_subscription_rate > 0)
+    {
+        SubscribeColors();
+    }
+}
+
+/*---------------------------------------------------------*\
+| Applies the colors the server sent for subscribed devices |
+| and signals an update on each, without sending them back. |
+| The packet is laid out as in MULTIUPDATELEDS.             |
+\*---------------------------------------------------------*/
+void NetworkClient::ProcessRequest_DeviceColorsUpdated(unsigned int data_size, char * data)
+{
+    RGBControllerBufferReader reader((const unsigned char *)data, data_size);
+
+    unsigned short num_devices;
+
+    reader.Skip(sizeof(unsigned int));
+    reader.Read(num_devices);
+
+    ControllerListMutex.lock();
+
+    for(unsigned short device_idx = 0; device_idx < num_devices; device_idx++)
+    {
+        unsigned int    dev_idx;
+        unsigned int    color_size;
+
+        reader.Read(dev_idx);
+
+        std::size_t     color_offset = reader.GetPosition();
+
+        reader.Read(color_size);
+
+        if(reader.Failed() || (color_size < sizeof(color_size)) || !reader.Skip(color_size - sizeof(color_size)))
+        {
+            break;
+        }
+
+        if((dev_idx < server_controllers.size())
+        && server_controllers[dev_idx]->SetColorDescription((const unsigned char *)data + color_offset, color_size))
+        {
+            server_controllers[dev_idx]->SignalUpdate();
+        }
+    }
+
+    ControllerListMutex.unlock();
+}
+
+void NetworkClient::StartBatch()
+{
+    SendMutex.lock();
+    writer.StartBatch();
+    SendMutex.unlock();
+}
+
+void NetworkClient::FinishBatch()
+{
+    SendMutex.lock();
+    writer.FinishBatch(client_sock);
+    SendMutex.unlock();
+}
+
+/*---------------------------------------------------------*\
+| Sends the current colors of several server devices.  A    |
+| protocol 5 server gets them in one packet and updates the |
+| devices together, older servers get one UpdateLEDs packet |
+| per device in a single batch.                             |
+\*---------------------------------------------------------*/
+void NetworkClient::UpdateControllerLEDs(const std::vector<unsigned int>& dev_idxs)
+{
+    ControllerListMutex.lock();
+
+    if(GetProtocolVersion() >= 5)
+    {
+        RGBControllerBufferWriter update_writer(multi_update_buf);
+        unsigned short            num_devices = 0;
+
+        update_writer.Write((unsigned int)0);
+        update_writer.Write(num_devices);
+
+        for(std::size_t idx = 0; idx < dev_idxs.size(); idx++)
+        {
+            unsigned int dev_idx = dev_idxs[idx];
+
+            if(dev_idx >= server_controllers.size())
+            {
+                continue;
+            }
+
+            RGBController * controller = server_controllers[dev_idx];
+            unsigned short  num_colors = (unsigned short)controller->colors.size();
+            unsigned int    color_size = sizeof(color_size) + sizeof(num_colors) + (num_colors * sizeof(RGBColor));
+
+            update_writer.Write(dev_idx);
+            update_writer.Write(color_size);
+            update_writer.Write(num_colors);
+            update_writer.Write(controller->colors.data(), num_colors * sizeof(RGBColor));
+
+            num_devices++;
+        }
+
+        update_writer.Patch(0, (unsigned int)update_writer.GetSize());
+        update_writer.Patch(sizeof(unsigned int), num_devices);
+
+        SendRequest_RGBController_MultiUpdateLEDs(update_writer.GetData(), (unsigned int)update_writer.GetSize());
+    }
+    else
+    {
+        StartBatch();
+
+        for(std::size_t idx = 0; idx < dev_idxs.size(); idx++)
+        {
+            if(dev_idxs[idx] < server_controllers.size())
+            {
+                server_controllers[dev_idxs[idx]]->UpdateLEDs();
+            }
+        }
+
+        FinishBatch();
+    }
+
+    ControllerListMutex.unlock();
+}
+
+/*---------------------------------------------------------*\
+| Sends a packet's header and data in one write.  The lock  |
+| keeps packets from different threads from interleaving.   |
+\*---------------------------------------------------------*/
+bool NetworkClient::SendPacket(NetPacketHeader * header, const void * data, unsigned int size)
+{
+    SendMutex.lock();
+    bool result = writer.SendPacket(client_sock, header, data, size);
+    SendMutex.unlock();
+
+    return(result);
 }
 
 void NetworkClient::SendData_ClientString()
@@ -617,73 +1399,65 @@ void NetworkClient::SendData_ClientString()
     reply_hdr.pkt_id       = NET_PACKET_ID_SET_CLIENT_NAME;
     reply_hdr.pkt_size     = strlen(client_name.c_str()) + 1;
 
-    send(client_sock, (char *)&reply_hdr, sizeof(NetPacketHeader), MSG_NOSIGNAL);
-    send(client_sock, (char *)client_name.c_str(), reply_hdr.pkt_size, MSG_NOSIGNAL);
+    SendPacket(&reply_hdr, client_name.c_str(), reply_hdr.pkt_size);
 }
 
-void NetworkClient::SendRequest_ControllerCount()
+unsigned int NetworkClient::SendRequest_ControllerCount()
 {
-    NetPacketHeader request_hdr;
-
-    request_hdr.pkt_magic[0] = 'O';
-    request_hdr.pkt_magic[1] = 'R';
-    request_hdr.pkt_magic[2] = 'G';
-    request_hdr.pkt_magic[3] = 'B';
-
-    request_hdr.pkt_dev_idx  = 0;
-    request_hdr.pkt_id       = NET_PACKET_ID_REQUEST_CONTROLLER_COUNT;
-    request_hdr.pkt_size     = 0;
+    return(SendRequestAsync(NET_PACKET_ID_REQUEST_CONTROLLER_COUNT, 0, NULL, 0, NULL, NULL));
+}
 
-    send(client_sock, (char *)&request_hdr, sizeof(NetPacketHeader), MSG_NOSIGNAL);
+unsigned int NetworkClient::SendRequest_ControllerData(unsigned int dev_idx)
+{
+    return(SendRequestAsync_ControllerData(dev_idx, NULL, NULL));
 }
 
-void NetworkClient::SendRequest_ControllerData(unsigned int dev_idx)
+unsigned int NetworkClient::SendRequestAsync_ControllerData(unsigned int dev_idx, NetClientReplyCallback callback, void * callback_arg)
 {
-    NetPacketHeader request_hdr;
     unsigned int    protocol_version;
 
-    controller_data_received = false;
-
-    request_hdr.pkt_magic[0] = 'O';
-    request_hdr.pkt_magic[1] = 'R';
-    request_hdr.pkt_magic[2] = 'G';
-    request_hdr.pkt_magic[3] = 'B';
-
-    request_hdr.pkt_dev_idx  = dev_idx;
-    request_hdr.pkt_id       = NET_PACKET_ID_REQUEST_CONTROLLER_DATA;
-
     if(server_protocol_version == 0)
     {
-        request_hdr.pkt_size     = 0;
+        return(SendRequestAsync(NET_PACKET_ID_REQUEST_CONTROLLER_DATA, dev_idx, NULL, 0, callback, callback_arg));
+    }
 
-        send(client_sock, (char *)&request_hdr, sizeof(NetPacketHeader), MSG_NOSIGNAL);
+    /*-------------------------------------------------------------*\
+    | Limit the protocol version to the highest supported by both   |
+    | the client and the server.                                    |
+    \*-------------------------------------------------------------*/
+    if(server_protocol_version > OPENRGB_SDK_PROTOCOL_VERSION)
+    {
+        protocol_version = OPENRGB_SDK_PROTOCOL_VERSION;
     }
     else
     {
-        request_hdr.pkt_size     = sizeof(unsigned int);
+        protocol_version = server_protocol_version;
+    }
 
-        /*-------------------------------------------------------------*\
-        | Limit the protocol version to the highest supported by both   |
-        | the client and the server.                                    |
-        \*-------------------------------------------------------------*/
-        if(server_protocol_version > OPENRGB_SDK_PROTOCOL_VERSION)
-        {
-            protocol_version = OPENRGB_SDK_PROTOCOL_VERSION;
-        }
-        else
-        {
-            protocol_version = server_protocol_version;
-        }
+    return(SendRequestAsync(NET_PACKET_ID_REQUEST_CONTROLLER_DATA, dev_idx, &protocol_version, sizeof(unsigned int), callback, callback_arg));
+}
 
-        send(client_sock, (char *)&request_hdr, sizeof(NetPacketHeader), MSG_NOSIGNAL);
-        send(client_sock, (char *)&protocol_version, sizeof(unsigned int), MSG_NOSIGNAL);
-    }
+unsigned int NetworkClient::SendRequest_UDPChannel()
+{
+    return(SendRequestAsync(NET_PACKET_ID_REQUEST_UDP_CHANNEL, 0, NULL, 0, NULL, NULL));
 }
 
-void NetworkClient::SendRequest_ProtocolVersion()
+void NetworkClient::SendRequest_ColorSubscription(const std::vector<unsigned int>& dev_idxs, unsigned int max_rate)
 {
-    NetPacketHeader request_hdr;
-    unsigned int    request_data;
+    NetPacketHeader             request_hdr;
+    std::vector<unsigned char>  request_data;
+    RGBControllerBufferWriter   request_writer(request_data);
+
+    request_writer.Write((unsigned int)0);
+    request_writer.Write(max_rate);
+    request_writer.Write((unsigned short)dev_idxs.size());
+
+    for(std::size_t idx = 0; idx < dev_idxs.size(); idx++)
+    {
+        request_writer.Write(dev_idxs[idx]);
+    }
+
+    request_writer.Patch(0, (unsigned int)request_writer.GetSize());
 
     request_hdr.pkt_magic[0] = 'O';
     request_hdr.pkt_magic[1] = 'R';
@@ -691,13 +1465,22 @@ void NetworkClient::SendRequest_ProtocolVersion()
     request_hdr.pkt_magic[3] = 'B';
 
     request_hdr.pkt_dev_idx  = 0;
-    request_hdr.pkt_id       = NET_PACKET_ID_REQUEST_PROTOCOL_VERSION;
-    request_hdr.pkt_size     = sizeof(unsigned int);
+    request_hdr.pkt_id       = NET_PACKET_ID_REQUEST_COLOR_SUBSCRIPTION;
+    request_hdr.pkt_size     = (unsigned int)request_writer.GetSize();
 
-    request_data             = OPENRGB_SDK_PROTOCOL_VERSION;
+    SendPacket(&request_hdr, request_writer.GetData(), request_hdr.pkt_size);
+}
 
-    send(client_sock, (char *)&request_hdr, sizeof(NetPacketHeader), MSG_NOSIGNAL);
-    send(client_sock, (char *)&request_data, sizeof(unsigned int), MSG_NOSIGNAL);
+unsigned int NetworkClient::SendRequest_DeviceIDs()
+{
+    return(SendRequestAsync(NET_PACKET_ID_REQUEST_DEVICE_IDS, 0, NULL, 0, NULL, NULL));
+}
+
+unsigned int NetworkClient::SendRequest_ProtocolVersion()
+{
+    unsigned int    request_data = OPENRGB_SDK_PROTOCOL_VERSION;
+
+    return(SendRequestAsync(NET_PACKET_ID_REQUEST_PROTOCOL_VERSION, 0, &request_data, sizeof(unsigned int), NULL, NULL));
 }
 
 void NetworkClient::SendRequest_RGBController_ResizeZone(unsigned int dev_idx, int zone, int new_size)
@@ -722,8 +1505,12 @@ void NetworkClient::SendRequest_RGBController_ResizeZone(unsigned int dev_idx, i
     request_data[0]          = zone;
     request_data[1]          = new_size;
 
-    send(client_sock, (char *)&request_hdr, sizeof(NetPacketHeader), MSG_NOSIGNAL);
-    send(client_sock, (char *)&request_data, sizeof(request_data), MSG_NOSIGNAL);
+    SendPacket(&request_hdr, &request_data, sizeof(request_data));
+}
+
+unsigned int NetworkClient::SendRequest_RGBController_GetStats(unsigned int dev_idx)
+{
+    return(SendRequestAsync(NET_PACKET_ID_RGBCONTROLLER_GETSTATS, dev_idx, NULL, 0, NULL, NULL));
 }
 
 void NetworkClient::SendRequest_RGBController_UpdateLEDs(unsigned int dev_idx, unsigned char * data, unsigned int size)
@@ -744,8 +1531,7 @@ void NetworkClient::SendRequest_RGBController_UpdateLEDs(unsigned int dev_idx, u
     request_hdr.pkt_id       = NET_PACKET_ID_RGBCONTROLLER_UPDATELEDS;
     request_hdr.pkt_size     = size;
 
-    send(client_sock, (char *)&request_hdr, sizeof(NetPacketHeader), MSG_NOSIGNAL);
-    send(client_sock, (char *)data, size, 0);
+    SendPacket(&request_hdr, data, size);
 }
 
 void NetworkClient::SendRequest_RGBController_UpdateZoneLEDs(unsigned int dev_idx, unsigned char * data, unsigned int size)
@@ -766,8 +1552,7 @@ void NetworkClient::SendRequest_RGBController_UpdateZoneLEDs(unsigned int dev_id
     request_hdr.pkt_id       = NET_PACKET_ID_RGBCONTROLLER_UPDATEZONELEDS;
     request_hdr.pkt_size     = size;
 
-    send(client_sock, (char *)&request_hdr, sizeof(NetPacketHeader), MSG_NOSIGNAL);
-    send(client_sock, (char *)data, size, MSG_NOSIGNAL);
+    SendPacket(&request_hdr, data, size);
 }
 
 void NetworkClient::SendRequest_RGBController_UpdateSingleLED(unsigned int dev_idx, unsigned char * data, unsigned int size)
@@ -788,8 +1573,107 @@ void NetworkClient::SendRequest_RGBController_UpdateSingleLED(unsigned int dev_i
     request_hdr.pkt_id       = NET_PACKET_ID_RGBCONTROLLER_UPDATESINGLELED;
     request_hdr.pkt_size     = size;
 
-    send(client_sock, (char *)&request_hdr, sizeof(NetPacketHeader), MSG_NOSIGNAL);
-    send(client_sock, (char *)data, size, MSG_NOSIGNAL);
+    SendPacket(&request_hdr, data, size);
+}
+
+void NetworkClient::SendRequest_RGBController_MultiUpdateLEDs(unsigned char * data, unsigned int size)
+{
+    if(change_in_progress)
+    {
+        return;
+    }
+
+    NetPacketHeader request_hdr;
+
+    request_hdr.pkt_magic[0] = 'O';
+    request_hdr.pkt_magic[1] = 'R';
+    request_hdr.pkt_magic[2] = 'G';
+    request_hdr.pkt_magic[3] = 'B';
+
+    request_hdr.pkt_dev_idx  = 0;
+    request_hdr.pkt_id       = NET_PACKET_ID_RGBCONTROLLER_MULTIUPDATELEDS;
+    request_hdr.pkt_size     = size;
+
+    SendPacket(&request_hdr, data, size);
+}
+
+/*---------------------------------------------------------*\
+| Returns false if the frame was not sent, so the encoder   |
+| can start over with a keyframe                            |
+\*---------------------------------------------------------*/
+bool NetworkClient::SendRequest_RGBController_DeltaUpdateLEDs(unsigned int dev_idx, unsigned char * data, unsigned int size)
+{
+    if(change_in_progress)
+    {
+        return(false);
+    }
+
+    NetPacketHeader request_hdr;
+
+    request_hdr.pkt_magic[0] = 'O';
+    request_hdr.pkt_magic[1] = 'R';
+    request_hdr.pkt_magic[2] = 'G';
+    request_hdr.pkt_magic[3] = 'B';
+
+    request_hdr.pkt_dev_idx  = dev_idx;
+    request_hdr.pkt_id       = NET_PACKET_ID_RGBCONTROLLER_DELTAUPDATELEDS;
+    request_hdr.pkt_size     = size;
+
+    return(SendPacket(&request_hdr, data, size));
+}
+
+/*---------------------------------------------------------*\
+| Sends a full frame as one UDP datagram.  Returns false if |
+| it could not be sent, so the caller can use TCP instead.  |
+|                                                           |
+| One sequence number is counted up for all devices, so it  |
+| keeps counting up for a device even when the controller   |
+| objects are recreated after a device list change.         |
+\*---------------------------------------------------------*/
+bool NetworkClient::SendRequest_RGBController_UDPUpdateLEDs(unsigned int dev_idx, unsigned char * data, unsigned int size)
+{
+    if(change_in_progress || !udp_ready)
+    {
+        return(false);
+    }
+
+    NetPacketHeader request_hdr;
+
+    request_hdr.pkt_magic[0] = 'O';
+    request_hdr.pkt_magic[1] = 'R';
+    request_hdr.pkt_magic[2] = 'G';
+    request_hdr.pkt_magic[3] = 'B';
+
+    request_hdr.pkt_dev_idx  = dev_idx;
+    request_hdr.pkt_id       = NET_PACKET_ID_RGBCONTROLLER_UDPUPDATELEDS;
+    request_hdr.pkt_size     = sizeof(udp_token) + sizeof(udp_frame_seq) + size;
+
+    if((sizeof(NetPacketHeader) + request_hdr.pkt_size) > OPENRGB_SDK_UDP_MAX_SIZE)
+    {
+        return(false);
+    }
+
+    bool result = false;
+
+    UDPMutex.lock();
+
+    if(udp_sock != INVALID_SOCKET)
+    {
+        RGBControllerBufferWriter udp_writer(udp_buf);
+
+        udp_writer.Write(request_hdr);
+        udp_writer.Write(udp_token);
+        udp_frame_seq++;
+
+        udp_writer.Write(udp_frame_seq);
+        udp_writer.Write(data, size);
+
+        result = (send(udp_sock, (const char *)udp_writer.GetData(), (int)udp_writer.GetSize(), MSG_NOSIGNAL) == (int)udp_writer.GetSize());
+    }
+
+    UDPMutex.unlock();
+
+    return(result);
 }
 
 void NetworkClient::SendRequest_RGBController_SetCustomMode(unsigned int dev_idx)
@@ -810,7 +1694,7 @@ void NetworkClient::SendRequest_RGBController_SetCustomMode(unsigned int dev_idx
     request_hdr.pkt_id       = NET_PACKET_ID_RGBCONTROLLER_SETCUSTOMMODE;
     request_hdr.pkt_size     = 0;
 
-    send(client_sock, (char *)&request_hdr, sizeof(NetPacketHeader), MSG_NOSIGNAL);
+    SendPacket(&request_hdr, NULL, 0);
 }
 
 void NetworkClient::SendRequest_RGBController_UpdateMode(unsigned int dev_idx, unsigned char * data, unsigned int size)
@@ -831,8 +1715,7 @@ void NetworkClient::SendRequest_RGBController_UpdateMode(unsigned int dev_idx, u
     request_hdr.pkt_id       = NET_PACKET_ID_RGBCONTROLLER_UPDATEMODE;
     request_hdr.pkt_size     = size;
 
-    send(client_sock, (char *)&request_hdr, sizeof(NetPacketHeader), MSG_NOSIGNAL);
-    send(client_sock, (char *)data, size, MSG_NOSIGNAL);
+    SendPacket(&request_hdr, data, size);
 }
 
 void NetworkClient::SendRequest_RGBController_SaveMode(unsigned int dev_idx, unsigned char * data, unsigned int size)
@@ -853,8 +1736,7 @@ void NetworkClient::SendRequest_RGBController_SaveMode(unsigned int dev_idx, uns
     request_hdr.pkt_id       = NET_PACKET_ID_RGBCONTROLLER_SAVEMODE;
     request_hdr.pkt_size     = size;
 
-    send(client_sock, (char *)&request_hdr, sizeof(NetPacketHeader), MSG_NOSIGNAL);
-    send(client_sock, (char *)data, size, MSG_NOSIGNAL);
+    SendPacket(&request_hdr, data, size);
 }
 
 void NetworkClient::SendRequest_LoadProfile(std::string profile_name)
@@ -870,8 +1752,7 @@ void NetworkClient::SendRequest_LoadProfile(std::string profile_name)
     reply_hdr.pkt_id       = NET_PACKET_ID_REQUEST_LOAD_PROFILE;
     reply_hdr.pkt_size     = strlen(profile_name.c_str()) + 1;
 
-    send(client_sock, (char *)&reply_hdr, sizeof(NetPacketHeader), MSG_NOSIGNAL);
-    send(client_sock, (char *)profile_name.c_str(), reply_hdr.pkt_size, MSG_NOSIGNAL);
+    SendPacket(&reply_hdr, profile_name.c_str(), reply_hdr.pkt_size);
 }
 
 void NetworkClient::SendRequest_SaveProfile(std::string profile_name)
@@ -887,8 +1768,7 @@ void NetworkClient::SendRequest_SaveProfile(std::string profile_name)
     reply_hdr.pkt_id       = NET_PACKET_ID_REQUEST_SAVE_PROFILE;
     reply_hdr.pkt_size     = strlen(profile_name.c_str()) + 1;
 
-    send(client_sock, (char *)&reply_hdr, sizeof(NetPacketHeader), MSG_NOSIGNAL);
-    send(client_sock, (char *)profile_name.c_str(), reply_hdr.pkt_size, MSG_NOSIGNAL);
+    SendPacket(&reply_hdr, profile_name.c_str(), reply_hdr.pkt_size);
 }
 
 void NetworkClient::SendRequest_DeleteProfile(std::string profile_name)
@@ -904,24 +1784,12 @@ void NetworkClient::SendRequest_DeleteProfile(std::string profile_name)
     reply_hdr.pkt_id       = NET_PACKET_ID_REQUEST_DELETE_PROFILE;
     reply_hdr.pkt_size     = strlen(profile_name.c_str()) + 1;
 
-    send(client_sock, (char *)&reply_hdr, sizeof(NetPacketHeader), MSG_NOSIGNAL);
-    send(client_sock, (char *)profile_name.c_str(), reply_hdr.pkt_size, MSG_NOSIGNAL);
+    SendPacket(&reply_hdr, profile_name.c_str(), reply_hdr.pkt_size);
 }
 
-void NetworkClient::SendRequest_GetProfileList()
+unsigned int NetworkClient::SendRequest_GetProfileList()
 {
-    NetPacketHeader reply_hdr;
-
-    reply_hdr.pkt_magic[0] = 'O';
-    reply_hdr.pkt_magic[1] = 'R';
-    reply_hdr.pkt_magic[2] = 'G';
-    reply_hdr.pkt_magic[3] = 'B';
-
-    reply_hdr.pkt_dev_idx  = 0;
-    reply_hdr.pkt_id       = NET_PACKET_ID_REQUEST_PROFILE_LIST;
-    reply_hdr.pkt_size     = 0;
-
-    send(client_sock, (char *)&reply_hdr, sizeof(NetPacketHeader), MSG_NOSIGNAL);
+    return(SendRequestAsync(NET_PACKET_ID_REQUEST_PROFILE_LIST, 0, NULL, 0, NULL, NULL));
 }
 
 std::vector<std::string> * NetworkClient::ProcessReply_ProfileList(unsigned int data_size, char * data)
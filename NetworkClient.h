@@ -8,8 +8,12 @@
 
 #include "RGBController.h"
 #include "NetworkProtocol.h"
+#include "NetworkPacketWriter.h"
 #include "net_port.h"
 
+#include <atomic>
+#include <condition_variable>
+#include <deque>
 #include <mutex>
 #include <thread>
 
@@ -17,6 +21,26 @@
 
 typedef void (*NetClientCallback)(void *);
 
+/*---------------------------------------------------------*\
+| Called on the listener thread with the reply to a request |
+| sent with SendRequestAsync.  data is NULL if the server   |
+| did not answer or the connection was lost.                |
+\*---------------------------------------------------------*/
+typedef void (*NetClientReplyCallback)(void * callback_arg, unsigned int request_id, unsigned int dev_idx, unsigned int data_size, char * data);
+
+/*---------------------------------------------------------*\
+| A request waiting for its reply                           |
+\*---------------------------------------------------------*/
+typedef struct
+{
+    unsigned int                        request_id;
+    unsigned int                        pkt_id;
+    unsigned int                        dev_idx;
+    NetClientReplyCallback              callback;
+    void *                              callback_arg;
+    bool                                cancelled;
+} NetworkClientRequest;
+
 class NetworkClient
 {
 public:
@@ -38,41 +62,99 @@ public:
     void            SetName(const char *new_name);
     void            SetPort(unsigned short new_port);
 
+    /*-----------------------------------------------------*\
+    | With the UDP channel enabled, LED updates go to a     |
+    | protocol 7 server as UDP datagrams, so a lost frame   |
+    | does not hold up the frames after it.  Must be set    |
+    | before StartClient.                                   |
+    \*-----------------------------------------------------*/
+    void            SetUDPChannel(bool enable);
+    bool            GetUDPChannel();
+
+    /*-----------------------------------------------------*\
+    | With a color subscription rate set, a protocol 8      |
+    | server sends the colors of its devices whenever they  |
+    | change, at most max_rate times per second, and they   |
+    | are applied to server_controllers.  0 turns the       |
+    | subscription off.                                     |
+    \*-----------------------------------------------------*/
+    void            SetColorSubscription(unsigned int max_rate);
+    unsigned int    GetColorSubscription();
+
     void            StartClient();
     void            StopClient();
 
     void            ConnectionThreadFunction();
     void            ListenThreadFunction();
 
-    void            WaitOnControllerData();
+    bool            GetControllerStats(unsigned int dev_idx, RGBControllerStats& stats);
+
+    /*-----------------------------------------------------*\
+    | Asynchronous requests return a request ID, or 0 if    |
+    | the request could not be sent, and any number can be  |
+    | in flight.  The server answers a client's requests in |
+    | order, so each reply goes to the oldest request with  |
+    | the same packet ID and device index, and requests     |
+    | sent before it that got no reply are failed.          |
+    |                                                       |
+    | WaitOnRequest returns once the request's callback has |
+    | run, or false on timeout, after which the callback is |
+    | not called.  It must not be called from a callback.   |
+    \*-----------------------------------------------------*/
+    unsigned int    SendRequestAsync(unsigned int pkt_id, unsigned int dev_idx, const void * data, unsigned int size, NetClientReplyCallback callback, void * callback_arg);
+    unsigned int    SendRequestAsync_ControllerData(unsigned int dev_idx, NetClientReplyCallback callback, void * callback_arg);
+    bool            WaitOnRequest(unsigned int request_id, unsigned int timeout_ms);
+
+    /*-----------------------------------------------------*\
+    | Requests sent between StartBatch and FinishBatch, by  |
+    | any thread, are sent to the server together.  Keep    |
+    | batches short, replies to batched requests only come  |
+    | after FinishBatch.                                    |
+    \*-----------------------------------------------------*/
+    void            StartBatch();
+    void            FinishBatch();
+
+    void            UpdateControllerLEDs(const std::vector<unsigned int>& dev_idxs);
     
     void        ProcessReply_ControllerCount(unsigned int data_size, char * data);
     void        ProcessReply_ControllerData(unsigned int data_size, char * data, unsigned int dev_idx);
     void        ProcessReply_ProtocolVersion(unsigned int data_size, char * data);
+    void        ProcessReply_UDPChannel(unsigned int data_size, char * data);
+    void        ProcessReply_DeviceIDs(unsigned int data_size, char * data);
 
     void        ProcessRequest_DeviceListChanged();
+    void        ProcessRequest_DeviceColorsUpdated(unsigned int data_size, char * data);
+    void        ProcessRequest_DeviceListDiff(unsigned int data_size, char * data);
 
     void        SendData_ClientString();
 
-    void        SendRequest_ControllerCount();
-    void        SendRequest_ControllerData(unsigned int dev_idx);
-    void        SendRequest_ProtocolVersion();
+    unsigned int SendRequest_ControllerCount();
+    unsigned int SendRequest_ControllerData(unsigned int dev_idx);
+    unsigned int SendRequest_DeviceIDs();
+    unsigned int SendRequest_ProtocolVersion();
+    unsigned int SendRequest_UDPChannel();
+    void        SendRequest_ColorSubscription(const std::vector<unsigned int>& dev_idxs, unsigned int max_rate);
 
     void        SendRequest_RGBController_ResizeZone(unsigned int dev_idx, int zone, int new_size);
 
     void        SendRequest_RGBController_UpdateLEDs(unsigned int dev_idx, unsigned char * data, unsigned int size);
     void        SendRequest_RGBController_UpdateZoneLEDs(unsigned int dev_idx, unsigned char * data, unsigned int size);
     void        SendRequest_RGBController_UpdateSingleLED(unsigned int dev_idx, unsigned char * data, unsigned int size);
+    void        SendRequest_RGBController_MultiUpdateLEDs(unsigned char * data, unsigned int size);
+    bool        SendRequest_RGBController_DeltaUpdateLEDs(unsigned int dev_idx, unsigned char * data, unsigned int size);
+    bool        SendRequest_RGBController_UDPUpdateLEDs(unsigned int dev_idx, unsigned char * data, unsigned int size);
 
     void        SendRequest_RGBController_SetCustomMode(unsigned int dev_idx);
 
     void        SendRequest_RGBController_UpdateMode(unsigned int dev_idx, unsigned char * data, unsigned int size);
     void        SendRequest_RGBController_SaveMode(unsigned int dev_idx, unsigned char * data, unsigned int size);
 
+    unsigned int SendRequest_RGBController_GetStats(unsigned int dev_idx);
+
 
     std::vector<std::string> * ProcessReply_ProfileList(unsigned int data_size, char * data);
 
-    void        SendRequest_GetProfileList();
+    unsigned int SendRequest_GetProfileList();
     void        SendRequest_LoadProfile(std::string profile_name);
     void        SendRequest_SaveProfile(std::string profile_name);
     void        SendRequest_DeleteProfile(std::string profile_name);
@@ -92,7 +174,6 @@ private:
     char            port_ip[20];
     unsigned short  port_num;
     bool            client_active;
-    bool            controller_data_received;
     bool            server_connected;
     bool            server_initialized;
     unsigned int    server_controller_count;
@@ -101,6 +182,69 @@ private:
     bool            server_protocol_version_received;
     bool            change_in_progress;
 
+    std::mutex          SendMutex;
+    NetworkPacketWriter writer;
+
+    /*-----------------------------------------------------*\
+    | Requests waiting for a reply in the order they were   |
+    | sent, and the request whose reply is being handled.   |
+    | Protected by RequestMutex.                            |
+    \*-----------------------------------------------------*/
+    std::mutex                          RequestMutex;
+    std::condition_variable             RequestCV;
+    std::deque<NetworkClientRequest>    PendingRequests;
+    unsigned int                        next_request_id;
+    unsigned int                        active_request_id;
+
+    bool            TakeRequest(unsigned int pkt_id, unsigned int dev_idx, NetworkClientRequest& request);
+    void            FinishRequest();
+    void            FailRequests();
+    bool            RequestPending(unsigned int request_id);
+
+    /*-----------------------------------------------------*\
+    | Controllers received during the initial sync, filled  |
+    | in by reply callbacks the connection thread waits on  |
+    \*-----------------------------------------------------*/
+    std::vector<RGBController *>        sync_controllers;
+
+    static void     SyncControllerDataCallback(void * callback_arg, unsigned int request_id, unsigned int dev_idx, unsigned int data_size, char * data);
+
+    /*-----------------------------------------------------*\
+    | Multi-device update buffer, protected by              |
+    | ControllerListMutex                                   |
+    \*-----------------------------------------------------*/
+    std::vector<unsigned char>  multi_update_buf;
+
+    /*-----------------------------------------------------*\
+    | Server device IDs of server_controllers and the       |
+    | sequence number of the server list they match, for    |
+    | applying device list diffs.  Protected by             |
+    | ControllerListMutex.                                  |
+    \*-----------------------------------------------------*/
+    std::vector<unsigned int>   server_controller_ids;
+    unsigned int                server_device_list_seq;
+
+    /*-----------------------------------------------------*\
+    | UDP channel, the socket, buffer and frame sequence    |
+    | number are protected by UDPMutex                      |
+    \*-----------------------------------------------------*/
+    bool                        udp_enabled;
+    std::atomic<bool>           udp_reply_received;
+    std::atomic<bool>           udp_ready;
+    unsigned short              udp_port;
+    unsigned int                udp_token;
+    unsigned int                udp_frame_seq;
+    std::mutex                  UDPMutex;
+    SOCKET                      udp_sock;
+    std::vector<unsigned char>  udp_buf;
+
+    void            OpenUDPChannel();
+    void            CloseUDPChannel();
+
+    std::atomic<unsigned int>   color_subscription_rate;
+
+    void            SubscribeColors();
+
     std::thread *   ConnectionThread;
     std::thread *   ListenThread;
 
@@ -109,4 +253,6 @@ private:
     std::vector<void *>                 ClientInfoChangeCallbackArgs;
 
     int recv_select(SOCKET s, char *buf, int len, int flags);
+
+    bool SendPacket(NetPacketHeader * header, const void * data, unsigned int size);
 };
@@ -0,0 +1,255 @@
+/*-----------------------------------------*\
+|  NetworkColorDelta.cpp                    |
+|                                           |
+|  Delta encoded LED frames for the SDK     |
+\*-----------------------------------------*/
+
+#include "NetworkColorDelta.h"
+#include "RGBControllerBuffer.h"
+
+NetworkColorDeltaEncoder::NetworkColorDeltaEncoder()
+{
+    frame_seq               = 0;
+    frames_since_keyframe   = 0;
+    keyframe_needed         = true;
+}
+
+void NetworkColorDeltaEncoder::Encode(std::vector<unsigned char>& data_buf, const std::vector<RGBColor>& colors)
+{
+    RGBControllerBufferWriter writer(data_buf);
+
+    unsigned short  num_colors  = (unsigned short)colors.size();
+    unsigned char   flags       = 0;
+
+    /*-----------------------------------------------------*\
+    | Send a keyframe when asked to, when the LED count     |
+    | changed and at the keyframe interval                  |
+    \*-----------------------------------------------------*/
+    if(keyframe_needed || (reference.size() != num_colors) || (frames_since_keyframe >= NET_COLOR_DELTA_KEYFRAME_INTERVAL))
+    {
+        reference.assign(num_colors, 0);
+
+        flags                  |= NET_COLOR_DELTA_FLAG_KEYFRAME;
+        frames_since_keyframe   = 0;
+        keyframe_needed         = false;
+    }
+
+    frames_since_keyframe++;
+    frame_seq++;
+
+    delta.resize(num_colors);
+
+    for(std::size_t color_idx = 0; color_idx < num_colors; color_idx++)
+    {
+        delta[color_idx]     = colors[color_idx] ^ reference[color_idx];
+        reference[color_idx] = colors[color_idx];
+    }
+
+    writer.Write((unsigned int)0);
+    writer.Write(frame_seq);
+
+    std::size_t flags_offset = writer.GetSize();
+
+    writer.Write(flags);
+    writer.Write(num_colors);
+
+    /*-----------------------------------------------------*\
+    | Run length encode the delta, giving up as soon as it  |
+    | is larger than the plain values                       |
+    \*-----------------------------------------------------*/
+    std::size_t values_offset   = writer.GetSize();
+    std::size_t plain_size      = num_colors * sizeof(RGBColor);
+    std::size_t color_idx       = 0;
+    bool        use_rle         = true;
+
+    while(color_idx < num_colors)
+    {
+        if((writer.GetSize() - values_offset) >= plain_size)
+        {
+            use_rle = false;
+            break;
+        }
+
+        unsigned short run = 1;
+
+        while(((color_idx + run) < num_colors) && (run < NET_COLOR_DELTA_RUN_MAX) && (delta[color_idx + run] == delta[color_idx]))
+        {
+            run++;
+        }
+
+        if(run >= 2)
+        {
+            writer.Write((unsigned short)(NET_COLOR_DELTA_RUN_REPEAT | run));
+            writer.Write(delta[color_idx]);
+
+            color_idx += run;
+            continue;
+        }
+
+        /*-------------------------------------------------*\
+        | Literal run up to the start of the next repeat    |
+        \*-------------------------------------------------*/
+        std::size_t literal_start = color_idx;
+
+        color_idx++;
+
+        while((color_idx < num_colors) && ((color_idx - literal_start) < NET_COLOR_DELTA_RUN_MAX))
+        {
+            if(((color_idx + 1) < num_colors) && (delta[color_idx + 1] == delta[color_idx]))
+            {
+                break;
+            }
+
+            color_idx++;
+        }
+
+        writer.Write((unsigned short)(color_idx - literal_start));
+        writer.Write(&delta[literal_start], (color_idx - literal_start) * sizeof(RGBColor));
+    }
+
+    if(use_rle && ((writer.GetSize() - values_offset) < plain_size))
+    {
+        flags |= NET_COLOR_DELTA_FLAG_RLE;
+    }
+    else
+    {
+        data_buf.resize(values_offset);
+
+        writer.Write(delta.data(), plain_size);
+    }
+
+    writer.Patch(flags_offset, flags);
+    writer.Patch(0, (unsigned int)writer.GetSize());
+}
+
+/*---------------------------------------------------------*\
+| Makes the next frame a keyframe, used when a frame could  |
+| not be sent                                               |
+\*---------------------------------------------------------*/
+void NetworkColorDeltaEncoder::Reset()
+{
+    keyframe_needed = true;
+}
+
+NetworkColorDeltaDecoder::NetworkColorDeltaDecoder()
+{
+    frame_seq   = 0;
+    valid       = false;
+}
+
+/*---------------------------------------------------------*\
+| Applies a delta frame.  Returns true if the frame was     |
+| decoded and GetColors() holds the new colors.             |
+\*---------------------------------------------------------*/
+bool NetworkColorDeltaDecoder::Decode(const unsigned char * data_buf, unsigned int data_size)
+{
+    RGBControllerBufferReader reader(data_buf, data_size);
+
+    unsigned short  seq;
+    unsigned char   flags;
+    unsigned short  num_colors;
+
+    reader.Skip(sizeof(unsigned int));
+    reader.Read(seq);
+    reader.Read(flags);
+    reader.Read(num_colors);
+
+    if(reader.Failed())
+    {
+        return(false);
+    }
+
+    if(flags & NET_COLOR_DELTA_FLAG_KEYFRAME)
+    {
+        reference.assign(num_colors, 0);
+        valid = true;
+    }
+    else if(!valid || (seq != (unsigned short)(frame_seq + 1)) || (reference.size() != num_colors))
+    {
+        valid = false;
+        return(false);
+    }
+
+    frame_seq = seq;
+
+    std::size_t color_idx = 0;
+
+    if(flags & NET_COLOR_DELTA_FLAG_RLE)
+    {
+        while(valid && (color_idx < num_colors))
+        {
+            unsigned short  run;
+            RGBColor        value;
+
+            reader.Read(run);
+
+            std::size_t count = run & NET_COLOR_DELTA_RUN_MAX;
+
+            if(reader.Failed() || (count == 0) || (count > (num_colors - color_idx)))
+            {
+                valid = false;
+                break;
+            }
+
+            if(run & NET_COLOR_DELTA_RUN_REPEAT)
+            {
+                if(!reader.Read(value))
+                {
+                    valid = false;
+                    break;
+                }
+
+                if(value == 0)
+                {
+                    color_idx += count;
+                    continue;
+                }
+
+                for(std::size_t run_idx = 0; run_idx < count; run_idx++)
+                {
+                    reference[color_idx++] ^= value;
+                }
+            }
+            else
+            {
+                if(!reader.CanRead(count, sizeof(RGBColor)))
+                {
+                    valid = false;
+                    break;
+                }
+
+                for(std::size_t run_idx = 0; run_idx < count; run_idx++)
+                {
+                    reader.Read(value);
+
+                    reference[color_idx++] ^= value;
+                }
+            }
+        }
+    }
+    else
+    {
+        if(reader.CanRead(num_colors, sizeof(RGBColor)))
+        {
+            RGBColor value;
+
+            for(; color_idx < num_colors; color_idx++)
+            {
+                reader.Read(value);
+
+                reference[color_idx] ^= value;
+            }
+        }
+        else
+        {
+            valid = false;
+        }
+    }
+
+    return(valid);
+}
+
+const std::vector<RGBColor>& NetworkColorDeltaDecoder::GetColors()
+{
+    return(reference);
+}
@@ -0,0 +1,82 @@
+/*-----------------------------------------*\
+|  NetworkColorDelta.h                      |
+|                                           |
+|  Delta encoded LED frames for the SDK     |
+\*-----------------------------------------*/
+
+#pragma once
+
+#include "RGBController.h"
+#include <vector>
+
+/*---------------------------------------------------------*\
+| A full frame is sent at least this often, so a device     |
+| whose decoder lost track recovers on its own              |
+\*---------------------------------------------------------*/
+#define NET_COLOR_DELTA_KEYFRAME_INTERVAL   120
+
+/*---------------------------------------------------------*\
+| Frame flags                                               |
+\*---------------------------------------------------------*/
+enum
+{
+    NET_COLOR_DELTA_FLAG_KEYFRAME   = (1 << 0),     /* Delta is against an all zero frame   */
+    NET_COLOR_DELTA_FLAG_RLE        = (1 << 1),     /* Delta values are run length encoded  */
+};
+
+/*---------------------------------------------------------*\
+| Run headers.  A repeat run is followed by one value that  |
+| is repeated, a literal run by that many values.           |
+\*---------------------------------------------------------*/
+#define NET_COLOR_DELTA_RUN_REPEAT          0x8000
+#define NET_COLOR_DELTA_RUN_MAX             0x7FFF
+
+/*---------------------------------------------------------*\
+| Delta frame layout:                                       |
+|                                                           |
+|   unsigned int    data_size                               |
+|   unsigned short  frame_seq                               |
+|   unsigned char   flags                                   |
+|   unsigned short  num_colors                              |
+|   delta values                                            |
+|                                                           |
+| Each delta value is the new color XORed with the color of |
+| the previous frame, so unchanged LEDs are zero.  With the |
+| RLE flag the values are sent as runs, otherwise as        |
+| num_colors plain values.  The encoder picks whichever is  |
+| smaller.                                                  |
+\*---------------------------------------------------------*/
+class NetworkColorDeltaEncoder
+{
+public:
+    NetworkColorDeltaEncoder();
+
+    void                                Encode(std::vector<unsigned char>& data_buf, const std::vector<RGBColor>& colors);
+    void                                Reset();
+
+private:
+    std::vector<RGBColor>               reference;
+    std::vector<RGBColor>               delta;
+    unsigned short                      frame_seq;
+    unsigned int                        frames_since_keyframe;
+    bool                                keyframe_needed;
+};
+
+/*---------------------------------------------------------*\
+| Rebuilds frames from the deltas of one encoder.  Deltas   |
+| that do not follow on from the last decoded frame are     |
+| ignored until the next keyframe.                          |
+\*---------------------------------------------------------*/
+class NetworkColorDeltaDecoder
+{
+public:
+    NetworkColorDeltaDecoder();
+
+    bool                                Decode(const unsigned char * data_buf, unsigned int data_size);
+    const std::vector<RGBColor>&        GetColors();
+
+private:
+    std::vector<RGBColor>               reference;
+    unsigned short                      frame_seq;
+    bool                                valid;
+};
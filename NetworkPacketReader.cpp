@@ -0,0 +1,151 @@
+/*-----------------------------------------*\
+|  NetworkPacketReader.cpp                  |
+|                                           |
+|  Buffered reader that splits an SDK       |
+|  stream into packets                      |
+\*-----------------------------------------*/
+
+#include "NetworkPacketReader.h"
+#include <cstring>
+
+NetworkPacketReader::NetworkPacketReader(unsigned int max_size)
+{
+    read_pos        = 0;
+    write_pos       = 0;
+    max_packet_size = max_size;
+    term_pos        = 0;
+    term_byte       = 0;
+    term_saved      = false;
+}
+
+char * NetworkPacketReader::GetRecvBuffer(std::size_t& size)
+{
+    RestoreTerminator();
+
+    /*-----------------------------------------------------*\
+    | Start over at the front once everything is consumed,  |
+    | otherwise move the unread bytes to the front when the |
+    | free space at the end runs low                        |
+    \*-----------------------------------------------------*/
+    if(read_pos == write_pos)
+    {
+        read_pos  = 0;
+        write_pos = 0;
+    }
+    else if((read_pos > 0) && ((buf.size() - write_pos) < (NET_PACKET_READER_RECV_SIZE + 1)))
+    {
+        memmove(buf.data(), &buf[read_pos], write_pos - read_pos);
+
+        write_pos -= read_pos;
+        read_pos   = 0;
+    }
+
+    /*-----------------------------------------------------*\
+    | Leave room for a receive and the null terminator.  If |
+    | a large packet has started, make room for all of it   |
+    \*-----------------------------------------------------*/
+    std::size_t needed = write_pos + NET_PACKET_READER_RECV_SIZE;
+
+    if(((write_pos - read_pos) >= sizeof(NetPacketHeader))
+    && (memcmp(&buf[read_pos], "ORGB", sizeof(NetPacketHeader::pkt_magic)) == 0))
+    {
+        NetPacketHeader header;
+
+        memcpy(&header, &buf[read_pos], sizeof(NetPacketHeader));
+
+        if(header.pkt_size <= max_packet_size)
+        {
+            std::size_t packet_end = read_pos + sizeof(NetPacketHeader) + header.pkt_size;
+
+            if(packet_end > needed)
+            {
+                needed = packet_end;
+            }
+        }
+    }
+
+    if(buf.size() < (needed + 1))
+    {
+        buf.resize(needed + 1);
+    }
+
+    size = buf.size() - write_pos - 1;
+
+    return(&buf[write_pos]);
+}
+
+void NetworkPacketReader::Received(std::size_t size)
+{
+    write_pos += size;
+}
+
+int NetworkPacketReader::ReadPacket(NetPacketHeader& header, char *& data)
+{
+    RestoreTerminator();
+
+    /*-----------------------------------------------------*\
+    | Skip anything that does not start with the magic      |
+    \*-----------------------------------------------------*/
+    while(((read_pos + sizeof(header.pkt_magic)) <= write_pos)
+       && (memcmp(&buf[read_pos], "ORGB", sizeof(header.pkt_magic)) != 0))
+    {
+        read_pos++;
+    }
+
+    if((write_pos - read_pos) < sizeof(NetPacketHeader))
+    {
+        return(NET_PACKET_READER_NEED_DATA);
+    }
+
+    memcpy(&header, &buf[read_pos], sizeof(NetPacketHeader));
+
+    if(header.pkt_size > max_packet_size)
+    {
+        return(NET_PACKET_READER_ERROR);
+    }
+
+    if((write_pos - read_pos - sizeof(NetPacketHeader)) < header.pkt_size)
+    {
+        return(NET_PACKET_READER_NEED_DATA);
+    }
+
+    data      = NULL;
+    read_pos += sizeof(NetPacketHeader);
+
+    if(header.pkt_size > 0)
+    {
+        data      = &buf[read_pos];
+        read_pos += header.pkt_size;
+
+        /*-------------------------------------------------*\
+        | Null terminate the data in place                  |
+        \*-------------------------------------------------*/
+        term_pos        = read_pos;
+        term_byte       = buf[term_pos];
+        term_saved      = true;
+        buf[term_pos]   = '\0';
+    }
+
+    return(NET_PACKET_READER_PACKET);
+}
+
+std::size_t NetworkPacketReader::GetBufferedSize()
+{
+    return(write_pos - read_pos);
+}
+
+void NetworkPacketReader::Reset()
+{
+    read_pos    = 0;
+    write_pos   = 0;
+    term_saved  = false;
+}
+
+void NetworkPacketReader::RestoreTerminator()
+{
+    if(term_saved)
+    {
+        buf[term_pos] = term_byte;
+        term_saved    = false;
+    }
+}
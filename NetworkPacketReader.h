@@ -0,0 +1,65 @@
+/*-----------------------------------------*\
+|  NetworkPacketReader.h                    |
+|                                           |
+|  Buffered reader that splits an SDK       |
+|  stream into packets                      |
+\*-----------------------------------------*/
+
+#pragma once
+
+#include "NetworkProtocol.h"
+#include <cstddef>
+#include <vector>
+
+#define NET_PACKET_READER_RECV_SIZE     65536
+#define NET_PACKET_READER_MAX_SIZE      (16 * 1024 * 1024)
+
+/*------------------------------------------------------------------*\
+| Read Results                                                       |
+\*------------------------------------------------------------------*/
+enum
+{
+    NET_PACKET_READER_NEED_DATA,                /* No complete packet is buffered   */
+    NET_PACKET_READER_PACKET,                   /* A complete packet was returned   */
+    NET_PACKET_READER_ERROR,                    /* Packet exceeds the size limit    */
+};
+
+/*---------------------------------------------------------*\
+| Data is received directly into the reader's buffer, then  |
+| every complete packet in it is returned in turn.  Packet  |
+| data points into the buffer, so nothing is copied or      |
+| allocated per packet.  The data is followed by a null so  |
+| string requests can use it directly, and stays valid      |
+| until the next call to ReadPacket or GetRecvBuffer.       |
+|                                                           |
+| Bytes before a packet magic are skipped.                  |
+\*---------------------------------------------------------*/
+class NetworkPacketReader
+{
+public:
+    NetworkPacketReader(unsigned int max_size = NET_PACKET_READER_MAX_SIZE);
+
+    char *                              GetRecvBuffer(std::size_t& size);
+    void                                Received(std::size_t size);
+
+    int                                 ReadPacket(NetPacketHeader& header, char *& data);
+
+    std::size_t                         GetBufferedSize();
+    void                                Reset();
+
+private:
+    std::vector<char>                   buf;
+    std::size_t                         read_pos;
+    std::size_t                         write_pos;
+    unsigned int                        max_packet_size;
+
+    /*-----------------------------------------------------*\
+    | The byte overwritten by the null after the last       |
+    | packet's data, restored before the buffer is used     |
+    \*-----------------------------------------------------*/
+    std::size_t                         term_pos;
+    char                                term_byte;
+    bool                                term_saved;
+
+    void                                RestoreTerminator();
+};
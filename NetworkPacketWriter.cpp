@@ -0,0 +1,257 @@
+/*-----------------------------------------*\
+|  NetworkPacketWriter.cpp                  |
+|                                           |
+|  Gathered and batched packet sends for    |
+|  the SDK client and server                |
+\*-----------------------------------------*/
+
+#include "NetworkPacketWriter.h"
+#include <cstring>
+#include <errno.h>
+
+#ifndef WIN32
+#include <netinet/tcp.h>
+#include <sys/select.h>
+#include <sys/uio.h>
+#endif
+
+#ifdef WIN32
+#define MSG_NOSIGNAL 0
+#endif
+
+#ifdef __APPLE__
+#define MSG_NOSIGNAL 0
+#endif
+
+#define NET_PACKET_WRITER_TIMEOUT_SECONDS   5
+
+/*---------------------------------------------------------*\
+| Returns true if the last socket call failed only because  |
+| it would have blocked or was interrupted                  |
+\*---------------------------------------------------------*/
+static bool SocketWouldBlock()
+{
+#ifdef WIN32
+    return(WSAGetLastError() == WSAEWOULDBLOCK);
+#else
+    return((errno == EAGAIN) || (errno == EWOULDBLOCK) || (errno == EINTR));
+#endif
+}
+
+NetworkPacketWriter::NetworkPacketWriter()
+{
+    batch_depth = 0;
+}
+
+bool NetworkPacketWriter::SetNoDelay(SOCKET sock, bool no_delay)
+{
+    /*-----------------------------------------------------*\
+    | TCP_NODELAY takes an int, a shorter value is rejected |
+    \*-----------------------------------------------------*/
+    int value = no_delay ? 1 : 0;
+
+    return(setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, (const char *)&value, sizeof(value)) == 0);
+}
+
+/*---------------------------------------------------------*\
+| Sends the packet starting offset bytes in, as one write   |
+| of the remaining header and data.  Returns the number of  |
+| bytes sent, 0 if the socket would block, or -1 if the     |
+| connection failed.                                        |
+\*---------------------------------------------------------*/
+int NetworkPacketWriter::SendPacketPart(SOCKET sock, const NetPacketHeader * header, const void * data, unsigned int size, std::size_t offset)
+{
+    const char *    parts[2]        = { (const char *)header, (const char *)data };
+    std::size_t     part_sizes[2]   = { sizeof(NetPacketHeader), size };
+    unsigned int    part_count      = 0;
+
+#ifdef WIN32
+    WSABUF          bufs[2];
+#else
+    struct iovec    bufs[2];
+#endif
+
+    /*-----------------------------------------------------*\
+    | Skip whatever an earlier call already sent            |
+    \*-----------------------------------------------------*/
+    for(unsigned int part_idx = 0; part_idx < 2; part_idx++)
+    {
+        if(offset >= part_sizes[part_idx])
+        {
+            offset -= part_sizes[part_idx];
+            continue;
+        }
+
+#ifdef WIN32
+        bufs[part_count].buf     = (char *)parts[part_idx] + offset;
+        bufs[part_count].len     = (ULONG)(part_sizes[part_idx] - offset);
+#else
+        bufs[part_count].iov_base = (void *)(parts[part_idx] + offset);
+        bufs[part_count].iov_len  = part_sizes[part_idx] - offset;
+#endif
+        part_count++;
+        offset = 0;
+    }
+
+    if(part_count == 0)
+    {
+        return(0);
+    }
+
+#ifdef WIN32
+    DWORD bytes_sent = 0;
+
+    if(WSASend(sock, bufs, part_count, &bytes_sent, 0, NULL, NULL) == SOCKET_ERROR)
+    {
+        return(SocketWouldBlock() ? 0 : -1);
+    }
+
+    return((int)bytes_sent);
+#else
+    struct msghdr msg;
+
+    memset(&msg, 0, sizeof(msg));
+
+    msg.msg_iov     = bufs;
+    msg.msg_iovlen  = part_count;
+
+    ssize_t bytes_sent = sendmsg(sock, &msg, MSG_NOSIGNAL);
+
+    if(bytes_sent < 0)
+    {
+        return(SocketWouldBlock() ? 0 : -1);
+    }
+
+    return((int)bytes_sent);
+#endif
+}
+
+/*---------------------------------------------------------*\
+| Sends a whole packet, or adds it to the current batch.    |
+| Returns false if the connection failed.                   |
+\*---------------------------------------------------------*/
+bool NetworkPacketWriter::SendPacket(SOCKET sock, const NetPacketHeader * header, const void * data, unsigned int size)
+{
+    if(batch_depth > 0)
+    {
+        batch_buf.insert(batch_buf.end(), (const char *)header, (const char *)header + sizeof(NetPacketHeader));
+
+        if(size > 0)
+        {
+            batch_buf.insert(batch_buf.end(), (const char *)data, (const char *)data + size);
+        }
+
+        if(batch_buf.size() < NET_PACKET_WRITER_MAX_BATCH_SIZE)
+        {
+            return(true);
+        }
+
+        bool result = SendAll(sock, batch_buf.data(), batch_buf.size());
+
+        batch_buf.clear();
+
+        return(result);
+    }
+
+    std::size_t total_size  = sizeof(NetPacketHeader) + size;
+    std::size_t offset      = 0;
+
+    while(offset < total_size)
+    {
+        int bytes_sent = SendPacketPart(sock, header, data, size, offset);
+
+        if(bytes_sent < 0)
+        {
+            return(false);
+        }
+
+        if((bytes_sent == 0) && !WaitWritable(sock))
+        {
+            return(false);
+        }
+
+        offset += bytes_sent;
+    }
+
+    return(true);
+}
+
+void NetworkPacketWriter::StartBatch()
+{
+    batch_depth++;
+}
+
+bool NetworkPacketWriter::FinishBatch(SOCKET sock)
+{
+    bool result = true;
+
+    if(batch_depth > 0)
+    {
+        batch_depth--;
+    }
+
+    if((batch_depth == 0) && !batch_buf.empty())
+    {
+        result = SendAll(sock, batch_buf.data(), batch_buf.size());
+
+        batch_buf.clear();
+    }
+
+    return(result);
+}
+
+bool NetworkPacketWriter::GetBatching()
+{
+    return(batch_depth > 0);
+}
+
+/*---------------------------------------------------------*\
+| Drops any batched packets, used when the connection is    |
+| lost                                                      |
+\*---------------------------------------------------------*/
+void NetworkPacketWriter::Reset()
+{
+    batch_depth = 0;
+    batch_buf.clear();
+}
+
+bool NetworkPacketWriter::SendAll(SOCKET sock, const char * data, std::size_t size)
+{
+    std::size_t offset = 0;
+
+    while(offset < size)
+    {
+        int bytes_sent = send(sock, data + offset, (int)(size - offset), MSG_NOSIGNAL);
+
+        if(bytes_sent < 0)
+        {
+            if(!SocketWouldBlock() || !WaitWritable(sock))
+            {
+                return(false);
+            }
+
+            continue;
+        }
+
+        offset += bytes_sent;
+    }
+
+    return(true);
+}
+
+/*---------------------------------------------------------*\
+| Waits for a non-blocking socket to accept more data       |
+\*---------------------------------------------------------*/
+bool NetworkPacketWriter::WaitWritable(SOCKET sock)
+{
+    fd_set  write_set;
+    timeval timeout;
+
+    FD_ZERO(&write_set);
+    FD_SET(sock, &write_set);
+
+    timeout.tv_sec  = NET_PACKET_WRITER_TIMEOUT_SECONDS;
+    timeout.tv_usec = 0;
+
+    return(select((int)sock + 1, NULL, &write_set, NULL, &timeout) > 0);
+}
@@ -0,0 +1,53 @@
+/*-----------------------------------------*\
+|  NetworkPacketWriter.h                    |
+|                                           |
+|  Gathered and batched packet sends for    |
+|  the SDK client and server                |
+\*-----------------------------------------*/
+
+#pragma once
+
+#include "NetworkProtocol.h"
+#include "net_port.h"
+#include <cstddef>
+#include <vector>
+
+/*---------------------------------------------------------*\
+| A batch is sent early once it reaches this size           |
+\*---------------------------------------------------------*/
+#define NET_PACKET_WRITER_MAX_BATCH_SIZE    65536
+
+/*---------------------------------------------------------*\
+| Sends each packet's header and data with a single         |
+| gathered write instead of one send per part, and resumes  |
+| partial writes where they stopped.                        |
+|                                                           |
+| Between StartBatch and FinishBatch, packets are collected |
+| and sent together, so several device updates share one   |
+| write and as few TCP segments as possible.  Batches nest; |
+| the outermost FinishBatch sends.                          |
+\*---------------------------------------------------------*/
+class NetworkPacketWriter
+{
+public:
+    NetworkPacketWriter();
+
+    static bool                         SetNoDelay(SOCKET sock, bool no_delay);
+
+    static int                          SendPacketPart(SOCKET sock, const NetPacketHeader * header, const void * data, unsigned int size, std::size_t offset);
+
+    bool                                SendPacket(SOCKET sock, const NetPacketHeader * header, const void * data, unsigned int size);
+
+    void                                StartBatch();
+    bool                                FinishBatch(SOCKET sock);
+    bool                                GetBatching();
+
+    void                                Reset();
+
+private:
+    unsigned int                        batch_depth;
+    std::vector<char>                   batch_buf;
+
+    static bool                         SendAll(SOCKET sock, const char * data, std::size_t size);
+    static bool                         WaitWritable(SOCKET sock);
+};
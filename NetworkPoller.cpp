@@ -0,0 +1,328 @@
+/*-----------------------------------------*\
+|  NetworkPoller.cpp                        |
+|                                           |
+|  Socket readiness polling for the SDK     |
+|  server.  Uses epoll on Linux and falls   |
+|  back to poll() elsewhere.                |
+\*-----------------------------------------*/
+
+#include "NetworkPoller.h"
+#include <cstring>
+
+#ifdef __linux__
+#include <sys/epoll.h>
+#include <sys/ioctl.h>
+#endif
+
+#ifdef __APPLE__
+#include <sys/ioctl.h>
+#endif
+
+#ifdef WIN32
+#define poll WSAPoll
+#endif
+
+#define NET_POLL_MAX_EVENTS     64
+
+NetworkPoller::NetworkPoller()
+{
+    use_epoll = false;
+    epoll_fd  = -1;
+    wake_sock = INVALID_SOCKET;
+
+#ifdef __linux__
+    epoll_fd  = epoll_create1(EPOLL_CLOEXEC);
+    use_epoll = (epoll_fd >= 0);
+#endif
+
+    /*-----------------------------------------------------*\
+    | Create the wake socket.  If this fails, Wait still    |
+    | returns at its timeout.                               |
+    \*-----------------------------------------------------*/
+    wake_sock = socket(AF_INET, SOCK_DGRAM, 0);
+
+    if(wake_sock != INVALID_SOCKET)
+    {
+        sockaddr_in wake_addr;
+        socklen_t   wake_addr_len = sizeof(wake_addr);
+
+        memset(&wake_addr, 0, sizeof(wake_addr));
+
+        wake_addr.sin_family      = AF_INET;
+        wake_addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        wake_addr.sin_port        = 0;
+
+        u_long arg = 1;
+
+        if((bind(wake_sock, (sockaddr *)&wake_addr, sizeof(wake_addr)) == SOCKET_ERROR)
+        || (getsockname(wake_sock, (sockaddr *)&wake_addr, &wake_addr_len) == SOCKET_ERROR)
+        || (connect(wake_sock, (sockaddr *)&wake_addr, sizeof(wake_addr)) == SOCKET_ERROR)
+        || (ioctlsocket(wake_sock, FIONBIO, &arg) == SOCKET_ERROR))
+        {
+            closesocket(wake_sock);
+            wake_sock = INVALID_SOCKET;
+        }
+    }
+
+    if(use_epoll)
+    {
+#ifdef __linux__
+        if(wake_sock != INVALID_SOCKET)
+        {
+            struct epoll_event wake_event;
+
+            wake_event.events   = EPOLLIN;
+            wake_event.data.ptr = this;
+
+            epoll_ctl(epoll_fd, EPOLL_CTL_ADD, wake_sock, &wake_event);
+        }
+#endif
+    }
+    else
+    {
+        struct pollfd wake_fd;
+
+        wake_fd.fd      = wake_sock;
+        wake_fd.events  = POLLIN;
+        wake_fd.revents = 0;
+
+        poll_fds.push_back(wake_fd);
+        poll_args.push_back(this);
+    }
+}
+
+NetworkPoller::~NetworkPoller()
+{
+#ifdef __linux__
+    if(epoll_fd >= 0)
+    {
+        close(epoll_fd);
+    }
+#endif
+
+    if(wake_sock != INVALID_SOCKET)
+    {
+        closesocket(wake_sock);
+    }
+}
+
+bool NetworkPoller::GetUsingEpoll()
+{
+    return(use_epoll);
+}
+
+bool NetworkPoller::Add(SOCKET sock, unsigned int events, void * arg)
+{
+    if(use_epoll)
+    {
+#ifdef __linux__
+        struct epoll_event sock_event;
+
+        sock_event.events   = ((events & NET_POLL_READ)  ? (uint32_t)EPOLLIN  : 0)
+                            | ((events & NET_POLL_WRITE) ? (uint32_t)EPOLLOUT : 0);
+        sock_event.data.ptr = arg;
+
+        return(epoll_ctl(epoll_fd, EPOLL_CTL_ADD, sock, &sock_event) == 0);
+#endif
+    }
+
+    struct pollfd sock_fd;
+
+    sock_fd.fd      = sock;
+    sock_fd.events  = ((events & NET_POLL_READ)  ? POLLIN  : 0)
+                    | ((events & NET_POLL_WRITE) ? POLLOUT : 0);
+    sock_fd.revents = 0;
+
+    poll_fds.push_back(sock_fd);
+    poll_args.push_back(arg);
+
+    return(true);
+}
+
+bool NetworkPoller::Modify(SOCKET sock, unsigned int events, void * arg)
+{
+    if(use_epoll)
+    {
+#ifdef __linux__
+        struct epoll_event sock_event;
+
+        sock_event.events   = ((events & NET_POLL_READ)  ? (uint32_t)EPOLLIN  : 0)
+                            | ((events & NET_POLL_WRITE) ? (uint32_t)EPOLLOUT : 0);
+        sock_event.data.ptr = arg;
+
+        return(epoll_ctl(epoll_fd, EPOLL_CTL_MOD, sock, &sock_event) == 0);
+#endif
+    }
+
+    for(std::size_t fd_idx = 1; fd_idx < poll_fds.size(); fd_idx++)
+    {
+        if(poll_fds[fd_idx].fd == sock)
+        {
+            poll_fds[fd_idx].events  = ((events & NET_POLL_READ)  ? POLLIN  : 0)
+                                     | ((events & NET_POLL_WRITE) ? POLLOUT : 0);
+            poll_args[fd_idx]        = arg;
+
+            return(true);
+        }
+    }
+
+    return(false);
+}
+
+void NetworkPoller::Remove(SOCKET sock)
+{
+    if(use_epoll)
+    {
+#ifdef __linux__
+        struct epoll_event sock_event;
+
+        epoll_ctl(epoll_fd, EPOLL_CTL_DEL, sock, &sock_event);
+        return;
+#endif
+    }
+
+    for(std::size_t fd_idx = 1; fd_idx < poll_fds.size(); fd_idx++)
+    {
+        if(poll_fds[fd_idx].fd == sock)
+        {
+            poll_fds.erase(poll_fds.begin() + fd_idx);
+            poll_args.erase(poll_args.begin() + fd_idx);
+            return;
+        }
+    }
+}
+
+int NetworkPoller::Wait(std::vector<NetPollEvent>& events, int timeout_ms)
+{
+    events.clear();
+
+    if(use_epoll)
+    {
+#ifdef __linux__
+        struct epoll_event ready_events[NET_POLL_MAX_EVENTS];
+
+        int ready_count = epoll_wait(epoll_fd, ready_events, NET_POLL_MAX_EVENTS, timeout_ms);
+
+        for(int ready_idx = 0; ready_idx < ready_count; ready_idx++)
+        {
+            if(ready_events[ready_idx].data.ptr == this)
+            {
+                DrainWake();
+                continue;
+            }
+
+            NetPollEvent event;
+
+            event.arg    = ready_events[ready_idx].data.ptr;
+            event.events = 0;
+
+            if(ready_events[ready_idx].events & EPOLLIN)
+            {
+                event.events |= NET_POLL_READ;
+            }
+
+            if(ready_events[ready_idx].events & EPOLLOUT)
+            {
+                event.events |= NET_POLL_WRITE;
+            }
+
+            /*---------------------------------------------*\
+            | Report errors as readable too, so the owner   |
+            | sees the failure from its next recv           |
+            \*---------------------------------------------*/
+            if(ready_events[ready_idx].events & (EPOLLERR | EPOLLHUP))
+            {
+                event.events |= (NET_POLL_READ | NET_POLL_ERROR);
+            }
+
+            events.push_back(event);
+        }
+
+        return((int)events.size());
+#endif
+    }
+
+    /*-----------------------------------------------------*\
+    | Skip the wake socket entry if it could not be created |
+    \*-----------------------------------------------------*/
+    struct pollfd * fds      = poll_fds.data();
+    std::size_t     fd_count = poll_fds.size();
+
+    if(wake_sock == INVALID_SOCKET)
+    {
+        fds++;
+        fd_count--;
+    }
+
+    int ready_count = poll(fds, (unsigned long)fd_count, timeout_ms);
+
+    if(ready_count <= 0)
+    {
+        return(0);
+    }
+
+    for(std::size_t fd_idx = 0; fd_idx < poll_fds.size(); fd_idx++)
+    {
+        short revents = poll_fds[fd_idx].revents;
+
+        if(revents == 0)
+        {
+            continue;
+        }
+
+        poll_fds[fd_idx].revents = 0;
+
+        if(fd_idx == 0)
+        {
+            DrainWake();
+            continue;
+        }
+
+        NetPollEvent event;
+
+        event.arg    = poll_args[fd_idx];
+        event.events = 0;
+
+        if(revents & POLLIN)
+        {
+            event.events |= NET_POLL_READ;
+        }
+
+        if(revents & POLLOUT)
+        {
+            event.events |= NET_POLL_WRITE;
+        }
+
+        if(revents & (POLLERR | POLLHUP | POLLNVAL))
+        {
+            event.events |= (NET_POLL_READ | NET_POLL_ERROR);
+        }
+
+        events.push_back(event);
+    }
+
+    return((int)events.size());
+}
+
+void NetworkPoller::Wake()
+{
+    if(wake_sock != INVALID_SOCKET)
+    {
+        char wake_byte = 0;
+
+        /*-------------------------------------------------*\
+        | A full socket buffer means a wakeup is already    |
+        | pending, so the result can be ignored             |
+        \*-------------------------------------------------*/
+        send(wake_sock, &wake_byte, 1, 0);
+    }
+}
+
+void NetworkPoller::DrainWake()
+{
+    char drain_buf[64];
+
+    while(recv(wake_sock, drain_buf, sizeof(drain_buf), 0) > 0)
+    {
+    }
+}
@@ -0,0 +1,73 @@
+/*-----------------------------------------*\
+|  NetworkPoller.h                          |
+|                                           |
+|  Socket readiness polling for the SDK     |
+|  server.  Uses epoll on Linux and falls   |
+|  back to poll() elsewhere.                |
+\*-----------------------------------------*/
+
+#pragma once
+
+#include "net_port.h"
+#include <vector>
+
+#ifdef WIN32
+#include <winsock2.h>
+#else
+#include <poll.h>
+#endif
+
+/*------------------------------------------------------------------*\
+| Poll Event Flags                                                   |
+\*------------------------------------------------------------------*/
+enum
+{
+    NET_POLL_READ       = (1 << 0),     /* Socket is readable or has a pending connection   */
+    NET_POLL_WRITE      = (1 << 1),     /* Socket is writable                               */
+    NET_POLL_ERROR      = (1 << 2),     /* Socket has an error or hung up, output only      */
+};
+
+typedef struct
+{
+    unsigned int        events;
+    void *              arg;
+} NetPollEvent;
+
+/*---------------------------------------------------------*\
+| Add, Modify, Remove and Wait are only called from the     |
+| thread that owns the poller.  Wake may be called from any |
+| thread to interrupt a Wait in progress.                   |
+\*---------------------------------------------------------*/
+class NetworkPoller
+{
+public:
+    NetworkPoller();
+    ~NetworkPoller();
+
+    bool                                GetUsingEpoll();
+
+    bool                                Add(SOCKET sock, unsigned int events, void * arg);
+    bool                                Modify(SOCKET sock, unsigned int events, void * arg);
+    void                                Remove(SOCKET sock);
+
+    int                                 Wait(std::vector<NetPollEvent>& events, int timeout_ms);
+    void                                Wake();
+
+private:
+    bool                                use_epoll;
+    int                                 epoll_fd;
+
+    /*-----------------------------------------------------*\
+    | poll() fallback state, index 0 is the wake socket     |
+    \*-----------------------------------------------------*/
+    std::vector<struct pollfd>          poll_fds;
+    std::vector<void *>                 poll_args;
+
+    /*-----------------------------------------------------*\
+    | Loopback UDP socket connected to itself, written by   |
+    | Wake to make the socket readable                      |
+    \*-----------------------------------------------------*/
+    SOCKET                              wake_sock;
+
+    void                                DrainWake();
+};
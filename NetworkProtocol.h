@@ -15,8 +15,14 @@
 |   1:      Add versioning, vendor string (Release 0.5) |
 |   2:      Add profile controls (Release 0.6)          |
 |   3:      Add brightness field to modes (Release 0.7) |
+|   4:      Add controller frame timing statistics      |
+|   5:      Add multi-device LED updates                |
+|   6:      Add delta encoded LED updates               |
+|   7:      Add UDP channel for LED updates             |
+|   8:      Add device color subscriptions              |
+|   9:      Add device IDs and device list diffs        |
 \*-----------------------------------------------------*/
-#define OPENRGB_SDK_PROTOCOL_VERSION    3
+#define OPENRGB_SDK_PROTOCOL_VERSION    9
 
 /*-----------------------------------------------------*\
 | Default OpenRGB SDK port is 6742                      |
@@ -24,6 +30,12 @@
 \*-----------------------------------------------------*/
 #define OPENRGB_SDK_PORT 6742
 
+/*-----------------------------------------------------*\
+| Largest UDP LED update datagram.  Frames that do not  |
+| fit are sent over TCP instead.                        |
+\*-----------------------------------------------------*/
+#define OPENRGB_SDK_UDP_MAX_SIZE        65507
+
 typedef struct NetPacketHeader
 {
     char                pkt_magic[4];               /* Magic value "ORGB" identifies beginning of packet    */
@@ -39,12 +51,19 @@ enum
     \*----------------------------------------------------------------------------------------------------------*/
     NET_PACKET_ID_REQUEST_CONTROLLER_COUNT      = 0,    /* Request RGBController device count from server       */
     NET_PACKET_ID_REQUEST_CONTROLLER_DATA       = 1,    /* Request RGBController data block                     */
+    NET_PACKET_ID_REQUEST_DEVICE_IDS            = 2,    /* Request device IDs in index order (protocol 9)       */
 
     NET_PACKET_ID_REQUEST_PROTOCOL_VERSION      = 40,   /* Request OpenRGB SDK protocol version from server     */
 
     NET_PACKET_ID_SET_CLIENT_NAME               = 50,   /* Send client name string to server                    */
 
+    NET_PACKET_ID_REQUEST_UDP_CHANNEL           = 60,   /* Request UDP channel for LED updates (protocol 7)     */
+
+    NET_PACKET_ID_REQUEST_COLOR_SUBSCRIPTION    = 70,   /* Subscribe to device color changes (protocol 8)       */
+
     NET_PACKET_ID_DEVICE_LIST_UPDATED           = 100,  /* Indicate to clients that device list has updated     */
+    NET_PACKET_ID_DEVICE_COLORS_UPDATED         = 101,  /* Push subscribed device colors to client (protocol 8) */
+    NET_PACKET_ID_DEVICE_LIST_DIFF              = 102,  /* Send device list changes to client (protocol 9)      */
 
     NET_PACKET_ID_REQUEST_PROFILE_LIST          = 150,  /* Request profile list                                 */
     NET_PACKET_ID_REQUEST_SAVE_PROFILE          = 151,  /* Save current configuration in a new profile          */
@@ -59,8 +78,13 @@ enum
     NET_PACKET_ID_RGBCONTROLLER_UPDATELEDS      = 1050, /* RGBController::UpdateLEDs()                          */
     NET_PACKET_ID_RGBCONTROLLER_UPDATEZONELEDS  = 1051, /* RGBController::UpdateZoneLEDs()                      */
     NET_PACKET_ID_RGBCONTROLLER_UPDATESINGLELED = 1052, /* RGBController::UpdateSingleLED()                     */
+    NET_PACKET_ID_RGBCONTROLLER_MULTIUPDATELEDS = 1053, /* RGBController::UpdateLEDs() on many (protocol 5)     */
+    NET_PACKET_ID_RGBCONTROLLER_DELTAUPDATELEDS = 1054, /* RGBController::UpdateLEDs() delta (protocol 6)       */
+    NET_PACKET_ID_RGBCONTROLLER_UDPUPDATELEDS   = 1055, /* RGBController::UpdateLEDs() UDP (protocol 7)         */
 
     NET_PACKET_ID_RGBCONTROLLER_SETCUSTOMMODE   = 1100, /* RGBController::SetCustomMode()                       */
     NET_PACKET_ID_RGBCONTROLLER_UPDATEMODE      = 1101, /* RGBController::UpdateMode()                          */
     NET_PACKET_ID_RGBCONTROLLER_SAVEMODE        = 1102, /* RGBController::SaveMode()                            */
+
+    NET_PACKET_ID_RGBCONTROLLER_GETSTATS        = 1150, /* RGBController::GetStats() (protocol 4)               */
 };
@@ -8,6 +8,8 @@
 
 #include "NetworkServer.h"
 #include "LogManager.h"
+#include "RGBControllerBuffer.h"
+#include <algorithm>
 #include <cstring>
 
 #ifndef WIN32
@@ -23,20 +25,83 @@
 #include <stdlib.h>
 #include <iostream>
 
-const char yes = 1;
-
 #ifdef WIN32
 #include <Windows.h>
+#define MSG_NOSIGNAL 0
 #else
 #include <unistd.h>
 #endif
 
+#ifdef __APPLE__
+#define MSG_NOSIGNAL 0
+#endif
+
 using namespace std::chrono_literals;
 
+/*---------------------------------------------------------*\
+| Number of the packet the current worker is processing, or |
+| 0 outside of a worker                                     |
+\*---------------------------------------------------------*/
+static thread_local unsigned long long worker_packet_seq = 0;
+
+/*---------------------------------------------------------*\
+| Returns true if the last socket call failed only because  |
+| it would have blocked                                     |
+\*---------------------------------------------------------*/
+static bool SocketWouldBlock()
+{
+#ifdef WIN32
+    return(WSAGetLastError() == WSAEWOULDBLOCK);
+#else
+    return((errno == EAGAIN) || (errno == EWOULDBLOCK) || (errno == EINTR));
+#endif
+}
+
+/*---------------------------------------------------------*\
+| Sends as much of the buffer as the socket accepts without |
+| blocking.  Returns the number of bytes sent, or -1 if the |
+| connection failed.                                        |
+\*---------------------------------------------------------*/
+static int SendNonBlocking(SOCKET sock, const char * data, std::size_t size)
+{
+    std::size_t bytes_sent = 0;
+
+    while(bytes_sent < size)
+    {
+        int tmp_bytes_sent = send(sock, data + bytes_sent, (int)(size - bytes_sent), MSG_NOSIGNAL);
+
+        if(tmp_bytes_sent < 0)
+        {
+            if(SocketWouldBlock())
+            {
+                break;
+            }
+
+            return(-1);
+        }
+
+        bytes_sent += tmp_bytes_sent;
+    }
+
+    return((int)bytes_sent);
+}
+
 NetworkClientInfo::NetworkClientInfo()
 {
-    client_sock          = INVALID_SOCKET;
-    client_listen_thread = nullptr;
+    client_sock             = INVALID_SOCKET;
+    client_protocol_version = 0;
+    poll_events             = 0;
+    ready                   = false;
+    running                 = false;
+    closing                 = false;
+    recv_paused             = false;
+    update_pending          = false;
+    send_pos                = 0;
+    send_failed             = false;
+    udp_token               = 0;
+    color_interval          = std::chrono::steady_clock::duration::zero();
+
+    memset(&client_addr, 0, sizeof(client_addr));
 }
 
 NetworkClientInfo::~NetworkClientInfo()
@@ -44,10 +109,19 @@ NetworkClientInfo::~NetworkClientInfo()
     if(client_sock != INVALID_SOCKET)
     {
         LOG_INFO("Closing server connection: %s", client_ip);
-        delete client_listen_thread;
         shutdown(client_sock, SD_RECEIVE);
         closesocket(client_sock);
     }
+
+    for(std::size_t packet_idx = 0; packet_idx < packets.size(); packet_idx++)
+    {
+        delete packets[packet_idx];
+    }
+
+    for(std::size_t packet_idx = 0; packet_idx < free_packets.size(); packet_idx++)
+    {
+        delete free_packets[packet_idx];
+    }
 }
 
 NetworkServer::NetworkServer(std::vector<RGBController *>& control) : controllers(control)
@@ -56,7 +130,20 @@ NetworkServer::NetworkServer(std::vector<RGBController *>& control) : controller
     server_online    = false;
     server_listening = false;
     ConnectionThread = nullptr;
+    Poller           = nullptr;
+    workers_running  = false;
+    work_seq         = 0;
     profile_manager  = nullptr;
+    server_sock      = INVALID_SOCKET;
+    udp_sock         = INVALID_SOCKET;
+
+    color_wake_pending = false;
+    device_list_seq    = 0;
+    next_device_id     = 1;
+
+    std::random_device random_seed;
+
+    UDPTokenGenerator.seed(random_seed());
 }
 
 NetworkServer::~NetworkServer()
@@ -81,14 +168,224 @@ void NetworkServer::ClientInfoChanged()
 
 void NetworkServer::DeviceListChanged()
 {
+    std::vector<unsigned int> removed_ids;
+    std::vector<unsigned int> added_idxs;
+    std::vector<unsigned int> changed_idxs;
+
+    std::vector<NetworkColorWatch *> released_watches;
+
+    ColorWatchMutex.lock();
+    ServerClientsMutex.lock();
+
+    unsigned int old_list_seq = device_list_seq;
+    bool         list_changed = UpdateDeviceList(removed_ids, added_idxs, changed_idxs);
+
     /*-------------------------------------------------*\
     | Indicate to the clients that the controller list  |
-    | has changed                                       |
+    | has changed.  Protocol 9 clients are sent only    |
+    | what changed, older clients fetch the whole list  |
     \*-------------------------------------------------*/
     for(unsigned int client_idx = 0; client_idx < ServerClients.size(); client_idx++)
     {
-        SendRequest_DeviceListChanged(ServerClients[client_idx]->client_sock);
+        NetworkClientInfo * client_info = ServerClients[client_idx];
+
+        if(client_info->client_protocol_version >= 9)
+        {
+            if(list_changed)
+            {
+                SendRequest_DeviceListDiff(client_info, old_list_seq, removed_ids, added_idxs, changed_idxs);
+            }
+        }
+        else
+        {
+            SendRequest_DeviceListChanged(client_info);
+        }
+    }
+
+    /*-------------------------------------------------*\
+    | Device indices may now refer to other devices, so |
+    | color subscriptions end and clients subscribe     |
+    | again with the new list                           |
+    \*-------------------------------------------------*/
+    if(list_changed)
+    {
+        for(unsigned int client_idx = 0; client_idx < ServerClients.size(); client_idx++)
+        {
+            ClearColorSubscription(ServerClients[client_idx]);
+        }
+
+        UpdateColorWatches(released_watches);
+    }
+
+    ServerClientsMutex.unlock();
+
+    ReleaseColorWatches(released_watches);
+
+    ColorWatchMutex.unlock();
+}
+
+/*---------------------------------------------------------*\
+| Called after a controller has been taken out of the list  |
+| and before it is deleted.  Drops its color watch, ending  |
+| the subscriptions that still refer to it, and waits for   |
+| requests that may still be using it.                      |
+\*---------------------------------------------------------*/
+void NetworkServer::ControllerRemoved(RGBController * controller)
+{
+    std::vector<NetworkColorWatch *> released_watches;
+
+    ColorWatchMutex.lock();
+    ServerClientsMutex.lock();
+
+    std::map<RGBController *, NetworkColorWatch *>::iterator watch_it = ColorWatches.find(controller);
+
+    if(watch_it != ColorWatches.end())
+    {
+        NetworkColorWatch * watch = watch_it->second;
+
+        for(unsigned int client_idx = 0; client_idx < ServerClients.size(); client_idx++)
+        {
+            std::vector<NetworkColorWatch *>& client_watches = ServerClients[client_idx]->color_watches;
+
+            if(std::find(client_watches.begin(), client_watches.end(), watch) != client_watches.end())
+            {
+                ClearColorSubscription(ServerClients[client_idx]);
+            }
+        }
+
+        ColorWatches.erase(watch_it);
+
+        released_watches.push_back(watch);
+    }
+
+    ServerClientsMutex.unlock();
+
+    ReleaseColorWatches(released_watches);
+
+    ColorWatchMutex.unlock();
+
+    /*-----------------------------------------------------*\
+    | Wait for the packets that started before the removal. |
+    | When called from a worker, for instance by a rescan   |
+    | request, that worker's own packet is not waited for   |
+    | and counts as started now.                            |
+    \*-----------------------------------------------------*/
+    std::unique_lock<std::mutex> work_lock(WorkMutex);
+
+    if(worker_packet_seq != 0)
+    {
+        RunningPackets.erase(worker_packet_seq);
+    }
+
+    unsigned long long removed_seq = work_seq;
+
+    WorkDoneCV.wait(work_lock, [this, removed_seq]{ return(RunningPackets.empty() || (*RunningPackets.begin() > removed_seq)); });
+
+    if(worker_packet_seq != 0)
+    {
+        worker_packet_seq = ++work_seq;
+        RunningPackets.insert(worker_packet_seq);
+    }
+}
+
+/*---------------------------------------------------------*\
+| Identifies the device a controller drives, so that a new  |
+| controller allocated where a deleted one was is not taken |
+| for the same device                                       |
+\*---------------------------------------------------------*/
+static unsigned long long GetDeviceIdentity(RGBController * controller)
+{
+    const std::string * fields[] = { &controller->name, &controller->vendor, &controller->location, &controller->serial };
+    unsigned long long  hash     = 14695981039346656037ULL;
+
+    for(std::size_t field_idx = 0; field_idx < (sizeof(fields) / sizeof(fields[0])); field_idx++)
+    {
+        const std::string& field = *fields[field_idx];
+
+        for(std::size_t char_idx = 0; char_idx <= field.size(); char_idx++)
+        {
+            hash ^= (unsigned char)field.c_str()[char_idx];
+            hash *= 1099511628211ULL;
+        }
+    }
+
+    return(hash ^ (unsigned long long)controller->type);
+}
+
+/*---------------------------------------------------------*\
+| Compares the controller list with the list last sent to   |
+| clients.  Fills in the IDs of removed devices and the     |
+| indices of added devices and of devices whose description |
+| changed, then makes the current list the sent list.       |
+| Returns false if nothing changed.  Must be called with    |
+| ServerClientsMutex held.                                  |
+\*---------------------------------------------------------*/
+bool NetworkServer::UpdateDeviceList(std::vector<unsigned int>& removed_ids, std::vector<unsigned int>& added_idxs, std::vector<unsigned int>& changed_idxs)
+{
+    std::vector<NetworkDeviceListEntry> new_list(controllers.size());
+    std::vector<bool>                   kept(DeviceList.size(), false);
+    bool                                moved = false;
+
+    for(std::size_t dev_idx = 0; dev_idx < controllers.size(); dev_idx++)
+    {
+        NetworkDeviceListEntry& entry = new_list[dev_idx];
+
+        entry.controller = controllers[dev_idx];
+        entry.generation = controllers[dev_idx]->GetDescriptionGeneration();
+        entry.identity   = GetDeviceIdentity(controllers[dev_idx]);
+
+        /*-------------------------------------------------*\
+        | Old entries are only compared, never dereferenced,|
+        | as their controllers may have been deleted        |
+        \*-------------------------------------------------*/
+        std::size_t old_idx = 0;
+
+        while((old_idx < DeviceList.size())
+           && (kept[old_idx] || (DeviceList[old_idx].controller != entry.controller) || (DeviceList[old_idx].identity != entry.identity)))
+        {
+            old_idx++;
+        }
+
+        if(old_idx < DeviceList.size())
+        {
+            entry.id      = DeviceList[old_idx].id;
+            kept[old_idx] = true;
+
+            if(DeviceList[old_idx].generation != entry.generation)
+            {
+                changed_idxs.push_back((unsigned int)dev_idx);
+            }
+
+            if(old_idx != dev_idx)
+            {
+                moved = true;
+            }
+        }
+        else
+        {
+            entry.id = next_device_id++;
+
+            added_idxs.push_back((unsigned int)dev_idx);
+        }
+    }
+
+    for(std::size_t old_idx = 0; old_idx < DeviceList.size(); old_idx++)
+    {
+        if(!kept[old_idx])
+        {
+            removed_ids.push_back(DeviceList[old_idx].id);
+        }
+    }
+
+    if(removed_ids.empty() && added_idxs.empty() && changed_idxs.empty() && !moved)
+    {
+        return(false);
     }
+
+    DeviceList.swap(new_list);
+    device_list_seq++;
+
+    return(true);
 }
 
 void NetworkServer::ServerListeningChanged()
@@ -121,9 +418,20 @@ bool NetworkServer::GetListening()
     return server_listening;
 }
 
+bool NetworkServer::GetUsingEpoll()
+{
+    return((Poller != nullptr) && Poller->GetUsingEpoll());
+}
+
 unsigned int NetworkServer::GetNumClients()
 {
-    return ServerClients.size();
+    unsigned int result;
+
+    ServerClientsMutex.lock();
+    result = ServerClients.size();
+    ServerClientsMutex.unlock();
+
+    return result;
 }
 
 const char * NetworkServer::GetClientString(unsigned int client_num)
@@ -282,20 +590,99 @@ void NetworkServer::StartServer()
     /*-------------------------------------------------*\
     | Set socket options - no delay                     |
     \*-------------------------------------------------*/
-    setsockopt(server_sock, IPPROTO_TCP, TCP_NODELAY, &yes, sizeof(yes));
+    NetworkPacketWriter::SetNoDelay(server_sock, true);
 
     server_online = true;
+
+    /*-------------------------------------------------*\
+    | Give the devices their IDs                        |
+    \*-------------------------------------------------*/
+    std::vector<unsigned int> removed_ids;
+    std::vector<unsigned int> added_idxs;
+    std::vector<unsigned int> changed_idxs;
+
+    ServerClientsMutex.lock();
+    UpdateDeviceList(removed_ids, added_idxs, changed_idxs);
+    ServerClientsMutex.unlock();
+
+    /*-------------------------------------------------*\
+    | Open the UDP channel on the same port.  Without   |
+    | it, clients send all LED updates over TCP         |
+    \*-------------------------------------------------*/
+    udp_sock = socket(AF_INET, SOCK_DGRAM, 0);
+
+    if(udp_sock != INVALID_SOCKET)
+    {
+        u_long arg = 1;
+
+        if((bind(udp_sock, (sockaddr*)&myAddress, sizeof(myAddress)) == SOCKET_ERROR)
+        || (ioctlsocket(udp_sock, FIONBIO, &arg) == SOCKET_ERROR))
+        {
+            LOG_WARNING("Could not open UDP channel on port %hu, error code: %d", GetPort(), errno);
+
+            closesocket(udp_sock);
+            udp_sock = INVALID_SOCKET;
+        }
+        else
+        {
+            udp_buf.resize(65536);
+        }
+    }
+
+    /*-------------------------------------------------*\
+    | Start the workers that process client packets     |
+    \*-------------------------------------------------*/
+    Poller          = new NetworkPoller();
+    workers_running = true;
+
+    for(unsigned int worker_idx = 0; worker_idx < NETWORK_SERVER_WORKER_THREADS; worker_idx++)
+    {
+        WorkerThreads.push_back(new std::thread(&NetworkServer::WorkerThreadFunction, this));
+    }
+
     /*-------------------------------------------------*\
     | Start the connection thread                       |
     \*-------------------------------------------------*/
     ConnectionThread = new std::thread(&NetworkServer::ConnectionThreadFunction, this);
-    ConnectionThread->detach();
 }
 
 void NetworkServer::StopServer()
 {
     server_online = false;
 
+    /*-------------------------------------------------*\
+    | Wake the connection thread and wait for it to     |
+    | exit, then stop the workers                       |
+    \*-------------------------------------------------*/
+    if(Poller)
+    {
+        Poller->Wake();
+    }
+
+    if(ConnectionThread)
+    {
+        ConnectionThread->join();
+        delete ConnectionThread;
+        ConnectionThread = nullptr;
+    }
+
+    WorkMutex.lock();
+    workers_running = false;
+    WorkMutex.unlock();
+
+    WorkCV.notify_all();
+
+    for(std::size_t worker_idx = 0; worker_idx < WorkerThreads.size(); worker_idx++)
+    {
+        WorkerThreads[worker_idx]->join();
+        delete WorkerThreads[worker_idx];
+    }
+
+    WorkerThreads.clear();
+
+    std::vector<NetworkColorWatch *> released_watches;
+
+    ColorWatchMutex.lock();
     ServerClientsMutex.lock();
 
     for(unsigned int client_idx = 0; client_idx < ServerClients.size(); client_idx++)
@@ -303,19 +690,49 @@ void NetworkServer::StopServer()
         delete ServerClients[client_idx];
     }
 
+    for(unsigned int client_idx = 0; client_idx < ClosedClients.size(); client_idx++)
+    {
+        delete ClosedClients[client_idx];
+    }
+
     ServerClients.clear();
+    ClosedClients.clear();
+    UDPSessions.clear();
+    ReadyClients.clear();
+    ReactorUpdates.clear();
 
-    shutdown(server_sock, SD_RECEIVE);
-    closesocket(server_sock);
+    /*-------------------------------------------------*\
+    | With no clients left this removes every watch, so |
+    | no update callback can wake the deleted poller    |
+    \*-------------------------------------------------*/
+    UpdateColorWatches(released_watches);
 
     ServerClientsMutex.unlock();
 
-    if(ConnectionThread)
+    ReleaseColorWatches(released_watches);
+
+    ColorWatchMutex.unlock();
+
+    ServerClientsMutex.lock();
+
+    delete Poller;
+    Poller = nullptr;
+
+    if(server_sock != INVALID_SOCKET)
     {
-        delete ConnectionThread;
-        ConnectionThread = nullptr;
+        shutdown(server_sock, SD_RECEIVE);
+        closesocket(server_sock);
+        server_sock = INVALID_SOCKET;
     }
 
+    if(udp_sock != INVALID_SOCKET)
+    {
+        closesocket(udp_sock);
+        udp_sock = INVALID_SOCKET;
+    }
+
+    ServerClientsMutex.unlock();
+
     /*-------------------------------------------------*\
     | Client info has changed, call the callbacks       |
     \*-------------------------------------------------*/
@@ -324,69 +741,137 @@ void NetworkServer::StopServer()
 
 void NetworkServer::ConnectionThreadFunction()
 {
-    //This thread handles client connections
-
+    /*-----------------------------------------------------*\
+    | This thread accepts client connections, reads and     |
+    | parses their packets and flushes their queued replies |
+    | for every client, using non-blocking sockets.  Parsed |
+    | packets are handed to the workers.                    |
+    \*-----------------------------------------------------*/
     printf("Network connection thread started on port %hu\n", GetPort());
+
+    if(listen(server_sock, SOMAXCONN) < 0)
+    {
+        printf("Connection thread closed\r\n");
+        server_online = false;
+
+        return;
+    }
+
+    u_long arg = 1;
+    ioctlsocket(server_sock, FIONBIO, &arg);
+
+    Poller->Add(server_sock, NET_POLL_READ, NULL);
+
+    if(udp_sock != INVALID_SOCKET)
+    {
+        Poller->Add(udp_sock, NET_POLL_READ, &udp_sock);
+    }
+
+    server_listening = true;
+    ServerListeningChanged();
+
+    std::vector<NetPollEvent> events;
+    int                       timeout_ms = TCP_TIMEOUT_SECONDS * 1000;
+
     while(server_online == true)
     {
-        /*-------------------------------------------------*\
-        | Create new socket for client connection           |
-        \*-------------------------------------------------*/
-        NetworkClientInfo * client_info = new NetworkClientInfo();
+        Poller->Wait(events, timeout_ms);
 
-        /*-------------------------------------------------*\
-        | Listen for incoming client connection on the      |
-        | server socket.  This call blocks until a          |
-        | connection is established                         |
-        \*-------------------------------------------------*/
-        if(listen(server_sock, 10) < 0)
+        for(std::size_t event_idx = 0; event_idx < events.size(); event_idx++)
         {
-            printf("Connection thread closed\r\n");
-            server_online = false;
+            NetworkClientInfo * client_info = (NetworkClientInfo *)events[event_idx].arg;
 
-            return;
+            /*---------------------------------------------*\
+            | The server socket is registered without a     |
+            | client                                        |
+            \*---------------------------------------------*/
+            if(client_info == NULL)
+            {
+                AcceptClients();
+                continue;
+            }
+
+            if(events[event_idx].arg == &udp_sock)
+            {
+                ReadUDP();
+                continue;
+            }
+
+            if(client_info->closing)
+            {
+                continue;
+            }
+
+            if((events[event_idx].events & NET_POLL_WRITE) && !FlushClient(client_info))
+            {
+                CloseClient(client_info);
+                continue;
+            }
+
+            if((events[event_idx].events & NET_POLL_READ) && !ReadClient(client_info))
+            {
+                CloseClient(client_info);
+                continue;
+            }
         }
 
-        server_listening = true;
-        ServerListeningChanged();
+        ProcessReactorUpdates();
 
+        timeout_ms = PushColorUpdates();
+    }
+
+    printf("Connection thread closed\r\n");
+    server_listening = false;
+    ServerListeningChanged();
+}
+
+void NetworkServer::AcceptClients()
+{
+    while(1)
+    {
         /*-------------------------------------------------*\
         | Accept the client connection                      |
         \*-------------------------------------------------*/
         struct sockaddr_in client_addr;
         socklen_t          client_addr_len = sizeof(client_addr);
-        client_info->client_sock = accept_select(server_sock, (struct sockaddr *)&client_addr, &client_addr_len);
+        SOCKET             client_sock     = accept(server_sock, (struct sockaddr *)&client_addr, &client_addr_len);
 
-        if(client_info->client_sock < 0)
+        if(client_sock == INVALID_SOCKET)
         {
-            printf("Connection thread closed\r\n");
-            server_online = false;
-
-            server_listening = false;
-            ServerListeningChanged();
+            if(!SocketWouldBlock())
+            {
+                LOG_ERROR("Failed to accept server connection, error code: %d", errno);
+            }
 
             return;
         }
 
         /*-------------------------------------------------*\
-        | Get the new client socket and store it in the     |
+        | Set up the new client socket and store it in the  |
         | clients vector                                    |
         \*-------------------------------------------------*/
-        u_long arg = 0;
+        NetworkClientInfo * client_info = new NetworkClientInfo();
+
+        client_info->client_sock = client_sock;
+
+        u_long arg = 1;
         ioctlsocket(client_info->client_sock, FIONBIO, &arg);
-        setsockopt(client_info->client_sock, IPPROTO_TCP, TCP_NODELAY, &yes, sizeof(yes));
+        NetworkPacketWriter::SetNoDelay(client_info->client_sock, true);
 
         inet_ntop(AF_INET, &client_addr.sin_addr, client_info->client_ip, INET_ADDRSTRLEN);
 
-        client_info->client_string = "Client";
+        client_info->client_addr = client_addr.sin_addr;
 
-        /* We need to lock before the thread could possibly finish */
-        ServerClientsMutex.lock();
+        client_info->client_string = "Client";
+        client_info->poll_events   = NET_POLL_READ;
 
-        //Start a listener thread for the new client socket
-        client_info->client_listen_thread = new std::thread(&NetworkServer::ListenThreadFunction, this, client_info);
-        client_info->client_listen_thread->detach();
+        if(!Poller->Add(client_info->client_sock, client_info->poll_events, client_info))
+        {
+            delete client_info;
+            continue;
+        }
 
+        ServerClientsMutex.lock();
         ServerClients.push_back(client_info);
         ServerClientsMutex.unlock();
 
@@ -395,441 +880,1311 @@ void NetworkServer::ConnectionThreadFunction()
         \*-------------------------------------------------*/
         ClientInfoChanged();
     }
-
-    printf("Connection thread closed\r\n");
-    server_online = false;
-    server_listening = false;
-    ServerListeningChanged();
 }
 
-int NetworkServer::accept_select(int sockfd, struct sockaddr *addr, socklen_t *addrlen)
+bool NetworkServer::ReadClient(NetworkClientInfo * client_info)
 {
-    fd_set              set;
-    struct timeval      timeout;
+    std::size_t recv_size;
+    char *      recv_buf   = client_info->reader.GetRecvBuffer(recv_size);
+    int         bytes_read = recv(client_info->client_sock, recv_buf, (int)recv_size, 0);
 
-    while(1)
+    if(bytes_read == 0)
+    {
+        return(false);
+    }
+
+    if(bytes_read < 0)
+    {
+        return(SocketWouldBlock());
+    }
+
+    client_info->reader.Received(bytes_read);
+
+    if(!ParseClientPackets(client_info))
     {
-        timeout.tv_sec          = TCP_TIMEOUT_SECONDS;
-        timeout.tv_usec         = 0;
+        return(false);
+    }
+
+    UpdateClientEvents(client_info);
+
+    return(true);
+}
+
+bool NetworkServer::ParseClientPackets(NetworkClientInfo * client_info)
+{
+    NetPacketHeader header;
+    char *          data;
+    int             result = NET_PACKET_READER_NEED_DATA;
 
-        FD_ZERO(&set);          /* clear the set */
-        FD_SET(sockfd, &set);   /* add our file descriptor to the set */
+    WorkMutex.lock();
 
-        int rv = select(sockfd + 1, &set, NULL, NULL, &timeout);
+    while(client_info->recv_paused == false)
+    {
+        result = client_info->reader.ReadPacket(header, data);
 
-        if(rv == SOCKET_ERROR || server_online == false)
+        if(result != NET_PACKET_READER_PACKET)
         {
-            return -1;
+            break;
         }
-        else if(rv == 0)
+
+        /*-------------------------------------------------*\
+        | Copy the packet into a recycled packet buffer,    |
+        | keeping a null after the data for strings         |
+        \*-------------------------------------------------*/
+        NetworkServerPacket * packet;
+
+        if(client_info->free_packets.empty())
         {
-            continue;
+            packet = new NetworkServerPacket();
         }
         else
         {
-            // socket has something to read
-            return(accept(sockfd, addr, addrlen));
+            packet = client_info->free_packets.back();
+            client_info->free_packets.pop_back();
+        }
+
+        packet->header = header;
+        packet->data.resize((std::size_t)header.pkt_size + 1);
+
+        if(data != NULL)
+        {
+            memcpy(packet->data.data(), data, header.pkt_size);
+        }
+
+        packet->data[header.pkt_size] = '\0';
+
+        /*-------------------------------------------------*\
+        | Queue the packet and put the client on the ready  |
+        | queue if no worker has it                         |
+        \*-------------------------------------------------*/
+        client_info->packets.push_back(packet);
+
+        if((client_info->ready == false) && (client_info->running == false))
+        {
+            client_info->ready = true;
+            ReadyClients.push_back(client_info);
+
+            WorkCV.notify_one();
+        }
+
+        if(client_info->packets.size() >= NETWORK_SERVER_MAX_QUEUED_PACKETS)
+        {
+            client_info->recv_paused = true;
         }
     }
+
+    WorkMutex.unlock();
+
+    return(result != NET_PACKET_READER_ERROR);
 }
 
-int NetworkServer::recv_select(SOCKET s, char *buf, int len, int flags)
+bool NetworkServer::FlushClient(NetworkClientInfo * client_info)
 {
-    fd_set              set;
-    struct timeval      timeout;
-
-    while(1)
-    {
-        timeout.tv_sec          = TCP_TIMEOUT_SECONDS;
-        timeout.tv_usec         = 0;
+    bool result = true;
 
-        FD_ZERO(&set);      /* clear the set */
-        FD_SET(s, &set);    /* add our file descriptor to the set */
+    client_info->send_mutex.lock();
 
-        int rv = select(s + 1, &set, NULL, NULL, &timeout);
+    if(client_info->send_pos < client_info->send_buf.size())
+    {
+        int bytes_sent = SendNonBlocking(client_info->client_sock, &client_info->send_buf[client_info->send_pos], client_info->send_buf.size() - client_info->send_pos);
 
-        if(rv == SOCKET_ERROR || server_online == false)
+        if(bytes_sent < 0)
         {
-            return 0;
+            client_info->send_failed = true;
+            result                   = false;
         }
-        else if(rv == 0)
+        else
         {
-            continue;
+            client_info->send_pos += bytes_sent;
         }
-        else
+    }
+
+    /*-----------------------------------------------------*\
+    | Reuse the buffer from the start once it is flushed    |
+    \*-----------------------------------------------------*/
+    if(client_info->send_pos == client_info->send_buf.size())
+    {
+        client_info->send_buf.clear();
+        client_info->send_pos = 0;
+    }
+
+    client_info->send_mutex.unlock();
+
+    if(result)
+    {
+        UpdateClientEvents(client_info);
+    }
+
+    return(result);
+}
+
+void NetworkServer::CloseClient(NetworkClientInfo * client_info)
+{
+    Poller->Remove(client_info->client_sock);
+
+    std::vector<NetworkColorWatch *> released_watches;
+
+    ColorWatchMutex.lock();
+    ServerClientsMutex.lock();
+
+    for(unsigned int this_idx = 0; this_idx < ServerClients.size(); this_idx++)
+    {
+        if(ServerClients[this_idx] == client_info)
         {
-            // socket has something to read
-            return(recv(s, buf, len, flags));
+            ServerClients.erase(ServerClients.begin() + this_idx);
+            break;
         }
     }
+
+    if(client_info->udp_token != 0)
+    {
+        UDPSessions.erase(client_info->udp_token);
+    }
+
+    if(!client_info->color_watches.empty())
+    {
+        ClearColorSubscription(client_info);
+        UpdateColorWatches(released_watches);
+    }
+
+    ServerClientsMutex.unlock();
+
+    ReleaseColorWatches(released_watches);
+
+    ColorWatchMutex.unlock();
+
+    /*-----------------------------------------------------*\
+    | Packets already received are still processed.  The    |
+    | client is deleted once the workers are done with it   |
+    \*-----------------------------------------------------*/
+    WorkMutex.lock();
+    client_info->closing = true;
+    WorkMutex.unlock();
+
+    ClosedClients.push_back(client_info);
+
+    /*-------------------------------------------------*\
+    | Client info has changed, call the callbacks       |
+    \*-------------------------------------------------*/
+    ClientInfoChanged();
+}
+
+void NetworkServer::UpdateClientEvents(NetworkClientInfo * client_info)
+{
+    unsigned int events = 0;
+
+    WorkMutex.lock();
+
+    if(client_info->recv_paused == false)
+    {
+        events |= NET_POLL_READ;
+    }
+
+    WorkMutex.unlock();
+
+    client_info->send_mutex.lock();
+
+    if(!client_info->send_buf.empty())
+    {
+        events |= NET_POLL_WRITE;
+    }
+
+    client_info->send_mutex.unlock();
+
+    if(events != client_info->poll_events)
+    {
+        Poller->Modify(client_info->client_sock, events, client_info);
+
+        client_info->poll_events = events;
+    }
 }
 
-void NetworkServer::ListenThreadFunction(NetworkClientInfo * client_info)
+/*---------------------------------------------------------*\
+| Asks the connection thread to look at a client again.     |
+| Must be called with WorkMutex held.                       |
+\*---------------------------------------------------------*/
+void NetworkServer::PostReactorUpdate(NetworkClientInfo * client_info)
 {
-    SOCKET client_sock = client_info->client_sock;
+    if(client_info->update_pending == false)
+    {
+        client_info->update_pending = true;
+        ReactorUpdates.push_back(client_info);
+    }
 
-    printf("Network server started\n");
-    //This thread handles messages received from clients
-    while(server_online == true)
+    if(Poller)
+    {
+        Poller->Wake();
+    }
+}
+
+void NetworkServer::ProcessReactorUpdates()
+{
+    std::vector<NetworkClientInfo *> updates;
+
+    WorkMutex.lock();
+
+    updates.swap(ReactorUpdates);
+
+    for(std::size_t update_idx = 0; update_idx < updates.size(); update_idx++)
     {
-        NetPacketHeader header;
-        int             bytes_read  = 0;
-        char *          data        = NULL;
+        updates[update_idx]->update_pending = false;
+    }
+
+    WorkMutex.unlock();
 
-        //Read first byte of magic
-        bytes_read = recv_select(client_sock, &header.pkt_magic[0], 1, 0);
+    for(std::size_t update_idx = 0; update_idx < updates.size(); update_idx++)
+    {
+        NetworkClientInfo * client_info = updates[update_idx];
 
-        if(bytes_read <= 0)
+        if(client_info->closing)
         {
-            goto listen_done;
+            continue;
         }
 
-        //Test first character of magic - 'O'
-        if(header.pkt_magic[0] != 'O')
+        /*-------------------------------------------------*\
+        | Drop clients whose replies could not be sent      |
+        \*-------------------------------------------------*/
+        client_info->send_mutex.lock();
+        bool send_failed = client_info->send_failed;
+        client_info->send_mutex.unlock();
+
+        if(send_failed)
         {
+            CloseClient(client_info);
             continue;
         }
 
-        //Read second byte of magic
-        bytes_read = recv_select(client_sock, &header.pkt_magic[1], 1, 0);
+        /*-------------------------------------------------*\
+        | Resume reading once the workers have drained half |
+        | of the packet queue, starting with the packets    |
+        | still in the receive buffer                       |
+        \*-------------------------------------------------*/
+        bool resumed = false;
+
+        WorkMutex.lock();
 
-        if(bytes_read <= 0)
+        if(client_info->recv_paused && (client_info->packets.size() < (NETWORK_SERVER_MAX_QUEUED_PACKETS / 2)))
         {
-            goto listen_done;
+            client_info->recv_paused = false;
+            resumed                  = true;
         }
 
-        //Test second character of magic - 'R'
-        if(header.pkt_magic[1] != 'R')
+        WorkMutex.unlock();
+
+        if(resumed && !ParseClientPackets(client_info))
         {
+            CloseClient(client_info);
             continue;
         }
 
-        //Read third byte of magic
-        bytes_read = recv_select(client_sock, &header.pkt_magic[2], 1, 0);
+        UpdateClientEvents(client_info);
+    }
+
+    /*-----------------------------------------------------*\
+    | Delete closed clients that no worker is using         |
+    \*-----------------------------------------------------*/
+    WorkMutex.lock();
 
-        if(bytes_read <= 0)
-        {
-            goto listen_done;
-        }
+    for(std::size_t client_idx = 0; client_idx < ClosedClients.size();)
+    {
+        NetworkClientInfo * client_info = ClosedClients[client_idx];
 
-        //Test third character of magic - 'G'
-        if(header.pkt_magic[2] != 'G')
+        if(client_info->ready || client_info->running)
         {
+            client_idx++;
             continue;
         }
 
-        //Read fourth byte of magic
-        bytes_read = recv_select(client_sock, &header.pkt_magic[3], 1, 0);
-
-        if(bytes_read <= 0)
+        if(client_info->update_pending)
         {
-            goto listen_done;
+            for(std::size_t update_idx = 0; update_idx < ReactorUpdates.size(); update_idx++)
+            {
+                if(ReactorUpdates[update_idx] == client_info)
+                {
+                    ReactorUpdates.erase(ReactorUpdates.begin() + update_idx);
+                    break;
+                }
+            }
         }
 
-        //Test fourth character of magic - 'B'
-        if(header.pkt_magic[3] != 'B')
+        ClosedClients.erase(ClosedClients.begin() + client_idx);
+
+        delete client_info;
+    }
+
+    WorkMutex.unlock();
+}
+
+void NetworkServer::WorkerThreadFunction()
+{
+    std::unique_lock<std::mutex> work_lock(WorkMutex);
+
+    while(1)
+    {
+        WorkCV.wait(work_lock, [this]{ return(!ReadyClients.empty() || !workers_running); });
+
+        if(!workers_running)
         {
-            continue;
+            break;
         }
 
-        //If we get to this point, the magic is correct.  Read the rest of the header
-        bytes_read = 0;
-        do
-        {
-            int tmp_bytes_read = 0;
+        /*-------------------------------------------------*\
+        | Take the next ready client and its oldest packet  |
+        \*-------------------------------------------------*/
+        NetworkClientInfo *   client_info = ReadyClients.front();
+        ReadyClients.pop_front();
 
-            tmp_bytes_read = recv_select(client_sock, (char *)&header.pkt_dev_idx + bytes_read, sizeof(header) - sizeof(header.pkt_magic) - bytes_read, 0);
+        NetworkServerPacket * packet      = client_info->packets.front();
+        client_info->packets.pop_front();
 
-            bytes_read += tmp_bytes_read;
+        client_info->ready   = false;
+        client_info->running = true;
 
-            if(tmp_bytes_read <= 0)
-            {
-                goto listen_done;
-            }
+        worker_packet_seq = ++work_seq;
+        RunningPackets.insert(worker_packet_seq);
+
+        work_lock.unlock();
+
+        ProcessPacket(client_info, packet);
+
+        work_lock.lock();
+
+        RunningPackets.erase(worker_packet_seq);
+        worker_packet_seq = 0;
+
+        WorkDoneCV.notify_all();
 
-        } while(bytes_read != sizeof(header) - sizeof(header.pkt_magic));
+        client_info->running = false;
+        client_info->free_packets.push_back(packet);
 
-        //Header received, now receive the data
-        if(header.pkt_size > 0)
+        /*-------------------------------------------------*\
+        | Requeue the client at the back of the ready queue |
+        | so busy clients cannot starve the others          |
+        \*-------------------------------------------------*/
+        if(!client_info->packets.empty())
         {
-            bytes_read = 0;
+            client_info->ready = true;
+            ReadyClients.push_back(client_info);
 
-            data = new char[header.pkt_size];
+            WorkCV.notify_one();
+        }
 
-            do
-            {
-                int tmp_bytes_read = 0;
+        /*-------------------------------------------------*\
+        | Let the connection thread resume reading a paused |
+        | client or delete a closed one                     |
+        \*-------------------------------------------------*/
+        if((client_info->recv_paused && (client_info->packets.size() < (NETWORK_SERVER_MAX_QUEUED_PACKETS / 2)))
+        || (client_info->closing && !client_info->ready))
+        {
+            PostReactorUpdate(client_info);
+        }
+    }
+}
+
+void NetworkServer::ProcessPacket(NetworkClientInfo * client_info, NetworkServerPacket * packet)
+{
+    NetPacketHeader&    header  = packet->header;
+    char *              data    = NULL;
+
+    if(header.pkt_size > 0)
+    {
+        data = packet->data.data();
+    }
 
-                tmp_bytes_read = recv_select(client_sock, &data[(unsigned int)bytes_read], header.pkt_size - bytes_read, 0);
+    //Entire request received, select functionality based on request ID
+    switch(header.pkt_id)
+    {
+        case NET_PACKET_ID_REQUEST_CONTROLLER_COUNT:
+            SendReply_ControllerCount(client_info);
+            break;
+
+        case NET_PACKET_ID_REQUEST_CONTROLLER_DATA:
+            {
+                unsigned int protocol_version = 0;
 
-                if(tmp_bytes_read <= 0)
+                if(header.pkt_size == sizeof(unsigned int))
                 {
-                    goto listen_done;
+                    memcpy(&protocol_version, data, sizeof(unsigned int));
                 }
-                bytes_read += tmp_bytes_read;
 
-            } while ((unsigned int)bytes_read < header.pkt_size);
-        }
+                SendReply_ControllerData(client_info, header.pkt_dev_idx, protocol_version);
+            }
+            break;
 
-        //Entire request received, select functionality based on request ID
-        switch(header.pkt_id)
-        {
-            case NET_PACKET_ID_REQUEST_CONTROLLER_COUNT:
-                SendReply_ControllerCount(client_sock);
+        case NET_PACKET_ID_REQUEST_DEVICE_IDS:
+            SendReply_DeviceIDs(client_info);
+            break;
+
+        case NET_PACKET_ID_REQUEST_PROTOCOL_VERSION:
+            SendReply_ProtocolVersion(client_info);
+            ProcessRequest_ClientProtocolVersion(client_info, header.pkt_size, data);
+            break;
+
+        case NET_PACKET_ID_SET_CLIENT_NAME:
+            if(data == NULL)
+            {
                 break;
+            }
 
-            case NET_PACKET_ID_REQUEST_CONTROLLER_DATA:
-                {
-                    unsigned int protocol_version = 0;
+            ProcessRequest_ClientString(client_info, header.pkt_size, data);
+            break;
 
-                    if(header.pkt_size == sizeof(unsigned int))
-                    {
-                        memcpy(&protocol_version, data, sizeof(unsigned int));
-                    }
+        case NET_PACKET_ID_REQUEST_UDP_CHANNEL:
+            ProcessRequest_UDPChannel(client_info);
+            break;
 
-                    SendReply_ControllerData(client_sock, header.pkt_dev_idx, protocol_version);
-                }
+        case NET_PACKET_ID_REQUEST_COLOR_SUBSCRIPTION:
+            if(data == NULL)
+            {
                 break;
+            }
 
-            case NET_PACKET_ID_REQUEST_PROTOCOL_VERSION:
-                SendReply_ProtocolVersion(client_sock);
-                ProcessRequest_ClientProtocolVersion(client_sock, header.pkt_size, data);
+            ProcessRequest_ColorSubscription(client_info, header.pkt_size, data);
+            break;
+
+        case NET_PACKET_ID_RGBCONTROLLER_RESIZEZONE:
+            if(data == NULL)
+            {
                 break;
+            }
 
-            case NET_PACKET_ID_SET_CLIENT_NAME:
-                if(data == NULL)
-                {
-                    break;
-                }
+            if((header.pkt_dev_idx < controllers.size()) && (header.pkt_size == (2 * sizeof(int))))
+            {
+                int zone;
+                int new_size;
+
+                memcpy(&zone, data, sizeof(int));
+                memcpy(&new_size, data + sizeof(int), sizeof(int));
+
+                controllers[header.pkt_dev_idx]->ResizeZone(zone, new_size);
+            }
+            break;
 
-                ProcessRequest_ClientString(client_sock, header.pkt_size, data);
+        case NET_PACKET_ID_RGBCONTROLLER_UPDATELEDS:
+            if(data == NULL)
+            {
                 break;
+            }
 
-            case NET_PACKET_ID_RGBCONTROLLER_RESIZEZONE:
-                if(data == NULL)
+            if(header.pkt_dev_idx < controllers.size())
+            {
+                if(controllers[header.pkt_dev_idx]->SetColorDescription((unsigned char *)data, header.pkt_size))
                 {
-                    break;
+                    controllers[header.pkt_dev_idx]->UpdateLEDs();
                 }
+            }
+            break;
 
-                if((header.pkt_dev_idx < controllers.size()) && (header.pkt_size == (2 * sizeof(int))))
-                {
-                    int zone;
-                    int new_size;
+        case NET_PACKET_ID_RGBCONTROLLER_MULTIUPDATELEDS:
+            if(data == NULL)
+            {
+                break;
+            }
 
-                    memcpy(&zone, data, sizeof(int));
-                    memcpy(&new_size, data + sizeof(int), sizeof(int));
+            ProcessRequest_RGBController_MultiUpdateLEDs(header.pkt_size, data);
+            break;
 
-                    controllers[header.pkt_dev_idx]->ResizeZone(zone, new_size);
-                }
+        case NET_PACKET_ID_RGBCONTROLLER_DELTAUPDATELEDS:
+            if(data == NULL)
+            {
                 break;
+            }
 
-            case NET_PACKET_ID_RGBCONTROLLER_UPDATELEDS:
-                if(data == NULL)
-                {
-                    break;
-                }
+            ProcessRequest_RGBController_DeltaUpdateLEDs(client_info, header.pkt_dev_idx, header.pkt_size, data);
+            break;
 
-                if(header.pkt_dev_idx < controllers.size())
-                {
-                    controllers[header.pkt_dev_idx]->SetColorDescription((unsigned char *)data);
-                    controllers[header.pkt_dev_idx]->UpdateLEDs();
-                }
+        case NET_PACKET_ID_RGBCONTROLLER_UPDATEZONELEDS:
+            if(data == NULL)
+            {
                 break;
+            }
 
-            case NET_PACKET_ID_RGBCONTROLLER_UPDATEZONELEDS:
-                if(data == NULL)
-                {
-                    break;
-                }
+            if(header.pkt_dev_idx < controllers.size())
+            {
+                int zone;
 
-                if(header.pkt_dev_idx < controllers.size())
+                if(controllers[header.pkt_dev_idx]->SetZoneColorDescription((unsigned char *)data, header.pkt_size))
                 {
-                    int zone;
-
                     memcpy(&zone, &data[sizeof(unsigned int)], sizeof(int));
 
-                    controllers[header.pkt_dev_idx]->SetZoneColorDescription((unsigned char *)data);
                     controllers[header.pkt_dev_idx]->UpdateZoneLEDs(zone);
                 }
+            }
+            break;
+
+        case NET_PACKET_ID_RGBCONTROLLER_UPDATESINGLELED:
+            if(data == NULL)
+            {
                 break;
+            }
 
-            case NET_PACKET_ID_RGBCONTROLLER_UPDATESINGLELED:
-                if(data == NULL)
-                {
-                    break;
-                }
+            if(header.pkt_dev_idx < controllers.size())
+            {
+                int led;
 
-                if(header.pkt_dev_idx < controllers.size())
+                if(controllers[header.pkt_dev_idx]->SetSingleLEDColorDescription((unsigned char *)data, header.pkt_size))
                 {
-                    int led;
-
                     memcpy(&led, data, sizeof(int));
 
-                    controllers[header.pkt_dev_idx]->SetSingleLEDColorDescription((unsigned char *)data);
                     controllers[header.pkt_dev_idx]->UpdateSingleLED(led);
                 }
-                break;
+            }
+            break;
 
-            case NET_PACKET_ID_RGBCONTROLLER_SETCUSTOMMODE:
-                if(header.pkt_dev_idx < controllers.size())
+        case NET_PACKET_ID_RGBCONTROLLER_SETCUSTOMMODE:
+            if(header.pkt_dev_idx < controllers.size())
+            {
+                controllers[header.pkt_dev_idx]->SetCustomMode();
+            }
+            break;
+
+        case NET_PACKET_ID_RGBCONTROLLER_UPDATEMODE:
+            if(data == NULL)
+            {
+                break;
+            }
+
+            if(header.pkt_dev_idx < controllers.size())
+            {
+                if(controllers[header.pkt_dev_idx]->SetModeDescription((unsigned char *)data, header.pkt_size, client_info->client_protocol_version))
                 {
-                    controllers[header.pkt_dev_idx]->SetCustomMode();
+                    controllers[header.pkt_dev_idx]->UpdateMode();
                 }
+            }
+            break;
+
+        case NET_PACKET_ID_RGBCONTROLLER_SAVEMODE:
+            if(data == NULL)
+            {
                 break;
+            }
 
-            case NET_PACKET_ID_RGBCONTROLLER_UPDATEMODE:
-                if(data == NULL)
+            if(header.pkt_dev_idx < controllers.size())
+            {
+                if(controllers[header.pkt_dev_idx]->SetModeDescription((unsigned char *)data, header.pkt_size, client_info->client_protocol_version))
                 {
-                    break;
+                    controllers[header.pkt_dev_idx]->SaveMode();
                 }
+            }
+            break;
+
+        case NET_PACKET_ID_RGBCONTROLLER_GETSTATS:
+            SendReply_ControllerStats(client_info, header.pkt_dev_idx);
+            break;
+
+        case NET_PACKET_ID_REQUEST_PROFILE_LIST:
+            SendReply_ProfileList(client_info);
+            break;
+
+        case NET_PACKET_ID_REQUEST_SAVE_PROFILE:
+            if(data == NULL)
+            {
+                break;
+            }
+
+            if(profile_manager)
+            {
+                profile_manager->SaveProfile(data);
+            }
+
+            break;
+
+        case NET_PACKET_ID_REQUEST_LOAD_PROFILE:
+            if(data == NULL)
+            {
+                break;
+            }
+
+            if(profile_manager)
+            {
+                profile_manager->LoadProfile(data);
+            }
+
+            for(RGBController* controller : controllers)
+            {
+                controller->UpdateLEDs();
+            }
+
+            break;
+
+        case NET_PACKET_ID_REQUEST_DELETE_PROFILE:
+            if(data == NULL)
+            {
+                break;
+            }
+
+            if(profile_manager)
+            {
+                profile_manager->DeleteProfile(data);
+            }
+
+            break;
+    }
+}
+
+void NetworkServer::ProcessRequest_ClientProtocolVersion(NetworkClientInfo * client_info, unsigned int data_size, char * data)
+{
+    unsigned int protocol_version = 0;
+
+    if(data_size == sizeof(unsigned int) && (data != NULL))
+    {
+        memcpy(&protocol_version, data, sizeof(unsigned int));
+    }
+
+    if(protocol_version > OPENRGB_SDK_PROTOCOL_VERSION)
+    {
+        protocol_version = OPENRGB_SDK_PROTOCOL_VERSION;
+    }
+
+    ServerClientsMutex.lock();
+    client_info->client_protocol_version = protocol_version;
+    ServerClientsMutex.unlock();
+
+    /*-------------------------------------------------*\
+    | Client info has changed, call the callbacks       |
+    \*-------------------------------------------------*/
+    ClientInfoChanged();
+}
+
+void NetworkServer::ProcessRequest_ClientString(NetworkClientInfo * client_info, unsigned int /*data_size*/, char * data)
+{
+    ServerClientsMutex.lock();
+    client_info->client_string = data;
+    ServerClientsMutex.unlock();
+
+    /*-------------------------------------------------*\
+    | Client info has changed, call the callbacks       |
+    \*-------------------------------------------------*/
+    ClientInfoChanged();
+}
+
+/*---------------------------------------------------------*\
+| Reads one device entry of a multi-device LED update: the  |
+| device index followed by a color description.  Returns    |
+| false if the entry is cut short or its size is wrong.     |
+\*---------------------------------------------------------*/
+static bool ReadMultiUpdateEntry(RGBControllerBufferReader& reader, const char * data, unsigned int& dev_idx, const unsigned char *& color_data, unsigned int& color_size)
+{
+    unsigned short num_colors;
+
+    reader.Read(dev_idx);
+
+    color_data = (const unsigned char *)data + reader.GetPosition();
+
+    reader.Read(color_size);
+    reader.Read(num_colors);
+
+    if(reader.Failed() || (color_size != (sizeof(unsigned int) + sizeof(unsigned short) + (num_colors * sizeof(RGBColor)))))
+    {
+        return(false);
+    }
+
+    return(reader.Skip(num_colors * sizeof(RGBColor)));
+}
+
+/*---------------------------------------------------------*\
+| Applies colors to several devices from one packet.  Every |
+| entry is checked before any colors change, then all of    |
+| the devices are updated together so the frame lands on    |
+| each of them at the same time.                            |
+\*---------------------------------------------------------*/
+void NetworkServer::ProcessRequest_RGBController_MultiUpdateLEDs(unsigned int data_size, char * data)
+{
+    const unsigned char *   color_data;
+    unsigned int            color_size;
+    unsigned int            dev_idx;
+    unsigned short          num_devices;
+
+    /*-----------------------------------------------------*\
+    | Check all entries                                     |
+    \*-----------------------------------------------------*/
+    RGBControllerBufferReader check_reader((const unsigned char *)data, data_size);
+
+    check_reader.Skip(sizeof(unsigned int));
+    check_reader.Read(num_devices);
+
+    for(unsigned short device_idx = 0; device_idx < num_devices; device_idx++)
+    {
+        if(!ReadMultiUpdateEntry(check_reader, data, dev_idx, color_data, color_size)
+        || (dev_idx >= controllers.size())
+        || (((color_size - sizeof(unsigned int) - sizeof(unsigned short)) / sizeof(RGBColor)) > controllers[dev_idx]->colors.size()))
+        {
+            return;
+        }
+    }
+
+    if(check_reader.Failed())
+    {
+        return;
+    }
+
+    /*-----------------------------------------------------*\
+    | Set the colors of every device                        |
+    \*-----------------------------------------------------*/
+    RGBControllerBufferReader color_reader((const unsigned char *)data, data_size);
+
+    color_reader.Skip(sizeof(unsigned int) + sizeof(unsigned short));
+
+    for(unsigned short device_idx = 0; device_idx < num_devices; device_idx++)
+    {
+        ReadMultiUpdateEntry(color_reader, data, dev_idx, color_data, color_size);
+
+        controllers[dev_idx]->SetColorDescription(color_data, color_size);
+    }
+
+    /*-----------------------------------------------------*\
+    | Then start the update on all of them                  |
+    \*-----------------------------------------------------*/
+    RGBControllerBufferReader update_reader((const unsigned char *)data, data_size);
+
+    update_reader.Skip(sizeof(unsigned int) + sizeof(unsigned short));
+
+    for(unsigned short device_idx = 0; device_idx < num_devices; device_idx++)
+    {
+        ReadMultiUpdateEntry(update_reader, data, dev_idx, color_data, color_size);
+
+        controllers[dev_idx]->UpdateLEDs();
+    }
+}
+
+/*---------------------------------------------------------*\
+| Rebuilds a frame from this client's previous frame for    |
+| the device and applies it                                 |
+\*---------------------------------------------------------*/
+void NetworkServer::ProcessRequest_RGBController_DeltaUpdateLEDs(NetworkClientInfo * client_info, unsigned int dev_idx, unsigned int data_size, char * data)
+{
+    if(dev_idx >= controllers.size())
+    {
+        return;
+    }
+
+    NetworkColorDeltaDecoder& decoder = client_info->delta_decoders[dev_idx];
+
+    if(!decoder.Decode((const unsigned char *)data, data_size))
+    {
+        return;
+    }
+
+    const std::vector<RGBColor>& new_colors = decoder.GetColors();
+    RGBController *              controller = controllers[dev_idx];
+
+    if(new_colors.size() > controller->colors.size())
+    {
+        return;
+    }
+
+    if(!new_colors.empty())
+    {
+        memcpy(&controller->colors[0], new_colors.data(), new_colors.size() * sizeof(RGBColor));
+    }
+
+    controller->UpdateLEDs();
+}
+
+/*---------------------------------------------------------*\
+| Gives the client a token for the UDP channel and replies  |
+| with the UDP port, or port 0 if there is no UDP channel:  |
+|                                                           |
+|   unsigned short  udp_port                                |
+|   unsigned int    udp_token                               |
+\*---------------------------------------------------------*/
+void NetworkServer::ProcessRequest_UDPChannel(NetworkClientInfo * client_info)
+{
+    NetPacketHeader reply_hdr;
+    unsigned short  udp_port    = 0;
+    unsigned int    udp_token   = 0;
+
+    ServerClientsMutex.lock();
+
+    /*-----------------------------------------------------*\
+    | Only register clients that are still connected, so a  |
+    | closed client cannot be left in the session map       |
+    \*-----------------------------------------------------*/
+    if(IsClientConnected(client_info) && (udp_sock != INVALID_SOCKET))
+    {
+        if(client_info->udp_token == 0)
+        {
+            do
+            {
+                udp_token = UDPTokenGenerator();
+            } while((udp_token == 0) || (UDPSessions.find(udp_token) != UDPSessions.end()));
+
+            client_info->udp_token = udp_token;
+            UDPSessions[udp_token] = client_info;
+        }
+
+        udp_port  = port_num;
+        udp_token = client_info->udp_token;
+    }
+
+    ServerClientsMutex.unlock();
+
+    unsigned char reply_data[sizeof(udp_port) + sizeof(udp_token)];
+
+    memcpy(&reply_data[0], &udp_port, sizeof(udp_port));
+    memcpy(&reply_data[sizeof(udp_port)], &udp_token, sizeof(udp_token));
+
+    reply_hdr.pkt_magic[0] = 'O';
+    reply_hdr.pkt_magic[1] = 'R';
+    reply_hdr.pkt_magic[2] = 'G';
+    reply_hdr.pkt_magic[3] = 'B';
+
+    reply_hdr.pkt_dev_idx  = 0;
+    reply_hdr.pkt_id       = NET_PACKET_ID_REQUEST_UDP_CHANNEL;
+    reply_hdr.pkt_size     = sizeof(reply_data);
+
+    SendPacket(client_info, &reply_hdr, reply_data, sizeof(reply_data));
+}
+
+void NetworkServer::ReadUDP()
+{
+    while(1)
+    {
+        sockaddr_in from_addr;
+        socklen_t   from_addr_len = sizeof(from_addr);
+
+        int bytes_read = recvfrom(udp_sock, udp_buf.data(), (int)udp_buf.size(), 0, (sockaddr *)&from_addr, &from_addr_len);
+
+        if(bytes_read < 0)
+        {
+            return;
+        }
+
+        ProcessUDPPacket(udp_buf.data(), (unsigned int)bytes_read, from_addr);
+    }
+}
+
+/*---------------------------------------------------------*\
+| A UDP LED update is one datagram holding a packet header  |
+| with the device index, then:                              |
+|                                                           |
+|   unsigned int    udp_token                               |
+|   unsigned int    frame_seq                               |
+|   color description, as in UPDATELEDS                     |
+|                                                           |
+| frame_seq counts up with every datagram the client sends. |
+| Datagrams can be lost or reordered, so a frame older than |
+| the last one applied to the device is dropped rather than |
+| applied.                                                  |
+\*---------------------------------------------------------*/
+void NetworkServer::ProcessUDPPacket(const char * data, unsigned int size, const sockaddr_in& from_addr)
+{
+    NetPacketHeader header;
+    unsigned int    udp_token;
+    unsigned int    frame_seq;
+
+    if(size < (sizeof(NetPacketHeader) + sizeof(udp_token) + sizeof(frame_seq)))
+    {
+        return;
+    }
+
+    memcpy(&header, data, sizeof(NetPacketHeader));
+
+    if((memcmp(header.pkt_magic, "ORGB", sizeof(header.pkt_magic)) != 0)
+    || (header.pkt_id != NET_PACKET_ID_RGBCONTROLLER_UDPUPDATELEDS)
+    || (header.pkt_size != (size - sizeof(NetPacketHeader))))
+    {
+        return;
+    }
+
+    memcpy(&udp_token, data + sizeof(NetPacketHeader), sizeof(udp_token));
+    memcpy(&frame_seq, data + sizeof(NetPacketHeader) + sizeof(udp_token), sizeof(frame_seq));
+
+    /*-----------------------------------------------------*\
+    | Accept the datagram only from the client's address    |
+    | and only if it is newer than the last one applied.    |
+    | The device is updated with ServerClientsMutex held,   |
+    | which ControllerRemoved() takes before a controller   |
+    | is deleted.                                           |
+    \*-----------------------------------------------------*/
+    bool apply = false;
+
+    ServerClientsMutex.lock();
+
+    if(header.pkt_dev_idx >= controllers.size())
+    {
+        ServerClientsMutex.unlock();
+        return;
+    }
+
+    std::map<unsigned int, NetworkClientInfo *>::iterator session = UDPSessions.find(udp_token);
+
+    if((session != UDPSessions.end()) && (memcmp(&session->second->client_addr, &from_addr.sin_addr, sizeof(in_addr)) == 0))
+    {
+        std::map<unsigned int, unsigned int>&          frame_seqs = session->second->udp_frame_seqs;
+        std::map<unsigned int, unsigned int>::iterator last_seq   = frame_seqs.find(header.pkt_dev_idx);
+
+        if((last_seq == frame_seqs.end()) || ((int)(frame_seq - last_seq->second) > 0))
+        {
+            frame_seqs[header.pkt_dev_idx] = frame_seq;
+            apply                          = true;
+        }
+    }
+
+    if(apply)
+    {
+        const unsigned char *   color_data = (const unsigned char *)data + sizeof(NetPacketHeader) + sizeof(udp_token) + sizeof(frame_seq);
+        unsigned int            color_size = header.pkt_size - sizeof(udp_token) - sizeof(frame_seq);
+
+        if(controllers[header.pkt_dev_idx]->SetColorDescription(color_data, color_size))
+        {
+            controllers[header.pkt_dev_idx]->UpdateLEDs();
+        }
+    }
+
+    ServerClientsMutex.unlock();
+}
+
+/*---------------------------------------------------------*\
+| Returns true if the client has not been closed.  Must be  |
+| called with ServerClientsMutex held.                      |
+\*---------------------------------------------------------*/
+bool NetworkServer::IsClientConnected(NetworkClientInfo * client_info)
+{
+    for(std::size_t client_idx = 0; client_idx < ServerClients.size(); client_idx++)
+    {
+        if(ServerClients[client_idx] == client_info)
+        {
+            return(true);
+        }
+    }
+
+    return(false);
+}
+
+/*---------------------------------------------------------*\
+| Subscribes the client to the colors of a list of devices, |
+| replacing its previous subscription:                      |
+|                                                           |
+|   unsigned int    data_size                               |
+|   unsigned int    max_rate                                |
+|   unsigned short  num_devices                             |
+|   unsigned int    dev_idx[num_devices]                    |
+|                                                           |
+| Whenever a subscribed device is updated, its colors are   |
+| sent to the client in a DEVICE_COLORS_UPDATED packet, at  |
+| most max_rate times per second.  Updates in between are   |
+| coalesced and only the latest colors are sent.  A         |
+| max_rate of 0 means the server's highest rate, and no     |
+| devices ends the subscription.                            |
+\*---------------------------------------------------------*/
+void NetworkServer::ProcessRequest_ColorSubscription(NetworkClientInfo * client_info, unsigned int data_size, char * data)
+{
+    RGBControllerBufferReader reader((const unsigned char *)data, data_size);
+
+    unsigned int    max_rate;
+    unsigned short  num_devices;
+
+    reader.Skip(sizeof(unsigned int));
+    reader.Read(max_rate);
+    reader.Read(num_devices);
+
+    if(reader.Failed() || !reader.CanRead(num_devices, sizeof(unsigned int)))
+    {
+        return;
+    }
+
+    if((max_rate == 0) || (max_rate > NETWORK_SERVER_MAX_COLOR_RATE))
+    {
+        max_rate = NETWORK_SERVER_MAX_COLOR_RATE;
+    }
+
+    std::vector<NetworkColorWatch *> released_watches;
+
+    ColorWatchMutex.lock();
+    ServerClientsMutex.lock();
+
+    if(!IsClientConnected(client_info))
+    {
+        ServerClientsMutex.unlock();
+        ColorWatchMutex.unlock();
+        return;
+    }
+
+    ClearColorSubscription(client_info);
+
+    for(unsigned short device_idx = 0; device_idx < num_devices; device_idx++)
+    {
+        unsigned int dev_idx;
+
+        reader.Read(dev_idx);
+
+        if((dev_idx >= controllers.size())
+        || (std::find(client_info->color_dev_idxs.begin(), client_info->color_dev_idxs.end(), dev_idx) != client_info->color_dev_idxs.end()))
+        {
+            continue;
+        }
+
+        /*-------------------------------------------------*\
+        | Start watching the controller on first use        |
+        \*-------------------------------------------------*/
+        RGBController *     controller  = controllers[dev_idx];
+        NetworkColorWatch * watch;
 
-                if(header.pkt_dev_idx < controllers.size())
-                {
-                    controllers[header.pkt_dev_idx]->SetModeDescription((unsigned char *)data, client_info->client_protocol_version);
-                    controllers[header.pkt_dev_idx]->UpdateMode();
-                }
-                break;
+        std::map<RGBController *, NetworkColorWatch *>::iterator watch_it = ColorWatches.find(controller);
 
-            case NET_PACKET_ID_RGBCONTROLLER_SAVEMODE:
-                if(data == NULL)
-                {
-                    break;
-                }
+        if(watch_it == ColorWatches.end())
+        {
+            watch = new NetworkColorWatch();
 
-                if(header.pkt_dev_idx < controllers.size())
-                {
-                    controllers[header.pkt_dev_idx]->SetModeDescription((unsigned char *)data, client_info->client_protocol_version);
-                    controllers[header.pkt_dev_idx]->SaveMode();
-                }
-                break;
+            watch->server       = this;
+            watch->controller   = controller;
+            watch->generation   = 0;
 
-            case NET_PACKET_ID_REQUEST_PROFILE_LIST:
-                SendReply_ProfileList(client_sock);
-                break;
+            ColorWatches[controller] = watch;
 
-            case NET_PACKET_ID_REQUEST_SAVE_PROFILE:
-                if(data == NULL)
-                {
-                    break;
-                }
+            controller->RegisterUpdateCallback(ColorWatchCallback, watch);
+        }
+        else
+        {
+            watch = watch_it->second;
+        }
 
-                if(profile_manager)
-                {
-                    profile_manager->SaveProfile(data);
-                }
+        /*-------------------------------------------------*\
+        | Start one generation behind so that the current   |
+        | colors are sent straight away                     |
+        \*-------------------------------------------------*/
+        client_info->color_dev_idxs.push_back(dev_idx);
+        client_info->color_watches.push_back(watch);
+        client_info->color_generations.push_back(watch->generation.load() - 1);
+    }
 
-                break;
+    client_info->color_interval  = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::microseconds(1000000 / max_rate));
+    client_info->color_next_push = std::chrono::steady_clock::now();
 
-            case NET_PACKET_ID_REQUEST_LOAD_PROFILE:
-                if(data == NULL)
-                {
-                    break;
-                }
+    UpdateColorWatches(released_watches);
 
-                if(profile_manager)
-                {
-                    profile_manager->LoadProfile(data);
-                }
+    ServerClientsMutex.unlock();
 
-                for(RGBController* controller : controllers)
-                {
-                    controller->UpdateLEDs();
-                }
+    ReleaseColorWatches(released_watches);
 
-                break;
+    ColorWatchMutex.unlock();
 
-            case NET_PACKET_ID_REQUEST_DELETE_PROFILE:
-                if(data == NULL)
-                {
-                    break;
-                }
+    if(Poller)
+    {
+        Poller->Wake();
+    }
+}
 
-                if(profile_manager)
-                {
-                    profile_manager->DeleteProfile(data);
-                }
+/*---------------------------------------------------------*\
+| Called by a watched controller after every update, from   |
+| whichever thread updated it.  Wakes the connection thread |
+| once for any number of updates until it has looked.       |
+\*---------------------------------------------------------*/
+void NetworkServer::ColorWatchCallback(void * arg)
+{
+    NetworkColorWatch * watch = (NetworkColorWatch *)arg;
 
-                break;
-        }
+    watch->generation++;
 
-        delete[] data;
+    if(!watch->server->color_wake_pending.exchange(true))
+    {
+        watch->server->Poller->Wake();
     }
+}
 
-listen_done:
+/*---------------------------------------------------------*\
+| Must be called with ServerClientsMutex held               |
+\*---------------------------------------------------------*/
+void NetworkServer::ClearColorSubscription(NetworkClientInfo * client_info)
+{
+    client_info->color_dev_idxs.clear();
+    client_info->color_watches.clear();
+    client_info->color_generations.clear();
+}
 
-    ServerClientsMutex.lock();
+/*---------------------------------------------------------*\
+| Takes the watches no client subscribes to off the watch   |
+| list.  Must be called with ColorWatchMutex and            |
+| ServerClientsMutex held, the watches are then released    |
+| once ServerClientsMutex is unlocked.                      |
+\*---------------------------------------------------------*/
+void NetworkServer::UpdateColorWatches(std::vector<NetworkColorWatch *>& released_watches)
+{
+    std::map<RGBController *, NetworkColorWatch *>::iterator watch_it = ColorWatches.begin();
 
-    for(unsigned int this_idx = 0; this_idx < ServerClients.size(); this_idx++)
+    while(watch_it != ColorWatches.end())
     {
-        if(ServerClients[this_idx] == client_info)
+        NetworkColorWatch * watch   = watch_it->second;
+        bool                in_use  = false;
+
+        for(std::size_t client_idx = 0; (client_idx < ServerClients.size()) && !in_use; client_idx++)
         {
-            delete client_info;
-            ServerClients.erase(ServerClients.begin() + this_idx);
-            break;
+            std::vector<NetworkColorWatch *>& client_watches = ServerClients[client_idx]->color_watches;
+
+            in_use = (std::find(client_watches.begin(), client_watches.end(), watch) != client_watches.end());
         }
-    }
 
-    client_info = nullptr;
+        if(in_use)
+        {
+            watch_it++;
+            continue;
+        }
 
-    ServerClientsMutex.unlock();
+        released_watches.push_back(watch);
 
-    /*-------------------------------------------------*\
-    | Client info has changed, call the callbacks       |
-    \*-------------------------------------------------*/
-    ClientInfoChanged();
+        watch_it = ColorWatches.erase(watch_it);
+    }
 }
 
-void NetworkServer::ProcessRequest_ClientProtocolVersion(SOCKET client_sock, unsigned int data_size, char * data)
+/*---------------------------------------------------------*\
+| Unregisters and deletes watches taken off the watch list. |
+| Must be called with ColorWatchMutex held, so the watched  |
+| controllers cannot be removed meanwhile.  Unregistering   |
+| waits for update callbacks in progress, which is why      |
+| ServerClientsMutex must not be held.                      |
+\*---------------------------------------------------------*/
+void NetworkServer::ReleaseColorWatches(std::vector<NetworkColorWatch *>& released_watches)
 {
-    unsigned int protocol_version = 0;
-
-    if(data_size == sizeof(unsigned int) && (data != NULL))
+    for(std::size_t watch_idx = 0; watch_idx < released_watches.size(); watch_idx++)
     {
-        memcpy(&protocol_version, data, sizeof(unsigned int));
+        released_watches[watch_idx]->controller->UnregisterUpdateCallback(released_watches[watch_idx]);
+
+        delete released_watches[watch_idx];
     }
 
-    if(protocol_version > OPENRGB_SDK_PROTOCOL_VERSION)
+    released_watches.clear();
+}
+
+/*---------------------------------------------------------*\
+| Sends each subscribed client the colors of its devices    |
+| that changed since the last push, once its interval has   |
+| passed and its earlier replies have been sent.  Returns   |
+| how long the connection thread may wait before the next   |
+| push is due, in milliseconds.                             |
+\*---------------------------------------------------------*/
+int NetworkServer::PushColorUpdates()
+{
+    int timeout_ms = TCP_TIMEOUT_SECONDS * 1000;
+
+    color_wake_pending = false;
+
+    ServerClientsMutex.lock();
+
+    if(ColorWatches.empty())
     {
-        protocol_version = OPENRGB_SDK_PROTOCOL_VERSION;
+        ServerClientsMutex.unlock();
+        return(timeout_ms);
     }
 
-    ServerClientsMutex.lock();
-    for(unsigned int this_idx = 0; this_idx < ServerClients.size(); this_idx++)
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+
+    for(std::size_t client_idx = 0; client_idx < ServerClients.size(); client_idx++)
     {
-        if(ServerClients[this_idx]->client_sock == client_sock)
+        NetworkClientInfo * client_info = ServerClients[client_idx];
+        bool                changed     = false;
+
+        for(std::size_t sub_idx = 0; (sub_idx < client_info->color_watches.size()) && !changed; sub_idx++)
         {
-            ServerClients[this_idx]->client_protocol_version = protocol_version;
-            break;
+            changed = (client_info->color_watches[sub_idx]->generation.load() != client_info->color_generations[sub_idx]);
         }
-    }
-    ServerClientsMutex.unlock();
 
-    /*-------------------------------------------------*\
-    | Client info has changed, call the callbacks       |
-    \*-------------------------------------------------*/
-    ClientInfoChanged();
-}
+        if(!changed)
+        {
+            continue;
+        }
 
-void NetworkServer::ProcessRequest_ClientString(SOCKET client_sock, unsigned int /*data_size*/, char * data)
-{
-    ServerClientsMutex.lock();
-    for(unsigned int this_idx = 0; this_idx < ServerClients.size(); this_idx++)
-    {
-        if(ServerClients[this_idx]->client_sock == client_sock)
+        /*-------------------------------------------------*\
+        | Wait for the client's interval to pass            |
+        \*-------------------------------------------------*/
+        if(now < client_info->color_next_push)
         {
-            ServerClients[this_idx]->client_string = data;
-            break;
+            int wait_ms = (int)std::chrono::duration_cast<std::chrono::milliseconds>(client_info->color_next_push - now).count() + 1;
+
+            if(wait_ms < timeout_ms)
+            {
+                timeout_ms = wait_ms;
+            }
+
+            continue;
+        }
+
+        /*-------------------------------------------------*\
+        | Hold back while earlier data is still queued, the |
+        | connection thread looks again once it is flushed  |
+        \*-------------------------------------------------*/
+        client_info->send_mutex.lock();
+        bool send_pending = !client_info->send_buf.empty();
+        client_info->send_mutex.unlock();
+
+        if(send_pending)
+        {
+            continue;
+        }
+
+        /*-------------------------------------------------*\
+        | Build a packet with the changed devices, laid out |
+        | as in MULTIUPDATELEDS                             |
+        \*-------------------------------------------------*/
+        RGBControllerBufferWriter   push_writer(color_push_buf);
+        unsigned short              num_devices = 0;
+
+        push_writer.Write((unsigned int)0);
+        push_writer.Write(num_devices);
+
+        for(std::size_t sub_idx = 0; sub_idx < client_info->color_watches.size(); sub_idx++)
+        {
+            NetworkColorWatch * watch       = client_info->color_watches[sub_idx];
+            unsigned int        dev_idx     = client_info->color_dev_idxs[sub_idx];
+            unsigned long long  generation  = watch->generation.load();
+
+            if(generation == client_info->color_generations[sub_idx])
+            {
+                continue;
+            }
+
+            client_info->color_generations[sub_idx] = generation;
+
+            /*---------------------------------------------*\
+            | Skip a device that is being removed           |
+            \*---------------------------------------------*/
+            if((dev_idx >= controllers.size()) || (controllers[dev_idx] != watch->controller))
+            {
+                continue;
+            }
+
+            RGBController * controller = watch->controller;
+            unsigned short  num_colors = (unsigned short)controller->colors.size();
+            unsigned int    color_size = sizeof(color_size) + sizeof(num_colors) + (num_colors * sizeof(RGBColor));
+
+            push_writer.Write(dev_idx);
+            push_writer.Write(color_size);
+            push_writer.Write(num_colors);
+            push_writer.Write(controller->colors.data(), num_colors * sizeof(RGBColor));
+
+            num_devices++;
         }
+
+        if(num_devices == 0)
+        {
+            continue;
+        }
+
+        push_writer.Patch(0, (unsigned int)push_writer.GetSize());
+        push_writer.Patch(sizeof(unsigned int), num_devices);
+
+        NetPacketHeader pkt_hdr;
+
+        pkt_hdr.pkt_magic[0] = 'O';
+        pkt_hdr.pkt_magic[1] = 'R';
+        pkt_hdr.pkt_magic[2] = 'G';
+        pkt_hdr.pkt_magic[3] = 'B';
+
+        pkt_hdr.pkt_dev_idx  = 0;
+        pkt_hdr.pkt_id       = NET_PACKET_ID_DEVICE_COLORS_UPDATED;
+        pkt_hdr.pkt_size     = (unsigned int)push_writer.GetSize();
+
+        SendPacket(client_info, &pkt_hdr, push_writer.GetData(), pkt_hdr.pkt_size);
+
+        client_info->color_next_push = now + client_info->color_interval;
     }
+
     ServerClientsMutex.unlock();
 
-    /*-------------------------------------------------*\
-    | Client info has changed, call the callbacks       |
-    \*-------------------------------------------------*/
-    ClientInfoChanged();
+    return(timeout_ms);
 }
 
-void NetworkServer::SendReply_ControllerCount(SOCKET client_sock)
+void NetworkServer::SendReply_ControllerCount(NetworkClientInfo * client_info)
 {
     NetPacketHeader reply_hdr;
     unsigned int    reply_data;
@@ -845,20 +2200,21 @@ void NetworkServer::SendReply_ControllerCount(SOCKET client_sock)
 
     reply_data             = controllers.size();
 
-    send(client_sock, (const char *)&reply_hdr, sizeof(NetPacketHeader), 0);
-    send(client_sock, (const char *)&reply_data, sizeof(unsigned int), 0);
+    SendPacket(client_info, &reply_hdr, &reply_data, sizeof(unsigned int));
 }
 
-void NetworkServer::SendReply_ControllerData(SOCKET client_sock, unsigned int dev_idx, unsigned int protocol_version)
+void NetworkServer::SendReply_ControllerData(NetworkClientInfo * client_info, unsigned int dev_idx, unsigned int protocol_version)
 {
     if(dev_idx < controllers.size())
     {
-        NetPacketHeader reply_hdr;
-        unsigned char *reply_data = controllers[dev_idx]->GetDeviceDescription(protocol_version);
-        unsigned int   reply_size;
+        NetPacketHeader             reply_hdr;
+        std::vector<unsigned char>  reply_data;
+        unsigned int                reply_size;
+
+        controllers[dev_idx]->WriteDeviceDescription(reply_data, protocol_version);
+
+        reply_size = (unsigned int)reply_data.size();
 
-        memcpy(&reply_size, reply_data, sizeof(reply_size));
-        
         reply_hdr.pkt_magic[0] = 'O';
         reply_hdr.pkt_magic[1] = 'R';
         reply_hdr.pkt_magic[2] = 'G';
@@ -868,14 +2224,78 @@ void NetworkServer::SendReply_ControllerData(SOCKET client_sock, unsigned int de
         reply_hdr.pkt_id       = NET_PACKET_ID_REQUEST_CONTROLLER_DATA;
         reply_hdr.pkt_size     = reply_size;
 
-        send(client_sock, (const char *)&reply_hdr, sizeof(NetPacketHeader), 0);
-        send(client_sock, (const char *)reply_data, reply_size, 0);
+        SendPacket(client_info, &reply_hdr, reply_data.data(), reply_size);
+    }
+}
+
+void NetworkServer::SendReply_ControllerStats(NetworkClientInfo * client_info, unsigned int dev_idx)
+{
+    if(dev_idx < controllers.size())
+    {
+        NetPacketHeader             reply_hdr;
+        std::vector<unsigned char>  reply_data;
+        unsigned int                reply_size;
+
+        controllers[dev_idx]->WriteStatsDescription(reply_data);
+
+        reply_size = (unsigned int)reply_data.size();
+
+        reply_hdr.pkt_magic[0] = 'O';
+        reply_hdr.pkt_magic[1] = 'R';
+        reply_hdr.pkt_magic[2] = 'G';
+        reply_hdr.pkt_magic[3] = 'B';
+
+        reply_hdr.pkt_dev_idx  = dev_idx;
+        reply_hdr.pkt_id       = NET_PACKET_ID_RGBCONTROLLER_GETSTATS;
+        reply_hdr.pkt_size     = reply_size;
+
+        SendPacket(client_info, &reply_hdr, reply_data.data(), reply_size);
+    }
+}
+
+/*---------------------------------------------------------*\
+| Replies with the device list sequence number and the ID   |
+| of each device in index order:                            |
+|                                                           |
+|   unsigned int    data_size                               |
+|   unsigned int    list_seq                                |
+|   unsigned int    num_devices                             |
+|   unsigned int    device_ids[num_devices]                 |
+\*---------------------------------------------------------*/
+void NetworkServer::SendReply_DeviceIDs(NetworkClientInfo * client_info)
+{
+    NetPacketHeader             reply_hdr;
+    std::vector<unsigned char>  reply_data;
+    RGBControllerBufferWriter   reply_writer(reply_data);
+
+    ServerClientsMutex.lock();
+
+    reply_writer.Write((unsigned int)0);
+    reply_writer.Write(device_list_seq);
+    reply_writer.Write((unsigned int)DeviceList.size());
 
-        delete[] reply_data;
+    for(std::size_t dev_idx = 0; dev_idx < DeviceList.size(); dev_idx++)
+    {
+        reply_writer.Write(DeviceList[dev_idx].id);
     }
+
+    ServerClientsMutex.unlock();
+
+    reply_writer.Patch(0, (unsigned int)reply_writer.GetSize());
+
+    reply_hdr.pkt_magic[0] = 'O';
+    reply_hdr.pkt_magic[1] = 'R';
+    reply_hdr.pkt_magic[2] = 'G';
+    reply_hdr.pkt_magic[3] = 'B';
+
+    reply_hdr.pkt_dev_idx  = 0;
+    reply_hdr.pkt_id       = NET_PACKET_ID_REQUEST_DEVICE_IDS;
+    reply_hdr.pkt_size     = (unsigned int)reply_writer.GetSize();
+
+    SendPacket(client_info, &reply_hdr, reply_writer.GetData(), reply_hdr.pkt_size);
 }
 
-void NetworkServer::SendReply_ProtocolVersion(SOCKET client_sock)
+void NetworkServer::SendReply_ProtocolVersion(NetworkClientInfo * client_info)
 {
     NetPacketHeader reply_hdr;
     unsigned int    reply_data;
@@ -891,11 +2311,10 @@ void NetworkServer::SendReply_ProtocolVersion(SOCKET client_sock)
 
     reply_data             = OPENRGB_SDK_PROTOCOL_VERSION;
 
-    send(client_sock, (const char *)&reply_hdr, sizeof(NetPacketHeader), 0);
-    send(client_sock, (const char *)&reply_data, sizeof(unsigned int), 0);
+    SendPacket(client_info, &reply_hdr, &reply_data, sizeof(unsigned int));
 }
 
-void NetworkServer::SendRequest_DeviceListChanged(SOCKET client_sock)
+void NetworkServer::SendRequest_DeviceListChanged(NetworkClientInfo * client_info)
 {
     NetPacketHeader pkt_hdr;
 
@@ -908,10 +2327,87 @@ void NetworkServer::SendRequest_DeviceListChanged(SOCKET client_sock)
     pkt_hdr.pkt_id       = NET_PACKET_ID_DEVICE_LIST_UPDATED;
     pkt_hdr.pkt_size     = 0;
 
-    send(client_sock, (char *)&pkt_hdr, sizeof(NetPacketHeader), 0);
+    SendPacket(client_info, &pkt_hdr, NULL, 0);
+}
+
+/*---------------------------------------------------------*\
+| Sends what changed in the device list since the list with |
+| sequence number old_list_seq:                             |
+|                                                           |
+|   unsigned int    data_size                               |
+|   unsigned int    old_list_seq                            |
+|   unsigned int    new_list_seq                            |
+|   unsigned short  num_removed                             |
+|   unsigned int    removed_ids[num_removed]                |
+|   unsigned short  num_added                               |
+|   added devices                                           |
+|   unsigned short  num_changed                             |
+|   changed devices                                         |
+|   unsigned int    num_devices                             |
+|   unsigned int    device_ids[num_devices]                 |
+|                                                           |
+| Each added or changed device is its ID followed by its    |
+| description, as in a CONTROLLER_DATA reply.  device_ids   |
+| gives the new order.  Must be called with                 |
+| ServerClientsMutex held.                                  |
+\*---------------------------------------------------------*/
+void NetworkServer::SendRequest_DeviceListDiff(NetworkClientInfo * client_info, unsigned int old_list_seq, const std::vector<unsigned int>& removed_ids, const std::vector<unsigned int>& added_idxs, const std::vector<unsigned int>& changed_idxs)
+{
+    unsigned int                protocol_version = std::min(client_info->client_protocol_version, (unsigned int)OPENRGB_SDK_PROTOCOL_VERSION);
+    RGBControllerBufferWriter   diff_writer(device_list_buf);
+
+    diff_writer.Write((unsigned int)0);
+    diff_writer.Write(old_list_seq);
+    diff_writer.Write(device_list_seq);
+
+    diff_writer.Write((unsigned short)removed_ids.size());
+
+    for(std::size_t removed_idx = 0; removed_idx < removed_ids.size(); removed_idx++)
+    {
+        diff_writer.Write(removed_ids[removed_idx]);
+    }
+
+    const std::vector<unsigned int> * described_idxs[] = { &added_idxs, &changed_idxs };
+
+    for(std::size_t list_idx = 0; list_idx < 2; list_idx++)
+    {
+        const std::vector<unsigned int>& dev_idxs = *described_idxs[list_idx];
+
+        diff_writer.Write((unsigned short)dev_idxs.size());
+
+        for(std::size_t idx = 0; idx < dev_idxs.size(); idx++)
+        {
+            controllers[dev_idxs[idx]]->WriteDeviceDescription(device_desc_buf, protocol_version);
+
+            diff_writer.Write(DeviceList[dev_idxs[idx]].id);
+            diff_writer.Write(device_desc_buf.data(), device_desc_buf.size());
+        }
+    }
+
+    diff_writer.Write((unsigned int)DeviceList.size());
+
+    for(std::size_t dev_idx = 0; dev_idx < DeviceList.size(); dev_idx++)
+    {
+        diff_writer.Write(DeviceList[dev_idx].id);
+    }
+
+    diff_writer.Patch(0, (unsigned int)diff_writer.GetSize());
+
+    NetPacketHeader pkt_hdr;
+
+    pkt_hdr.pkt_magic[0] = 'O';
+    pkt_hdr.pkt_magic[1] = 'R';
+    pkt_hdr.pkt_magic[2] = 'G';
+    pkt_hdr.pkt_magic[3] = 'B';
+
+    pkt_hdr.pkt_dev_idx  = 0;
+    pkt_hdr.pkt_id       = NET_PACKET_ID_DEVICE_LIST_DIFF;
+    pkt_hdr.pkt_size     = (unsigned int)diff_writer.GetSize();
+
+    SendPacket(client_info, &pkt_hdr, diff_writer.GetData(), pkt_hdr.pkt_size);
 }
 
-void NetworkServer::SendReply_ProfileList(SOCKET client_sock)
+void NetworkServer::SendReply_ProfileList(NetworkClientInfo * client_info)
 {
     if(!profile_manager)
     {
@@ -933,8 +2429,88 @@ void NetworkServer::SendReply_ProfileList(SOCKET client_sock)
     reply_hdr.pkt_id       = NET_PACKET_ID_REQUEST_PROFILE_LIST;
     reply_hdr.pkt_size     = reply_size;
 
-    send(client_sock, (const char *)&reply_hdr, sizeof(NetPacketHeader), 0);
-    send(client_sock, (const char *)reply_data, reply_size, 0);
+    SendPacket(client_info, &reply_hdr, reply_data, reply_size);
+}
+
+/*---------------------------------------------------------*\
+| Sends a packet without blocking, writing the header and   |
+| data together.  Whatever the socket does not accept is    |
+| kept in the client's send buffer, in order, and flushed   |
+| by the connection thread once the socket is writable.     |
+\*---------------------------------------------------------*/
+void NetworkServer::SendPacket(NetworkClientInfo * client_info, NetPacketHeader * header, const void * data, unsigned int size)
+{
+    std::size_t total_size  = sizeof(NetPacketHeader) + size;
+    std::size_t offset      = 0;
+
+    client_info->send_mutex.lock();
+
+    if(client_info->send_failed)
+    {
+        client_info->send_mutex.unlock();
+        return;
+    }
+
+    bool was_pending = !client_info->send_buf.empty();
+
+    /*-----------------------------------------------------*\
+    | Only write directly if nothing is queued ahead        |
+    \*-----------------------------------------------------*/
+    if(!was_pending)
+    {
+        while(offset < total_size)
+        {
+            int bytes_sent = NetworkPacketWriter::SendPacketPart(client_info->client_sock, header, data, size, offset);
+
+            if(bytes_sent <= 0)
+            {
+                client_info->send_failed = (bytes_sent < 0);
+                break;
+            }
+
+            offset += bytes_sent;
+        }
+    }
+
+    /*-----------------------------------------------------*\
+    | Queue the rest of a partly sent packet                |
+    \*-----------------------------------------------------*/
+    if(!client_info->send_failed && (offset < sizeof(NetPacketHeader)))
+    {
+        client_info->send_buf.insert(client_info->send_buf.end(), (const char *)header + offset, (const char *)header + sizeof(NetPacketHeader));
+
+        offset = sizeof(NetPacketHeader);
+    }
+
+    if(!client_info->send_failed && (offset < total_size))
+    {
+        const char * data_ptr = (const char *)data + (offset - sizeof(NetPacketHeader));
+
+        client_info->send_buf.insert(client_info->send_buf.end(), data_ptr, (const char *)data + size);
+    }
+
+    /*-----------------------------------------------------*\
+    | Drop clients that stop reading their replies          |
+    \*-----------------------------------------------------*/
+    if((client_info->send_buf.size() - client_info->send_pos) > NETWORK_SERVER_MAX_SEND_SIZE)
+    {
+        client_info->send_failed = true;
+    }
+
+    bool notify = client_info->send_failed || (!was_pending && !client_info->send_buf.empty());
+
+    client_info->send_mutex.unlock();
+
+    /*-----------------------------------------------------*\
+    | Have the connection thread watch for writability or   |
+    | close the failed connection                           |
+    \*-----------------------------------------------------*/
+    if(notify)
+    {
+        WorkMutex.lock();
+        PostReactorUpdate(client_info);
+        WorkMutex.unlock();
+    }
 }
 
 void NetworkServer::SetProfileManager(ProfileManagerInterface* profile_manager_pointer)
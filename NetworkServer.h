@@ -9,9 +9,19 @@
 #include "RGBController.h"
 #include "NetworkProtocol.h"
 #include "net_port.h"
+#include "NetworkColorDelta.h"
+#include "NetworkPacketReader.h"
+#include "NetworkPacketWriter.h"
+#include "NetworkPoller.h"
 #include "ProfileManager.h"
 
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <map>
 #include <mutex>
+#include <random>
+#include <set>
 #include <thread>
 #include <chrono>
 
@@ -19,8 +29,57 @@
 
 #define TCP_TIMEOUT_SECONDS 5
 
+/*---------------------------------------------------------*\
+| Per connection limits.  A connection whose packet queue   |
+| is full is not read from until a worker drains it, and a  |
+| connection that stops reading its replies is dropped once |
+| its send buffer reaches the limit.                        |
+\*---------------------------------------------------------*/
+#define NETWORK_SERVER_MAX_QUEUED_PACKETS   64
+#define NETWORK_SERVER_MAX_SEND_SIZE        (16 * 1024 * 1024)
+#define NETWORK_SERVER_WORKER_THREADS       2
+
+/*---------------------------------------------------------*\
+| Highest rate, in pushes per second, at which a client is  |
+| sent the colors of the devices it subscribed to           |
+\*---------------------------------------------------------*/
+#define NETWORK_SERVER_MAX_COLOR_RATE       240
+
 typedef void (*NetServerCallback)(void *);
 
+typedef struct
+{
+    NetPacketHeader                     header;
+    std::vector<char>                   data;
+} NetworkServerPacket;
+
+class NetworkServer;
+
+/*---------------------------------------------------------*\
+| Watches one controller for color subscriptions.  Its      |
+| update callback only counts the update and wakes the      |
+| connection thread, which sends the colors.                |
+\*---------------------------------------------------------*/
+typedef struct
+{
+    NetworkServer *                     server;
+    RGBController *                     controller;
+    std::atomic<unsigned long long>     generation;
+} NetworkColorWatch;
+
+/*---------------------------------------------------------*\
+| A device in the list last sent to clients.  A device      |
+| keeps its ID for as long as it is in the list, whatever   |
+| its index.                                                |
+\*---------------------------------------------------------*/
+typedef struct
+{
+    RGBController *                     controller;
+    unsigned int                        id;
+    unsigned int                        generation;
+    unsigned long long                  identity;
+} NetworkDeviceListEntry;
+
 class NetworkClientInfo
 {
 public:
@@ -28,10 +87,62 @@ public:
     ~NetworkClientInfo();
 
     SOCKET          client_sock;
-    std::thread *   client_listen_thread;
     std::string     client_string;
     unsigned int    client_protocol_version;
     char            client_ip[INET_ADDRSTRLEN];
+    in_addr         client_addr;
+
+    /*-----------------------------------------------------*\
+    | Receive state, only used by the connection thread     |
+    \*-----------------------------------------------------*/
+    NetworkPacketReader                 reader;
+    unsigned int                        poll_events;
+
+    /*-----------------------------------------------------*\
+    | Work state, protected by NetworkServer::WorkMutex     |
+    \*-----------------------------------------------------*/
+    std::deque<NetworkServerPacket *>   packets;
+    std::vector<NetworkServerPacket *>  free_packets;
+    bool                                ready;
+    bool                                running;
+    bool                                closing;
+    bool                                recv_paused;
+    bool                                update_pending;
+
+    /*-----------------------------------------------------*\
+    | Delta decoders by device index.  Only used by the     |
+    | worker processing this client's current packet.       |
+    \*-----------------------------------------------------*/
+    std::map<unsigned int, NetworkColorDeltaDecoder>    delta_decoders;
+
+    /*-----------------------------------------------------*\
+    | UDP channel state, protected by ServerClientsMutex.   |
+    | The last frame sequence number applied by device      |
+    | index, older frames are dropped.                      |
+    \*-----------------------------------------------------*/
+    unsigned int                                        udp_token;
+    std::map<unsigned int, unsigned int>                udp_frame_seqs;
+
+    /*-----------------------------------------------------*\
+    | Color subscription, protected by ServerClientsMutex.  |
+    | For each subscribed device, the watch generation that |
+    | was last sent to the client.                          |
+    \*-----------------------------------------------------*/
+    std::vector<unsigned int>                           color_dev_idxs;
+    std::vector<NetworkColorWatch *>                    color_watches;
+    std::vector<unsigned long long>                     color_generations;
+    std::chrono::steady_clock::duration                 color_interval;
+    std::chrono::steady_clock::time_point               color_next_push;
+
+    /*-----------------------------------------------------*\
+    | Send state.  Bytes the socket did not accept are kept |
+    | in send_buf and flushed by the connection thread from |
+    | send_pos onwards.                                     |
+    \*-----------------------------------------------------*/
+    std::mutex                          send_mutex;
+    std::vector<char>                   send_buf;
+    std::size_t                         send_pos;
+    bool                                send_failed;
 };
 
 class NetworkServer
@@ -50,6 +161,7 @@ public:
 
     void                                ClientInfoChanged();
     void                                DeviceListChanged();
+    void                                ControllerRemoved(RGBController * controller);
     void                                RegisterClientInfoChangeCallback(NetServerCallback, void * new_callback_arg);
 
     void                                ServerListeningChanged();
@@ -60,25 +172,36 @@ public:
     void                                StartServer();
     void                                StopServer();
 
+    bool                                GetUsingEpoll();
+
     void                                ConnectionThreadFunction();
-    void                                ListenThreadFunction(NetworkClientInfo * client_sock);
+    void                                WorkerThreadFunction();
 
-    void                                ProcessRequest_ClientProtocolVersion(SOCKET client_sock, unsigned int data_size, char * data);
-    void                                ProcessRequest_ClientString(SOCKET client_sock, unsigned int data_size, char * data);
+    void                                ProcessPacket(NetworkClientInfo * client_info, NetworkServerPacket * packet);
 
-    void                                SendReply_ControllerCount(SOCKET client_sock);
-    void                                SendReply_ControllerData(SOCKET client_sock, unsigned int dev_idx, unsigned int protocol_version);
-    void                                SendReply_ProtocolVersion(SOCKET client_sock);
+    void                                ProcessRequest_ClientProtocolVersion(NetworkClientInfo * client_info, unsigned int data_size, char * data);
+    void                                ProcessRequest_ClientString(NetworkClientInfo * client_info, unsigned int data_size, char * data);
+    void                                ProcessRequest_RGBController_MultiUpdateLEDs(unsigned int data_size, char * data);
+    void                                ProcessRequest_RGBController_DeltaUpdateLEDs(NetworkClientInfo * client_info, unsigned int dev_idx, unsigned int data_size, char * data);
+    void                                ProcessRequest_UDPChannel(NetworkClientInfo * client_info);
+    void                                ProcessRequest_ColorSubscription(NetworkClientInfo * client_info, unsigned int data_size, char * data);
 
-    void                                SendRequest_DeviceListChanged(SOCKET client_sock);
-    void                                SendReply_ProfileList(SOCKET client_sock);
+    void                                SendReply_ControllerCount(NetworkClientInfo * client_info);
+    void                                SendReply_ControllerData(NetworkClientInfo * client_info, unsigned int dev_idx, unsigned int protocol_version);
+    void                                SendReply_DeviceIDs(NetworkClientInfo * client_info);
+    void                                SendReply_ControllerStats(NetworkClientInfo * client_info, unsigned int dev_idx);
+    void                                SendReply_ProtocolVersion(NetworkClientInfo * client_info);
+
+    void                                SendRequest_DeviceListChanged(NetworkClientInfo * client_info);
+    void                                SendRequest_DeviceListDiff(NetworkClientInfo * client_info, unsigned int old_list_seq, const std::vector<unsigned int>& removed_ids, const std::vector<unsigned int>& added_idxs, const std::vector<unsigned int>& changed_idxs);
+    void                                SendReply_ProfileList(NetworkClientInfo * client_info);
 
     void                                SetProfileManager(ProfileManagerInterface* profile_manager_pointer);
 
 protected:
     unsigned short                      port_num;
-    bool                                server_online;
-    bool                                server_listening;
+    std::atomic<bool>                   server_online;
+    std::atomic<bool>                   server_listening;
 
     std::vector<RGBController *>&       controllers;
 
@@ -86,6 +209,31 @@ protected:
     std::vector<NetworkClientInfo *>    ServerClients;
     std::thread *                       ConnectionThread;
 
+    /*-----------------------------------------------------*\
+    | Connection thread state.  Closed clients are deleted  |
+    | once no worker is processing their packets.           |
+    \*-----------------------------------------------------*/
+    NetworkPoller *                     Poller;
+    std::vector<NetworkClientInfo *>    ClosedClients;
+
+    /*-----------------------------------------------------*\
+    | Worker state.  A client is on the ready queue while   |
+    | it has packets and no worker is processing one, so    |
+    | each client's packets are handled in order.  Packets  |
+    | being processed are numbered in RunningPackets, so a  |
+    | removed controller is only deleted once the packets   |
+    | that may have taken it from the list are done.        |
+    \*-----------------------------------------------------*/
+    std::mutex                          WorkMutex;
+    std::condition_variable             WorkCV;
+    std::condition_variable             WorkDoneCV;
+    std::set<unsigned long long>        RunningPackets;
+    unsigned long long                  work_seq;
+    std::deque<NetworkClientInfo *>     ReadyClients;
+    std::vector<NetworkClientInfo *>    ReactorUpdates;
+    std::vector<std::thread *>          WorkerThreads;
+    bool                                workers_running;
+
     std::mutex                          ClientInfoChangeMutex;
     std::vector<NetServerCallback>      ClientInfoChangeCallbacks;
     std::vector<void *>                 ClientInfoChangeCallbackArgs;
@@ -103,6 +251,62 @@ private:
 
     SOCKET          server_sock;
 
-    int             accept_select(int sockfd, struct sockaddr *addr, socklen_t *addrlen);
-    int             recv_select(SOCKET s, char *buf, int len, int flags);
+    /*-----------------------------------------------------*\
+    | UDP channel for LED updates.  Clients are found by    |
+    | the token the server gave them, sessions are          |
+    | protected by ServerClientsMutex.                      |
+    \*-----------------------------------------------------*/
+    SOCKET                                      udp_sock;
+    std::vector<char>                           udp_buf;
+    std::map<unsigned int, NetworkClientInfo *> UDPSessions;
+    std::mt19937                                UDPTokenGenerator;
+
+    /*-----------------------------------------------------*\
+    | Color subscriptions.  Only subscribed controllers are |
+    | watched, the watches are protected by                 |
+    | ServerClientsMutex.  Unused watches are unregistered  |
+    | after it is released but with ColorWatchMutex, taken  |
+    | first, still held so a removed controller is not      |
+    | deleted while its watch is unregistered.  The push    |
+    | buffer is only used by the connection thread.         |
+    \*-----------------------------------------------------*/
+    std::mutex                                      ColorWatchMutex;
+    std::map<RGBController *, NetworkColorWatch *>  ColorWatches;
+    std::atomic<bool>                               color_wake_pending;
+    std::vector<unsigned char>                      color_push_buf;
+
+    static void     ColorWatchCallback(void * arg);
+    void            ClearColorSubscription(NetworkClientInfo * client_info);
+    void            UpdateColorWatches(std::vector<NetworkColorWatch *>& released_watches);
+    void            ReleaseColorWatches(std::vector<NetworkColorWatch *>& released_watches);
+    int             PushColorUpdates();
+
+    bool            IsClientConnected(NetworkClientInfo * client_info);
+
+    /*-----------------------------------------------------*\
+    | Device list as last sent to clients, with the ID of   |
+    | each device, protected by ServerClientsMutex.  The    |
+    | sequence number counts the changes to the list.       |
+    \*-----------------------------------------------------*/
+    std::vector<NetworkDeviceListEntry>             DeviceList;
+    unsigned int                                    device_list_seq;
+    unsigned int                                    next_device_id;
+    std::vector<unsigned char>                      device_list_buf;
+    std::vector<unsigned char>                      device_desc_buf;
+
+    bool            UpdateDeviceList(std::vector<unsigned int>& removed_ids, std::vector<unsigned int>& added_idxs, std::vector<unsigned int>& changed_idxs);
+
+    void            ReadUDP();
+    void            ProcessUDPPacket(const char * data, unsigned int size, const sockaddr_in& from_addr);
+
+    void            AcceptClients();
+    bool            ReadClient(NetworkClientInfo * client_info);
+    bool            ParseClientPackets(NetworkClientInfo * client_info);
+    bool            FlushClient(NetworkClientInfo * client_info);
+    void            CloseClient(NetworkClientInfo * client_info);
+    void            UpdateClientEvents(NetworkClientInfo * client_info);
+    void            ProcessReactorUpdates();
+    void            PostReactorUpdate(NetworkClientInfo * client_info);
+
+    void            SendPacket(NetworkClientInfo * client_info, NetPacketHeader * header, const void * data, unsigned int size);
 };
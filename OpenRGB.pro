@@ -177,6 +177,10 @@ HEADERS +=
     dependencies/libcmmk/include/libcmmk/libcmmk.h                                              \
     LogManager.h                                                                                \
     NetworkClient.h                                                                             \
+    NetworkColorDelta.h                                                                         \
+    NetworkPacketReader.h                                                                       \
+    NetworkPacketWriter.h                                                                       \
+    NetworkPoller.h                                                                             \
     NetworkProtocol.h                                                                           \
     NetworkServer.h                                                                             \
     OpenRGBPluginInterface.h                                                                    \
@@ -184,6 +188,8 @@ HEADERS +=
     ProfileManager.h                                                                            \
     ResourceManager.h                                                                           \
     SettingsManager.h                                                                           \
+    DetectionCache.h                                                                            \
+    HotplugMonitor.h                                                                            \
     Detector.h                                                                                  \
     DeviceDetector.h                                                                            \
     filesystem.h                                                                                \
@@ -572,8 +578,11 @@ HEADERS +=
     Controllers/ZETEdgeAirProController/RGBController_ZETEdgeAirPro.h                           \
     Controllers/ZETKeyboardController/ZETBladeOpticalController.h                               \
     Controllers/ZETKeyboardController/RGBController_ZETBladeOptical.h                           \
+    RGBController/RGBColorConvert.h                                                             \
     RGBController/RGBController.h                                                               \
     RGBController/RGBController_Dummy.h                                                         \
+    RGBController/RGBControllerBuffer.h                                                         \
+    RGBController/RGBControllerDispatcher.h                                                     \
     RGBController/RGBControllerKeyNames.h                                                       \
     RGBController/RGBController_Network.h                                                       \
 
@@ -624,8 +633,13 @@ SOURCES +=
     dependencies/libcmmk/src/libcmmk.c                                                          \
     main.cpp                                                                                    \
     cli.cpp                                                                                     \
+    DetectionCache.cpp                                                                          \
     LogManager.cpp                                                                              \
     NetworkClient.cpp                                                                           \
+    NetworkColorDelta.cpp                                                                       \
+    NetworkPacketReader.cpp                                                                     \
+    NetworkPacketWriter.cpp                                                                     \
+    NetworkPoller.cpp                                                                           \
     NetworkServer.cpp                                                                           \
     PluginManager.cpp                                                                           \
     ProfileManager.cpp                                                                          \
@@ -1103,8 +1117,10 @@ SOURCES +=
     Controllers/ZETKeyboardController/ZETBladeOpticalController.cpp                             \
     Controllers/ZETKeyboardController/ZETKeyboardControllerDetect.cpp                           \
     Controllers/ZETKeyboardController/RGBController_ZETBladeOptical.cpp                         \
+    RGBController/RGBColorConvert.cpp                                                           \
     RGBController/RGBController.cpp                                                             \
     RGBController/RGBController_Dummy.cpp                                                       \
+    RGBController/RGBControllerDispatcher.cpp                                                   \
     RGBController/RGBControllerKeyNames.cpp                                                     \
     RGBController/RGBController_Network.cpp                                                     \
 
@@ -1442,6 +1458,7 @@ contains(QMAKE_PLATFORM, linux) {
     dependencies/hueplusplus-1.0.0/src/LinHttpHandler.cpp                                       \
     i2c_smbus/i2c_smbus_linux.cpp                                                               \
     serial_port/find_usb_serial_port_linux.cpp                                                  \
+    HotplugMonitor_Linux.cpp                                                                    \
     AutoStart/AutoStart-Linux.cpp                                                               \
     Controllers/ENESMBusController/XPGSpectrixS40GDetect.cpp                                    \
     Controllers/ENESMBusController/ENESMBusInterface/ENESMBusInterface_SpectrixS40G.cpp         \
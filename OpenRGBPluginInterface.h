@@ -22,8 +22,9 @@
 | 0:    OpenRGB 0.6     Unversioned, early plugin API.                                                  |
 | 1:    OpenRGB 0.61    First versioned API, introduced with plugin settings changes                    |
 | 2:    OpenRGB 0.7     First released versioned API, callback unregister functions in ResourceManager  |
+| 3:    OpenRGB 0.71+   RGBController layout changed: frame pipeline, dispatcher and deferred populate  |
 \*-----------------------------------------------------------------------------------------------------*/
-#define OPENRGB_PLUGIN_API_VERSION  2
+#define OPENRGB_PLUGIN_API_VERSION  3
 
 /*-----------------------------------------------------------------------------------------------------*\
 | Plugin Tab Location Values                                                                            |
@@ -68,16 +68,13 @@ bool ProfileManager::SaveProfile(std::string profile_name, bool sizes)
         /*---------------------------------------------------------*\
         | Write controller data for each controller                 |
         \*---------------------------------------------------------*/
+        std::vector<unsigned char> controller_data;
+
         for(std::size_t controller_index = 0; controller_index < controllers.size(); controller_index++)
         {
-            unsigned char *controller_data = controllers[controller_index]->GetDeviceDescription(profile_version);
-            unsigned int controller_size;
-
-            memcpy(&controller_size, controller_data, sizeof(controller_size));
-
-            controller_file.write((const char *)controller_data, controller_size);
+            controllers[controller_index]->WriteDeviceDescription(controller_data, profile_version);
 
-            delete[] controller_data;
+            controller_file.write((const char *)controller_data.data(), controller_data.size());
         }
 
         /*---------------------------------------------------------*\
@@ -172,24 +169,36 @@ std::vector<RGBController*> ProfileManager::LoadProfileToList
             /*---------------------------------------------------------*\
             | Read controller data from file until EOF                  |
             \*---------------------------------------------------------*/
+            std::vector<unsigned char> controller_data;
+
             while(!(controller_file.peek() == EOF))
             {
                 controller_file.read((char *)&controller_size, sizeof(controller_size));
 
-                unsigned char *controller_data = new unsigned char[controller_size];
+                if(controller_size < sizeof(controller_size))
+                {
+                    break;
+                }
+
+                controller_data.resize(controller_size);
 
                 controller_file.seekg(controller_offset);
 
-                controller_file.read((char *)controller_data, controller_size);
+                controller_file.read((char *)controller_data.data(), controller_size);
 
+                /*---------------------------------------------------------*\
+                | Stop at a truncated or malformed controller description   |
+                \*---------------------------------------------------------*/
                 RGBController_Dummy *temp_controller = new RGBController_Dummy();
 
-                temp_controller->ReadDeviceDescription(controller_data, profile_version);
+                if(!temp_controller->ReadDeviceDescription(controller_data.data(), (unsigned int)controller_file.gcount(), profile_version))
+                {
+                    delete temp_controller;
+                    break;
+                }
 
                 temp_controllers.push_back(temp_controller);
 
-                delete[] controller_data;
-
                 controller_offset += controller_size;
                 controller_file.seekg(controller_offset);
             }
@@ -0,0 +1,278 @@
+/*-----------------------------------------*\
+|  RGBColorConvert.cpp                      |
+|                                           |
+|  Color conversion kernels for packing     |
+|  RGBColor buffers into device byte        |
+|  streams, with SIMD implementations       |
+\*-----------------------------------------*/
+
+#include "RGBColorConvert.h"
+#include <atomic>
+#include <cstring>
+
+/*---------------------------------------------------------*\
+| x86 kernels are compiled with per-function target         |
+| attributes and selected at runtime, so the build does not |
+| need any extra compiler flags                             |
+\*---------------------------------------------------------*/
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define RGBCOLOR_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define RGBCOLOR_TARGET(isa)
+#else
+#define RGBCOLOR_TARGET(isa) __attribute__((target(isa)))
+#endif
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define RGBCOLOR_NEON
+#include <arm_neon.h>
+#endif
+
+/*---------------------------------------------------------*\
+| Source byte of each output byte for every channel order.  |
+| An RGBColor is stored as R, G, B, 0 in memory.            |
+\*---------------------------------------------------------*/
+static const unsigned char order_map[6][3] =
+{
+    { 0, 1, 2 },                                /* RGB                              */
+    { 0, 2, 1 },                                /* RBG                              */
+    { 1, 0, 2 },                                /* GRB                              */
+    { 1, 2, 0 },                                /* GBR                              */
+    { 2, 0, 1 },                                /* BRG                              */
+    { 2, 1, 0 },                                /* BGR                              */
+};
+
+static std::atomic<int> simd_level(-1);
+
+static int DetectSIMDLevel()
+{
+#if defined(RGBCOLOR_X86)
+#ifdef _MSC_VER
+    int info[4];
+
+    __cpuid(info, 0);
+
+    int max_leaf = info[0];
+
+    __cpuid(info, 1);
+
+    bool sse2       = (info[3] & (1 << 26)) != 0;
+    bool ssse3      = (info[2] & (1 << 9))  != 0;
+    bool osxsave    = (info[2] & (1 << 27)) != 0;
+    bool avx2       = false;
+
+    if(osxsave && (max_leaf >= 7) && ((_xgetbv(0) & 0x06) == 0x06))
+    {
+        __cpuidex(info, 7, 0);
+
+        avx2        = (info[1] & (1 << 5)) != 0;
+    }
+#else
+    __builtin_cpu_init();
+
+    bool sse2       = __builtin_cpu_supports("sse2");
+    bool ssse3      = __builtin_cpu_supports("ssse3");
+    bool avx2       = __builtin_cpu_supports("avx2");
+#endif
+
+    if(avx2 && ssse3)
+    {
+        return(RGBCOLOR_SIMD_AVX2);
+    }
+    else if(ssse3)
+    {
+        return(RGBCOLOR_SIMD_SSSE3);
+    }
+    else if(sse2)
+    {
+        return(RGBCOLOR_SIMD_SSE2);
+    }
+#elif defined(RGBCOLOR_NEON)
+    return(RGBCOLOR_SIMD_NEON);
+#endif
+
+    return(RGBCOLOR_SIMD_SCALAR);
+}
+
+int RGBColorGetSIMDLevel()
+{
+    int level = simd_level.load();
+
+    if(level < 0)
+    {
+        level = DetectSIMDLevel();
+        simd_level = level;
+    }
+
+    return(level);
+}
+
+void RGBColorSetSIMDLevel(int level)
+{
+    int detected = DetectSIMDLevel();
+
+    if((level < RGBCOLOR_SIMD_SCALAR) || (level > detected))
+    {
+        level = detected;
+    }
+
+    simd_level = level;
+}
+
+/*---------------------------------------------------------*\
+| Scalar kernels                                            |
+|   Each SIMD kernel returns the number of colors it        |
+|   processed and the scalar kernel finishes the remainder  |
+\*---------------------------------------------------------*/
+static void PackScalar(const RGBColor* colors, unsigned int count, unsigned char* out, int order)
+{
+    const unsigned char* map = order_map[order];
+
+    for(unsigned int color_idx = 0; color_idx < count; color_idx++)
+    {
+        unsigned char channels[3];
+
+        channels[0]             = RGBGetRValue(colors[color_idx]);
+        channels[1]             = RGBGetGValue(colors[color_idx]);
+        channels[2]             = RGBGetBValue(colors[color_idx]);
+
+        out[(color_idx * 3) + 0] = channels[map[0]];
+        out[(color_idx * 3) + 1] = channels[map[1]];
+        out[(color_idx * 3) + 2] = channels[map[2]];
+    }
+}
+
+#if defined(RGBCOLOR_X86)
+/*---------------------------------------------------------*\
+| x86 kernels                                               |
+\*---------------------------------------------------------*/
+RGBCOLOR_TARGET("sse2")
+static __m128i PackShuffleMask(int order)
+{
+    const unsigned char*    map = order_map[order];
+    unsigned char           mask[16];
+
+    memset(mask, 0x80, sizeof(mask));
+
+    for(int pixel_idx = 0; pixel_idx < 4; pixel_idx++)
+    {
+        for(int channel_idx = 0; channel_idx < 3; channel_idx++)
+        {
+            mask[(pixel_idx * 3) + channel_idx] = (unsigned char)((pixel_idx * 4) + map[channel_idx]);
+        }
+    }
+
+    return(_mm_loadu_si128((const __m128i*)mask));
+}
+
+RGBCOLOR_TARGET("ssse3")
+static unsigned int PackSSSE3(const RGBColor* colors, unsigned int count, unsigned char* out, int order)
+{
+    __m128i         mask        = PackShuffleMask(order);
+    unsigned int    color_idx   = 0;
+
+    for(; (color_idx + 4) <= count; color_idx += 4)
+    {
+        __m128i packed = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)&colors[color_idx]), mask);
+
+        /*-------------------------------------------------*\
+        | Store exactly 12 bytes so the output buffer needs |
+        | no padding                                        |
+        \*-------------------------------------------------*/
+        _mm_storel_epi64((__m128i*)&out[color_idx * 3], packed);
+
+        int tail = _mm_cvtsi128_si32(_mm_srli_si128(packed, 8));
+
+        memcpy(&out[(color_idx * 3) + 8], &tail, 4);
+    }
+
+    return(color_idx);
+}
+
+RGBCOLOR_TARGET("avx2")
+static unsigned int PackAVX2(const RGBColor* colors, unsigned int count, unsigned char* out, int order)
+{
+    __m128i         mask128     = PackShuffleMask(order);
+    __m256i         mask        = _mm256_broadcastsi128_si256(mask128);
+    __m256i         compact     = _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 3, 7);
+    unsigned int    color_idx   = 0;
+
+    for(; (color_idx + 8) <= count; color_idx += 8)
+    {
+        __m256i packed = _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i*)&colors[color_idx]), mask);
+
+        /*-------------------------------------------------*\
+        | Each 128-bit lane holds 12 bytes, move them next  |
+        | to each other and store 24 bytes                  |
+        \*-------------------------------------------------*/
+        packed = _mm256_permutevar8x32_epi32(packed, compact);
+
+        _mm_storeu_si128((__m128i*)&out[color_idx * 3], _mm256_castsi256_si128(packed));
+        _mm_storel_epi64((__m128i*)&out[(color_idx * 3) + 16], _mm256_extracti128_si256(packed, 1));
+    }
+
+    return(color_idx);
+}
+
+#endif
+
+#if defined(RGBCOLOR_NEON)
+/*---------------------------------------------------------*\
+| ARM NEON kernels                                          |
+\*---------------------------------------------------------*/
+static unsigned int PackNEON(const RGBColor* colors, unsigned int count, unsigned char* out, int order)
+{
+    const unsigned char*    map         = order_map[order];
+    unsigned int            color_idx   = 0;
+
+    for(; (color_idx + 16) <= count; color_idx += 16)
+    {
+        uint8x16x4_t    in = vld4q_u8((const uint8_t*)&colors[color_idx]);
+        uint8x16x3_t    packed;
+
+        packed.val[0] = in.val[map[0]];
+        packed.val[1] = in.val[map[1]];
+        packed.val[2] = in.val[map[2]];
+
+        vst3q_u8(&out[color_idx * 3], packed);
+    }
+
+    return(color_idx);
+}
+
+#endif
+
+/*---------------------------------------------------------*\
+| Dispatch                                                  |
+\*---------------------------------------------------------*/
+void RGBColorPack(const RGBColor* colors, unsigned int count, unsigned char* out, int order)
+{
+    unsigned int done = 0;
+
+    if((order < RGBCOLOR_ORDER_RGB) || (order > RGBCOLOR_ORDER_BGR))
+    {
+        order = RGBCOLOR_ORDER_RGB;
+    }
+
+    switch(RGBColorGetSIMDLevel())
+    {
+#if defined(RGBCOLOR_X86)
+    case RGBCOLOR_SIMD_AVX2:
+        done = PackAVX2(colors, count, out, order);
+        break;
+
+    case RGBCOLOR_SIMD_SSSE3:
+        done = PackSSSE3(colors, count, out, order);
+        break;
+#elif defined(RGBCOLOR_NEON)
+    case RGBCOLOR_SIMD_NEON:
+        done = PackNEON(colors, count, out, order);
+        break;
+#endif
+    default:
+        break;
+    }
+
+    PackScalar(&colors[done], count - done, &out[done * 3], order);
+}
@@ -0,0 +1,51 @@
+/*-----------------------------------------*\
+|  RGBColorConvert.h                        |
+|                                           |
+|  Color conversion kernels for packing     |
+|  RGBColor buffers into device byte        |
+|  streams, with SIMD implementations       |
+\*-----------------------------------------*/
+
+#pragma once
+
+#include "RGBController.h"
+
+/*------------------------------------------------------------------*\
+| Channel Orders                                                     |
+|   Output byte order when packing RGBColor values, matching the     |
+|   order of the E1.31 and serial LED strip rgb_order settings       |
+\*------------------------------------------------------------------*/
+enum
+{
+    RGBCOLOR_ORDER_RGB,
+    RGBCOLOR_ORDER_RBG,
+    RGBCOLOR_ORDER_GRB,
+    RGBCOLOR_ORDER_GBR,
+    RGBCOLOR_ORDER_BRG,
+    RGBCOLOR_ORDER_BGR,
+};
+
+/*------------------------------------------------------------------*\
+| SIMD Levels                                                        |
+\*------------------------------------------------------------------*/
+enum
+{
+    RGBCOLOR_SIMD_SCALAR,                       /* Portable C++ loops               */
+    RGBCOLOR_SIMD_SSE2,                         /* x86 SSE2                         */
+    RGBCOLOR_SIMD_SSSE3,                        /* x86 SSSE3 byte shuffles          */
+    RGBCOLOR_SIMD_AVX2,                         /* x86 AVX2                         */
+    RGBCOLOR_SIMD_NEON,                         /* ARM NEON                         */
+};
+
+/*------------------------------------------------------------------*\
+| The SIMD level is detected on first use.  It can be lowered, for   |
+| example to compare against the scalar kernels, but never raised    |
+| above what the CPU supports.                                       |
+\*------------------------------------------------------------------*/
+int  RGBColorGetSIMDLevel();
+void RGBColorSetSIMDLevel(int level);
+
+/*------------------------------------------------------------------*\
+| Pack count colors into 3 bytes each in the given channel order     |
+\*------------------------------------------------------------------*/
+void RGBColorPack(const RGBColor* colors, unsigned int count, unsigned char* out, int order);
@@ -1,4 +1,8 @@
 #include "RGBController.h"
+#include "RGBControllerBuffer.h"
+#include "RGBControllerDispatcher.h"
+#include <algorithm>
+#include <cstdio>
 #include <cstring>
 
 using namespace std::chrono_literals;
@@ -27,1548 +31,1786 @@ mode::~mode()
 
 RGBController::RGBController()
 {
-    DeviceThreadRunning = true;
-    DeviceCallThread = new std::thread(&RGBController::DeviceCallThreadFunction, this);
+    CallFlag_UpdateLEDs     = false;
+    CallFlag_UpdateMode     = false;
+    DeviceCallIdleWakeups   = 0;
+    DeviceCallDispatched    = false;
+    Populated               = true;
+    DeviceThreadRunning     = false;
+    DeviceCallThread        = nullptr;
+    DeviceCallStopping      = false;
+    FrameIsPending          = false;
+    FrameSnapshot           = false;
+    FramePendingSnapshot    = false;
+    FrameActiveSnapshot     = false;
+    FrameServiceThread      = std::thread::id();
+    FrameMaxFPS             = 0;
+    FramesSubmitted         = 0;
+    FramesCoalesced         = 0;
+    FramesSent              = 0;
+    FramesPartial           = 0;
+    PartialUpdateFlags      = 0;
+    FrameDirtyLED           = -1;
+    FrameForceFull          = true;
+    DescriptionGeneration   = 0;
+    CallbackWaiters         = 0;
+    SignalUpdateCount       = 0;
+    SignalUpdateTime        = 0;
+    SignalUpdateTimeMax     = 0;
+    StatsFrameInterval      = 0.0f;
+    StatsUpdateLatency      = RGBControllerHistogram();
+    StatsTransportTime      = RGBControllerHistogram();
 }
 
 RGBController::~RGBController()
 {
-    DeviceThreadRunning = false;
-    DeviceCallThread->join();
-    delete DeviceCallThread;
-
-    leds.clear();
-    colors.clear();
-    zones.clear();
-    modes.clear();
-}
+    /*---------------------------------------------------------*\
+    | Release a device call waiting for its frame slot          |
+    \*---------------------------------------------------------*/
+    DeviceCallMutex.lock();
+    DeviceCallStopping = true;
+    DeviceCallMutex.unlock();
 
-unsigned char * RGBController::GetDeviceDescription(unsigned int protocol_version)
-{
-    unsigned int data_ptr = 0;
-    unsigned int data_size = 0;
+    DeviceCallCV.notify_all();
 
     /*---------------------------------------------------------*\
-    | Calculate data size                                       |
+    | Remove the controller from the shared dispatcher, waiting |
+    | for any device call in progress                           |
     \*---------------------------------------------------------*/
-    unsigned short name_len         = strlen(name.c_str())          + 1;
-    unsigned short vendor_len       = strlen(vendor.c_str())        + 1;
-    unsigned short description_len  = strlen(description.c_str())   + 1;
-    unsigned short version_len      = strlen(version.c_str())       + 1;
-    unsigned short serial_len       = strlen(serial.c_str())        + 1;
-    unsigned short location_len     = strlen(location.c_str())      + 1;
-    unsigned short num_modes        = modes.size();
-    unsigned short num_zones        = zones.size();
-    unsigned short num_leds         = leds.size();
-    unsigned short num_colors       = colors.size();
-
-    unsigned short *mode_name_len   = new unsigned short[num_modes];
-    unsigned short *zone_name_len   = new unsigned short[num_zones];
-    unsigned short *led_name_len    = new unsigned short[num_leds];
-
-    unsigned short *zone_matrix_len = new unsigned short[num_zones];
-    unsigned short *mode_num_colors = new unsigned short[num_modes];
-
-    data_size += sizeof(data_size);
-    data_size += sizeof(device_type);
-    data_size += name_len           + sizeof(name_len);
-
-    if(protocol_version >= 1)
+    if(DeviceCallDispatched.load())
     {
-        data_size += vendor_len     + sizeof(vendor_len);
+        RGBControllerDispatcher::get()->Unregister(this);
     }
 
-    data_size += description_len    + sizeof(description_len);
-    data_size += version_len        + sizeof(version_len);
-    data_size += serial_len         + sizeof(serial_len);
-    data_size += location_len       + sizeof(location_len);
+    /*---------------------------------------------------------*\
+    | Stop the device call thread.  The running flag is cleared |
+    | under the call mutex so the thread cannot miss the wakeup |
+    \*---------------------------------------------------------*/
+    DeviceCallMutex.lock();
+    DeviceThreadRunning = false;
+    DeviceCallMutex.unlock();
 
-    data_size += sizeof(num_modes);
-    data_size += sizeof(active_mode);
+    DeviceCallCV.notify_all();
 
-    for(int mode_index = 0; mode_index < num_modes; mode_index++)
+    if(DeviceCallThread)
     {
-        mode_name_len[mode_index]   = strlen(modes[mode_index].name.c_str()) + 1;
-        mode_num_colors[mode_index] = modes[mode_index].colors.size();
-
-        data_size += mode_name_len[mode_index] + sizeof(mode_name_len[mode_index]);
-        data_size += sizeof(modes[mode_index].value);
-        data_size += sizeof(modes[mode_index].flags);
-        data_size += sizeof(modes[mode_index].speed_min);
-        data_size += sizeof(modes[mode_index].speed_max);
-        if(protocol_version >= 3)
-        {
-            data_size += sizeof(modes[mode_index].brightness_min);
-            data_size += sizeof(modes[mode_index].brightness_max);
-        }
-        data_size += sizeof(modes[mode_index].colors_min);
-        data_size += sizeof(modes[mode_index].colors_max);
-        data_size += sizeof(modes[mode_index].speed);
-        if(protocol_version >= 3)
-        {
-            data_size += sizeof(modes[mode_index].brightness);
-        }
-        data_size += sizeof(modes[mode_index].direction);
-        data_size += sizeof(modes[mode_index].color_mode);
-        data_size += sizeof(mode_num_colors[mode_index]);
-        data_size += (mode_num_colors[mode_index] * sizeof(RGBColor));
+        DeviceCallThread->join();
+        delete DeviceCallThread;
     }
 
-    data_size += sizeof(num_zones);
+    leds.clear();
+    colors.clear();
+    zones.clear();
+    modes.clear();
+}
 
-    for(int zone_index = 0; zone_index < num_zones; zone_index++)
-    {
-        zone_name_len[zone_index]   = strlen(zones[zone_index].name.c_str()) + 1;
-        
-        data_size += zone_name_len[zone_index] + sizeof(zone_name_len[zone_index]);
-        data_size += sizeof(zones[zone_index].type);
-        data_size += sizeof(zones[zone_index].leds_min);
-        data_size += sizeof(zones[zone_index].leds_max);
-        data_size += sizeof(zones[zone_index].leds_count);
+/*---------------------------------------------------------*\
+| Copy a serialized description into a new[] buffer for     |
+| the pointer returning interface functions                 |
+\*---------------------------------------------------------*/
+static unsigned char * CopyDescription(const std::vector<unsigned char>& data)
+{
+    unsigned char *data_buf = new unsigned char[data.size()];
 
-        if(zones[zone_index].matrix_map == NULL)
-        {
-            zone_matrix_len[zone_index] = 0;
-        }
-        else
-        {
-            zone_matrix_len[zone_index] = (2 * sizeof(unsigned int)) + (zones[zone_index].matrix_map->height * zones[zone_index].matrix_map->width * sizeof(unsigned int));
-        }
+    memcpy(data_buf, data.data(), data.size());
 
-        data_size += sizeof(zone_matrix_len[zone_index]);
-        data_size += zone_matrix_len[zone_index];
-    }
+    return(data_buf);
+}
 
-    data_size += sizeof(num_leds);
+void RGBController::WriteMode(RGBControllerBufferWriter& writer, const mode& mode_out, unsigned int protocol_version)
+{
+    /*---------------------------------------------------------*\
+    | Mode name, value, flags and speed range                   |
+    \*---------------------------------------------------------*/
+    writer.WriteString(mode_out.name);
+    writer.Write(mode_out.value);
+    writer.Write(mode_out.flags);
+    writer.Write(mode_out.speed_min);
+    writer.Write(mode_out.speed_max);
 
-    for(int led_index = 0; led_index < num_leds; led_index++)
+    /*---------------------------------------------------------*\
+    | Brightness range if protocol 3 or higher                  |
+    \*---------------------------------------------------------*/
+    if(protocol_version >= 3)
     {
-        led_name_len[led_index] = strlen(leds[led_index].name.c_str()) + 1;
-
-        data_size += led_name_len[led_index] + sizeof(led_name_len[led_index]);
-
-        data_size += sizeof(leds[led_index].value);
+        writer.Write(mode_out.brightness_min);
+        writer.Write(mode_out.brightness_max);
     }
 
-    data_size += sizeof(num_colors);
-    data_size += num_colors * sizeof(RGBColor);
+    writer.Write(mode_out.colors_min);
+    writer.Write(mode_out.colors_max);
+    writer.Write(mode_out.speed);
 
     /*---------------------------------------------------------*\
-    | Create data buffer                                        |
+    | Brightness if protocol 3 or higher                        |
     \*---------------------------------------------------------*/
-    unsigned char *data_buf = new unsigned char[data_size];
+    if(protocol_version >= 3)
+    {
+        writer.Write(mode_out.brightness);
+    }
+
+    writer.Write(mode_out.direction);
+    writer.Write(mode_out.color_mode);
 
     /*---------------------------------------------------------*\
-    | Copy in data size                                         |
+    | Mode colors (count+data)                                  |
     \*---------------------------------------------------------*/
-    memcpy(&data_buf[data_ptr], &data_size, sizeof(data_size));
-    data_ptr += sizeof(data_size);
+    unsigned short mode_num_colors = (unsigned short)mode_out.colors.size();
 
+    writer.Write(mode_num_colors);
+    writer.Write(mode_out.colors.data(), mode_num_colors * sizeof(RGBColor));
+}
+
+bool RGBController::ReadMode(RGBControllerBufferReader& reader, mode& mode_in, unsigned int protocol_version)
+{
     /*---------------------------------------------------------*\
-    | Copy in type                                              |
+    | Mode name, value, flags and speed range                   |
     \*---------------------------------------------------------*/
-    memcpy(&data_buf[data_ptr], &type, sizeof(device_type));
-    data_ptr += sizeof(device_type);
+    reader.ReadString(mode_in.name);
+    reader.Read(mode_in.value);
+    reader.Read(mode_in.flags);
+    reader.Read(mode_in.speed_min);
+    reader.Read(mode_in.speed_max);
 
     /*---------------------------------------------------------*\
-    | Copy in name (size+data)                                  |
+    | Brightness range if protocol 3 or higher                  |
     \*---------------------------------------------------------*/
-    memcpy(&data_buf[data_ptr], &name_len, sizeof(unsigned short));
-    data_ptr += sizeof(unsigned short);
+    if(protocol_version >= 3)
+    {
+        reader.Read(mode_in.brightness_min);
+        reader.Read(mode_in.brightness_max);
+    }
 
-    strcpy((char *)&data_buf[data_ptr], name.c_str());
-    data_ptr += name_len;
+    reader.Read(mode_in.colors_min);
+    reader.Read(mode_in.colors_max);
+    reader.Read(mode_in.speed);
 
     /*---------------------------------------------------------*\
-    | Copy in vendor (size+data) if protocol 1 or higher        |
+    | Brightness if protocol 3 or higher                        |
     \*---------------------------------------------------------*/
-    if(protocol_version >= 1)
+    if(protocol_version >= 3)
     {
-        memcpy(&data_buf[data_ptr], &vendor_len, sizeof(unsigned short));
-        data_ptr += sizeof(unsigned short);
-
-        strcpy((char *)&data_buf[data_ptr], vendor.c_str());
-        data_ptr += vendor_len;
+        reader.Read(mode_in.brightness);
     }
 
-    /*---------------------------------------------------------*\
-    | Copy in description (size+data)                           |
-    \*---------------------------------------------------------*/
-    memcpy(&data_buf[data_ptr], &description_len, sizeof(unsigned short));
-    data_ptr += sizeof(unsigned short);
+    reader.Read(mode_in.direction);
+    reader.Read(mode_in.color_mode);
 
-    strcpy((char *)&data_buf[data_ptr], description.c_str());
-    data_ptr += description_len;
-    
     /*---------------------------------------------------------*\
-    | Copy in version (size+data)                               |
+    | Mode colors (count+data)                                  |
     \*---------------------------------------------------------*/
-    memcpy(&data_buf[data_ptr], &version_len, sizeof(unsigned short));
-    data_ptr += sizeof(unsigned short);
+    unsigned short mode_num_colors;
 
-    strcpy((char *)&data_buf[data_ptr], version.c_str());
-    data_ptr += version_len;
+    reader.Read(mode_num_colors);
 
-    /*---------------------------------------------------------*\
-    | Copy in serial (size+data)                                |
-    \*---------------------------------------------------------*/
-    memcpy(&data_buf[data_ptr], &serial_len, sizeof(unsigned short));
-    data_ptr += sizeof(unsigned short);
+    if(!reader.CanRead(mode_num_colors, sizeof(RGBColor)))
+    {
+        return(false);
+    }
 
-    strcpy((char *)&data_buf[data_ptr], serial.c_str());
-    data_ptr += serial_len;
+    mode_in.colors.resize(mode_num_colors);
+    reader.Read(mode_in.colors.data(), mode_num_colors * sizeof(RGBColor));
 
-    /*---------------------------------------------------------*\
-    | Copy in location (size+data)                              |
-    \*---------------------------------------------------------*/
-    memcpy(&data_buf[data_ptr], &location_len, sizeof(unsigned short));
-    data_ptr += sizeof(unsigned short);
+    return(!reader.Failed());
+}
 
-    strcpy((char *)&data_buf[data_ptr], location.c_str());
-    data_ptr += location_len;
+unsigned char * RGBController::GetDeviceDescription(unsigned int protocol_version)
+{
+    std::vector<unsigned char> data;
 
-    /*---------------------------------------------------------*\
-    | Copy in number of modes (data)                            |
-    \*---------------------------------------------------------*/
-    memcpy(&data_buf[data_ptr], &num_modes, sizeof(unsigned short));
-    data_ptr += sizeof(unsigned short);
+    WriteDeviceDescription(data, protocol_version);
 
-    /*---------------------------------------------------------*\
-    | Copy in active mode (data)                                |
-    \*---------------------------------------------------------*/
-    memcpy(&data_buf[data_ptr], &active_mode, sizeof(active_mode));
-    data_ptr += sizeof(active_mode);
+    return(CopyDescription(data));
+}
 
+void RGBController::WriteDeviceDescription(std::vector<unsigned char>& data_buf, unsigned int protocol_version)
+{
     /*---------------------------------------------------------*\
-    | Copy in modes                                             |
+    | Everything up to the colors is served from the cache for  |
+    | this protocol version, serializing it again only if the   |
+    | description generation has changed since it was cached   |
     \*---------------------------------------------------------*/
-    for(int mode_index = 0; mode_index < num_modes; mode_index++)
-    {
-        /*---------------------------------------------------------*\
-        | Copy in mode name (size+data)                             |
-        \*---------------------------------------------------------*/
-        memcpy(&data_buf[data_ptr], &mode_name_len[mode_index], sizeof(unsigned short));
-        data_ptr += sizeof(unsigned short);
-
-        strcpy((char *)&data_buf[data_ptr], modes[mode_index].name.c_str());
-        data_ptr += mode_name_len[mode_index];
+    DescriptionCacheMutex.lock();
 
-        /*---------------------------------------------------------*\
-        | Copy in mode value (data)                                 |
-        \*---------------------------------------------------------*/
-        memcpy(&data_buf[data_ptr], &modes[mode_index].value, sizeof(modes[mode_index].value));
-        data_ptr += sizeof(modes[mode_index].value);
-
-        /*---------------------------------------------------------*\
-        | Copy in mode flags (data)                                 |
-        \*---------------------------------------------------------*/
-        memcpy(&data_buf[data_ptr], &modes[mode_index].flags, sizeof(modes[mode_index].flags));
-        data_ptr += sizeof(modes[mode_index].flags);
+    RGBControllerDescriptionCache& cache      = DescriptionCache[protocol_version];
+    unsigned int                   generation = DescriptionGeneration.load();
 
-        /*---------------------------------------------------------*\
-        | Copy in mode speed_min (data)                             |
-        \*---------------------------------------------------------*/
-        memcpy(&data_buf[data_ptr], &modes[mode_index].speed_min, sizeof(modes[mode_index].speed_min));
-        data_ptr += sizeof(modes[mode_index].speed_min);
+    if(!cache.valid || (cache.generation != generation))
+    {
+        WriteDeviceDescriptionHead(cache, protocol_version);
 
-        /*---------------------------------------------------------*\
-        | Copy in mode speed_max (data)                             |
-        \*---------------------------------------------------------*/
-        memcpy(&data_buf[data_ptr], &modes[mode_index].speed_max, sizeof(modes[mode_index].speed_max));
-        data_ptr += sizeof(modes[mode_index].speed_max);
+        cache.generation = generation;
+        cache.valid      = true;
+    }
 
-        /*---------------------------------------------------------*\
-        | Copy in mode brightness_min and brightness_max (data) if  |
-        | protocol 3 or higher                                      |
-        \*---------------------------------------------------------*/
-        if(protocol_version >= 3)
-        {
-            memcpy(&data_buf[data_ptr], &modes[mode_index].brightness_min, sizeof(modes[mode_index].brightness_min));
-            data_ptr += sizeof(modes[mode_index].brightness_min);
+    RGBControllerBufferWriter writer(data_buf);
 
-            memcpy(&data_buf[data_ptr], &modes[mode_index].brightness_max, sizeof(modes[mode_index].brightness_max));
-            data_ptr += sizeof(modes[mode_index].brightness_max);
-        }
+    writer.Write(cache.data.data(), cache.data.size());
 
-        /*---------------------------------------------------------*\
-        | Copy in mode colors_min (data)                            |
-        \*---------------------------------------------------------*/
-        memcpy(&data_buf[data_ptr], &modes[mode_index].colors_min, sizeof(modes[mode_index].colors_min));
-        data_ptr += sizeof(modes[mode_index].colors_min);
+    std::size_t active_mode_offset = cache.active_mode_offset;
 
-        /*---------------------------------------------------------*\
-        | Copy in mode colors_max (data)                            |
-        \*---------------------------------------------------------*/
-        memcpy(&data_buf[data_ptr], &modes[mode_index].colors_max, sizeof(modes[mode_index].colors_max));
-        data_ptr += sizeof(modes[mode_index].colors_max);
+    DescriptionCacheMutex.unlock();
 
-        /*---------------------------------------------------------*\
-        | Copy in mode speed (data)                                 |
-        \*---------------------------------------------------------*/
-        memcpy(&data_buf[data_ptr], &modes[mode_index].speed, sizeof(modes[mode_index].speed));
-        data_ptr += sizeof(modes[mode_index].speed);
+    /*---------------------------------------------------------*\
+    | The active mode and colors change without a generation   |
+    | bump, so they are always written from the controller      |
+    \*---------------------------------------------------------*/
+    writer.Patch(active_mode_offset, active_mode);
 
-        /*---------------------------------------------------------*\
-        | Copy in mode brightness (data) if protocol 3 or higher    |
-        \*---------------------------------------------------------*/
-        if(protocol_version >= 3)
-        {
-            memcpy(&data_buf[data_ptr], &modes[mode_index].brightness, sizeof(modes[mode_index].brightness));
-            data_ptr += sizeof(modes[mode_index].brightness);
-        }
+    unsigned short num_colors = (unsigned short)colors.size();
 
-        /*---------------------------------------------------------*\
-        | Copy in mode direction (data)                             |
-        \*---------------------------------------------------------*/
-        memcpy(&data_buf[data_ptr], &modes[mode_index].direction, sizeof(modes[mode_index].direction));
-        data_ptr += sizeof(modes[mode_index].direction);
+    writer.Write(num_colors);
+    writer.Write(colors.data(), num_colors * sizeof(RGBColor));
 
-        /*---------------------------------------------------------*\
-        | Copy in mode color_mode (data)                            |
-        \*---------------------------------------------------------*/
-        memcpy(&data_buf[data_ptr], &modes[mode_index].color_mode, sizeof(modes[mode_index].color_mode));
-        data_ptr += sizeof(modes[mode_index].color_mode);
+    unsigned int data_size = (unsigned int)writer.GetSize();
 
-        /*---------------------------------------------------------*\
-        | Copy in mode number of colors                             |
-        \*---------------------------------------------------------*/
-        memcpy(&data_buf[data_ptr], &mode_num_colors[mode_index], sizeof(unsigned short));
-        data_ptr += sizeof(unsigned short);
+    writer.Patch(0, data_size);
+}
 
-        /*---------------------------------------------------------*\
-        | Copy in mode mode colors                                  |
-        \*---------------------------------------------------------*/
-        for(int color_index = 0; color_index < mode_num_colors[mode_index]; color_index++)
-        {
-            /*---------------------------------------------------------*\
-            | Copy in color (data)                                      |
-            \*---------------------------------------------------------*/
-            memcpy(&data_buf[data_ptr], &modes[mode_index].colors[color_index], sizeof(modes[mode_index].colors[color_index]));
-            data_ptr += sizeof(modes[mode_index].colors[color_index]);
-        }
-    }
+void RGBController::WriteDeviceDescriptionHead(RGBControllerDescriptionCache& cache, unsigned int protocol_version)
+{
+    RGBControllerBufferWriter writer(cache.data);
 
     /*---------------------------------------------------------*\
-    | Copy in number of zones (data)                            |
+    | Data size, filled in once everything is written           |
     \*---------------------------------------------------------*/
-    memcpy(&data_buf[data_ptr], &num_zones, sizeof(unsigned short));
-    data_ptr += sizeof(unsigned short);
+    unsigned int data_size = 0;
+
+    writer.Write(data_size);
 
     /*---------------------------------------------------------*\
-    | Copy in zones                                             |
+    | Type and strings.  Vendor is only sent if protocol 1 or   |
+    | higher.                                                   |
     \*---------------------------------------------------------*/
-    for(int zone_index = 0; zone_index < num_zones; zone_index++)
-    {
-        /*---------------------------------------------------------*\
-        | Copy in zone name (size+data)                             |
-        \*---------------------------------------------------------*/
-        memcpy(&data_buf[data_ptr], &zone_name_len[zone_index], sizeof(unsigned short));
-        data_ptr += sizeof(unsigned short);
+    writer.Write(type);
+    writer.WriteString(name);
 
-        strcpy((char *)&data_buf[data_ptr], zones[zone_index].name.c_str());
-        data_ptr += zone_name_len[zone_index];
+    if(protocol_version >= 1)
+    {
+        writer.WriteString(vendor);
+    }
 
-        /*---------------------------------------------------------*\
-        | Copy in zone type (data)                                  |
-        \*---------------------------------------------------------*/
-        memcpy(&data_buf[data_ptr], &zones[zone_index].type, sizeof(zones[zone_index].type));
-        data_ptr += sizeof(zones[zone_index].type);
+    writer.WriteString(description);
+    writer.WriteString(version);
+    writer.WriteString(serial);
+    writer.WriteString(location);
 
-        /*---------------------------------------------------------*\
-        | Copy in zone minimum LED count (data)                     |
-        \*---------------------------------------------------------*/
-        memcpy(&data_buf[data_ptr], &zones[zone_index].leds_min, sizeof(zones[zone_index].leds_min));
-        data_ptr += sizeof(zones[zone_index].leds_min);
+    /*---------------------------------------------------------*\
+    | Modes                                                     |
+    \*---------------------------------------------------------*/
+    unsigned short num_modes = (unsigned short)modes.size();
 
-        /*---------------------------------------------------------*\
-        | Copy in zone maximum LED count (data)                     |
-        \*---------------------------------------------------------*/
-        memcpy(&data_buf[data_ptr], &zones[zone_index].leds_max, sizeof(zones[zone_index].leds_max));
-        data_ptr += sizeof(zones[zone_index].leds_max);
+    writer.Write(num_modes);
 
-        /*---------------------------------------------------------*\
-        | Copy in zone LED count (data)                             |
-        \*---------------------------------------------------------*/
-        memcpy(&data_buf[data_ptr], &zones[zone_index].leds_count, sizeof(zones[zone_index].leds_count));
-        data_ptr += sizeof(zones[zone_index].leds_count);
+    cache.active_mode_offset = writer.GetSize();
 
-        /*---------------------------------------------------------*\
-        | Copy in size of zone matrix                               |
-        \*---------------------------------------------------------*/
-        memcpy(&data_buf[data_ptr], &zone_matrix_len[zone_index], sizeof(zone_matrix_len[zone_index]));
-        data_ptr += sizeof(zone_matrix_len[zone_index]);
+    writer.Write(active_mode);
 
-        /*---------------------------------------------------------*\
-        | Copy in matrix data if size is nonzero                    |
-        \*---------------------------------------------------------*/
-        if(zone_matrix_len[zone_index] > 0)
-        {
-            /*---------------------------------------------------------*\
-            | Copy in matrix height                                     |
-            \*---------------------------------------------------------*/
-            memcpy(&data_buf[data_ptr], &zones[zone_index].matrix_map->height, sizeof(zones[zone_index].matrix_map->height));
-            data_ptr += sizeof(zones[zone_index].matrix_map->height);
-
-            /*---------------------------------------------------------*\
-            | Copy in matrix width                                      |
-            \*---------------------------------------------------------*/
-            memcpy(&data_buf[data_ptr], &zones[zone_index].matrix_map->width, sizeof(zones[zone_index].matrix_map->width));
-            data_ptr += sizeof(zones[zone_index].matrix_map->width);
-
-            /*---------------------------------------------------------*\
-            | Copy in matrix map                                        |
-            \*---------------------------------------------------------*/
-            for(unsigned int matrix_idx = 0; matrix_idx < (zones[zone_index].matrix_map->height * zones[zone_index].matrix_map->width); matrix_idx++)
-            {
-                memcpy(&data_buf[data_ptr], &zones[zone_index].matrix_map->map[matrix_idx], sizeof(zones[zone_index].matrix_map->map[matrix_idx]));
-                data_ptr += sizeof(zones[zone_index].matrix_map->map[matrix_idx]);
-            }
-        }
+    for(int mode_index = 0; mode_index < num_modes; mode_index++)
+    {
+        WriteMode(writer, modes[mode_index], protocol_version);
     }
 
     /*---------------------------------------------------------*\
-    | Copy in number of LEDs (data)                             |
+    | Zones                                                     |
     \*---------------------------------------------------------*/
-    memcpy(&data_buf[data_ptr], &num_leds, sizeof(unsigned short));
-    data_ptr += sizeof(unsigned short);
+    unsigned short num_zones = (unsigned short)zones.size();
 
-    /*---------------------------------------------------------*\
-    | Copy in LEDs                                              |
-    \*---------------------------------------------------------*/
-    for(int led_index = 0; led_index < num_leds; led_index++)
+    writer.Write(num_zones);
+
+    for(int zone_index = 0; zone_index < num_zones; zone_index++)
     {
+        writer.WriteString(zones[zone_index].name);
+        writer.Write(zones[zone_index].type);
+        writer.Write(zones[zone_index].leds_min);
+        writer.Write(zones[zone_index].leds_max);
+        writer.Write(zones[zone_index].leds_count);
+
         /*---------------------------------------------------------*\
-        | Copy in LED name (size+data)                              |
+        | Matrix size, followed by height, width and map if the     |
+        | zone has a matrix                                         |
         \*---------------------------------------------------------*/
-        unsigned short ledname_len = strlen(leds[led_index].name.c_str()) + 1;
-        memcpy(&data_buf[data_ptr], &ledname_len, sizeof(unsigned short));
-        data_ptr += sizeof(unsigned short);
+        matrix_map_type * matrix_map      = zones[zone_index].matrix_map;
+        unsigned short    zone_matrix_len = 0;
+
+        if(matrix_map != NULL)
+        {
+            zone_matrix_len = (unsigned short)((2 * sizeof(unsigned int)) + (matrix_map->height * matrix_map->width * sizeof(unsigned int)));
+        }
 
-        strcpy((char *)&data_buf[data_ptr], leds[led_index].name.c_str());
-        data_ptr += ledname_len;
+        writer.Write(zone_matrix_len);
 
-        /*---------------------------------------------------------*\
-        | Copy in LED value (data)                                  |
-        \*---------------------------------------------------------*/
-        memcpy(&data_buf[data_ptr], &leds[led_index].value, sizeof(leds[led_index].value));
-        data_ptr += sizeof(leds[led_index].value);
+        if(zone_matrix_len > 0)
+        {
+            writer.Write(matrix_map->height);
+            writer.Write(matrix_map->width);
+            writer.Write(matrix_map->map, matrix_map->height * matrix_map->width * sizeof(unsigned int));
+        }
     }
 
     /*---------------------------------------------------------*\
-    | Copy in number of colors (data)                           |
+    | LEDs                                                      |
     \*---------------------------------------------------------*/
-    memcpy(&data_buf[data_ptr], &num_colors, sizeof(unsigned short));
-    data_ptr += sizeof(unsigned short);
+    unsigned short num_leds = (unsigned short)leds.size();
 
-    /*---------------------------------------------------------*\
-    | Copy in colors                                            |
-    \*---------------------------------------------------------*/
-    for(int color_index = 0; color_index < num_colors; color_index++)
+    writer.Write(num_leds);
+
+    for(int led_index = 0; led_index < num_leds; led_index++)
     {
-        /*---------------------------------------------------------*\
-        | Copy in color (data)                                      |
-        \*---------------------------------------------------------*/
-        memcpy(&data_buf[data_ptr], &colors[color_index], sizeof(colors[color_index]));
-        data_ptr += sizeof(colors[color_index]);
+        writer.WriteString(leds[led_index].name);
+        writer.Write(leds[led_index].value);
     }
-
-    delete[] mode_name_len;
-    delete[] zone_name_len;
-    delete[] led_name_len;
-
-    delete[] zone_matrix_len;
-    delete[] mode_num_colors;
-
-    return(data_buf);
 }
 
 void RGBController::ReadDeviceDescription(unsigned char* data_buf, unsigned int protocol_version)
 {
-    unsigned int data_ptr = 0;
+    unsigned int data_size;
 
-    data_ptr += sizeof(unsigned int);
+    memcpy(&data_size, data_buf, sizeof(data_size));
 
-    /*---------------------------------------------------------*\
-    | Copy in type                                              |
-    \*---------------------------------------------------------*/
-    memcpy(&type, &data_buf[data_ptr], sizeof(device_type));
-    data_ptr += sizeof(device_type);
+    ReadDeviceDescription(data_buf, data_size, protocol_version);
+}
 
+bool RGBController::ReadDeviceDescription(const unsigned char* data_buf, unsigned int data_size, unsigned int protocol_version)
+{
     /*---------------------------------------------------------*\
-    | Copy in name                                              |
+    | Only read up to the size in the description, which must   |
+    | fit in the given buffer                                   |
     \*---------------------------------------------------------*/
-    unsigned short name_len;
-    memcpy(&name_len, &data_buf[data_ptr], sizeof(unsigned short));
-    data_ptr += sizeof(unsigned short);
+    unsigned int desc_size;
 
-    name = (char *)&data_buf[data_ptr];
-    data_ptr += name_len;
+    RGBControllerBufferReader size_reader(data_buf, data_size);
 
-    /*---------------------------------------------------------*\
-    | Copy in vendor if protocol version is 1 or higher         |
-    \*---------------------------------------------------------*/
-    if(protocol_version >= 1)
+    if(!size_reader.Read(desc_size) || (desc_size > data_size))
     {
-        unsigned short vendor_len;
-        memcpy(&vendor_len, &data_buf[data_ptr], sizeof(unsigned short));
-        data_ptr += sizeof(unsigned short);
-
-        vendor = (char *)&data_buf[data_ptr];
-        data_ptr += vendor_len;
+        return(false);
     }
 
-    /*---------------------------------------------------------*\
-    | Copy in description                                       |
-    \*---------------------------------------------------------*/
-    unsigned short description_len;
-    memcpy(&description_len, &data_buf[data_ptr], sizeof(unsigned short));
-    data_ptr += sizeof(unsigned short);
+    RGBControllerBufferReader reader(data_buf, desc_size);
 
-    description = (char *)&data_buf[data_ptr];
-    data_ptr += description_len;
+    reader.Skip(sizeof(desc_size));
 
     /*---------------------------------------------------------*\
-    | Copy in version                                           |
+    | Everything is read into locals first so that a malformed |
+    | description leaves the controller unchanged               |
     \*---------------------------------------------------------*/
-    unsigned short version_len;
-    memcpy(&version_len, &data_buf[data_ptr], sizeof(unsigned short));
-    data_ptr += sizeof(unsigned short);
+    device_type             new_type;
+    std::string             new_name;
+    std::string             new_vendor;
+    std::string             new_description;
+    std::string             new_version;
+    std::string             new_serial;
+    std::string             new_location;
+    int                     new_active_mode;
+    std::vector<mode>       new_modes;
+    std::vector<zone>       new_zones;
+    std::vector<led>        new_leds;
+    std::vector<RGBColor>   new_colors;
 
-    version = (char *)&data_buf[data_ptr];
-    data_ptr += version_len;
-    
     /*---------------------------------------------------------*\
-    | Copy in serial                                            |
+    | Type and strings.  Vendor is only sent if protocol 1 or   |
+    | higher.                                                   |
     \*---------------------------------------------------------*/
-    unsigned short serial_len;
-    memcpy(&serial_len, &data_buf[data_ptr], sizeof(unsigned short));
-    data_ptr += sizeof(unsigned short);
-
-    serial = (char *)&data_buf[data_ptr];
-    data_ptr += serial_len;
+    reader.Read(new_type);
+    reader.ReadString(new_name);
 
-    /*---------------------------------------------------------*\
-    | Copy in location                                          |
-    \*---------------------------------------------------------*/
-    unsigned short location_len;
-    memcpy(&location_len, &data_buf[data_ptr], sizeof(unsigned short));
-    data_ptr += sizeof(unsigned short);
+    if(protocol_version >= 1)
+    {
+        reader.ReadString(new_vendor);
+    }
 
-    location = (char *)&data_buf[data_ptr];
-    data_ptr += location_len;
+    reader.ReadString(new_description);
+    reader.ReadString(new_version);
+    reader.ReadString(new_serial);
+    reader.ReadString(new_location);
 
     /*---------------------------------------------------------*\
-    | Copy in number of modes (data)                            |
+    | Modes                                                     |
     \*---------------------------------------------------------*/
     unsigned short num_modes;
-    memcpy(&num_modes, &data_buf[data_ptr], sizeof(unsigned short));
-    data_ptr += sizeof(unsigned short);
 
-    /*---------------------------------------------------------*\
-    | Copy in active mode (data)                                |
-    \*---------------------------------------------------------*/
-    memcpy(&active_mode, &data_buf[data_ptr], sizeof(active_mode));
-    data_ptr += sizeof(active_mode);
+    reader.Read(num_modes);
+    reader.Read(new_active_mode);
+
+    if((num_modes > 0) && ((new_active_mode < 0) || (new_active_mode >= num_modes)))
+    {
+        return(false);
+    }
 
-    /*---------------------------------------------------------*\
-    | Copy in modes                                             |
-    \*---------------------------------------------------------*/
     for(int mode_index = 0; mode_index < num_modes; mode_index++)
     {
         mode new_mode;
 
-        /*---------------------------------------------------------*\
-        | Copy in mode name (size+data)                             |
-        \*---------------------------------------------------------*/
-        unsigned short modename_len;
-        memcpy(&modename_len, &data_buf[data_ptr], sizeof(unsigned short));
-        data_ptr += sizeof(unsigned short);
-
-        new_mode.name = (char *)&data_buf[data_ptr];
-        data_ptr += modename_len;
+        if(!ReadMode(reader, new_mode, protocol_version))
+        {
+            return(false);
+        }
 
-        /*---------------------------------------------------------*\
-        | Copy in mode value (data)                                 |
-        \*---------------------------------------------------------*/
-        memcpy(&new_mode.value, &data_buf[data_ptr], sizeof(new_mode.value));
-        data_ptr += sizeof(new_mode.value);
+        new_modes.push_back(new_mode);
+    }
 
-        /*---------------------------------------------------------*\
-        | Copy in mode flags (data)                                 |
-        \*---------------------------------------------------------*/
-        memcpy(&new_mode.flags, &data_buf[data_ptr], sizeof(new_mode.flags));
-        data_ptr += sizeof(new_mode.flags);
+    /*---------------------------------------------------------*\
+    | Zones                                                     |
+    \*---------------------------------------------------------*/
+    unsigned short      num_zones;
+    unsigned long long  total_led_count = 0;
 
-        /*---------------------------------------------------------*\
-        | Copy in mode speed_min (data)                             |
-        \*---------------------------------------------------------*/
-        memcpy(&new_mode.speed_min, &data_buf[data_ptr], sizeof(new_mode.speed_min));
-        data_ptr += sizeof(new_mode.speed_min);
+    reader.Read(num_zones);
 
-        /*---------------------------------------------------------*\
-        | Copy in mode speed_max (data)                             |
-        \*---------------------------------------------------------*/
-        memcpy(&new_mode.speed_max, &data_buf[data_ptr], sizeof(new_mode.speed_max));
-        data_ptr += sizeof(new_mode.speed_max);
+    for(int zone_index = 0; zone_index < num_zones; zone_index++)
+    {
+        zone new_zone;
 
-        /*---------------------------------------------------------*\
-        | Copy in mode brightness min and max if protocol version   |
-        | is 3 or higher                                            |
-        \*---------------------------------------------------------*/
-        if(protocol_version >= 3)
-        {
-            memcpy(&new_mode.brightness_min, &data_buf[data_ptr], sizeof(new_mode.brightness_min));
-            data_ptr += sizeof(new_mode.brightness_min);
+        reader.ReadString(new_zone.name);
+        reader.Read(new_zone.type);
+        reader.Read(new_zone.leds_min);
+        reader.Read(new_zone.leds_max);
+        reader.Read(new_zone.leds_count);
 
-            memcpy(&new_mode.brightness_max, &data_buf[data_ptr], sizeof(new_mode.brightness_max));
-            data_ptr += sizeof(new_mode.brightness_max);
-        }
+        new_zone.matrix_map = NULL;
 
-        /*---------------------------------------------------------*\
-        | Copy in mode colors_min (data)                            |
-        \*---------------------------------------------------------*/
-        memcpy(&new_mode.colors_min, &data_buf[data_ptr], sizeof(new_mode.colors_min));
-        data_ptr += sizeof(new_mode.colors_min);
+        total_led_count += new_zone.leds_count;
 
         /*---------------------------------------------------------*\
-        | Copy in mode colors_max (data)                            |
+        | Matrix size, followed by height, width and map if the     |
+        | zone has a matrix                                         |
         \*---------------------------------------------------------*/
-        memcpy(&new_mode.colors_max, &data_buf[data_ptr], sizeof(new_mode.colors_max));
-        data_ptr += sizeof(new_mode.colors_max);
+        unsigned short zone_matrix_len;
 
-        /*---------------------------------------------------------*\
-        | Copy in mode speed (data)                                 |
-        \*---------------------------------------------------------*/
-        memcpy(&new_mode.speed, &data_buf[data_ptr], sizeof(new_mode.speed));
-        data_ptr += sizeof(new_mode.speed);
+        reader.Read(zone_matrix_len);
 
-        /*---------------------------------------------------------*\
-        | Copy in mode brightness if protocol version is 3 or higher|
-        \*---------------------------------------------------------*/
-        if(protocol_version >= 3)
+        if(zone_matrix_len > 0)
         {
-            memcpy(&new_mode.brightness, &data_buf[data_ptr], sizeof(new_mode.brightness));
-            data_ptr += sizeof(new_mode.brightness);
-        }
+            unsigned int height;
+            unsigned int width;
 
-        /*---------------------------------------------------------*\
-        | Copy in mode direction (data)                             |
-        \*---------------------------------------------------------*/
-        memcpy(&new_mode.direction, &data_buf[data_ptr], sizeof(new_mode.direction));
-        data_ptr += sizeof(new_mode.direction);
+            reader.Read(height);
+            reader.Read(width);
 
-        /*---------------------------------------------------------*\
-        | Copy in mode color_mode (data)                            |
-        \*---------------------------------------------------------*/
-        memcpy(&new_mode.color_mode, &data_buf[data_ptr], sizeof(new_mode.color_mode));
-        data_ptr += sizeof(new_mode.color_mode);
+            if(reader.CanRead((unsigned long long)height * width, sizeof(unsigned int)))
+            {
+                matrix_map_type * new_map = new matrix_map_type;
 
-        /*---------------------------------------------------------*\
-        | Copy in mode number of colors                             |
-        \*---------------------------------------------------------*/
-        unsigned short mode_num_colors;
-        memcpy(&mode_num_colors, &data_buf[data_ptr], sizeof(unsigned short));
-        data_ptr += sizeof(unsigned short);
+                new_map->height = height;
+                new_map->width  = width;
+                new_map->map    = new unsigned int[height * width];
 
-        /*---------------------------------------------------------*\
-        | Copy in mode mode colors                                  |
-        \*---------------------------------------------------------*/
-        for(int color_index = 0; color_index < mode_num_colors; color_index++)
-        {
-            /*---------------------------------------------------------*\
-            | Copy in color (data)                                      |
-            \*---------------------------------------------------------*/
-            RGBColor new_color;
-            memcpy(&new_color, &data_buf[data_ptr], sizeof(RGBColor));
-            data_ptr += sizeof(modes[mode_index].colors[color_index]);
-
-            new_mode.colors.push_back(new_color);
+                reader.Read(new_map->map, height * width * sizeof(unsigned int));
+
+                new_zone.matrix_map = new_map;
+            }
         }
 
-        modes.push_back(new_mode);
+        new_zones.push_back(new_zone);
+
+        if(reader.Failed())
+        {
+            break;
+        }
     }
 
     /*---------------------------------------------------------*\
-    | Copy in number of zones (data)                            |
+    | LEDs                                                      |
     \*---------------------------------------------------------*/
-    unsigned short num_zones;
-    memcpy(&num_zones, &data_buf[data_ptr], sizeof(unsigned short));
-    data_ptr += sizeof(unsigned short);
+    unsigned short num_leds;
 
-    /*---------------------------------------------------------*\
-    | Copy in zones                                             |
-    \*---------------------------------------------------------*/
-    for(int zone_index = 0; zone_index < num_zones; zone_index++)
+    reader.Read(num_leds);
+
+    if(reader.CanRead(num_leds, sizeof(unsigned short) + sizeof(unsigned int)))
     {
-        zone new_zone;
+        for(int led_index = 0; led_index < num_leds; led_index++)
+        {
+            led new_led;
 
-        /*---------------------------------------------------------*\
-        | Copy in zone name (size+data)                             |
-        \*---------------------------------------------------------*/
-        unsigned short zonename_len;
-        memcpy(&zonename_len, &data_buf[data_ptr], sizeof(unsigned short));
-        data_ptr += sizeof(unsigned short);
-
-        new_zone.name = (char *)&data_buf[data_ptr];
-        data_ptr += zonename_len;
-
-        /*---------------------------------------------------------*\
-        | Copy in zone type (data)                                  |
-        \*---------------------------------------------------------*/
-        memcpy(&new_zone.type, &data_buf[data_ptr], sizeof(new_zone.type));
-        data_ptr += sizeof(new_zone.type);
+            reader.ReadString(new_led.name);
+            reader.Read(new_led.value);
 
-        /*---------------------------------------------------------*\
-        | Copy in zone minimum LED count (data)                     |
-        \*---------------------------------------------------------*/
-        memcpy(&new_zone.leds_min, &data_buf[data_ptr], sizeof(new_zone.leds_min));
-        data_ptr += sizeof(new_zone.leds_min);
+            new_leds.push_back(new_led);
+        }
+    }
 
-        /*---------------------------------------------------------*\
-        | Copy in zone maximum LED count (data)                     |
-        \*---------------------------------------------------------*/
-        memcpy(&new_zone.leds_max, &data_buf[data_ptr], sizeof(new_zone.leds_max));
-        data_ptr += sizeof(new_zone.leds_max);
+    /*---------------------------------------------------------*\
+    | Colors                                                    |
+    \*---------------------------------------------------------*/
+    unsigned short num_colors;
 
-        /*---------------------------------------------------------*\
-        | Copy in zone LED count (data)                             |
-        \*---------------------------------------------------------*/
-        memcpy(&new_zone.leds_count, &data_buf[data_ptr], sizeof(new_zone.leds_count));
-        data_ptr += sizeof(new_zone.leds_count);
+    reader.Read(num_colors);
 
-        /*---------------------------------------------------------*\
-        | Copy in size of zone matrix                               |
-        \*---------------------------------------------------------*/
-        unsigned short zone_matrix_len;
-        memcpy(&zone_matrix_len, &data_buf[data_ptr], sizeof(zone_matrix_len));
-        data_ptr += sizeof(zone_matrix_len);
+    if(reader.CanRead(num_colors, sizeof(RGBColor)))
+    {
+        new_colors.resize(num_colors);
+        reader.Read(new_colors.data(), num_colors * sizeof(RGBColor));
+    }
 
-        /*---------------------------------------------------------*\
-        | Copy in matrix data if size is nonzero                    |
-        \*---------------------------------------------------------*/
-        if(zone_matrix_len > 0)
+    /*---------------------------------------------------------*\
+    | The zones must not claim more LEDs than the description   |
+    | contains, as SetupColors() points each zone into the LED  |
+    | list                                                      |
+    \*---------------------------------------------------------*/
+    if(reader.Failed() || (total_led_count > new_leds.size()))
+    {
+        for(std::size_t zone_index = 0; zone_index < new_zones.size(); zone_index++)
         {
-            /*---------------------------------------------------------*\
-            | Create a map data structure to fill in and attach it to   |
-            | the new zone                                              |
-            \*---------------------------------------------------------*/
-            matrix_map_type * new_map = new matrix_map_type;
-
-            new_zone.matrix_map = new_map;
-
-            /*---------------------------------------------------------*\
-            | Copy in matrix height                                     |
-            \*---------------------------------------------------------*/
-            memcpy(&new_map->height, &data_buf[data_ptr], sizeof(new_map->height));
-            data_ptr += sizeof(new_map->height);
-
-            /*---------------------------------------------------------*\
-            | Copy in matrix width                                      |
-            \*---------------------------------------------------------*/
-            memcpy(&new_map->width, &data_buf[data_ptr], sizeof(new_map->width));
-            data_ptr += sizeof(new_map->width);
-
-            /*---------------------------------------------------------*\
-            | Copy in matrix map                                        |
-            \*---------------------------------------------------------*/
-            new_map->map = new unsigned int[new_map->height * new_map->width];
-
-            for(unsigned int matrix_idx = 0; matrix_idx < (new_map->height * new_map->width); matrix_idx++)
+            if(new_zones[zone_index].matrix_map != NULL)
             {
-                memcpy(&new_map->map[matrix_idx], &data_buf[data_ptr], sizeof(new_map->map[matrix_idx]));
-                data_ptr += sizeof(new_map->map[matrix_idx]);
+                delete[] new_zones[zone_index].matrix_map->map;
+                delete new_zones[zone_index].matrix_map;
             }
         }
-        else
-        {
-            new_zone.matrix_map = NULL;
-        }
-        
-        zones.push_back(new_zone);
+
+        return(false);
     }
 
-    /*---------------------------------------------------------*\
-    | Copy in number of LEDs (data)                             |
-    \*---------------------------------------------------------*/
-    unsigned short num_leds;
-    memcpy(&num_leds, &data_buf[data_ptr], sizeof(unsigned short));
-    data_ptr += sizeof(unsigned short);
+    type        = new_type;
+    name        = new_name;
+    vendor      = new_vendor;
+    description = new_description;
+    version     = new_version;
+    serial      = new_serial;
+    location    = new_location;
+    active_mode = new_active_mode;
+    modes       = new_modes;
+    zones       = new_zones;
+    leds        = new_leds;
+    colors      = new_colors;
 
     /*---------------------------------------------------------*\
-    | Copy in LEDs                                              |
+    | Setup colors, which also invalidates the cached           |
+    | description                                               |
     \*---------------------------------------------------------*/
-    for(int led_index = 0; led_index < num_leds; led_index++)
-    {
-        led new_led;
+    SetupColors();
 
-        /*---------------------------------------------------------*\
-        | Copy in LED name (size+data)                              |
-        \*---------------------------------------------------------*/
-        unsigned short ledname_len;
-        memcpy(&ledname_len, &data_buf[data_ptr], sizeof(unsigned short));
-        data_ptr += sizeof(unsigned short);
+    return(true);
+}
 
-        new_led.name = (char *)&data_buf[data_ptr];
-        data_ptr += ledname_len;
+unsigned char * RGBController::GetModeDescription(int mode, unsigned int protocol_version)
+{
+    std::vector<unsigned char> data;
 
-        /*---------------------------------------------------------*\
-        | Copy in LED value (data)                                  |
-        \*---------------------------------------------------------*/
-        memcpy(&new_led.value, &data_buf[data_ptr], sizeof(new_led.value));
-        data_ptr += sizeof(new_led.value);
+    WriteModeDescription(data, mode, protocol_version);
 
-        leds.push_back(new_led);
-    }
+    return(CopyDescription(data));
+}
 
-    /*---------------------------------------------------------*\
-    | Copy in number of colors (data)                           |
-    \*---------------------------------------------------------*/
-    unsigned short num_colors;
-    memcpy(&num_colors, &data_buf[data_ptr], sizeof(unsigned short));
-    data_ptr += sizeof(unsigned short);
+void RGBController::WriteModeDescription(std::vector<unsigned char>& data_buf, int mode, unsigned int protocol_version)
+{
+    RGBControllerBufferWriter writer(data_buf);
+
+    unsigned int data_size = 0;
+
+    writer.Write(data_size);
+    writer.Write(mode);
+
+    WriteMode(writer, modes[mode], protocol_version);
+
+    data_size = (unsigned int)writer.GetSize();
+
+    writer.Patch(0, data_size);
+}
+
+void RGBController::SetModeDescription(unsigned char* data_buf, unsigned int protocol_version)
+{
+    unsigned int data_size;
+
+    memcpy(&data_size, data_buf, sizeof(data_size));
+
+    SetModeDescription(data_buf, data_size, protocol_version);
+}
+
+bool RGBController::SetModeDescription(const unsigned char* data_buf, unsigned int data_size, unsigned int protocol_version)
+{
+    RGBControllerBufferReader reader(data_buf, data_size);
+
+    int mode_idx;
+
+    reader.Skip(sizeof(unsigned int));
+    reader.Read(mode_idx);
 
     /*---------------------------------------------------------*\
-    | Copy in colors                                            |
+    | Check if we aren't reading beyond the list of modes.      |
     \*---------------------------------------------------------*/
-    for(int color_index = 0; color_index < num_colors; color_index++)
+    if(reader.Failed() || (mode_idx < 0) || (((size_t) mode_idx) >= modes.size()))
     {
-        RGBColor new_color;
+        return(false);
+    }
 
-        /*---------------------------------------------------------*\
-        | Copy in color (data)                                      |
-        \*---------------------------------------------------------*/
-        memcpy(&new_color, &data_buf[data_ptr], sizeof(RGBColor));
-        data_ptr += sizeof(RGBColor);
+    mode new_mode;
 
-        colors.push_back(new_color);
+    if(!ReadMode(reader, new_mode, protocol_version))
+    {
+        return(false);
     }
 
     /*---------------------------------------------------------*\
-    | Setup colors                                              |
+    | Set active mode to the new mode                           |
     \*---------------------------------------------------------*/
-    SetupColors();
+    modes[mode_idx] = new_mode;
+    active_mode     = mode_idx;
+
+    InvalidateDescription();
+
+    return(true);
 }
 
-unsigned char * RGBController::GetModeDescription(int mode, unsigned int protocol_version)
+unsigned char * RGBController::GetColorDescription()
 {
-    unsigned int data_ptr = 0;
-    unsigned int data_size = 0;
+    std::vector<unsigned char> data;
 
-    unsigned short mode_name_len;
-    unsigned short mode_num_colors;
+    WriteColorDescription(data);
+
+    return(CopyDescription(data));
+}
+
+void RGBController::WriteColorDescription(std::vector<unsigned char>& data_buf)
+{
+    RGBControllerBufferWriter writer(data_buf);
+
+    unsigned short num_colors = (unsigned short)colors.size();
+    unsigned int   data_size  = sizeof(data_size) + sizeof(num_colors) + (num_colors * sizeof(RGBColor));
+
+    writer.Write(data_size);
+    writer.Write(num_colors);
+    writer.Write(colors.data(), num_colors * sizeof(RGBColor));
+}
+
+void RGBController::SetColorDescription(unsigned char* data_buf)
+{
+    unsigned int data_size;
+
+    memcpy(&data_size, data_buf, sizeof(data_size));
+
+    SetColorDescription(data_buf, data_size);
+}
+
+bool RGBController::SetColorDescription(const unsigned char* data_buf, unsigned int data_size)
+{
+    RGBControllerBufferReader reader(data_buf, data_size);
+
+    unsigned short num_colors;
+
+    reader.Skip(sizeof(unsigned int));
+    reader.Read(num_colors);
 
     /*---------------------------------------------------------*\
-    | Calculate data size                                       |
+    | Check if we aren't reading beyond the list of colors.     |
     \*---------------------------------------------------------*/
-    mode_name_len   = strlen(modes[mode].name.c_str()) + 1;
-    mode_num_colors = modes[mode].colors.size();
-
-    data_size += sizeof(data_size);
-    data_size += sizeof(mode);
-    data_size += sizeof(mode_name_len);
-    data_size += mode_name_len;
-    data_size += sizeof(modes[mode].value);
-    data_size += sizeof(modes[mode].flags);
-    data_size += sizeof(modes[mode].speed_min);
-    data_size += sizeof(modes[mode].speed_max);
-    if(protocol_version >= 3)
-    {
-        data_size += sizeof(modes[mode].brightness_min);
-        data_size += sizeof(modes[mode].brightness_max);
-    }
-    data_size += sizeof(modes[mode].colors_min);
-    data_size += sizeof(modes[mode].colors_max);
-    data_size += sizeof(modes[mode].speed);
-    if(protocol_version >= 3)
+    if(reader.Failed() || (((size_t) num_colors) > colors.size()) || !reader.CanRead(num_colors, sizeof(RGBColor)))
     {
-        data_size += sizeof(modes[mode].brightness);
+        return(false);
     }
-    data_size += sizeof(modes[mode].direction);
-    data_size += sizeof(modes[mode].color_mode);
-    data_size += sizeof(mode_num_colors);
-    data_size += (mode_num_colors * sizeof(RGBColor));
 
-    /*---------------------------------------------------------*\
-    | Create data buffer                                        |
-    \*---------------------------------------------------------*/
-    unsigned char *data_buf = new unsigned char[data_size];
+    return(reader.Read(colors.data(), num_colors * sizeof(RGBColor)));
+}
+
+unsigned char * RGBController::GetZoneColorDescription(int zone)
+{
+    std::vector<unsigned char> data;
+
+    WriteZoneColorDescription(data, zone);
+
+    return(CopyDescription(data));
+}
+
+void RGBController::WriteZoneColorDescription(std::vector<unsigned char>& data_buf, int zone)
+{
+    RGBControllerBufferWriter writer(data_buf);
+
+    unsigned short num_colors = (unsigned short)zones[zone].leds_count;
+    unsigned int   data_size  = sizeof(data_size) + sizeof(zone) + sizeof(num_colors) + (num_colors * sizeof(RGBColor));
+
+    writer.Write(data_size);
+    writer.Write(zone);
+    writer.Write(num_colors);
+    writer.Write(zones[zone].colors, num_colors * sizeof(RGBColor));
+}
+
+void RGBController::SetZoneColorDescription(unsigned char* data_buf)
+{
+    unsigned int data_size;
+
+    memcpy(&data_size, data_buf, sizeof(data_size));
+
+    SetZoneColorDescription(data_buf, data_size);
+}
+
+bool RGBController::SetZoneColorDescription(const unsigned char* data_buf, unsigned int data_size)
+{
+    RGBControllerBufferReader reader(data_buf, data_size);
+
+    unsigned int   zone_idx;
+    unsigned short num_colors;
+
+    reader.Skip(sizeof(unsigned int));
+    reader.Read(zone_idx);
+    reader.Read(num_colors);
 
     /*---------------------------------------------------------*\
-    | Copy in data size                                         |
+    | Check if we aren't reading beyond the list of zones or    |
+    | the zone's colors.                                        |
     \*---------------------------------------------------------*/
-    memcpy(&data_buf[data_ptr], &data_size, sizeof(data_size));
-    data_ptr += sizeof(data_size);
+    if(reader.Failed() || (((size_t) zone_idx) >= zones.size()) || (num_colors > zones[zone_idx].leds_count) || !reader.CanRead(num_colors, sizeof(RGBColor)))
+    {
+        return(false);
+    }
+
+    return(reader.Read(zones[zone_idx].colors, num_colors * sizeof(RGBColor)));
+}
+
+unsigned char * RGBController::GetSingleLEDColorDescription(int led)
+{
+    std::vector<unsigned char> data;
+
+    WriteSingleLEDColorDescription(data, led);
+
+    return(CopyDescription(data));
+}
 
+void RGBController::WriteSingleLEDColorDescription(std::vector<unsigned char>& data_buf, int led)
+{
     /*---------------------------------------------------------*\
-    | Copy in mode index                                        |
+    | Fixed size descrption:                                    |
+    |       int:      LED index                                 |
+    |       RGBColor: LED color                                 |
     \*---------------------------------------------------------*/
-    memcpy(&data_buf[data_ptr], &mode, sizeof(int));
-    data_ptr += sizeof(int);
+    RGBControllerBufferWriter writer(data_buf);
 
+    writer.Write(led);
+    writer.Write(colors[led]);
+}
+
+void RGBController::SetSingleLEDColorDescription(unsigned char* data_buf)
+{
+    SetSingleLEDColorDescription(data_buf, sizeof(int) + sizeof(RGBColor));
+}
+
+bool RGBController::SetSingleLEDColorDescription(const unsigned char* data_buf, unsigned int data_size)
+{
     /*---------------------------------------------------------*\
-    | Copy in mode name (size+data)                             |
+    | Fixed size descrption:                                    |
+    |       int:      LED index                                 |
+    |       RGBColor: LED color                                 |
     \*---------------------------------------------------------*/
-    memcpy(&data_buf[data_ptr], &mode_name_len, sizeof(unsigned short));
-    data_ptr += sizeof(unsigned short);
+    RGBControllerBufferReader reader(data_buf, data_size);
 
-    strcpy((char *)&data_buf[data_ptr], modes[mode].name.c_str());
-    data_ptr += mode_name_len;
+    int      led_idx;
+    RGBColor new_color;
+
+    reader.Read(led_idx);
+    reader.Read(new_color);
 
     /*---------------------------------------------------------*\
-    | Copy in mode value (data)                                 |
+    | Check if we aren't reading beyond the list of leds.       |
     \*---------------------------------------------------------*/
-    memcpy(&data_buf[data_ptr], &modes[mode].value, sizeof(modes[mode].value));
-    data_ptr += sizeof(modes[mode].value);
+    if(reader.Failed() || (led_idx < 0) || (((size_t) led_idx) >= colors.size()))
+    {
+        return(false);
+    }
+
+    colors[led_idx] = new_color;
+
+    return(true);
+}
+
+void RGBController::InvalidateDescription()
+{
+    DescriptionGeneration++;
+}
+
+unsigned int RGBController::GetDescriptionGeneration()
+{
+    return(DescriptionGeneration.load());
+}
+
+void RGBController::SetupColors()
+{
+    unsigned int total_led_count;
 
     /*---------------------------------------------------------*\
-    | Copy in mode flags (data)                                 |
+    | Zones and LEDs are set up or resized before this is       |
+    | called, so the cached description is out of date         |
     \*---------------------------------------------------------*/
-    memcpy(&data_buf[data_ptr], &modes[mode].flags, sizeof(modes[mode].flags));
-    data_ptr += sizeof(modes[mode].flags);
+    InvalidateDescription();
 
     /*---------------------------------------------------------*\
-    | Copy in mode speed_min (data)                             |
+    | Determine total number of LEDs on the device              |
     \*---------------------------------------------------------*/
-    memcpy(&data_buf[data_ptr], &modes[mode].speed_min, sizeof(modes[mode].speed_min));
-    data_ptr += sizeof(modes[mode].speed_min);
+    total_led_count = 0;
+
+    for(std::size_t zone_idx = 0; zone_idx < zones.size(); zone_idx++)
+    {
+        total_led_count += zones[zone_idx].leds_count;
+    }
 
     /*---------------------------------------------------------*\
-    | Copy in mode speed_max (data)                             |
+    | Set the size of the color buffer to the number of LEDs    |
     \*---------------------------------------------------------*/
-    memcpy(&data_buf[data_ptr], &modes[mode].speed_max, sizeof(modes[mode].speed_max));
-    data_ptr += sizeof(modes[mode].speed_max);
+    colors.resize(total_led_count);
 
     /*---------------------------------------------------------*\
-    | Copy in mode brightness min and max if protocol version   |
-    | is 3 or higher                                            |
+    | Set the color buffer pointers on each zone                |
     \*---------------------------------------------------------*/
-    if(protocol_version >= 3)
+    total_led_count = 0;
+
+    for(std::size_t zone_idx = 0; zone_idx < zones.size(); zone_idx++)
     {
-        memcpy(&data_buf[data_ptr], &modes[mode].brightness_min, sizeof(modes[mode].brightness_min));
-        data_ptr += sizeof(modes[mode].brightness_min);
+        zones[zone_idx].start_idx=total_led_count;
 
-        memcpy(&data_buf[data_ptr], &modes[mode].brightness_max, sizeof(modes[mode].brightness_max));
-        data_ptr += sizeof(modes[mode].brightness_max);
+        if((colors.size() > 0) && (zones[zone_idx].leds_count > 0))
+        {
+            zones[zone_idx].colors = &colors[total_led_count];
+        }
+        else
+        {
+            zones[zone_idx].colors = NULL;
+        }
+
+        if((leds.size() > 0) && (zones[zone_idx].leds_count > 0))
+        {
+            zones[zone_idx].leds   = &leds[total_led_count];
+        }
+        else
+        {
+            zones[zone_idx].leds    = NULL;
+        }
+
+
+        total_led_count += zones[zone_idx].leds_count;
     }
+}
 
-    /*---------------------------------------------------------*\
-    | Copy in mode colors_min (data)                            |
-    \*---------------------------------------------------------*/
-    memcpy(&data_buf[data_ptr], &modes[mode].colors_min, sizeof(modes[mode].colors_min));
-    data_ptr += sizeof(modes[mode].colors_min);
+RGBColor RGBController::GetLED(unsigned int led)
+{
+    if(led < colors.size())
+    {
+        return(colors[led]);
+    }
+    else
+    {
+        return(0x00000000);
+    }
+}
 
-    /*---------------------------------------------------------*\
-    | Copy in mode colors_max (data)                            |
-    \*---------------------------------------------------------*/
-    memcpy(&data_buf[data_ptr], &modes[mode].colors_max, sizeof(modes[mode].colors_max));
-    data_ptr += sizeof(modes[mode].colors_max);
+void RGBController::SetLED(unsigned int led, RGBColor color)
+{
+    if(led < colors.size())
+    {
+        colors[led] = color;
+    }
+}
 
-    /*---------------------------------------------------------*\
-    | Copy in mode speed (data)                                 |
-    \*---------------------------------------------------------*/
-    memcpy(&data_buf[data_ptr], &modes[mode].speed, sizeof(modes[mode].speed));
-    data_ptr += sizeof(modes[mode].speed);
+void RGBController::SetAllLEDs(RGBColor color)
+{
+    for(std::size_t zone_idx = 0; zone_idx < zones.size(); zone_idx++)
+    {
+        SetAllZoneLEDs(zone_idx, color);
+    }
+}
 
-    /*---------------------------------------------------------*\
-    | Copy in mode brightness if protocol version is 3 or higher|
-    \*---------------------------------------------------------*/
-    if(protocol_version >= 3)
+void RGBController::SetAllZoneLEDs(int zone, RGBColor color)
+{
+    for (std::size_t color_idx = 0; color_idx < zones[zone].leds_count; color_idx++)
     {
-        memcpy(&data_buf[data_ptr], &modes[mode].brightness, sizeof(modes[mode].brightness));
-        data_ptr += sizeof(modes[mode].brightness);
+        zones[zone].colors[color_idx] = color;
     }
-    
-    /*---------------------------------------------------------*\
-    | Copy in mode direction (data)                             |
-    \*---------------------------------------------------------*/
-    memcpy(&data_buf[data_ptr], &modes[mode].direction, sizeof(modes[mode].direction));
-    data_ptr += sizeof(modes[mode].direction);
+}
 
-    /*---------------------------------------------------------*\
-    | Copy in mode color_mode (data)                            |
-    \*---------------------------------------------------------*/
-    memcpy(&data_buf[data_ptr], &modes[mode].color_mode, sizeof(modes[mode].color_mode));
-    data_ptr += sizeof(modes[mode].color_mode);
+int RGBController::GetMode()
+{
+    return(active_mode);
+}
 
-    /*---------------------------------------------------------*\
-    | Copy in mode number of colors                             |
-    \*---------------------------------------------------------*/
-    memcpy(&data_buf[data_ptr], &mode_num_colors, sizeof(unsigned short));
-    data_ptr += sizeof(unsigned short);
+void RGBController::SetMode(int mode)
+{
+    active_mode = mode;
 
-    /*---------------------------------------------------------*\
-    | Copy in mode mode colors                                  |
-    \*---------------------------------------------------------*/
-    for(int color_index = 0; color_index < mode_num_colors; color_index++)
+    UpdateMode();
+}
+
+/*---------------------------------------------------------*\
+| Callback lists this thread is calling, innermost last, so |
+| that a callback removing a callback from a list it is     |
+| being called from does not wait on itself                 |
+\*---------------------------------------------------------*/
+static thread_local std::vector<const RGBControllerCallbackList *> signal_update_lists;
+
+void RGBController::RegisterUpdateCallback(RGBControllerCallback new_callback, void * new_callback_arg)
+{
+    UpdateMutex.lock();
+
+    std::shared_ptr<RGBControllerCallbackList> new_list = std::make_shared<RGBControllerCallbackList>();
+
+    if(UpdateCallbackList)
     {
-        /*---------------------------------------------------------*\
-        | Copy in color (data)                                      |
-        \*---------------------------------------------------------*/
-        memcpy(&data_buf[data_ptr], &modes[mode].colors[color_index], sizeof(modes[mode].colors[color_index]));
-        data_ptr += sizeof(modes[mode].colors[color_index]);
+        *new_list = *UpdateCallbackList;
     }
 
-    return(data_buf);
+    RGBControllerCallbackEntry new_entry;
+
+    new_entry.callback      = new_callback;
+    new_entry.callback_arg  = new_callback_arg;
+
+    new_list->push_back(new_entry);
+
+    std::atomic_store(&UpdateCallbackList, std::shared_ptr<const RGBControllerCallbackList>(new_list));
+
+    UpdateMutex.unlock();
 }
 
-void RGBController::SetModeDescription(unsigned char* data_buf, unsigned int protocol_version)
+void RGBController::UnregisterUpdateCallback(void * callback_arg)
 {
-    int mode_idx;
-    unsigned int data_ptr = sizeof(unsigned int);
+    UpdateMutex.lock();
 
-    /*---------------------------------------------------------*\
-    | Copy in mode index                                        |
-    \*---------------------------------------------------------*/
-    memcpy(&mode_idx, &data_buf[data_ptr], sizeof(int));
-    data_ptr += sizeof(int);
+    std::shared_ptr<RGBControllerCallbackList> new_list = std::make_shared<RGBControllerCallbackList>();
+
+    if(UpdateCallbackList)
+    {
+        *new_list = *UpdateCallbackList;
+    }
 
+    for(unsigned int callback_idx = 0; callback_idx < new_list->size(); callback_idx++ )
+    {
+        if((*new_list)[callback_idx].callback_arg == callback_arg)
+        {
+            new_list->erase(new_list->begin() + callback_idx);
+
+            break;
+        }
+    }
+
+    std::shared_ptr<const RGBControllerCallbackList> old_list = std::atomic_exchange(&UpdateCallbackList, std::shared_ptr<const RGBControllerCallbackList>(new_list));
+
+    UpdateMutex.unlock();
+
+    WaitForCallbacks(old_list);
+}
+
+void RGBController::ClearCallbacks()
+{
+    UpdateMutex.lock();
+
+    std::shared_ptr<const RGBControllerCallbackList> old_list = std::atomic_exchange(&UpdateCallbackList, std::shared_ptr<const RGBControllerCallbackList>());
+
+    UpdateMutex.unlock();
+
+    WaitForCallbacks(old_list);
+}
+
+void RGBController::WaitForCallbacks(std::shared_ptr<const RGBControllerCallbackList>& old_list)
+{
     /*---------------------------------------------------------*\
-    | Check if we aren't reading beyond the list of modes.      |
+    | Wait until no other thread is still calling the old list, |
+    | so a removed callback's argument can be freed as soon as  |
+    | this returns.  References held by SignalUpdate() calls on |
+    | this thread, when called from a callback, are not waited  |
+    | for.                                                      |
     \*---------------------------------------------------------*/
-    if(((size_t) mode_idx) >  modes.size())
+    if(!old_list)
     {
         return;
     }
 
-    /*---------------------------------------------------------*\
-    | Get pointer to target mode                                |
-    \*---------------------------------------------------------*/
-    mode * new_mode = &modes[mode_idx];
-    
-    /*---------------------------------------------------------*\
-    | Set active mode to the new mode                           |
-    \*---------------------------------------------------------*/
-    active_mode = mode_idx;
+    long held_count = 1 + std::count(signal_update_lists.begin(), signal_update_lists.end(), old_list.get());
 
-    /*---------------------------------------------------------*\
-    | Copy in mode name (size+data)                             |
-    \*---------------------------------------------------------*/
-    unsigned short modename_len;
-    memcpy(&modename_len, &data_buf[data_ptr], sizeof(unsigned short));
-    data_ptr += sizeof(unsigned short);
+    CallbackWaiters++;
 
-    new_mode->name = (char *)&data_buf[data_ptr];
-    data_ptr += modename_len;
+    std::atomic_thread_fence(std::memory_order_seq_cst);
 
-    /*---------------------------------------------------------*\
-    | Copy in mode value (data)                                 |
-    \*---------------------------------------------------------*/
-    memcpy(&new_mode->value, &data_buf[data_ptr], sizeof(new_mode->value));
-    data_ptr += sizeof(new_mode->value);
+    std::unique_lock<std::mutex> update_lock(UpdateMutex);
 
-    /*---------------------------------------------------------*\
-    | Copy in mode flags (data)                                 |
-    \*---------------------------------------------------------*/
-    memcpy(&new_mode->flags, &data_buf[data_ptr], sizeof(new_mode->flags));
-    data_ptr += sizeof(new_mode->flags);
+    CallbackDoneCV.wait(update_lock, [&old_list, held_count]{ return(old_list.use_count() <= held_count); });
 
-    /*---------------------------------------------------------*\
-    | Copy in mode speed_min (data)                             |
-    \*---------------------------------------------------------*/
-    memcpy(&new_mode->speed_min, &data_buf[data_ptr], sizeof(new_mode->speed_min));
-    data_ptr += sizeof(new_mode->speed_min);
+    update_lock.unlock();
 
-    /*---------------------------------------------------------*\
-    | Copy in mode speed_max (data)                             |
-    \*---------------------------------------------------------*/
-    memcpy(&new_mode->speed_max, &data_buf[data_ptr], sizeof(new_mode->speed_max));
-    data_ptr += sizeof(new_mode->speed_max);
+    CallbackWaiters--;
+}
+
+void RGBController::SignalUpdate()
+{
+    std::shared_ptr<const RGBControllerCallbackList> callback_list = std::atomic_load(&UpdateCallbackList);
+
+    if(!callback_list || callback_list->empty())
+    {
+        return;
+    }
+
+    std::chrono::steady_clock::time_point start_time = std::chrono::steady_clock::now();
+
+    signal_update_lists.push_back(callback_list.get());
+
+    /*-------------------------------------------------*\
+    | Client info has changed, call the callbacks       |
+    \*-------------------------------------------------*/
+    for(std::size_t callback_idx = 0; callback_idx < callback_list->size(); callback_idx++)
+    {
+        (*callback_list)[callback_idx].callback((*callback_list)[callback_idx].callback_arg);
+    }
+
+    signal_update_lists.pop_back();
+
+    /*-------------------------------------------------*\
+    | Release the list and wake any thread waiting for  |
+    | it to be released                                 |
+    \*-------------------------------------------------*/
+    callback_list.reset();
+
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    if(CallbackWaiters.load() > 0)
+    {
+        UpdateMutex.lock();
+        UpdateMutex.unlock();
+
+        CallbackDoneCV.notify_all();
+    }
+
+    /*-------------------------------------------------*\
+    | Record the time spent in callbacks                |
+    \*-------------------------------------------------*/
+    unsigned long long callback_time = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start_time).count();
+    unsigned long long callback_max  = SignalUpdateTimeMax.load();
+
+    SignalUpdateCount++;
+    SignalUpdateTime += callback_time;
+
+    while((callback_time > callback_max) && !SignalUpdateTimeMax.compare_exchange_weak(callback_max, callback_time))
+    {
+    }
+}
+
+unsigned long long RGBController::GetSignalUpdateCount()
+{
+    return(SignalUpdateCount.load());
+}
+
+unsigned long long RGBController::GetSignalUpdateTime()
+{
+    return(SignalUpdateTime.load());
+}
+
+unsigned long long RGBController::GetSignalUpdateTimeMax()
+{
+    return(SignalUpdateTimeMax.load());
+}
+
+void RGBController::UpdateLEDs()
+{
+    if(!Populated.load())
+    {
+        return;
+    }
 
     /*---------------------------------------------------------*\
-    | Copy in mode brightness_min and brightness_max (data) if  |
-    | protocol 3 or higher                                      |
+    | Snapshot the color buffer if the driver reads it.  If the |
+    | previous frame has not been sent yet it is replaced,      |
+    | latest frame wins                                         |
     \*---------------------------------------------------------*/
-    if(protocol_version >= 3)
+    bool snapshot = FrameSnapshot.load();
+
+    FrameMutex.lock();
+
+    if(FrameIsPending)
+    {
+        FramesCoalesced++;
+    }
+    else
     {
-        memcpy(&new_mode->brightness_min, &data_buf[data_ptr], sizeof(new_mode->brightness_min));
-        data_ptr += sizeof(new_mode->brightness_min);
+        FramePendingTime = std::chrono::steady_clock::now();
+    }
 
-        memcpy(&new_mode->brightness_max, &data_buf[data_ptr], sizeof(new_mode->brightness_max));
-        data_ptr += sizeof(new_mode->brightness_max);
+    if(snapshot)
+    {
+        FramePending        = colors;
     }
-    
+
+    FramePendingSnapshot    = snapshot;
+    FrameIsPending          = true;
+
+    FrameMutex.unlock();
+
+    FramesSubmitted++;
+
+    CallFlag_UpdateLEDs = true;
+
+    QueueDeviceCall();
+
+    SignalUpdate();
+}
+
+void RGBController::UpdateMode()
+{
+    if(!Populated.load())
+    {
+        return;
+    }
+
     /*---------------------------------------------------------*\
-    | Copy in mode colors_min (data)                            |
+    | Mode settings are changed in place before UpdateMode() is |
+    | called, so the cached description is out of date          |
     \*---------------------------------------------------------*/
-    memcpy(&new_mode->colors_min, &data_buf[data_ptr], sizeof(new_mode->colors_min));
-    data_ptr += sizeof(new_mode->colors_min);
+    InvalidateDescription();
+
+    CallFlag_UpdateMode = true;
+
+    QueueDeviceCall();
+}
 
+void RGBController::QueueDeviceCall()
+{
     /*---------------------------------------------------------*\
-    | Copy in mode colors_max (data)                            |
+    | Dispatched controllers are queued on their lane           |
     \*---------------------------------------------------------*/
-    memcpy(&new_mode->colors_max, &data_buf[data_ptr], sizeof(new_mode->colors_max));
-    data_ptr += sizeof(new_mode->colors_max);
+    if(DeviceCallDispatched.load())
+    {
+        RGBControllerDispatcher::get()->Schedule(this);
+        return;
+    }
 
     /*---------------------------------------------------------*\
-    | Copy in mode speed (data)                                 |
+    | Otherwise wake this controller's device call thread,      |
+    | starting it on first use                                  |
     \*---------------------------------------------------------*/
-    memcpy(&new_mode->speed, &data_buf[data_ptr], sizeof(new_mode->speed));
-    data_ptr += sizeof(new_mode->speed);
+    DeviceCallMutex.lock();
+
+    if(DeviceCallThread == nullptr)
+    {
+        DeviceThreadRunning = true;
+        DeviceCallThread    = new std::thread(&RGBController::DeviceCallThreadFunction, this);
+    }
+
+    DeviceCallMutex.unlock();
+
+    DeviceCallCV.notify_one();
+}
+
+void RGBController::SetDispatchLane(std::string lane_name)
+{
+    if(lane_name.empty() || DeviceCallDispatched.load())
+    {
+        return;
+    }
+
+    RGBControllerDispatcher::get()->Register(this, lane_name);
 
     /*---------------------------------------------------------*\
-    | Copy in mode brightness (data) if protocol 3 or higher    |
+    | Stop the device call thread if it was already started so  |
+    | that only the dispatcher services this controller         |
     \*---------------------------------------------------------*/
-    if(protocol_version >= 3)
+    DeviceCallMutex.lock();
+
+    std::thread* old_thread = DeviceCallThread;
+
+    DeviceCallThread        = nullptr;
+    DeviceThreadRunning     = false;
+    DeviceCallDispatched    = true;
+
+    DeviceCallMutex.unlock();
+
+    DeviceCallCV.notify_all();
+
+    if(old_thread)
     {
-        memcpy(&new_mode->brightness, &data_buf[data_ptr], sizeof(new_mode->brightness));
-        data_ptr += sizeof(new_mode->brightness);
+        old_thread->join();
+        delete old_thread;
     }
-    
+
     /*---------------------------------------------------------*\
-    | Copy in mode direction (data)                             |
+    | Hand over any call that was pending on the old thread     |
     \*---------------------------------------------------------*/
-    memcpy(&new_mode->direction, &data_buf[data_ptr], sizeof(new_mode->direction));
-    data_ptr += sizeof(new_mode->direction);
+    if(CallFlag_UpdateLEDs.load() || CallFlag_UpdateMode.load())
+    {
+        RGBControllerDispatcher::get()->Schedule(this);
+    }
+}
+
+void RGBController::SaveMode()
+{
+    if(!Populated.load())
+    {
+        return;
+    }
+
+    InvalidateDescription();
+
+    DeviceSaveMode();
+}
+
+void RGBController::DeviceUpdateLEDs()
+{
+
+}
+
+void RGBController::DeviceUpdateMode()
+{
+
+}
+
+void RGBController::DeviceCallThreadFunction()
+{
+    while(DeviceThreadRunning.load() == true)
+    {
+        /*-------------------------------------------------*\
+        | Sleep until a call flag is set or the thread is   |
+        | asked to stop.  Wakeups that find nothing to do   |
+        | are counted as idle wakeups.                      |
+        \*-------------------------------------------------*/
+        std::unique_lock<std::mutex> call_lock(DeviceCallMutex);
+
+        while((CallFlag_UpdateLEDs.load() == false)
+           && (CallFlag_UpdateMode.load() == false)
+           && (DeviceThreadRunning.load() == true))
+        {
+            DeviceCallCV.wait(call_lock);
+
+            if((CallFlag_UpdateLEDs.load() == false)
+            && (CallFlag_UpdateMode.load() == false)
+            && (DeviceThreadRunning.load() == true))
+            {
+                DeviceCallIdleWakeups++;
+            }
+        }
+
+        call_lock.unlock();
+
+        if(DeviceThreadRunning.load() == false)
+        {
+            break;
+        }
+
+        DeviceCallService();
+    }
+}
+
+void RGBController::DeviceCallService()
+{
+    /*-----------------------------------------------------*\
+    | Clear each flag before servicing it so a request made |
+    | during the device call is not lost                    |
+    \*-----------------------------------------------------*/
+    if(CallFlag_UpdateMode.exchange(false) == true)
+    {
+        DeviceUpdateMode();
+
+        /*-------------------------------------------------*\
+        | The device may have dropped its LED state, so the |
+        | next frame is sent in full                        |
+        \*-------------------------------------------------*/
+        FrameForceFull = true;
+    }
+    if(CallFlag_UpdateLEDs.load() == true)
+    {
+        /*-------------------------------------------------*\
+        | A dispatched controller must not hold its worker  |
+        | and lane while it waits, so the frame is left     |
+        | pending and the dispatcher services it again at   |
+        | the frame slot                                    |
+        \*-------------------------------------------------*/
+        if(DeviceCallDispatched.load() && (GetFrameSlotTime().time_since_epoch().count() != 0))
+        {
+            return;
+        }
+
+        WaitForFrameSlot();
+
+        CallFlag_UpdateLEDs = false;
+
+        /*-------------------------------------------------*\
+        | Take the latest frame.  A flag set by a frame     |
+        | that was already taken has nothing left to send   |
+        \*-------------------------------------------------*/
+        FrameMutex.lock();
+
+        bool frame_ready    = FrameIsPending;
+        bool frame_partial  = false;
+
+        std::chrono::steady_clock::time_point pending_time = FramePendingTime;
+
+        if(frame_ready)
+        {
+            if(FramePendingSnapshot)
+            {
+                frame_partial = FrameFindChanges(PartialUpdateFlags.load());
+
+                FrameActive.swap(FramePending);
+            }
+
+            FrameActiveSnapshot = FramePendingSnapshot;
+            FrameIsPending      = false;
+        }
+
+        FrameMutex.unlock();
+
+        if(frame_ready)
+        {
+            std::chrono::steady_clock::time_point frame_time = std::chrono::steady_clock::now();
+
+            FrameServiceThread = std::this_thread::get_id();
+
+            if(!frame_partial)
+            {
+                DeviceUpdateLEDs();
+                FrameForceFull = false;
+            }
+            else if(FrameDirtyLED >= 0)
+            {
+                UpdateSingleLED(FrameDirtyLED);
+            }
+            else
+            {
+                for(std::size_t dirty_idx = 0; dirty_idx < FrameDirtyZones.size(); dirty_idx++)
+                {
+                    UpdateZoneLEDs(FrameDirtyZones[dirty_idx]);
+                }
+            }
+
+            FrameServiceThread = std::thread::id();
+
+            FramesSent++;
+
+            RecordFrameStats(pending_time, frame_time);
+
+            if(frame_partial)
+            {
+                FramesPartial++;
+            }
+
+            unsigned int max_fps = FrameMaxFPS.load();
+
+            if(max_fps > 0)
+            {
+                FrameNextTime = frame_time + std::chrono::microseconds(1000000 / max_fps);
+            }
+        }
+    }
+}
 
-    /*---------------------------------------------------------*\
-    | Copy in mode color_mode (data)                            |
-    \*---------------------------------------------------------*/
-    memcpy(&new_mode->color_mode, &data_buf[data_ptr], sizeof(new_mode->color_mode));
-    data_ptr += sizeof(new_mode->color_mode);
+void RGBController::RecordFrameStats(std::chrono::steady_clock::time_point pending_time, std::chrono::steady_clock::time_point send_time)
+{
+    std::chrono::steady_clock::time_point done_time = std::chrono::steady_clock::now();
 
-    /*---------------------------------------------------------*\
-    | Copy in mode number of colors                             |
-    \*---------------------------------------------------------*/
-    unsigned short mode_num_colors;
-    memcpy(&mode_num_colors, &data_buf[data_ptr], sizeof(unsigned short));
-    data_ptr += sizeof(unsigned short);
+    StatsMutex.lock();
+
+    RGBControllerHistogramAdd(StatsUpdateLatency, std::chrono::duration_cast<std::chrono::microseconds>(send_time - pending_time).count());
+    RGBControllerHistogramAdd(StatsTransportTime, std::chrono::duration_cast<std::chrono::microseconds>(done_time - send_time).count());
 
     /*---------------------------------------------------------*\
-    | Copy in mode mode colors                                  |
+    | Average the interval between frames over roughly the last |
+    | eight frames                                              |
     \*---------------------------------------------------------*/
-    new_mode->colors.clear();
-    for(int color_index = 0; color_index < mode_num_colors; color_index++)
+    if(StatsLastSendTime.time_since_epoch().count() != 0)
     {
-        /*---------------------------------------------------------*\
-        | Copy in color (data)                                      |
-        \*---------------------------------------------------------*/
-        RGBColor new_color;
-        memcpy(&new_color, &data_buf[data_ptr], sizeof(RGBColor));
-        data_ptr += sizeof(RGBColor);
+        float interval = std::chrono::duration<float>(send_time - StatsLastSendTime).count();
 
-        new_mode->colors.push_back(new_color);
+        if(StatsFrameInterval == 0.0f)
+        {
+            StatsFrameInterval = interval;
+        }
+        else
+        {
+            StatsFrameInterval += (interval - StatsFrameInterval) / 8.0f;
+        }
     }
+
+    StatsLastSendTime = send_time;
+
+    StatsMutex.unlock();
 }
 
-unsigned char * RGBController::GetColorDescription()
+void RGBController::GetStats(RGBControllerStats& stats)
 {
-    unsigned int data_ptr = 0;
-    unsigned int data_size = 0;
+    stats.frames_submitted  = FramesSubmitted.load();
+    stats.frames_sent       = FramesSent.load();
+    stats.frames_dropped    = FramesCoalesced.load();
+    stats.frames_partial    = FramesPartial.load();
 
-    unsigned short num_colors = colors.size();
+    StatsMutex.lock();
 
     /*---------------------------------------------------------*\
-    | Calculate data size                                       |
+    | A device that has not sent a frame for over two average   |
+    | intervals, and at least a second, is reported as idle     |
     \*---------------------------------------------------------*/
-    data_size += sizeof(data_size);
-    data_size += sizeof(num_colors);
-    data_size += num_colors * sizeof(RGBColor);
+    float idle_time = std::chrono::duration<float>(std::chrono::steady_clock::now() - StatsLastSendTime).count();
 
-    /*---------------------------------------------------------*\
-    | Create data buffer                                        |
-    \*---------------------------------------------------------*/
-    unsigned char *data_buf = new unsigned char[data_size];
+    if((StatsFrameInterval > 0.0f) && (idle_time < std::max(2.0f * StatsFrameInterval, 1.0f)))
+    {
+        stats.frame_rate    = 1.0f / StatsFrameInterval;
+    }
+    else
+    {
+        stats.frame_rate    = 0.0f;
+    }
 
-    /*---------------------------------------------------------*\
-    | Copy in data size                                         |
-    \*---------------------------------------------------------*/
-    memcpy(&data_buf[data_ptr], &data_size, sizeof(data_size));
-    data_ptr += sizeof(data_size);
+    stats.update_latency    = StatsUpdateLatency;
+    stats.transport_time    = StatsTransportTime;
 
-    /*---------------------------------------------------------*\
-    | Copy in number of colors (data)                           |
-    \*---------------------------------------------------------*/
-    memcpy(&data_buf[data_ptr], &num_colors, sizeof(unsigned short));
-    data_ptr += sizeof(unsigned short);
+    StatsMutex.unlock();
+}
 
-    /*---------------------------------------------------------*\
-    | Copy in colors                                            |
-    \*---------------------------------------------------------*/
-    for(int color_index = 0; color_index < num_colors; color_index++)
-    {
-        /*---------------------------------------------------------*\
-        | Copy in color (data)                                      |
-        \*---------------------------------------------------------*/
-        memcpy(&data_buf[data_ptr], &colors[color_index], sizeof(colors[color_index]));
-        data_ptr += sizeof(colors[color_index]);
-    }
+void RGBController::ResetStats()
+{
+    StatsMutex.lock();
 
-    return(data_buf);
+    StatsLastSendTime   = std::chrono::steady_clock::time_point();
+    StatsFrameInterval  = 0.0f;
+    StatsUpdateLatency  = RGBControllerHistogram();
+    StatsTransportTime  = RGBControllerHistogram();
+
+    StatsMutex.unlock();
+
+    FramesSubmitted     = 0;
+    FramesCoalesced     = 0;
+    FramesSent          = 0;
+    FramesPartial       = 0;
 }
 
-void RGBController::SetColorDescription(unsigned char* data_buf)
+static void WriteHistogram(RGBControllerBufferWriter& writer, const RGBControllerHistogram& histogram)
 {
-    unsigned int data_ptr = sizeof(unsigned int);
+    unsigned short num_buckets = RGBCONTROLLER_HISTOGRAM_BUCKETS;
 
-    /*---------------------------------------------------------*\
-    | Copy in number of colors (data)                           |
-    \*---------------------------------------------------------*/
-    unsigned short num_colors;
-    memcpy(&num_colors, &data_buf[data_ptr], sizeof(unsigned short));
-    data_ptr += sizeof(unsigned short);
+    writer.Write(histogram.count);
+    writer.Write(histogram.total_us);
+    writer.Write(histogram.max_us);
+    writer.Write(num_buckets);
+    writer.Write(histogram.buckets, sizeof(histogram.buckets));
+}
 
-    /*---------------------------------------------------------*\
-    | Check if we aren't reading beyond the list of colors.     |
-    \*---------------------------------------------------------*/
-    if(((size_t) num_colors) > colors.size())
-    {
-        return;
-    }
+static void ReadHistogram(RGBControllerBufferReader& reader, RGBControllerHistogram& histogram)
+{
+    unsigned short num_buckets;
+
+    histogram = RGBControllerHistogram();
+
+    reader.Read(histogram.count);
+    reader.Read(histogram.total_us);
+    reader.Read(histogram.max_us);
+    reader.Read(num_buckets);
 
     /*---------------------------------------------------------*\
-    | Copy in colors                                            |
+    | Buckets beyond what this build knows about are added to   |
+    | the last bucket                                           |
     \*---------------------------------------------------------*/
-    for(int color_index = 0; color_index < num_colors; color_index++)
+    for(unsigned int bucket_idx = 0; bucket_idx < num_buckets; bucket_idx++)
     {
-        RGBColor new_color;
+        unsigned long long bucket_count;
 
-        /*---------------------------------------------------------*\
-        | Copy in color (data)                                      |
-        \*---------------------------------------------------------*/
-        memcpy(&new_color, &data_buf[data_ptr], sizeof(RGBColor));
-        data_ptr += sizeof(RGBColor);
+        if(!reader.Read(bucket_count))
+        {
+            break;
+        }
 
-        colors[color_index] = new_color;
+        histogram.buckets[std::min(bucket_idx, (unsigned int)RGBCONTROLLER_HISTOGRAM_BUCKETS - 1)] += bucket_count;
     }
 }
 
-unsigned char * RGBController::GetZoneColorDescription(int zone)
+void RGBController::WriteStatsDescription(std::vector<unsigned char>& data_buf)
 {
-    unsigned int data_ptr = 0;
+    RGBControllerStats          stats;
+    RGBControllerBufferWriter   writer(data_buf);
+
+    GetStats(stats);
+
     unsigned int data_size = 0;
 
-    unsigned short num_colors = zones[zone].leds_count;
+    writer.Write(data_size);
+    writer.Write(stats.frames_submitted);
+    writer.Write(stats.frames_sent);
+    writer.Write(stats.frames_dropped);
+    writer.Write(stats.frames_partial);
+    writer.Write(stats.frame_rate);
 
-    /*---------------------------------------------------------*\
-    | Calculate data size                                       |
-    \*---------------------------------------------------------*/
-    data_size += sizeof(data_size);
-    data_size += sizeof(zone);
-    data_size += sizeof(num_colors);
-    data_size += num_colors * sizeof(RGBColor);
+    WriteHistogram(writer, stats.update_latency);
+    WriteHistogram(writer, stats.transport_time);
 
-    /*---------------------------------------------------------*\
-    | Create data buffer                                        |
-    \*---------------------------------------------------------*/
-    unsigned char *data_buf = new unsigned char[data_size];
+    data_size = (unsigned int)writer.GetSize();
 
-    /*---------------------------------------------------------*\
-    | Copy in data size                                         |
-    \*---------------------------------------------------------*/
-    memcpy(&data_buf[data_ptr], &data_size, sizeof(data_size));
-    data_ptr += sizeof(data_size);
+    writer.Patch(0, data_size);
+}
 
-    /*---------------------------------------------------------*\
-    | Copy in zone index                                        |
-    \*---------------------------------------------------------*/
-    memcpy(&data_buf[data_ptr], &zone, sizeof(zone));
-    data_ptr += sizeof(zone);
+bool RGBController::ReadStatsDescription(const unsigned char* data_buf, unsigned int data_size, RGBControllerStats& stats)
+{
+    RGBControllerBufferReader reader(data_buf, data_size);
 
-    /*---------------------------------------------------------*\
-    | Copy in number of colors (data)                           |
-    \*---------------------------------------------------------*/
-    memcpy(&data_buf[data_ptr], &num_colors, sizeof(unsigned short));
-    data_ptr += sizeof(unsigned short);
+    reader.Skip(sizeof(unsigned int));
+    reader.Read(stats.frames_submitted);
+    reader.Read(stats.frames_sent);
+    reader.Read(stats.frames_dropped);
+    reader.Read(stats.frames_partial);
+    reader.Read(stats.frame_rate);
 
-    /*---------------------------------------------------------*\
-    | Copy in colors                                            |
-    \*---------------------------------------------------------*/
-    for(int color_index = 0; color_index < num_colors; color_index++)
-    {
-        /*---------------------------------------------------------*\
-        | Copy in color (data)                                      |
-        \*---------------------------------------------------------*/
-        memcpy(&data_buf[data_ptr], &zones[zone].colors[color_index], sizeof(zones[zone].colors[color_index]));
-        data_ptr += sizeof(zones[zone].colors[color_index]);
-    }
+    ReadHistogram(reader, stats.update_latency);
+    ReadHistogram(reader, stats.transport_time);
 
-    return(data_buf);
+    return(!reader.Failed());
 }
 
-void RGBController::SetZoneColorDescription(unsigned char* data_buf)
+void RGBControllerHistogramAdd(RGBControllerHistogram& histogram, unsigned long long time_us)
 {
-    unsigned int data_ptr = sizeof(unsigned int);
-    unsigned int zone_idx;
-
-    /*---------------------------------------------------------*\
-    | Copy in zone index                                        |
-    \*---------------------------------------------------------*/
-    memcpy(&zone_idx, &data_buf[data_ptr], sizeof(zone_idx));
-    data_ptr += sizeof(zone_idx);
+    unsigned int       bucket_idx   = 0;
+    unsigned long long bucket_limit = RGBCONTROLLER_HISTOGRAM_BASE_US;
 
-    /*---------------------------------------------------------*\
-    | Check if we aren't reading beyond the list of zones.      |
-    \*---------------------------------------------------------*/
-    if(((size_t) zone_idx) > zones.size())
+    while((time_us >= bucket_limit) && (bucket_idx < (RGBCONTROLLER_HISTOGRAM_BUCKETS - 1)))
     {
-        return;
+        bucket_idx++;
+        bucket_limit *= 2;
     }
 
-    /*---------------------------------------------------------*\
-    | Copy in number of colors (data)                           |
-    \*---------------------------------------------------------*/
-    unsigned short num_colors;
-    memcpy(&num_colors, &data_buf[data_ptr], sizeof(unsigned short));
-    data_ptr += sizeof(unsigned short);
+    histogram.buckets[bucket_idx]++;
+    histogram.count++;
+    histogram.total_us += time_us;
 
-    /*---------------------------------------------------------*\
-    | Copy in colors                                            |
-    \*---------------------------------------------------------*/
-    for(int color_index = 0; color_index < num_colors; color_index++)
+    if(time_us > histogram.max_us)
     {
-        RGBColor new_color;
-
-        /*---------------------------------------------------------*\
-        | Copy in color (data)                                      |
-        \*---------------------------------------------------------*/
-        memcpy(&new_color, &data_buf[data_ptr], sizeof(RGBColor));
-        data_ptr += sizeof(RGBColor);
-
-        zones[zone_idx].colors[color_index] = new_color;
+        histogram.max_us = time_us;
     }
 }
 
-unsigned char * RGBController::GetSingleLEDColorDescription(int led)
+unsigned long long RGBControllerHistogramPercentile(const RGBControllerHistogram& histogram, float percentile)
 {
     /*---------------------------------------------------------*\
-    | Fixed size descrption:                                    |
-    |       int:      LED index                                 |
-    |       RGBColor: LED color                                 |
+    | Returns the upper limit of the bucket containing the      |
+    | percentile, capped at the maximum time seen               |
     \*---------------------------------------------------------*/
-    unsigned char *data_buf = new unsigned char[sizeof(int) + sizeof(RGBColor)];
+    unsigned long long target       = (unsigned long long)(histogram.count * percentile / 100.0f);
+    unsigned long long seen         = 0;
+    unsigned long long bucket_limit = RGBCONTROLLER_HISTOGRAM_BASE_US;
 
-    /*---------------------------------------------------------*\
-    | Copy in LED index                                         |
-    \*---------------------------------------------------------*/
-    memcpy(&data_buf[0], &led, sizeof(int));
+    for(unsigned int bucket_idx = 0; bucket_idx < RGBCONTROLLER_HISTOGRAM_BUCKETS; bucket_idx++)
+    {
+        seen += histogram.buckets[bucket_idx];
 
-    /*---------------------------------------------------------*\
-    | Copy in LED color                                         |
-    \*---------------------------------------------------------*/
-    memcpy(&data_buf[sizeof(led)], &colors[led], sizeof(RGBColor));
+        if((seen > target) || (seen == histogram.count))
+        {
+            break;
+        }
 
-    return(data_buf);
+        bucket_limit *= 2;
+    }
+
+    return(std::min(bucket_limit, histogram.max_us));
 }
 
-void RGBController::SetSingleLEDColorDescription(unsigned char* data_buf)
+std::string RGBControllerHistogramToString(const RGBControllerHistogram& histogram)
 {
-    /*---------------------------------------------------------*\
-    | Fixed size descrption:                                    |
-    |       int:      LED index                                 |
-    |       RGBColor: LED color                                 |
-    \*---------------------------------------------------------*/
-    int led_idx;
-
-    /*---------------------------------------------------------*\
-    | Copy in LED index                                         |
-    \*---------------------------------------------------------*/
-    memcpy(&led_idx, &data_buf[0], sizeof(led_idx));
+    char histogram_string[96];
 
-    /*---------------------------------------------------------*\
-    | Check if we aren't reading beyond the list of leds.       |
-    \*---------------------------------------------------------*/
-    if(((size_t) led_idx) > leds.size())
+    if(histogram.count == 0)
     {
-        return;
+        return("no frames");
     }
 
-    /*---------------------------------------------------------*\
-    | Copy in LED color                                         |
-    \*---------------------------------------------------------*/
-    memcpy(&colors[led_idx], &data_buf[sizeof(led_idx)], sizeof(RGBColor));
+    snprintf(histogram_string, sizeof(histogram_string), "avg %.2f ms, p95 %.2f ms, max %.2f ms",
+             (histogram.total_us / (double)histogram.count) / 1000.0,
+             RGBControllerHistogramPercentile(histogram, 95.0f) / 1000.0,
+             histogram.max_us / 1000.0);
+
+    return(histogram_string);
 }
 
-void RGBController::SetupColors()
+bool RGBController::FrameFindChanges(unsigned int flags)
 {
-    unsigned int total_led_count;
+    FrameDirtyZones.clear();
+    FrameDirtyLED = -1;
 
     /*---------------------------------------------------------*\
-    | Determine total number of LEDs on the device              |
+    | Without partial update support, after a mode change, if   |
+    | the last frame was not a snapshot, or if the LED count    |
+    | changed, send the full frame                              |
     \*---------------------------------------------------------*/
-    total_led_count = 0;
-
-    for(std::size_t zone_idx = 0; zone_idx < zones.size(); zone_idx++)
+    if((flags == 0) || FrameForceFull || !FrameActiveSnapshot || (FramePending.size() != FrameActive.size()))
     {
-        total_led_count += zones[zone_idx].leds_count;
+        return(false);
     }
 
-    /*---------------------------------------------------------*\
-    | Set the size of the color buffer to the number of LEDs    |
-    \*---------------------------------------------------------*/
-    colors.resize(total_led_count);
-
-    /*---------------------------------------------------------*\
-    | Set the color buffer pointers on each zone                |
-    \*---------------------------------------------------------*/
-    total_led_count = 0;
+    unsigned int changed_count  = 0;
+    int          changed_led    = -1;
 
     for(std::size_t zone_idx = 0; zone_idx < zones.size(); zone_idx++)
     {
-        zones[zone_idx].start_idx=total_led_count;
+        unsigned int start_idx  = zones[zone_idx].start_idx;
+        unsigned int end_idx    = start_idx + zones[zone_idx].leds_count;
+        bool         zone_dirty = false;
 
-        if((colors.size() > 0) && (zones[zone_idx].leds_count > 0))
-        {
-            zones[zone_idx].colors = &colors[total_led_count];
-        }
-        else
+        if(end_idx > FramePending.size())
         {
-            zones[zone_idx].colors = NULL;
+            return(false);
         }
 
-        if((leds.size() > 0) && (zones[zone_idx].leds_count > 0))
+        for(unsigned int led_idx = start_idx; led_idx < end_idx; led_idx++)
         {
-            zones[zone_idx].leds   = &leds[total_led_count];
+            if(FramePending[led_idx] != FrameActive[led_idx])
+            {
+                changed_count++;
+                changed_led = led_idx;
+                zone_dirty  = true;
+            }
         }
-        else
+
+        if(zone_dirty)
         {
-            zones[zone_idx].leds    = NULL;
+            FrameDirtyZones.push_back((int)zone_idx);
         }
+    }
 
-
-        total_led_count += zones[zone_idx].leds_count;
+    if(changed_count == 0)
+    {
+        return(false);
     }
-}
 
-RGBColor RGBController::GetLED(unsigned int led)
-{
-    if(led < colors.size())
+    if((changed_count == 1) && (flags & PARTIAL_UPDATE_SINGLE_LED))
     {
-        return(colors[led]);
+        FrameDirtyLED = changed_led;
+        return(true);
     }
-    else
+
+    if((flags & PARTIAL_UPDATE_ZONE) && (FrameDirtyZones.size() < zones.size()))
     {
-        return(0x00000000);
+        return(true);
     }
+
+    return(false);
 }
 
-void RGBController::SetLED(unsigned int led, RGBColor color)
+void RGBController::WaitForFrameSlot()
 {
-    if(led < colors.size())
+    if(FrameMaxFPS.load() == 0)
     {
-        colors[led] = color;
+        return;
     }
+
+    std::unique_lock<std::mutex> call_lock(DeviceCallMutex);
+
+    DeviceCallCV.wait_until(call_lock, FrameNextTime, [this]{ return(DeviceCallStopping.load()); });
 }
 
-void RGBController::SetAllLEDs(RGBColor color)
+std::chrono::steady_clock::time_point RGBController::GetFrameSlotTime()
 {
-    for(std::size_t zone_idx = 0; zone_idx < zones.size(); zone_idx++)
+    /*---------------------------------------------------------*\
+    | Returns the time a pending frame may be sent, or a zero   |
+    | time point if there is no frame waiting for its slot.     |
+    | Only valid between device calls, as the slot is moved by  |
+    | DeviceCallService().                                      |
+    \*---------------------------------------------------------*/
+    if((FrameMaxFPS.load() == 0) || (CallFlag_UpdateLEDs.load() == false) || DeviceCallStopping.load())
     {
-        SetAllZoneLEDs(zone_idx, color);
+        return(std::chrono::steady_clock::time_point());
     }
-}
 
-void RGBController::SetAllZoneLEDs(int zone, RGBColor color)
-{
-    for (std::size_t color_idx = 0; color_idx < zones[zone].leds_count; color_idx++)
+    if(std::chrono::steady_clock::now() >= FrameNextTime)
     {
-        zones[zone].colors[color_idx] = color;
+        return(std::chrono::steady_clock::time_point());
     }
-}
 
-int RGBController::GetMode()
-{
-    return(active_mode);
+    return(FrameNextTime);
 }
 
-void RGBController::SetMode(int mode)
+void RGBController::SetMaxFrameRate(unsigned int max_fps)
 {
-    active_mode = mode;
-
-    UpdateMode();
+    FrameMaxFPS = max_fps;
 }
 
-void RGBController::RegisterUpdateCallback(RGBControllerCallback new_callback, void * new_callback_arg)
+unsigned int RGBController::GetMaxFrameRate()
 {
-    UpdateCallbacks.push_back(new_callback);
-    UpdateCallbackArgs.push_back(new_callback_arg);
+    return(FrameMaxFPS.load());
 }
 
-void RGBController::UnregisterUpdateCallback(void * callback_arg)
+const std::vector<RGBColor>& RGBController::GetFrameColors()
 {
-    for(unsigned int callback_idx = 0; callback_idx < UpdateCallbackArgs.size(); callback_idx++ )
+    /*---------------------------------------------------------*\
+    | Inside the device call the snapshot taken by UpdateLEDs() |
+    | is returned.  The first call turns snapshots on, so until |
+    | the next frame the live color buffer is returned, as it   |
+    | is for direct calls from UpdateZoneLEDs() or              |
+    | UpdateSingleLED().                                        |
+    \*---------------------------------------------------------*/
+    if(FrameServiceThread == std::this_thread::get_id())
     {
-        if(UpdateCallbackArgs[callback_idx] == callback_arg)
-        {
-            UpdateCallbackArgs.erase(UpdateCallbackArgs.begin() + callback_idx);
-            UpdateCallbacks.erase(UpdateCallbacks.begin() + callback_idx);
+        FrameSnapshot = true;
 
-            break;
+        if(FrameActiveSnapshot)
+        {
+            return(FrameActive);
         }
     }
+
+    return(colors);
 }
 
-void RGBController::ClearCallbacks()
+unsigned long long RGBController::GetFramesSubmitted()
 {
-    UpdateCallbacks.clear();
-    UpdateCallbackArgs.clear();
+    return(FramesSubmitted.load());
 }
 
-void RGBController::SignalUpdate()
+unsigned long long RGBController::GetFramesCoalesced()
 {
-    UpdateMutex.lock();
+    return(FramesCoalesced.load());
+}
 
-    /*-------------------------------------------------*\
-    | Client info has changed, call the callbacks       |
-    \*-------------------------------------------------*/
-    for(unsigned int callback_idx = 0; callback_idx < UpdateCallbacks.size(); callback_idx++)
-    {
-        UpdateCallbacks[callback_idx](UpdateCallbackArgs[callback_idx]);
-    }
+unsigned long long RGBController::GetFramesSent()
+{
+    return(FramesSent.load());
+}
 
-    UpdateMutex.unlock();
+unsigned long long RGBController::GetFramesPartial()
+{
+    return(FramesPartial.load());
 }
-void RGBController::UpdateLEDs()
+
+void RGBController::SetPartialUpdateFlags(unsigned int flags)
 {
-    CallFlag_UpdateLEDs = true;
+    PartialUpdateFlags = flags;
 
-    SignalUpdate();
+    /*---------------------------------------------------------*\
+    | Changes are found by comparing snapshots, and the partial |
+    | paths send from the active snapshot                       |
+    \*---------------------------------------------------------*/
+    if(flags != 0)
+    {
+        FrameSnapshot = true;
+    }
 }
 
-void RGBController::UpdateMode()
+unsigned long long RGBController::GetIdleWakeupCount()
 {
-    CallFlag_UpdateMode = true;
+    return(DeviceCallIdleWakeups.load());
 }
 
-void RGBController::SaveMode()
+void RGBController::DeviceSaveMode()
 {
-    DeviceSaveMode();
+    /*-------------------------------------------------*\
+    | If not implemented by controller, does nothing    |
+    \*-------------------------------------------------*/
 }
 
-void RGBController::DeviceUpdateLEDs()
+void RGBController::DeferPopulate()
 {
-
+    Populated = false;
 }
 
-void RGBController::DeviceUpdateMode()
+bool RGBController::GetPopulated()
 {
-
+    return(Populated.load());
 }
 
-void RGBController::DeviceCallThreadFunction()
+void RGBController::Populate()
 {
-    CallFlag_UpdateLEDs = false;
-    CallFlag_UpdateMode = false;
-
-    while(DeviceThreadRunning.load() == true)
+    if(Populated.load())
     {
-        if(CallFlag_UpdateMode.load() == true)
-        {
-            DeviceUpdateMode();
-            CallFlag_UpdateMode = false;
-        }
-        if(CallFlag_UpdateLEDs.load() == true)
-        {
-            DeviceUpdateLEDs();
-            CallFlag_UpdateLEDs = false;
-        }
-        else
-        {
-           std::this_thread::sleep_for(1ms);
-        }
+        return;
     }
+
+    DevicePopulate();
+
+    /*---------------------------------------------------------*\
+    | Modes, zones and LEDs are new, so the cached description  |
+    | is out of date                                            |
+    \*---------------------------------------------------------*/
+    InvalidateDescription();
+
+    Populated = true;
+
+    SignalUpdate();
 }
 
-void RGBController::DeviceSaveMode()
+void RGBController::DevicePopulate()
 {
     /*-------------------------------------------------*\
     | If not implemented by controller, does nothing    |
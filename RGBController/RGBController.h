@@ -10,11 +10,17 @@
 #pragma once
 
 #include <atomic>
+#include <map>
+#include <memory>
 #include <vector>
 #include <string>
 #include <thread>
 #include <chrono>
 #include <mutex>
+#include <condition_variable>
+
+class RGBControllerBufferWriter;
+class RGBControllerBufferReader;
 
 /*------------------------------------------------------------------*\
 | RGB Color Type and Conversion Macros                               |
@@ -44,6 +50,17 @@ enum
     MODE_FLAG_AUTOMATIC_SAVE            = (1 << 9), /* Mode automatically saves         */
 };
 
+/*------------------------------------------------------------------*\
+| Partial Update Flags                                               |
+|   Set by a device implementation whose UpdateSingleLED() or        |
+|   UpdateZoneLEDs() is cheaper than a full DeviceUpdateLEDs()       |
+\*------------------------------------------------------------------*/
+enum
+{
+    PARTIAL_UPDATE_SINGLE_LED           = (1 << 0), /* Send one changed LED alone       */
+    PARTIAL_UPDATE_ZONE                 = (1 << 1), /* Send only the changed zones      */
+};
+
 /*------------------------------------------------------------------*\
 | Mode Directions                                                    |
 \*------------------------------------------------------------------*/
@@ -186,6 +203,59 @@ enum
 \*------------------------------------------------------------------*/
 typedef void (*RGBControllerCallback)(void *);
 
+typedef struct
+{
+    RGBControllerCallback   callback;
+    void *                  callback_arg;
+} RGBControllerCallbackEntry;
+
+typedef std::vector<RGBControllerCallbackEntry> RGBControllerCallbackList;
+
+/*------------------------------------------------------------------*\
+| Frame Timing Statistics                                            |
+|   Histogram bucket 0 counts times under 16us, and each following   |
+|   bucket doubles the range, so the last bucket counts times of     |
+|   about 262ms and up.  Times are in microseconds.                  |
+\*------------------------------------------------------------------*/
+#define RGBCONTROLLER_HISTOGRAM_BUCKETS     16
+#define RGBCONTROLLER_HISTOGRAM_BASE_US     16
+
+typedef struct
+{
+    unsigned long long      count;
+    unsigned long long      total_us;
+    unsigned long long      max_us;
+    unsigned long long      buckets[RGBCONTROLLER_HISTOGRAM_BUCKETS];
+} RGBControllerHistogram;
+
+typedef struct
+{
+    unsigned long long      frames_submitted;   /* UpdateLEDs() calls       */
+    unsigned long long      frames_sent;        /* Frames sent to device    */
+    unsigned long long      frames_dropped;     /* Frames coalesced away    */
+    unsigned long long      frames_partial;     /* Partial frames sent      */
+    float                   frame_rate;         /* Recent frames per second */
+    RGBControllerHistogram  update_latency;     /* Submit to send start     */
+    RGBControllerHistogram  transport_time;     /* Time spent sending       */
+} RGBControllerStats;
+
+void                RGBControllerHistogramAdd(RGBControllerHistogram& histogram, unsigned long long time_us);
+unsigned long long  RGBControllerHistogramPercentile(const RGBControllerHistogram& histogram, float percentile);
+std::string         RGBControllerHistogramToString(const RGBControllerHistogram& histogram);
+
+/*------------------------------------------------------------------*\
+| Cached Device Description                                          |
+|   The serialized description for one protocol version, up to but   |
+|   not including the colors                                         |
+\*------------------------------------------------------------------*/
+typedef struct
+{
+    bool                        valid = false;
+    unsigned int                generation = 0;
+    std::size_t                 active_mode_offset = 0;
+    std::vector<unsigned char>  data;
+} RGBControllerDescriptionCache;
+
 std::string device_type_to_str(device_type type);
 
 class RGBControllerInterface
@@ -297,6 +367,36 @@ public:
     unsigned char *         GetSingleLEDColorDescription(int led);
     void                    SetSingleLEDColorDescription(unsigned char* data_buf);
 
+    /*---------------------------------------------------------*\
+    | Serialize into a caller owned buffer that is reused from  |
+    | call to call, and deserialize from a sized buffer.  The   |
+    | readers bounds check every field and return false on a    |
+    | malformed description without modifying the controller.   |
+    \*---------------------------------------------------------*/
+    void                    WriteDeviceDescription(std::vector<unsigned char>& data_buf, unsigned int protocol_version);
+    bool                    ReadDeviceDescription(const unsigned char* data_buf, unsigned int data_size, unsigned int protocol_version);
+
+    void                    WriteModeDescription(std::vector<unsigned char>& data_buf, int mode, unsigned int protocol_version);
+    bool                    SetModeDescription(const unsigned char* data_buf, unsigned int data_size, unsigned int protocol_version);
+
+    void                    WriteColorDescription(std::vector<unsigned char>& data_buf);
+    bool                    SetColorDescription(const unsigned char* data_buf, unsigned int data_size);
+
+    void                    WriteZoneColorDescription(std::vector<unsigned char>& data_buf, int zone);
+    bool                    SetZoneColorDescription(const unsigned char* data_buf, unsigned int data_size);
+
+    void                    WriteSingleLEDColorDescription(std::vector<unsigned char>& data_buf, int led);
+    bool                    SetSingleLEDColorDescription(const unsigned char* data_buf, unsigned int data_size);
+
+    /*---------------------------------------------------------*\
+    | The serialized device description is cached until the    |
+    | generation changes.  SetupColors(), UpdateMode() and      |
+    | SaveMode() invalidate it; call InvalidateDescription()    |
+    | after changing names or other description fields.         |
+    \*---------------------------------------------------------*/
+    void                    InvalidateDescription();
+    unsigned int            GetDescriptionGeneration();
+
     void                    RegisterUpdateCallback(RGBControllerCallback new_callback, void * new_callback_arg);
     void                    UnregisterUpdateCallback(void * callback_arg);
     void                    ClearCallbacks();
@@ -310,6 +410,56 @@ public:
     void                    SaveMode();
 
     void                    DeviceCallThreadFunction();
+    void                    DeviceCallService();
+
+    void                    SetDispatchLane(std::string lane_name);
+
+    unsigned long long      GetIdleWakeupCount();
+
+    void                    SetMaxFrameRate(unsigned int max_fps);
+    unsigned int            GetMaxFrameRate();
+
+    std::chrono::steady_clock::time_point GetFrameSlotTime();
+
+    const std::vector<RGBColor>& GetFrameColors();
+
+    unsigned long long      GetFramesSubmitted();
+    unsigned long long      GetFramesCoalesced();
+    unsigned long long      GetFramesSent();
+    unsigned long long      GetFramesPartial();
+
+    void                    SetPartialUpdateFlags(unsigned int flags);
+
+    /*---------------------------------------------------------*\
+    | Time spent in update callbacks, in nanoseconds.  Divide   |
+    | the total by the count for the average per update.        |
+    \*---------------------------------------------------------*/
+    unsigned long long      GetSignalUpdateCount();
+    unsigned long long      GetSignalUpdateTime();
+    unsigned long long      GetSignalUpdateTimeMax();
+
+    /*---------------------------------------------------------*\
+    | Frame timing statistics for finding devices that fall    |
+    | behind.  The stats description is the SDK wire format.    |
+    \*---------------------------------------------------------*/
+    void                    GetStats(RGBControllerStats& stats);
+    void                    ResetStats();
+
+    void                    WriteStatsDescription(std::vector<unsigned char>& data_buf);
+    static bool             ReadStatsDescription(const unsigned char* data_buf, unsigned int data_size, RGBControllerStats& stats);
+
+    /*---------------------------------------------------------*\
+    | Deferred setup.  A controller that calls DeferPopulate()  |
+    | in its constructor is registered with only its identity   |
+    | (name, vendor, description, version, serial, location and |
+    | type) filled in.  Populate() then runs DevicePopulate()   |
+    | off the detection thread to read modes, zones and LEDs    |
+    | from the device.  LED and mode updates are ignored until  |
+    | the controller is populated.                              |
+    \*---------------------------------------------------------*/
+    void                    DeferPopulate();
+    bool                    GetPopulated();
+    void                    Populate();
 
     /*---------------------------------------------------------*\
     | Functions to be implemented in device implementation      |
@@ -327,16 +477,128 @@ public:
 
     virtual void            SetCustomMode()                             = 0;
 
+    virtual void            DevicePopulate();
+
 private:
     std::thread*            DeviceCallThread;
     std::atomic<bool>       CallFlag_UpdateLEDs;
     std::atomic<bool>       CallFlag_UpdateMode;
     std::atomic<bool>       DeviceThreadRunning;
+
+    /*---------------------------------------------------------*\
+    | The device call thread sleeps on this condition variable  |
+    | until UpdateLEDs() or UpdateMode() sets a call flag.  The |
+    | idle wakeup counter counts wakeups that found no work.    |
+    \*---------------------------------------------------------*/
+    std::mutex                          DeviceCallMutex;
+    std::condition_variable             DeviceCallCV;
+    std::atomic<unsigned long long>     DeviceCallIdleWakeups;
+
+    /*---------------------------------------------------------*\
+    | Controllers that opt into the shared dispatcher have no   |
+    | device call thread of their own.  Otherwise the thread is |
+    | started on the first UpdateLEDs() or UpdateMode() call.   |
+    \*---------------------------------------------------------*/
+    std::atomic<bool>                   DeviceCallDispatched;
+
+    std::atomic<bool>                   Populated;
+
+    void                                QueueDeviceCall();
+
+    /*---------------------------------------------------------*\
+    | Frame pipeline.  UpdateLEDs() marks a frame pending,      |
+    | replacing (coalescing) any frame that has not been sent   |
+    | yet.  Drivers that read their colors through              |
+    | GetFrameColors() also get a snapshot: UpdateLEDs() copies |
+    | the color buffer into the pending frame and the device    |
+    | call swaps it into the active frame.  Other drivers read  |
+    | the live color buffer and skip the copy.  A nonzero max   |
+    | frame rate delays the device call until the next frame    |
+    | slot.  The device call thread sleeps until the slot,      |
+    | while a dispatched controller is requeued by the          |
+    | dispatcher.                                               |
+    \*---------------------------------------------------------*/
+    std::mutex                              FrameMutex;
+    std::vector<RGBColor>                   FramePending;
+    std::vector<RGBColor>                   FrameActive;
+    bool                                    FrameIsPending;
+    std::atomic<bool>                       FrameSnapshot;
+    bool                                    FramePendingSnapshot;
+    bool                                    FrameActiveSnapshot;
+    std::atomic<std::thread::id>            FrameServiceThread;
+
+    std::atomic<unsigned int>               FrameMaxFPS;
+    std::chrono::steady_clock::time_point   FrameNextTime;
+    std::atomic<bool>                       DeviceCallStopping;
+
+    std::atomic<unsigned long long>         FramesSubmitted;
+    std::atomic<unsigned long long>         FramesCoalesced;
+    std::atomic<unsigned long long>         FramesSent;
+
+    void                                    WaitForFrameSlot();
+
+    /*---------------------------------------------------------*\
+    | Dirty tracking.  The pending frame is compared against    |
+    | the last sent frame and, if the device supports it, only  |
+    | the changed LED or zones are sent.  A frame with no       |
+    | changes is sent in full so keepalive updates still work.  |
+    \*---------------------------------------------------------*/
+    std::atomic<unsigned int>               PartialUpdateFlags;
+    std::atomic<unsigned long long>         FramesPartial;
+    std::vector<int>                        FrameDirtyZones;
+    int                                     FrameDirtyLED;
+    bool                                    FrameForceFull;
+
+    bool                                    FrameFindChanges(unsigned int flags);
+
+    /*---------------------------------------------------------*\
+    | Frame timing.  The pending time is when the pending frame |
+    | was first submitted, so coalesced frames count the time   |
+    | the device has been behind.  The frame interval is a      |
+    | moving average used for the frame rate.                   |
+    \*---------------------------------------------------------*/
+    std::mutex                              StatsMutex;
+    std::chrono::steady_clock::time_point   FramePendingTime;
+    std::chrono::steady_clock::time_point   StatsLastSendTime;
+    float                                   StatsFrameInterval;
+    RGBControllerHistogram                  StatsUpdateLatency;
+    RGBControllerHistogram                  StatsTransportTime;
+
+    void                                    RecordFrameStats(std::chrono::steady_clock::time_point pending_time, std::chrono::steady_clock::time_point send_time);
+
+    /*---------------------------------------------------------*\
+    | Serialized description cache, one entry per protocol      |
+    | version                                                   |
+    \*---------------------------------------------------------*/
+    std::mutex                                              DescriptionCacheMutex;
+    std::map<unsigned int, RGBControllerDescriptionCache>   DescriptionCache;
+    std::atomic<unsigned int>                               DescriptionGeneration;
+
+    void                                    WriteDeviceDescriptionHead(RGBControllerDescriptionCache& cache, unsigned int protocol_version);
+
+    static void                             WriteMode(RGBControllerBufferWriter& writer, const mode& mode_out, unsigned int protocol_version);
+    static bool                             ReadMode(RGBControllerBufferReader& reader, mode& mode_in, unsigned int protocol_version);
+
     //bool                    CallFlag_UpdateZoneLEDs                     = false;
     //bool                    CallFlag_UpdateSingleLED                    = false;
     //bool                    CallFlag_UpdateMode                         = false;
 
-    std::mutex                          UpdateMutex;
-    std::vector<RGBControllerCallback>  UpdateCallbacks;
-    std::vector<void *>                 UpdateCallbackArgs;
+    /*---------------------------------------------------------*\
+    | Update callbacks are kept in a copy-on-write list.        |
+    | SignalUpdate() takes a reference to the current list and  |
+    | calls it without locking, while registering or removing a |
+    | callback publishes a modified copy under UpdateMutex.     |
+    | Removing a callback waits on CallbackDoneCV until no      |
+    | other thread still holds the old list.                    |
+    \*---------------------------------------------------------*/
+    std::mutex                                      UpdateMutex;
+    std::shared_ptr<const RGBControllerCallbackList> UpdateCallbackList;
+    std::condition_variable                         CallbackDoneCV;
+    std::atomic<unsigned int>                       CallbackWaiters;
+
+    std::atomic<unsigned long long>                 SignalUpdateCount;
+    std::atomic<unsigned long long>                 SignalUpdateTime;
+    std::atomic<unsigned long long>                 SignalUpdateTimeMax;
+
+    void                                            WaitForCallbacks(std::shared_ptr<const RGBControllerCallbackList>& old_list);
 };
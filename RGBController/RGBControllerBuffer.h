@@ -0,0 +1,202 @@
+/*-----------------------------------------*\
+|  RGBControllerBuffer.h                    |
+|                                           |
+|  Bounds checked writer and reader used to |
+|  serialize RGBController descriptions     |
+|  into reusable buffers                    |
+\*-----------------------------------------*/
+
+#pragma once
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+/*---------------------------------------------------------*\
+| Appends fields to a caller owned byte vector.  The vector |
+| is cleared but keeps its capacity, so a buffer that is    |
+| reused for every frame stops allocating once it has grown |
+| to the largest packet size.                               |
+\*---------------------------------------------------------*/
+class RGBControllerBufferWriter
+{
+public:
+    RGBControllerBufferWriter(std::vector<unsigned char>& buffer) : buf(buffer)
+    {
+        buf.clear();
+    }
+
+    void Write(const void* data, std::size_t size)
+    {
+        std::size_t offset = buf.size();
+
+        buf.resize(offset + size);
+
+        if(size > 0)
+        {
+            memcpy(&buf[offset], data, size);
+        }
+    }
+
+    template<typename T>
+    void Write(const T& value)
+    {
+        Write(&value, sizeof(T));
+    }
+
+    /*-----------------------------------------------------*\
+    | Strings are written as a 16-bit length including the  |
+    | null terminator, followed by the terminated string    |
+    \*-----------------------------------------------------*/
+    void WriteString(const std::string& value)
+    {
+        unsigned short len = (unsigned short)(strlen(value.c_str()) + 1);
+
+        Write(len);
+        Write(value.c_str(), len);
+    }
+
+    /*-----------------------------------------------------*\
+    | Overwrite a field that was already written, such as   |
+    | the size prefix once the total size is known          |
+    \*-----------------------------------------------------*/
+    template<typename T>
+    void Patch(std::size_t offset, const T& value)
+    {
+        if(offset + sizeof(T) <= buf.size())
+        {
+            memcpy(&buf[offset], &value, sizeof(T));
+        }
+    }
+
+    unsigned char* GetData()
+    {
+        return(buf.data());
+    }
+
+    std::size_t GetSize()
+    {
+        return(buf.size());
+    }
+
+private:
+    std::vector<unsigned char>& buf;
+};
+
+/*---------------------------------------------------------*\
+| Reads fields from a sized buffer.  A read that would run  |
+| past the end fails, zero fills its output and marks the   |
+| reader as failed, so a parser can read a whole structure  |
+| and check Failed() once at the end.                       |
+\*---------------------------------------------------------*/
+class RGBControllerBufferReader
+{
+public:
+    RGBControllerBufferReader(const unsigned char* data, std::size_t size)
+    {
+        buf     = data;
+        buf_len = (data == NULL) ? 0 : size;
+        buf_ptr = 0;
+        failed  = false;
+    }
+
+    bool Read(void* data, std::size_t size)
+    {
+        if(failed || (size > Remaining()))
+        {
+            failed = true;
+            memset(data, 0, size);
+            return(false);
+        }
+
+        if(size > 0)
+        {
+            memcpy(data, &buf[buf_ptr], size);
+        }
+
+        buf_ptr += size;
+
+        return(true);
+    }
+
+    template<typename T>
+    bool Read(T& value)
+    {
+        return(Read(&value, sizeof(T)));
+    }
+
+    /*-----------------------------------------------------*\
+    | Reads a string written by WriteString.  The string    |
+    | ends at the first null within its length, or at the   |
+    | length if the terminator is missing.                  |
+    \*-----------------------------------------------------*/
+    bool ReadString(std::string& value)
+    {
+        unsigned short len;
+
+        if(!Read(len) || (len > Remaining()))
+        {
+            failed = true;
+            value.clear();
+            return(false);
+        }
+
+        const char* str     = (const char*)&buf[buf_ptr];
+        const void* str_end = memchr(str, 0, len);
+
+        value.assign(str, (str_end == NULL) ? len : (std::size_t)((const char*)str_end - str));
+
+        buf_ptr += len;
+
+        return(true);
+    }
+
+    bool Skip(std::size_t size)
+    {
+        if(failed || (size > Remaining()))
+        {
+            failed = true;
+            return(false);
+        }
+
+        buf_ptr += size;
+
+        return(true);
+    }
+
+    /*-----------------------------------------------------*\
+    | Check that count elements of the given size can still |
+    | be read before sizing containers from untrusted counts|
+    \*-----------------------------------------------------*/
+    bool CanRead(unsigned long long count, std::size_t size)
+    {
+        if(failed || (count * size > Remaining()))
+        {
+            failed = true;
+            return(false);
+        }
+
+        return(true);
+    }
+
+    bool Failed()
+    {
+        return(failed);
+    }
+
+    std::size_t Remaining()
+    {
+        return(buf_len - buf_ptr);
+    }
+
+    std::size_t GetPosition()
+    {
+        return(buf_ptr);
+    }
+
+private:
+    const unsigned char*    buf;
+    std::size_t             buf_len;
+    std::size_t             buf_ptr;
+    bool                    failed;
+};
@@ -0,0 +1,425 @@
+/*-----------------------------------------*\
+|  RGBControllerDispatcher.cpp              |
+|                                           |
+|  Shared worker pool that services device  |
+|  calls for RGBControllers, serialized per |
+|  physical transport (lane)                |
+\*-----------------------------------------*/
+
+#include "RGBControllerDispatcher.h"
+#include "RGBController.h"
+
+#define DISPATCHER_DEFAULT_THREADS  4
+
+RGBControllerDispatcher* RGBControllerDispatcher::instance;
+
+RGBControllerDispatcher *RGBControllerDispatcher::get()
+{
+    static std::mutex instance_mutex;
+
+    std::lock_guard<std::mutex> instance_lock(instance_mutex);
+
+    if(!instance)
+    {
+        instance = new RGBControllerDispatcher();
+    }
+
+    return instance;
+}
+
+RGBControllerDispatcher::RGBControllerDispatcher()
+{
+    unsigned int hw_threads = std::thread::hardware_concurrency();
+
+    thread_count    = DISPATCHER_DEFAULT_THREADS;
+    workers_running = false;
+
+    if((hw_threads > 0) && (hw_threads < thread_count))
+    {
+        thread_count = hw_threads;
+    }
+}
+
+void RGBControllerDispatcher::SetThreadCount(unsigned int new_thread_count)
+{
+    std::lock_guard<std::mutex> dispatch_lock(DispatchMutex);
+
+    /*-----------------------------------------------------*\
+    | The worker count can only be changed before the first |
+    | controller is registered                              |
+    \*-----------------------------------------------------*/
+    if(workers.empty() && (new_thread_count > 0))
+    {
+        thread_count = new_thread_count;
+    }
+}
+
+unsigned int RGBControllerDispatcher::GetThreadCount()
+{
+    std::lock_guard<std::mutex> dispatch_lock(DispatchMutex);
+
+    return((unsigned int)workers.size());
+}
+
+unsigned int RGBControllerDispatcher::GetLaneCount()
+{
+    std::lock_guard<std::mutex> dispatch_lock(DispatchMutex);
+
+    return((unsigned int)lanes.size());
+}
+
+std::string RGBControllerDispatcher::GetLaneForLocation(std::string location)
+{
+    /*-----------------------------------------------------*\
+    | SMBus controllers on the same bus share a lane, so    |
+    | strip the device address from I2C locations           |
+    \*-----------------------------------------------------*/
+    if(location.compare(0, 4, "I2C:") == 0)
+    {
+        std::size_t address_pos = location.rfind(", address ");
+
+        if(address_pos != std::string::npos)
+        {
+            location = location.substr(0, address_pos);
+        }
+    }
+
+    return(location);
+}
+
+void RGBControllerDispatcher::StartWorkers()
+{
+    workers_running = true;
+
+    for(unsigned int worker_idx = 0; worker_idx < thread_count; worker_idx++)
+    {
+        workers.push_back(new std::thread(&RGBControllerDispatcher::WorkerThreadFunction, this));
+    }
+}
+
+void RGBControllerDispatcher::Shutdown()
+{
+    /*-----------------------------------------------------*\
+    | Stop the workers once their current device call has  |
+    | returned.  Work still pending is dropped, and the     |
+    | workers are started again by the next Register.       |
+    \*-----------------------------------------------------*/
+    std::vector<std::thread *> stopped_workers;
+
+    DispatchMutex.lock();
+
+    workers_running = false;
+    stopped_workers.swap(workers);
+
+    DispatchMutex.unlock();
+
+    WorkCV.notify_all();
+
+    for(std::size_t worker_idx = 0; worker_idx < stopped_workers.size(); worker_idx++)
+    {
+        stopped_workers[worker_idx]->join();
+        delete stopped_workers[worker_idx];
+    }
+}
+
+void RGBControllerDispatcher::Register(RGBController * controller, std::string lane_name)
+{
+    std::lock_guard<std::mutex> dispatch_lock(DispatchMutex);
+
+    if(entries.find(controller) != entries.end())
+    {
+        return;
+    }
+
+    if(workers.empty())
+    {
+        StartWorkers();
+    }
+
+    /*-----------------------------------------------------*\
+    | Find or create the lane for this transport            |
+    \*-----------------------------------------------------*/
+    RGBControllerDispatchLane * lane;
+
+    std::map<std::string, RGBControllerDispatchLane *>::iterator lane_it = lanes.find(lane_name);
+
+    if(lane_it == lanes.end())
+    {
+        lane                    = new RGBControllerDispatchLane();
+        lane->name              = lane_name;
+        lane->controller_count  = 0;
+        lane->ready             = false;
+        lane->active            = false;
+
+        lanes[lane_name]        = lane;
+    }
+    else
+    {
+        lane = lane_it->second;
+    }
+
+    lane->controller_count++;
+
+    RGBControllerDispatchEntry entry;
+
+    entry.lane              = lane;
+    entry.queued            = false;
+    entry.running           = false;
+    entry.deferred          = false;
+    entry.unregistering     = false;
+
+    entries[controller]     = entry;
+}
+
+void RGBControllerDispatcher::Unregister(RGBController * controller)
+{
+    std::unique_lock<std::mutex> dispatch_lock(DispatchMutex);
+
+    std::map<RGBController *, RGBControllerDispatchEntry>::iterator entry_it = entries.find(controller);
+
+    if(entry_it == entries.end())
+    {
+        return;
+    }
+
+    RGBControllerDispatchLane * lane = entry_it->second.lane;
+
+    entry_it->second.unregistering = true;
+
+    /*-----------------------------------------------------*\
+    | Drop any pending work for this controller             |
+    \*-----------------------------------------------------*/
+    for(std::size_t pending_idx = 0; pending_idx < lane->pending.size(); pending_idx++)
+    {
+        if(lane->pending[pending_idx] == controller)
+        {
+            lane->pending.erase(lane->pending.begin() + pending_idx);
+            break;
+        }
+    }
+
+    entry_it->second.queued = false;
+
+    /*-----------------------------------------------------*\
+    | Wait for a worker currently servicing the controller  |
+    \*-----------------------------------------------------*/
+    IdleCV.wait(dispatch_lock, [entry_it]{ return(entry_it->second.running == false); });
+
+    /*-----------------------------------------------------*\
+    | Drop the deferred entry only now, as it may have been |
+    | added by the call that was just waited for            |
+    \*-----------------------------------------------------*/
+    if(entry_it->second.deferred)
+    {
+        for(std::multimap<std::chrono::steady_clock::time_point, RGBController *>::iterator deferred_it = deferred.begin(); deferred_it != deferred.end(); deferred_it++)
+        {
+            if(deferred_it->second == controller)
+            {
+                deferred.erase(deferred_it);
+                break;
+            }
+        }
+    }
+
+    entries.erase(entry_it);
+
+    lane->controller_count--;
+
+    /*-----------------------------------------------------*\
+    | Remove the lane once it is empty and no worker holds  |
+    | a reference to it                                     |
+    \*-----------------------------------------------------*/
+    if((lane->controller_count == 0) && (lane->ready == false) && (lane->active == false))
+    {
+        lanes.erase(lane->name);
+        delete lane;
+    }
+}
+
+void RGBControllerDispatcher::Schedule(RGBController * controller)
+{
+    std::unique_lock<std::mutex> dispatch_lock(DispatchMutex);
+
+    std::map<RGBController *, RGBControllerDispatchEntry>::iterator entry_it = entries.find(controller);
+
+    /*-----------------------------------------------------*\
+    | A deferred controller is queued again at its frame    |
+    | slot, which picks up the new call as well             |
+    \*-----------------------------------------------------*/
+    if((entry_it == entries.end())
+    || (entry_it->second.queued == true)
+    || (entry_it->second.deferred == true)
+    || (entry_it->second.unregistering == true))
+    {
+        return;
+    }
+
+    QueueController(controller, entry_it->second);
+
+    dispatch_lock.unlock();
+
+    WorkCV.notify_one();
+}
+
+void RGBControllerDispatcher::QueueController(RGBController * controller, RGBControllerDispatchEntry & entry)
+{
+    RGBControllerDispatchLane * lane = entry.lane;
+
+    entry.queued = true;
+    lane->pending.push_back(controller);
+
+    /*-----------------------------------------------------*\
+    | A lane is put on the ready queue when it has pending  |
+    | work and is not already being serviced                |
+    \*-----------------------------------------------------*/
+    if((lane->ready == false) && (lane->active == false))
+    {
+        lane->ready = true;
+        ready_lanes.push_back(lane);
+    }
+}
+
+void RGBControllerDispatcher::ReleaseDeferred()
+{
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+
+    while(!deferred.empty() && (deferred.begin()->first <= now))
+    {
+        RGBController * controller = deferred.begin()->second;
+
+        deferred.erase(deferred.begin());
+
+        std::map<RGBController *, RGBControllerDispatchEntry>::iterator entry_it = entries.find(controller);
+
+        if(entry_it == entries.end())
+        {
+            continue;
+        }
+
+        entry_it->second.deferred = false;
+
+        if((entry_it->second.queued == false) && (entry_it->second.unregistering == false))
+        {
+            QueueController(controller, entry_it->second);
+        }
+    }
+}
+
+void RGBControllerDispatcher::WorkerThreadFunction()
+{
+    std::unique_lock<std::mutex> dispatch_lock(DispatchMutex);
+
+    while(1)
+    {
+        ReleaseDeferred();
+
+        if(!workers_running)
+        {
+            break;
+        }
+
+        /*-------------------------------------------------*\
+        | With nothing ready, sleep until new work arrives  |
+        | or the earliest deferred controller is due        |
+        \*-------------------------------------------------*/
+        if(ready_lanes.empty())
+        {
+            if(deferred.empty())
+            {
+                WorkCV.wait(dispatch_lock);
+            }
+            else
+            {
+                /*-----------------------------------------*\
+                | Copy the time, as the entry may be erased |
+                | while this worker waits                   |
+                \*-----------------------------------------*/
+                std::chrono::steady_clock::time_point wake_time = deferred.begin()->first;
+
+                WorkCV.wait_until(dispatch_lock, wake_time);
+            }
+
+            continue;
+        }
+
+        /*-------------------------------------------------*\
+        | Take the next ready lane and its first pending    |
+        | controller                                        |
+        \*-------------------------------------------------*/
+        RGBControllerDispatchLane * lane = ready_lanes.front();
+        ready_lanes.pop_front();
+
+        lane->ready = false;
+
+        if(lane->pending.empty())
+        {
+            if(lane->controller_count == 0)
+            {
+                lanes.erase(lane->name);
+                delete lane;
+            }
+
+            continue;
+        }
+
+        RGBController * controller = lane->pending.front();
+        lane->pending.pop_front();
+
+        /*-------------------------------------------------*\
+        | Pending controllers are registered, and the entry |
+        | is kept until running is cleared below            |
+        \*-------------------------------------------------*/
+        std::map<RGBController *, RGBControllerDispatchEntry>::iterator entry_it = entries.find(controller);
+
+        entry_it->second.queued  = false;
+        entry_it->second.running = true;
+        lane->active             = true;
+
+        dispatch_lock.unlock();
+
+        controller->DeviceCallService();
+
+        dispatch_lock.lock();
+
+        entry_it->second.running = false;
+        lane->active             = false;
+
+        /*-------------------------------------------------*\
+        | A controller left waiting for its frame slot is   |
+        | deferred so the lane can service the others, and  |
+        | an idle worker is woken to wait for the slot.  A  |
+        | controller being unregistered is left alone.      |
+        \*-------------------------------------------------*/
+        if((entry_it->second.queued == false) && (entry_it->second.unregistering == false))
+        {
+            std::chrono::steady_clock::time_point slot_time = controller->GetFrameSlotTime();
+
+            if(slot_time.time_since_epoch().count() != 0)
+            {
+                entry_it->second.deferred = true;
+                deferred.insert(std::make_pair(slot_time, controller));
+
+                WorkCV.notify_one();
+            }
+        }
+
+        /*-------------------------------------------------*\
+        | Requeue the lane at the back of the ready queue   |
+        | so busy lanes cannot starve the others            |
+        \*-------------------------------------------------*/
+        if(!lane->pending.empty())
+        {
+            lane->ready = true;
+            ready_lanes.push_back(lane);
+
+            WorkCV.notify_one();
+        }
+        else if(lane->controller_count == 0)
+        {
+            lanes.erase(lane->name);
+            delete lane;
+        }
+
+        IdleCV.notify_all();
+    }
+}
@@ -0,0 +1,90 @@
+/*-----------------------------------------*\
+|  RGBControllerDispatcher.h                |
+|                                           |
+|  Shared worker pool that services device  |
+|  calls for RGBControllers, serialized per |
+|  physical transport (lane)                |
+\*-----------------------------------------*/
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+class RGBController;
+
+/*---------------------------------------------------------*\
+| A lane is a serial queue for one physical transport, such |
+| as one HID path, one SMBus bus or one serial port.  Only  |
+| one controller on a lane is serviced at a time, while     |
+| different lanes are serviced in parallel by the workers.  |
+\*---------------------------------------------------------*/
+struct RGBControllerDispatchLane
+{
+    std::string                         name;
+    std::deque<RGBController *>         pending;
+    unsigned int                        controller_count;
+    bool                                ready;
+    bool                                active;
+};
+
+/*---------------------------------------------------------*\
+| A controller waiting for its frame slot is deferred, off  |
+| its lane, until the slot time and then queued again.  A   |
+| controller being unregistered is never queued or deferred |
+\*---------------------------------------------------------*/
+struct RGBControllerDispatchEntry
+{
+    RGBControllerDispatchLane *         lane;
+    bool                                queued;
+    bool                                running;
+    bool                                deferred;
+    bool                                unregistering;
+};
+
+class RGBControllerDispatcher
+{
+public:
+    static RGBControllerDispatcher *    get();
+
+    void                                SetThreadCount(unsigned int new_thread_count);
+    unsigned int                        GetThreadCount();
+    unsigned int                        GetLaneCount();
+
+    void                                Register(RGBController * controller, std::string lane_name);
+    void                                Unregister(RGBController * controller);
+    void                                Schedule(RGBController * controller);
+
+    void                                Shutdown();
+
+    static std::string                  GetLaneForLocation(std::string location);
+
+private:
+    RGBControllerDispatcher();
+
+    void                                StartWorkers();
+    void                                WorkerThreadFunction();
+    void                                QueueController(RGBController * controller, RGBControllerDispatchEntry & entry);
+    void                                ReleaseDeferred();
+
+    static RGBControllerDispatcher *    instance;
+
+    std::mutex                                                  DispatchMutex;
+    std::condition_variable                                     WorkCV;
+    std::condition_variable                                     IdleCV;
+
+    unsigned int                                                thread_count;
+    bool                                                        workers_running;
+    std::vector<std::thread *>                                  workers;
+
+    std::map<std::string, RGBControllerDispatchLane *>          lanes;
+    std::map<RGBController *, RGBControllerDispatchEntry>       entries;
+    std::deque<RGBControllerDispatchLane *>                     ready_lanes;
+    std::multimap<std::chrono::steady_clock::time_point, RGBController *> deferred;
+};
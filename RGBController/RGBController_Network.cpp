@@ -6,14 +6,31 @@
 |  Adam Honse (CalcProgrammer1) 4/11/2020   |
 \*-----------------------------------------*/
 
-#include <cstring>
-
 #include "RGBController_Network.h"
 
 RGBController_Network::RGBController_Network(NetworkClient * client_ptr, unsigned int dev_idx_val)
 {
-    client  = client_ptr;
-    dev_idx = dev_idx_val;
+    client          = client_ptr;
+    dev_idx         = dev_idx_val;
+}
+
+/*---------------------------------------------------------*\
+| Moves the controller to another server index after a      |
+| device list change.  The server keeps delta state by      |
+| index, so the next frame is sent as a keyframe.           |
+\*---------------------------------------------------------*/
+void RGBController_Network::SetDeviceIndex(unsigned int dev_idx_val)
+{
+    data_buf_mutex.lock();
+
+    if(dev_idx != dev_idx_val)
+    {
+        dev_idx = dev_idx_val;
+
+        delta_encoder.Reset();
+    }
+
+    data_buf_mutex.unlock();
 }
 
 void RGBController_Network::SetupZones()
@@ -28,67 +45,94 @@ void RGBController_Network::ResizeZone(int zone, int new_size)
 
 void RGBController_Network::DeviceUpdateLEDs()
 {
-    unsigned char * data = GetColorDescription();
-    unsigned int size;
-
-    memcpy(&size, &data[0], sizeof(unsigned int));
-
-    client->SendRequest_RGBController_UpdateLEDs(dev_idx, data, size);
-
-    delete[] data;
+    data_buf_mutex.lock();
+
+    /*-----------------------------------------------------*\
+    | Frames go over the UDP channel when it is open, and   |
+    | over TCP if that fails                                |
+    \*-----------------------------------------------------*/
+    bool sent = false;
+
+    if(client->GetUDPChannel())
+    {
+        WriteColorDescription(data_buf);
+
+        sent = client->SendRequest_RGBController_UDPUpdateLEDs(dev_idx, data_buf.data(), (unsigned int)data_buf.size());
+    }
+
+    if(!sent && (client->GetProtocolVersion() >= 6))
+    {
+        delta_encoder.Encode(data_buf, colors);
+
+        if(!client->SendRequest_RGBController_DeltaUpdateLEDs(dev_idx, data_buf.data(), (unsigned int)data_buf.size()))
+        {
+            delta_encoder.Reset();
+        }
+    }
+    else if(!sent)
+    {
+        WriteColorDescription(data_buf);
+
+        client->SendRequest_RGBController_UpdateLEDs(dev_idx, data_buf.data(), (unsigned int)data_buf.size());
+    }
+
+    data_buf_mutex.unlock();
 }
 
 void RGBController_Network::UpdateZoneLEDs(int zone)
 {
-    unsigned char * data = GetZoneColorDescription(zone);
-    unsigned int size;
+    data_buf_mutex.lock();
 
-    memcpy(&size, &data[0], sizeof(unsigned int));
+    WriteZoneColorDescription(data_buf, zone);
 
-    client->SendRequest_RGBController_UpdateZoneLEDs(dev_idx, data, size);
+    client->SendRequest_RGBController_UpdateZoneLEDs(dev_idx, data_buf.data(), (unsigned int)data_buf.size());
 
-    delete[] data;
+    data_buf_mutex.unlock();
 }
 
 void RGBController_Network::UpdateSingleLED(int led)
 {
-    unsigned char * data = GetSingleLEDColorDescription(led);
+    data_buf_mutex.lock();
 
-    client->SendRequest_RGBController_UpdateSingleLED(dev_idx, data, sizeof(int) + sizeof(RGBColor));
+    WriteSingleLEDColorDescription(data_buf, led);
 
-    delete[] data;
+    client->SendRequest_RGBController_UpdateSingleLED(dev_idx, data_buf.data(), (unsigned int)data_buf.size());
+
+    data_buf_mutex.unlock();
 }
 
 void RGBController_Network::SetCustomMode()
 {
+    client->StartBatch();
     client->SendRequest_RGBController_SetCustomMode(dev_idx);
 
-    client->SendRequest_ControllerData(dev_idx);
-    client->WaitOnControllerData();
+    unsigned int request_id = client->SendRequest_ControllerData(dev_idx);
+
+    client->FinishBatch();
+
+    client->WaitOnRequest(request_id, 1000);
 }
 
 void RGBController_Network::DeviceUpdateMode()
 {
-    unsigned char * data = GetModeDescription(active_mode, client->GetProtocolVersion());
-    unsigned int size;
+    data_buf_mutex.lock();
 
-    memcpy(&size, &data[0], sizeof(unsigned int));
+    WriteModeDescription(data_buf, active_mode, client->GetProtocolVersion());
 
-    client->SendRequest_RGBController_UpdateMode(dev_idx, data, size);
+    client->SendRequest_RGBController_UpdateMode(dev_idx, data_buf.data(), (unsigned int)data_buf.size());
 
-    delete[] data;
+    data_buf_mutex.unlock();
 }
 
 void RGBController_Network::DeviceSaveMode()
 {
-    unsigned char * data = GetModeDescription(active_mode, client->GetProtocolVersion());
-    unsigned int size;
+    data_buf_mutex.lock();
 
-    memcpy(&size, &data[0], sizeof(unsigned int));
+    WriteModeDescription(data_buf, active_mode, client->GetProtocolVersion());
 
-    client->SendRequest_RGBController_SaveMode(dev_idx, data, size);
+    client->SendRequest_RGBController_SaveMode(dev_idx, data_buf.data(), (unsigned int)data_buf.size());
 
-    delete[] data;
+    data_buf_mutex.unlock();
 }
 
 /*-----------------------------------------------------*\
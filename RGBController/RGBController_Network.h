@@ -10,12 +10,15 @@
 
 #include "RGBController.h"
 #include "NetworkClient.h"
+#include "NetworkColorDelta.h"
 
 class RGBController_Network : public RGBController
 {
 public:
     RGBController_Network(NetworkClient * client_ptr, unsigned int dev_idx_val);
 
+    void        SetDeviceIndex(unsigned int dev_idx_val);
+
     void        SetupZones();
 
     void        ResizeZone(int zone, int new_size);
@@ -31,6 +34,20 @@ public:
     void        UpdateLEDs();
 
 private:
-    NetworkClient *     client;
-    unsigned int        dev_idx;
+    NetworkClient *             client;
+    std::atomic<unsigned int>   dev_idx;
+
+    /*---------------------------------------------------------*\
+    | Request buffer reused for every update so that sending    |
+    | frames does not allocate once it has grown.  Updates can  |
+    | come from several threads, so the buffer is locked.       |
+    \*---------------------------------------------------------*/
+    std::mutex                  data_buf_mutex;
+    std::vector<unsigned char>  data_buf;
+
+    /*---------------------------------------------------------*\
+    | Servers with protocol 6 get LED updates as deltas from    |
+    | the previous frame, protected by data_buf_mutex           |
+    \*---------------------------------------------------------*/
+    NetworkColorDeltaEncoder    delta_encoder;
 };
@@ -12,7 +12,11 @@
 #include "ResourceManager.h"
 #include "ProfileManager.h"
 #include "LogManager.h"
+#include "RGBControllerDispatcher.h"
+#include "dependencies/dmiinfo.h"
 #include "filesystem.h"
+#include "find_usb_serial_port.h"
+#include "pci_ids.h"
 
 #include <stdlib.h>
 #include <string>
@@ -20,6 +24,13 @@
 
 ResourceManager* ResourceManager::instance;
 
+/*---------------------------------------------------------*\
+| The detection job running on this thread, if any.         |
+| Controllers registered from a detector are collected in   |
+| the job instead of being added to the list directly.      |
+\*---------------------------------------------------------*/
+static thread_local DetectionJob* current_detection_job = NULL;
+
 using namespace std::chrono_literals;
 
 ResourceManager *ResourceManager::get()
@@ -41,6 +52,11 @@ ResourceManager::ResourceManager()
     detection_percent           = 100;
     detection_string            = "";
     detection_is_required       = false;
+    detection_next_group        = 0;
+    detection_cache_used        = false;
+    hotplug_monitor             = nullptr;
+    populate_idle_threads       = 0;
+    populate_stopping           = false;
     DetectDevicesThread         = nullptr;
     dynamic_detectors_processed = false;
 
@@ -100,6 +116,16 @@ ResourceManager::ResourceManager()
             client->SetName(titleString.c_str());
             client->SetPort(client_port);
 
+            if(client_settings["clients"][client_idx].contains("udp_channel"))
+            {
+                client->SetUDPChannel(client_settings["clients"][client_idx]["udp_channel"]);
+            }
+
+            if(client_settings["clients"][client_idx].contains("color_subscription_rate"))
+            {
+                client->SetColorSubscription(client_settings["clients"][client_idx]["color_subscription_rate"]);
+            }
+
             client->StartClient();
 
             for(int timeout = 0; timeout < 100; timeout++)
@@ -125,7 +151,18 @@ ResourceManager::ResourceManager()
 
 ResourceManager::~ResourceManager()
 {
+#ifdef __linux__
+    if(hotplug_monitor != nullptr)
+    {
+        hotplug_monitor->Stop();
+        delete hotplug_monitor;
+        hotplug_monitor = nullptr;
+    }
+#endif
+
     Cleanup();
+
+    RGBControllerDispatcher::get()->Shutdown();
 }
 
 void ResourceManager::RegisterI2CBus(i2c_smbus_interface *bus)
@@ -142,20 +179,96 @@ std::vector<i2c_smbus_interface*> & ResourceManager::GetI2CBusses()
 void ResourceManager::RegisterRGBController(RGBController *rgb_controller)
 {
     LOG_INFO("[%s] Registering RGB controller", rgb_controller->name.c_str());
-    rgb_controllers_hw.push_back(rgb_controller);
+
+    /*-------------------------------------------------------------------------*\
+    | Controllers registered by a running detection job are added once all      |
+    | earlier jobs have finished                                                |
+    \*-------------------------------------------------------------------------*/
+    if(current_detection_job != NULL)
+    {
+        current_detection_job->registered.push_back(rgb_controller);
+        return;
+    }
+
+    AddRGBController(rgb_controller);
 
     UpdateDeviceList();
 }
 
+void ResourceManager::AddRGBController(RGBController *rgb_controller)
+{
+    /*-------------------------------------------------------------------------*\
+    | If enabled, service device calls from the shared dispatcher instead of a  |
+    | thread per controller.  Controllers on the same transport share a lane    |
+    \*-------------------------------------------------------------------------*/
+    json dispatcher_settings = settings_manager->GetSettings("DeviceDispatcher");
+    bool dispatcher_enabled  = false;
+
+    if(dispatcher_settings.contains("enabled"))
+    {
+        dispatcher_enabled   = dispatcher_settings["enabled"];
+    }
+
+    if(dispatcher_enabled && !rgb_controller->location.empty())
+    {
+        if(dispatcher_settings.contains("threads"))
+        {
+            RGBControllerDispatcher::get()->SetThreadCount(dispatcher_settings["threads"]);
+        }
+
+        rgb_controller->SetDispatchLane(RGBControllerDispatcher::GetLaneForLocation(rgb_controller->location));
+    }
+
+    /*-------------------------------------------------------------------------*\
+    | Apply the maximum frame rate.  A per-device value keyed by location       |
+    | overrides the global value, and 0 means unlimited                         |
+    \*-------------------------------------------------------------------------*/
+    json frame_rate_settings = settings_manager->GetSettings("FrameRate");
+    unsigned int max_fps     = 0;
+
+    if(frame_rate_settings.contains("max_fps"))
+    {
+        max_fps              = frame_rate_settings["max_fps"];
+    }
+
+    if(frame_rate_settings.contains("devices") && frame_rate_settings["devices"].contains(rgb_controller->location))
+    {
+        max_fps              = frame_rate_settings["devices"][rgb_controller->location];
+    }
+
+    rgb_controller->SetMaxFrameRate(max_fps);
+
+    DeviceListChangeMutex.lock();
+    rgb_controllers_hw.push_back(rgb_controller);
+    DeviceListChangeMutex.unlock();
+}
+
 void ResourceManager::UnregisterRGBController(RGBController* rgb_controller)
 {
     LOG_INFO("[%s] Unregistering RGB controller", rgb_controller->name.c_str());
 
+    RemoveRGBController(rgb_controller);
+
+    /*-------------------------------------------------------------------------*\
+    | The caller may delete the controller once this returns                    |
+    \*-------------------------------------------------------------------------*/
+    server->ControllerRemoved(rgb_controller);
+}
+
+/*---------------------------------------------------------*\
+| Takes a controller out of the lists.  The SDK server may  |
+| still be using it until server->ControllerRemoved() has   |
+| returned.                                                 |
+\*---------------------------------------------------------*/
+void ResourceManager::RemoveRGBController(RGBController* rgb_controller)
+{
     /*-------------------------------------------------------------------------*\
     | Clear callbacks from the controller before removal                        |
     \*-------------------------------------------------------------------------*/
     rgb_controller->ClearCallbacks();
 
+    DeviceListChangeMutex.lock();
+
     /*-------------------------------------------------------------------------*\
     | Find the controller to remove and remove it from the hardware list        |
     \*-------------------------------------------------------------------------*/
@@ -176,6 +289,14 @@ void ResourceManager::UnregisterRGBController(RGBController* rgb_controller)
         rgb_controllers.erase(rgb_it);
     }
 
+    DeviceListChangeMutex.unlock();
+
+    /*-------------------------------------------------------------------------*\
+    | Make sure the controller is not being populated, the caller may delete it |
+    | Once it is out of the hardware list it can not be queued again            |
+    \*-------------------------------------------------------------------------*/
+    CancelPopulate(rgb_controller);
+
     UpdateDeviceList();
 }
 
@@ -216,6 +337,23 @@ void ResourceManager::RegisterDeviceDetector(std::string name, DeviceDetectorFun
     device_detectors.push_back(detector);
 }
 
+/*---------------------------------------------------------*\
+| Serial detectors run with the other detectors, and again  |
+| when a serial port with their USB VID/PID is added        |
+\*---------------------------------------------------------*/
+void ResourceManager::RegisterSerialDeviceDetector(std::string name, DeviceDetectorFunction detector, uint16_t vid, uint16_t pid)
+{
+    SerialDeviceDetectorBlock block;
+
+    block.name          = name;
+    block.function      = detector;
+    block.address       = (vid << 16) | pid;
+
+    serial_device_detectors.push_back(block);
+
+    RegisterDeviceDetector(name, detector);
+}
+
 void ResourceManager::RegisterHIDDeviceDetector(std::string name,
                                HIDDeviceDetectorFunction  detector,
                                uint16_t vid,
@@ -233,6 +371,12 @@ void ResourceManager::RegisterHIDDeviceDetector(std::string name,
     block.usage_page    = usage_page;
     block.usage         = usage;
 
+    /*-------------------------------------------------------------------------*\
+    | Index the detector by VID/PID so each enumerated device is only matched   |
+    | against the detectors registered for it                                   |
+    \*-------------------------------------------------------------------------*/
+    hid_device_detector_index[block.address].push_back((unsigned int)hid_device_detectors.size());
+
     hid_device_detectors.push_back(block);
 }
 
@@ -350,18 +494,29 @@ void ResourceManager::UpdateDeviceList()
     DeviceListChangeMutex.lock();
 
     /*-------------------------------------------------*\
-    | Insert hardware controllers into controller list  |
+    | Insert hardware controllers into controller list. |
+    | Controllers that are not populated yet are left   |
+    | out until Populate() has filled in their modes,   |
+    | zones and LEDs.                                   |
     \*-------------------------------------------------*/
+    unsigned int list_idx = 0;
+
     for(unsigned int hw_controller_idx = 0; hw_controller_idx < rgb_controllers_hw.size(); hw_controller_idx++)
     {
+        if(!rgb_controllers_hw[hw_controller_idx]->GetPopulated())
+        {
+            continue;
+        }
+
         /*-------------------------------------------------*\
         | Check if the controller is already in the list    |
         | at the correct index                              |
         \*-------------------------------------------------*/
-        if(hw_controller_idx < rgb_controllers.size())
+        if(list_idx < rgb_controllers.size())
         {
-            if(rgb_controllers[hw_controller_idx] == rgb_controllers_hw[hw_controller_idx])
+            if(rgb_controllers[list_idx] == rgb_controllers_hw[hw_controller_idx])
             {
+                list_idx++;
                 continue;
             }
         }
@@ -370,12 +525,15 @@ void ResourceManager::UpdateDeviceList()
         | If not, check if the controller is already in the |
         | list at a different index                         |
         \*-------------------------------------------------*/
+        bool found = false;
+
         for(unsigned int controller_idx = 0; controller_idx < rgb_controllers.size(); controller_idx++)
         {
             if(rgb_controllers[controller_idx] == rgb_controllers_hw[hw_controller_idx])
             {
                 rgb_controllers.erase(rgb_controllers.begin() + controller_idx);
-                rgb_controllers.insert(rgb_controllers.begin() + hw_controller_idx, rgb_controllers_hw[hw_controller_idx]);
+                rgb_controllers.insert(rgb_controllers.begin() + list_idx, rgb_controllers_hw[hw_controller_idx]);
+                found = true;
                 break;
             }
         }
@@ -383,7 +541,24 @@ void ResourceManager::UpdateDeviceList()
         /*-------------------------------------------------*\
         | If it still hasn't been found, add it to the list |
         \*-------------------------------------------------*/
-        rgb_controllers.insert(rgb_controllers.begin() + hw_controller_idx, rgb_controllers_hw[hw_controller_idx]);
+        if(!found)
+        {
+            rgb_controllers.insert(rgb_controllers.begin() + list_idx, rgb_controllers_hw[hw_controller_idx]);
+        }
+
+        list_idx++;
+    }
+
+    /*-------------------------------------------------*\
+    | Populate new controllers that were registered     |
+    | with only their identity                          |
+    \*-------------------------------------------------*/
+    for(unsigned int hw_controller_idx = 0; hw_controller_idx < rgb_controllers_hw.size(); hw_controller_idx++)
+    {
+        if(!rgb_controllers_hw[hw_controller_idx]->GetPopulated())
+        {
+            QueuePopulate(rgb_controllers_hw[hw_controller_idx]);
+        }
     }
 
     /*-------------------------------------------------*\
@@ -512,6 +687,13 @@ static void NetworkClientInfoChangeCallback(void* this_ptr)
     this_obj->DeviceListChanged();
 }
 
+static void HotplugEventCallback(void* this_ptr, std::vector<HotplugEvent>& events)
+{
+    ResourceManager* this_obj = (ResourceManager*)this_ptr;
+
+    this_obj->ProcessHotplugEvents(events);
+}
+
 void ResourceManager::RegisterNetworkClient(NetworkClient* new_client)
 {
     new_client->RegisterClientInfoChangeCallback(NetworkClientInfoChangeCallback, this);
@@ -592,6 +774,34 @@ void ResourceManager::Cleanup()
 {
     ResourceManager::get()->WaitForDeviceDetection();
 
+    /*-------------------------------------------------*\
+    | Stop the populate threads, nothing is queued once |
+    | detection has finished                            |
+    \*-------------------------------------------------*/
+    PopulateMutex.lock();
+    populate_stopping = true;
+    PopulateMutex.unlock();
+
+    PopulateCV.notify_all();
+
+    for(unsigned int thread_idx = 0; thread_idx < populate_threads.size(); thread_idx++)
+    {
+        populate_threads[thread_idx]->join();
+        delete populate_threads[thread_idx];
+    }
+
+    populate_threads.clear();
+    populate_idle_threads = 0;
+    populate_stopping     = false;
+
+    /*-------------------------------------------------*\
+    | Take the controllers out of the lists with the    |
+    | detection lock held, so that hotplug processing   |
+    | never sees a controller that is being deleted     |
+    \*-------------------------------------------------*/
+    DetectDeviceMutex.lock();
+    DeviceListChangeMutex.lock();
+
     std::vector<RGBController *> rgb_controllers_hw_copy = rgb_controllers_hw;
 
     for(unsigned int hw_controller_idx = 0; hw_controller_idx < rgb_controllers_hw.size(); hw_controller_idx++)
@@ -608,8 +818,13 @@ void ResourceManager::Cleanup()
 
     rgb_controllers_hw.clear();
 
+    DeviceListChangeMutex.unlock();
+    DetectDeviceMutex.unlock();
+
     for(RGBController* rgb_controller : rgb_controllers_hw_copy)
     {
+        server->ControllerRemoved(rgb_controller);
+
         delete rgb_controller;
     }
 
@@ -657,11 +872,6 @@ void ResourceManager::ProcessDynamicDetectors()
 
 void ResourceManager::DetectDevices()
 {
-    /*-----------------------------------------------------*\
-    | Process pre-detection hooks                           |
-    \*-----------------------------------------------------*/
-    ProcessPreDetectionHooks();
-
     /*-----------------------------------------------------*\
     | Process Dynamic Detectors                             |
     \*-----------------------------------------------------*/
@@ -704,6 +914,13 @@ void ResourceManager::DetectDevices()
 
         DetectionProgressChanged();
 
+        /*-------------------------------------------------*\
+        | Flag the rescan before cleaning up, so hotplug    |
+        | events handled before the detection thread starts |
+        | are left to the rescan                            |
+        \*-------------------------------------------------*/
+        detection_is_required = true;
+
         Cleanup();
 
         UpdateDeviceList();
@@ -711,9 +928,28 @@ void ResourceManager::DetectDevices()
         /*-------------------------------------------------*\
         | Start the device detection thread                 |
         \*-------------------------------------------------*/
-        detection_is_required = true;
         DetectDevicesThread = new std::thread(&ResourceManager::DetectDevicesThreadFunction, this);
 
+#ifdef __linux__
+        /*-------------------------------------------------*\
+        | Start following hotplugged devices, unless turned |
+        | off in the detector settings                      |
+        \*-------------------------------------------------*/
+        json detector_settings  = settings_manager->GetSettings("Detectors");
+        bool hotplug_enabled    = true;
+
+        if(detector_settings.contains("hotplug"))
+        {
+            hotplug_enabled     = detector_settings["hotplug"];
+        }
+
+        if(hotplug_enabled && (hotplug_monitor == nullptr))
+        {
+            hotplug_monitor = new HotplugMonitor();
+            hotplug_monitor->Start(HotplugEventCallback, this);
+        }
+#endif
+
         /*-------------------------------------------------*\
         | Release the current thread to allow detection     |
         | thread to start                                   |
@@ -781,204 +1017,512 @@ const char* wchar_to_char(const wchar_t* pwchar)
     return filePathC;
 }
 
-void ResourceManager::DetectDevicesThreadFunction()
+/*---------------------------------------------------------*\
+| Returns true if a HID detector handles this HID device    |
+\*---------------------------------------------------------*/
+static bool HIDDetectorMatches(const HIDDeviceDetectorBlock& detector, hid_device_info* info)
 {
-    DetectDeviceMutex.lock();
-
-    hid_device_info*    current_hid_device;
-    float               percent             = 0.0f;
-    float               percent_denominator = 0.0f;
-    json                detector_settings;
-    unsigned int        hid_device_count    = 0;
-    hid_device_info*    hid_devices         = NULL;
-    bool                hid_safe_mode       = false;
-    unsigned int        prev_count          = 0;
-    std::vector<bool>   size_used;
+    unsigned int addr = (info->vendor_id << 16) | info->product_id;
 
-    LOG_INFO("------------------------------------------------------");
-    LOG_INFO("|               Start device detection               |");
-    LOG_INFO("------------------------------------------------------");
+    return(( (     detector.address    == addr                              ) )
+#ifdef USE_HID_USAGE
+        && ( (     detector.usage_page == HID_USAGE_PAGE_ANY                )
+          || (     detector.usage_page == info->usage_page                  ) )
+        && ( (     detector.usage      == HID_USAGE_ANY                     )
+          || (     detector.usage      == info->usage                       ) )
+        && ( (     detector.interface  == HID_INTERFACE_ANY                 )
+          || (     detector.interface  == info->interface_number            ) )
+#else
+        && ( (     detector.interface  == HID_INTERFACE_ANY                 )
+          || (     detector.interface  == info->interface_number            ) )
+#endif
+        );
+}
 
-    size_used.resize(rgb_controllers_sizes.size());
+/*---------------------------------------------------------*\
+| Identifies a HID device in the detection cache by its     |
+| path and serial number                                    |
+\*---------------------------------------------------------*/
+static std::string GetHIDDeviceCacheKey(hid_device_info* info)
+{
+    std::string key = "HID:";
 
-    for(unsigned int size_idx = 0; size_idx < size_used.size(); size_idx++)
+    if(info->path != NULL)
     {
-        size_used[size_idx] = false;
+        key += info->path;
     }
 
-    /*-------------------------------------------------*\
-    | Open device disable list and read in disabled     |
-    | device strings                                    |
-    \*-------------------------------------------------*/
-    detector_settings = settings_manager->GetSettings("Detectors");
-
-    /*-------------------------------------------------*\
-    | Initialize HID interface for detection            |
-    \*-------------------------------------------------*/
-    int hid_status = hid_init();
-
-    LOG_INFO("Initializing HID interfaces: %s", ((hid_status == 0) ? "Success" : "Failed"));
+    key += ":";
 
-    /*-------------------------------------------------*\
-    | Check HID safe mode setting                       |
-    \*-------------------------------------------------*/
-    if(detector_settings.contains("hid_safe_mode"))
+    for(const wchar_t* serial_char = info->serial_number; (serial_char != NULL) && (*serial_char != 0); serial_char++)
     {
-        hid_safe_mode = detector_settings["hid_safe_mode"];
+        key += (char)*serial_char;
     }
 
-    /*-------------------------------------------------*\
-    | Calculate the percentage denominator by adding    |
-    | the number of I2C and miscellaneous detectors and |
-    | the number of enumerated HID devices              |
-    |                                                   |
-    | Start by iterating through all HID devices in     |
-    | list to get a total count                         |
-    \*-------------------------------------------------*/
-    if(!hid_safe_mode)
-    {
-        hid_devices = hid_enumerate(0, 0);
-    }
+    return(key);
+}
 
-    current_hid_device = hid_devices;
+/*---------------------------------------------------------*\
+| Returns true if a controller location refers to a device  |
+| node, so /dev/hidraw1 does not match /dev/hidraw10        |
+\*---------------------------------------------------------*/
+static bool LocationHasDevnode(const std::string& location, const std::string& devnode)
+{
+    std::size_t pos = location.find(devnode);
 
-    while(current_hid_device)
+    while(pos != std::string::npos)
     {
-        hid_device_count++;
+        std::size_t end = pos + devnode.size();
+
+        if((end == location.size()) || !isalnum((unsigned char)location[end]))
+        {
+            return(true);
+        }
 
-        current_hid_device = current_hid_device->next;
+        pos = location.find(devnode, pos + 1);
     }
 
-    percent_denominator = i2c_device_detectors.size() + i2c_pci_device_detectors.size() + device_detectors.size() + hid_device_count;
+    return(false);
+}
 
-    /*-------------------------------------------------*\
-    | Start at 0% detection progress                    |
-    \*-------------------------------------------------*/
-    detection_percent = 0;
+/*---------------------------------------------------------*\
+| Follows devices being plugged in and removed without a    |
+| full rescan.  Controllers on removed device nodes are     |
+| removed, and only the HID and serial detectors matching   |
+| an added device node are run.  Other controllers are left |
+| untouched.                                                |
+\*---------------------------------------------------------*/
+void ResourceManager::ProcessHotplugEvents(std::vector<HotplugEvent>& events)
+{
+    json                        detector_settings;
+    std::vector<std::string>    added_hid_paths;
+    std::vector<std::string>    added_serial_ports;
+    std::vector<RGBController*> removed_controllers;
+    DetectionJob                hotplug_job;
+    std::vector<bool>           size_used;
 
-    /*-------------------------------------------------*\
-    | Detect i2c interfaces                             |
-    \*-------------------------------------------------*/
-    LOG_INFO("------------------------------------------------------");
-    LOG_INFO("|             Detecting I2C interfaces               |");
-    LOG_INFO("------------------------------------------------------");
-    
-    bool i2c_interface_fail = false;
+    /*-----------------------------------------------------*\
+    | Wait for a running detection to finish.  Devices it   |
+    | already found are skipped below.                      |
+    \*-----------------------------------------------------*/
+    DetectDeviceMutex.lock();
 
-    for(unsigned int i2c_bus_detector_idx = 0; i2c_bus_detector_idx < i2c_bus_detectors.size() && detection_is_required.load(); i2c_bus_detector_idx++)
+    /*-----------------------------------------------------*\
+    | A rescan that is about to start detects every device  |
+    | again                                                 |
+    \*-----------------------------------------------------*/
+    if(detection_is_required.load())
     {
-        if(i2c_bus_detectors[i2c_bus_detector_idx]() == false)
-        {
-            i2c_interface_fail = true;
-        }
-
-        I2CBusListChanged();
+        DetectDeviceMutex.unlock();
+        return;
     }
 
-    /*-------------------------------------------------*\
-    | Detect i2c devices                                |
-    \*-------------------------------------------------*/
-    LOG_INFO("------------------------------------------------------");
-    LOG_INFO("|               Detecting I2C devices                |");
-    LOG_INFO("------------------------------------------------------");
-    for(unsigned int i2c_detector_idx = 0; i2c_detector_idx < i2c_device_detectors.size() && detection_is_required.load(); i2c_detector_idx++)
+    detector_settings = settings_manager->GetSettings("Detectors");
+
+    for(unsigned int event_idx = 0; event_idx < events.size(); event_idx++)
     {
-        detection_string = i2c_device_detector_strings[i2c_detector_idx].c_str();
+        HotplugEvent& event = events[event_idx];
 
-        /*-------------------------------------------------*\
-        | Check if this detector is enabled                 |
-        \*-------------------------------------------------*/
-        bool this_device_enabled = true;
-        if(detector_settings.contains("detectors") && detector_settings["detectors"].contains(detection_string))
+        if((event.subsystem != "hidraw") && (event.subsystem != "tty"))
         {
-            this_device_enabled = detector_settings["detectors"][detection_string];
+            if((event.subsystem == "i2c-dev") && (event.action == HOTPLUG_ACTION_ADD))
+            {
+                LOG_INFO("[ResourceManager] I2C adapter %s added, rescan to detect devices on it", event.devnode.c_str());
+            }
+
+            continue;
         }
 
-        LOG_DEBUG("[%s] is %s", detection_string, ((this_device_enabled == true) ? "enabled" : "disabled"));
-        if(this_device_enabled)
+        std::vector<std::string>& added_nodes = (event.subsystem == "hidraw") ? added_hid_paths : added_serial_ports;
+
+        if(event.action == HOTPLUG_ACTION_ADD)
         {
-            DetectionProgressChanged();
-            
-            i2c_device_detectors[i2c_detector_idx](busses);
+            added_nodes.push_back(event.devnode);
+            continue;
         }
 
         /*-------------------------------------------------*\
-        | If the device list size has changed, call the     |
-        | device list changed callbacks                     |
+        | A node removed again before it was handled needs  |
+        | no detection                                      |
         \*-------------------------------------------------*/
-        if(rgb_controllers_hw.size() != prev_count)
+        added_nodes.erase(std::remove(added_nodes.begin(), added_nodes.end(), event.devnode), added_nodes.end());
+
+        std::vector<RGBController*> rgb_controllers_hw_copy = rgb_controllers_hw;
+
+        for(unsigned int controller_idx = 0; controller_idx < rgb_controllers_hw_copy.size(); controller_idx++)
         {
-            /*-------------------------------------------------*\
-            | First, load sizes for the new controllers         |
-            \*-------------------------------------------------*/
-            for(unsigned int controller_size_idx = prev_count; controller_size_idx < rgb_controllers_hw.size(); controller_size_idx++)
+            if(LocationHasDevnode(rgb_controllers_hw_copy[controller_idx]->location, event.devnode))
             {
-                profile_manager->LoadDeviceFromListWithOptions(rgb_controllers_sizes, size_used, rgb_controllers_hw[controller_size_idx], true, false);
-            }
+                LOG_INFO("[%s] Device %s removed", rgb_controllers_hw_copy[controller_idx]->name.c_str(), event.devnode.c_str());
 
-            UpdateDeviceList();
-        }
-        else
-        {
-            LOG_DEBUG("[%s] no devices found", detection_string);
+                RemoveRGBController(rgb_controllers_hw_copy[controller_idx]);
+
+                removed_controllers.push_back(rgb_controllers_hw_copy[controller_idx]);
+            }
         }
-        prev_count = rgb_controllers_hw.size();
+    }
 
-        LOG_TRACE("[%s] detection end", detection_string);
-        
-        /*-------------------------------------------------*\
-        | Update detection percent                          |
-        \*-------------------------------------------------*/
-        percent = (i2c_detector_idx + 1.0f) / percent_denominator;
+    /*-----------------------------------------------------*\
+    | Collect controllers from the detectors in a job, so   |
+    | they are added and sized together                     |
+    \*-----------------------------------------------------*/
+    hotplug_job.name            = "Hotplug";
+    hotplug_job.cached_count    = -1;
+    hotplug_job.skipped         = false;
+    hotplug_job.done            = false;
+    hotplug_job.added           = false;
 
-        detection_percent = percent * 100.0f;
+    /*-----------------------------------------------------*\
+    | Reset the paths detectors remember between runs, so a |
+    | device plugged in again on a reused node is detected  |
+    \*-----------------------------------------------------*/
+    if(!added_hid_paths.empty() || !added_serial_ports.empty())
+    {
+        ProcessPreDetectionHooks();
     }
 
-    /*-------------------------------------------------*\
-    | Detect i2c PCI devices                            |
-    \*-------------------------------------------------*/
-    LOG_INFO("------------------------------------------------------");
-    LOG_INFO("|               Detecting I2C PCI devices            |");
-    LOG_INFO("------------------------------------------------------");
-    for(unsigned int i2c_detector_idx = 0; i2c_detector_idx < i2c_pci_device_detectors.size() && detection_is_required.load(); i2c_detector_idx++)
+    current_detection_job = &hotplug_job;
+
+    /*-----------------------------------------------------*\
+    | Run the HID detectors for added HID device nodes that |
+    | no controller uses yet                                |
+    \*-----------------------------------------------------*/
+    if(!added_hid_paths.empty())
     {
-        detection_string = i2c_pci_device_detectors[i2c_detector_idx].name.c_str();
+        hid_device_info* hid_devices = hid_enumerate(0, 0);
 
-        /*-------------------------------------------------*\
-        | Check if this detector is enabled                 |
-        \*-------------------------------------------------*/
-        bool this_device_enabled = true;
-        if(detector_settings.contains("detectors") && detector_settings["detectors"].contains(detection_string))
+        for(hid_device_info* hid_device = hid_devices; hid_device; hid_device = hid_device->next)
         {
-            this_device_enabled = detector_settings["detectors"][detection_string];
-        }
+            std::string hid_path = (hid_device->path != NULL) ? hid_device->path : "";
 
-        LOG_DEBUG("[%s] is %s", detection_string, ((this_device_enabled == true) ? "enabled" : "disabled"));
-        if(this_device_enabled)
-        {
-            DetectionProgressChanged();
-            
-            for(unsigned int bus = 0; bus < busses.size(); bus++)
+            if(std::find(added_hid_paths.begin(), added_hid_paths.end(), hid_path) == added_hid_paths.end())
             {
-                if(busses[bus]->pci_vendor           == i2c_pci_device_detectors[i2c_detector_idx].ven_id    &&
-                   busses[bus]->pci_device           == i2c_pci_device_detectors[i2c_detector_idx].dev_id    &&
-                   busses[bus]->pci_subsystem_vendor == i2c_pci_device_detectors[i2c_detector_idx].subven_id &&
-                   busses[bus]->pci_subsystem_device == i2c_pci_device_detectors[i2c_detector_idx].subdev_id)
-                {
-                    i2c_pci_device_detectors[i2c_detector_idx].function(busses[bus], i2c_pci_device_detectors[i2c_detector_idx].i2c_addr, i2c_pci_device_detectors[i2c_detector_idx].name);
-                }
+                continue;
+            }
+
+            bool path_in_use = false;
+
+            for(unsigned int controller_idx = 0; controller_idx < rgb_controllers_hw.size(); controller_idx++)
+            {
+                if(LocationHasDevnode(rgb_controllers_hw[controller_idx]->location, hid_path))
+                {
+                    path_in_use = true;
+                    break;
+                }
+            }
+
+            HIDDeviceDetectorIndex::const_iterator index_it = hid_device_detector_index.find((hid_device->vendor_id << 16) | hid_device->product_id);
+
+            if(path_in_use || (index_it == hid_device_detector_index.end()))
+            {
+                continue;
+            }
+
+            for(unsigned int address_detector_idx = 0; address_detector_idx < index_it->second.size(); address_detector_idx++)
+            {
+                HIDDeviceDetectorBlock& hid_detector  = hid_device_detectors[index_it->second[address_detector_idx]];
+                const char*             detector_name = hid_detector.name.c_str();
+
+                if(!HIDDetectorMatches(hid_detector, hid_device))
+                {
+                    continue;
+                }
+
+                if(detector_settings.contains("detectors") && detector_settings["detectors"].contains(detector_name) && !detector_settings["detectors"][detector_name])
+                {
+                    continue;
+                }
+
+                LOG_INFO("[%s] Detecting added device %s", detector_name, hid_path.c_str());
+
+                hid_detector.function(hid_device, hid_detector.name);
+            }
+        }
+
+        hid_free_enumeration(hid_devices);
+    }
+
+    /*-----------------------------------------------------*\
+    | Run the serial detectors whose VID/PID has one of the |
+    | added serial ports                                    |
+    \*-----------------------------------------------------*/
+    for(unsigned int serial_detector_idx = 0; (serial_detector_idx < serial_device_detectors.size()) && !added_serial_ports.empty(); serial_detector_idx++)
+    {
+        SerialDeviceDetectorBlock&  serial_detector = serial_device_detectors[serial_detector_idx];
+        const char*                 detector_name   = serial_detector.name.c_str();
+        std::vector<std::string *>  ports           = find_usb_serial_port(serial_detector.address >> 16, serial_detector.address & 0x0000FFFF);
+        bool                        port_added      = false;
+
+        for(unsigned int port_idx = 0; port_idx < ports.size(); port_idx++)
+        {
+            if(std::find(added_serial_ports.begin(), added_serial_ports.end(), *ports[port_idx]) != added_serial_ports.end())
+            {
+                port_added = true;
+            }
+
+            delete ports[port_idx];
+        }
+
+        if(!port_added)
+        {
+            continue;
+        }
+
+        if(detector_settings.contains("detectors") && detector_settings["detectors"].contains(detector_name) && !detector_settings["detectors"][detector_name])
+        {
+            continue;
+        }
+
+        LOG_INFO("[%s] Detecting added serial device", detector_name);
+
+        serial_detector.function(hotplug_job.detected);
+    }
+
+    current_detection_job = NULL;
+
+    /*-----------------------------------------------------*\
+    | Serial detectors open every port of their VID/PID, so |
+    | drop new controllers for devices already in the list  |
+    \*-----------------------------------------------------*/
+    std::vector<RGBController*> new_controllers = hotplug_job.registered;
+
+    new_controllers.insert(new_controllers.end(), hotplug_job.detected.begin(), hotplug_job.detected.end());
+
+    unsigned int prev_count = (unsigned int)rgb_controllers_hw.size();
+
+    for(unsigned int new_idx = 0; new_idx < new_controllers.size(); new_idx++)
+    {
+        bool duplicate = false;
+
+        for(unsigned int controller_idx = 0; controller_idx < prev_count; controller_idx++)
+        {
+            if(rgb_controllers_hw[controller_idx]->location == new_controllers[new_idx]->location)
+            {
+                duplicate = true;
+                break;
+            }
+        }
+
+        if(duplicate)
+        {
+            removed_controllers.push_back(new_controllers[new_idx]);
+            continue;
+        }
+
+        if(new_idx < hotplug_job.registered.size())
+        {
+            AddRGBController(new_controllers[new_idx]);
+        }
+        else
+        {
+            DeviceListChangeMutex.lock();
+            rgb_controllers_hw.push_back(new_controllers[new_idx]);
+            DeviceListChangeMutex.unlock();
+        }
+    }
+
+    if(rgb_controllers_hw.size() != prev_count)
+    {
+        size_used.resize(rgb_controllers_sizes.size(), false);
+
+        for(unsigned int controller_size_idx = prev_count; controller_size_idx < rgb_controllers_hw.size(); controller_size_idx++)
+        {
+            profile_manager->LoadDeviceFromListWithOptions(rgb_controllers_sizes, size_used, rgb_controllers_hw[controller_size_idx], true, false);
+        }
+
+        UpdateDeviceList();
+    }
+
+    DetectDeviceMutex.unlock();
+
+    /*-----------------------------------------------------*\
+    | Delete removed and duplicate controllers once they    |
+    | are out of the list and the SDK server is done with   |
+    | them.  The server is waited for without the detection |
+    | lock, as a request it is processing may need it.      |
+    \*-----------------------------------------------------*/
+    for(unsigned int removed_idx = 0; removed_idx < removed_controllers.size(); removed_idx++)
+    {
+        server->ControllerRemoved(removed_controllers[removed_idx]);
+
+        delete removed_controllers[removed_idx];
+    }
+}
+
+/*---------------------------------------------------------*\
+| Queues a detector to run in the given group.  Jobs in a   |
+| group run in the order they were added.                   |
+\*---------------------------------------------------------*/
+void ResourceManager::AddDetectionJob(const std::string& group, const char* name, const std::string& cache_key, DeviceDetectorFunction function)
+{
+    DetectionJob new_job;
+
+    new_job.name            = name;
+    new_job.function        = function;
+    new_job.cache_key       = cache_key;
+    new_job.cached_count    = -1;
+    new_job.skipped         = false;
+    new_job.done            = false;
+    new_job.added           = false;
+
+    if(detection_group_keys.find(group) == detection_group_keys.end())
+    {
+        detection_group_keys[group] = (unsigned int)detection_groups.size();
+        detection_groups.push_back(std::vector<unsigned int>());
+    }
+
+    detection_groups[detection_group_keys[group]].push_back((unsigned int)detection_jobs.size());
+    detection_jobs.push_back(new_job);
+}
+
+void ResourceManager::DetectionWorkerThreadFunction()
+{
+    /*-----------------------------------------------------*\
+    | Take groups until none are left, running each group's |
+    | jobs in order                                         |
+    \*-----------------------------------------------------*/
+    while(true)
+    {
+        unsigned int group_idx = detection_next_group++;
+
+        if(group_idx >= detection_groups.size())
+        {
+            break;
+        }
+
+        for(unsigned int group_job_idx = 0; group_job_idx < detection_groups[group_idx].size(); group_job_idx++)
+        {
+            DetectionJob& job = detection_jobs[detection_groups[group_idx][group_job_idx]];
+
+            /*---------------------------------------------*\
+            | Jobs finished in an earlier pass are left as  |
+            | they are                                      |
+            \*---------------------------------------------*/
+            DetectionJobMutex.lock();
+            bool job_done = job.done;
+            DetectionJobMutex.unlock();
+
+            if(job_done)
+            {
+                continue;
+            }
+
+            /*---------------------------------------------*\
+            | Skip jobs the detection cache ruled out, and  |
+            | the remaining jobs if detection was stopped   |
+            \*---------------------------------------------*/
+            if(!job.skipped && detection_is_required.load())
+            {
+                LOG_TRACE("[%s] detection start", job.name);
+
+                current_detection_job = &job;
+
+                job.function(job.detected);
+
+                current_detection_job = NULL;
+            }
+
+            DetectionJobMutex.lock();
+            job.done = true;
+            DetectionJobMutex.unlock();
+
+            DetectionJobCV.notify_all();
+        }
+    }
+}
+
+/*---------------------------------------------------------*\
+| Runs every queued job that has not finished yet and adds  |
+| their controllers in job order.  Returns true if a job    |
+| found a different number of controllers than the cache    |
+| said it would.                                            |
+\*---------------------------------------------------------*/
+bool ResourceManager::RunDetectionJobs(unsigned int thread_count, std::vector<bool>& size_used)
+{
+    std::vector<std::thread*>   detection_threads;
+    bool                        cache_mismatch      = false;
+
+    detection_next_group = 0;
+
+    for(unsigned int thread_idx = 0; (thread_idx < thread_count) && (thread_idx < detection_groups.size()); thread_idx++)
+    {
+        detection_threads.push_back(new std::thread(&ResourceManager::DetectionWorkerThreadFunction, this));
+    }
+
+    /*-------------------------------------------------*\
+    | Add controllers as jobs finish, in job order, so  |
+    | the device list is the same on every run          |
+    \*-------------------------------------------------*/
+    unsigned int next_job_idx = 0;
+
+    while(next_job_idx < detection_jobs.size())
+    {
+        std::vector<DetectionJob*>      finished_jobs;
+        std::unique_lock<std::mutex>    job_lock(DetectionJobMutex);
+
+        DetectionJobCV.wait(job_lock, [this, next_job_idx]{ return(detection_jobs[next_job_idx].done); });
+
+        while((next_job_idx < detection_jobs.size()) && detection_jobs[next_job_idx].done)
+        {
+            if(!detection_jobs[next_job_idx].added)
+            {
+                detection_jobs[next_job_idx].added = true;
+
+                finished_jobs.push_back(&detection_jobs[next_job_idx]);
             }
+
+            next_job_idx++;
+        }
+
+        job_lock.unlock();
+
+        unsigned int prev_count = (unsigned int)rgb_controllers_hw.size();
+
+        for(unsigned int finished_idx = 0; finished_idx < finished_jobs.size(); finished_idx++)
+        {
+            DetectionJob* job           = finished_jobs[finished_idx];
+            int           found_count   = (int)(job->registered.size() + job->detected.size());
+
+            if(job->skipped)
+            {
+                continue;
+            }
+
+            if(found_count == 0)
+            {
+                LOG_DEBUG("[%s] no devices found", job->name);
+            }
+
+            /*---------------------------------------------*\
+            | A job the cache knows about finding something |
+            | else means the hardware changed               |
+            \*---------------------------------------------*/
+            if((job->cached_count > 0) && (found_count != job->cached_count))
+            {
+                LOG_INFO("[%s] found %d devices, %d expected from the detection cache", job->name, found_count, job->cached_count);
+
+                cache_mismatch = true;
+            }
+
+            for(unsigned int controller_idx = 0; controller_idx < job->registered.size(); controller_idx++)
+            {
+                AddRGBController(job->registered[controller_idx]);
+            }
+
+            DeviceListChangeMutex.lock();
+            rgb_controllers_hw.insert(rgb_controllers_hw.end(), job->detected.begin(), job->detected.end());
+            DeviceListChangeMutex.unlock();
+
+            LOG_TRACE("[%s] detection end", job->name);
         }
 
         /*-------------------------------------------------*\
-        | If the device list size has changed, call the     |
-        | device list changed callbacks                     |
+        | If the device list size has changed, load sizes   |
+        | for the new controllers and call the device list  |
+        | changed callbacks                                 |
         \*-------------------------------------------------*/
         if(rgb_controllers_hw.size() != prev_count)
         {
-            /*-------------------------------------------------*\
-            | First, load sizes for the new controllers         |
-            \*-------------------------------------------------*/
             for(unsigned int controller_size_idx = prev_count; controller_size_idx < rgb_controllers_hw.size(); controller_size_idx++)
             {
                 profile_manager->LoadDeviceFromListWithOptions(rgb_controllers_sizes, size_used, rgb_controllers_hw[controller_size_idx], true, false);
@@ -986,127 +1530,408 @@ void ResourceManager::DetectDevicesThreadFunction()
 
             UpdateDeviceList();
         }
-        else
+
+        /*-------------------------------------------------*\
+        | Update detection percent, showing the job that    |
+        | is holding up the list                            |
+        \*-------------------------------------------------*/
+        if(next_job_idx < detection_jobs.size())
         {
-            LOG_DEBUG("[%s] no devices found", detection_string);
+            detection_string = detection_jobs[next_job_idx].name;
         }
-        prev_count = rgb_controllers_hw.size();
 
-        LOG_TRACE("[%s] detection end", detection_string);
-        
+        detection_percent = (next_job_idx * 100) / detection_jobs.size();
+
+        DetectionProgressChanged();
+    }
+
+    for(unsigned int thread_idx = 0; thread_idx < detection_threads.size(); thread_idx++)
+    {
+        detection_threads[thread_idx]->join();
+        delete detection_threads[thread_idx];
+    }
+
+    return(cache_mismatch);
+}
+
+void ResourceManager::QueuePopulate(RGBController *rgb_controller)
+{
+    std::lock_guard<std::mutex> populate_lock(PopulateMutex);
+
+    if((std::find(populate_queue.begin(), populate_queue.end(), rgb_controller) != populate_queue.end())
+    || (std::find(populate_active.begin(), populate_active.end(), rgb_controller) != populate_active.end()))
+    {
+        return;
+    }
+
+    populate_queue.push_back(rgb_controller);
+
+    /*-------------------------------------------------*\
+    | Start another thread if none is waiting for work  |
+    \*-------------------------------------------------*/
+    if((populate_idle_threads < populate_queue.size()) && (populate_threads.size() < DETECTION_DEFAULT_THREADS))
+    {
+        populate_idle_threads++;
+        populate_threads.push_back(new std::thread(&ResourceManager::PopulateWorkerThreadFunction, this));
+    }
+
+    PopulateCV.notify_all();
+}
+
+/*---------------------------------------------------------*\
+| Removes a controller from the populate queue, waiting for |
+| it to finish if it is being populated                     |
+\*---------------------------------------------------------*/
+void ResourceManager::CancelPopulate(RGBController *rgb_controller)
+{
+    std::unique_lock<std::mutex> populate_lock(PopulateMutex);
+
+    populate_queue.erase(std::remove(populate_queue.begin(), populate_queue.end(), rgb_controller), populate_queue.end());
+
+    PopulateCV.wait(populate_lock, [this, rgb_controller]{ return(std::find(populate_active.begin(), populate_active.end(), rgb_controller) == populate_active.end()); });
+
+    PopulateCV.notify_all();
+}
+
+void ResourceManager::PopulateWorkerThreadFunction()
+{
+    std::unique_lock<std::mutex> populate_lock(PopulateMutex);
+
+    while(true)
+    {
+        PopulateCV.wait(populate_lock, [this]{ return(populate_stopping || !populate_queue.empty()); });
+
+        if(populate_stopping)
+        {
+            break;
+        }
+
+        RGBController* rgb_controller = populate_queue.front();
+
+        populate_queue.erase(populate_queue.begin());
+        populate_active.push_back(rgb_controller);
+        populate_idle_threads--;
+
+        populate_lock.unlock();
+
+        LOG_TRACE("[%s] populate start", rgb_controller->name.c_str());
+
+        rgb_controller->Populate();
+
+        /*-------------------------------------------------*\
+        | The zones were not known when sizes were loaded   |
+        | during detection                                  |
+        \*-------------------------------------------------*/
+        std::vector<bool> size_used(rgb_controllers_sizes.size(), false);
+
+        profile_manager->LoadDeviceFromListWithOptions(rgb_controllers_sizes, size_used, rgb_controller, true, false);
+
+        LOG_TRACE("[%s] populate end", rgb_controller->name.c_str());
+
         /*-------------------------------------------------*\
-        | Update detection percent                          |
+        | The controller is complete, add it to the list    |
         \*-------------------------------------------------*/
-        percent = (i2c_device_detectors.size() + i2c_detector_idx + 1.0f) / percent_denominator;
+        UpdateDeviceList();
+
+        populate_lock.lock();
 
-        detection_percent = percent * 100.0f;
+        populate_active.erase(std::find(populate_active.begin(), populate_active.end(), rgb_controller));
+        populate_idle_threads++;
+
+        PopulateCV.notify_all();
     }
+}
+
+/*---------------------------------------------------------*\
+| Identifies the system the detection cache was saved on:   |
+| the OpenRGB version, the board, the I2C busses and which  |
+| DIMM slots answer on the DRAM SMBus.  Adding memory does  |
+| not change the busses, and the DRAM jobs that found       |
+| nothing last time are skipped, so without the slots a new |
+| RGB DIMM would never be detected from the cache.          |
+\*---------------------------------------------------------*/
+std::string ResourceManager::GetDetectionFingerprint()
+{
+    DMIInfo     dmi;
+    std::string fingerprint = std::string(VERSION_STRING) + "|" + dmi.getManufacturer() + "|" + dmi.getMainboard();
+
+    for(unsigned int bus = 0; bus < busses.size(); bus++)
+    {
+        char bus_ids[32];
+
+        snprintf(bus_ids, sizeof(bus_ids), ":%04X:%04X:%04X:%04X", busses[bus]->pci_vendor, busses[bus]->pci_device, busses[bus]->pci_subsystem_vendor, busses[bus]->pci_subsystem_device);
+
+        fingerprint += "|" + std::string(busses[bus]->device_name) + bus_ids;
+
+        IF_DRAM_SMBUS(busses[bus]->pci_vendor, busses[bus]->pci_device)
+        {
+            char slots_present[8];
+
+            for(int slot_addr = 0x50; slot_addr <= 0x57; slot_addr++)
+            {
+                slots_present[slot_addr - 0x50] = (busses[bus]->i2c_smbus_read_byte_data(slot_addr, 0x00) >= 0) ? '1' : '0';
+            }
+
+            fingerprint += ":SPD" + std::string(slots_present, sizeof(slots_present));
+        }
+    }
+
+    return(fingerprint);
+}
+
+void ResourceManager::DetectDevicesThreadFunction()
+{
+    DetectDeviceMutex.lock();
+
+    hid_device_info*    current_hid_device;
+    json                detector_settings;
+    hid_device_info*    hid_devices         = NULL;
+    bool                hid_safe_mode       = false;
+    unsigned int        thread_count        = DETECTION_DEFAULT_THREADS;
+    std::vector<bool>   size_used;
+
+    LOG_INFO("------------------------------------------------------");
+    LOG_INFO("|               Start device detection               |");
+    LOG_INFO("------------------------------------------------------");
 
     /*-------------------------------------------------*\
-    | Detect HID devices                                |
+    | Process pre-detection hooks.  They reset state    |
+    | kept by the detectors, so they run with the       |
+    | detection lock held, as hotplug detection does    |
+    \*-------------------------------------------------*/
+    ProcessPreDetectionHooks();
+
+    size_used.resize(rgb_controllers_sizes.size());
+
+    for(unsigned int size_idx = 0; size_idx < size_used.size(); size_idx++)
+    {
+        size_used[size_idx] = false;
+    }
+
+    /*-------------------------------------------------*\
+    | Open device disable list and read in disabled     |
+    | device strings                                    |
+    \*-------------------------------------------------*/
+    detector_settings = settings_manager->GetSettings("Detectors");
+
+    /*-------------------------------------------------*\
+    | Initialize HID interface for detection            |
+    \*-------------------------------------------------*/
+    int hid_status = hid_init();
+
+    LOG_INFO("Initializing HID interfaces: %s", ((hid_status == 0) ? "Success" : "Failed"));
+
+    /*-------------------------------------------------*\
+    | Check HID safe mode setting                       |
+    \*-------------------------------------------------*/
+    if(detector_settings.contains("hid_safe_mode"))
+    {
+        hid_safe_mode = detector_settings["hid_safe_mode"];
+    }
+
+    /*-------------------------------------------------*\
+    | Check detection thread count setting.  A count of |
+    | 1 runs every detector in turn as before.          |
+    \*-------------------------------------------------*/
+    if(detector_settings.contains("detection_threads") && (detector_settings["detection_threads"] > 0))
+    {
+        thread_count = detector_settings["detection_threads"];
+    }
+
+    /*-------------------------------------------------*\
+    | Start at 0% detection progress                    |
+    \*-------------------------------------------------*/
+    detection_percent = 0;
+
+    /*-------------------------------------------------*\
+    | Detect i2c interfaces                             |
     |                                                   |
-    | Reset current device pointer to first device      |
+    | The I2C device detectors need the full bus list,  |
+    | so this runs before any jobs start                |
     \*-------------------------------------------------*/
     LOG_INFO("------------------------------------------------------");
-    LOG_INFO("|               Detecting HID devices                |");
-    if (hid_safe_mode)
-    LOG_INFO("|                  with safe mode                    |");
+    LOG_INFO("|             Detecting I2C interfaces               |");
     LOG_INFO("------------------------------------------------------");
-    current_hid_device = hid_devices;
+    
+    bool i2c_interface_fail = false;
+
+    for(unsigned int i2c_bus_detector_idx = 0; i2c_bus_detector_idx < i2c_bus_detectors.size() && detection_is_required.load(); i2c_bus_detector_idx++)
+    {
+        if(i2c_bus_detectors[i2c_bus_detector_idx]() == false)
+        {
+            i2c_interface_fail = true;
+        }
+
+        I2CBusListChanged();
+    }
+
+    detection_jobs.clear();
+    detection_groups.clear();
+    detection_group_keys.clear();
+
+    /*-------------------------------------------------*\
+    | Queue i2c device detectors, one job per detector  |
+    | and bus.  Each bus is a group, so busses are      |
+    | probed in parallel but one address at a time.     |
+    \*-------------------------------------------------*/
+    for(unsigned int i2c_detector_idx = 0; i2c_detector_idx < i2c_device_detectors.size(); i2c_detector_idx++)
+    {
+        const char* detector_name = i2c_device_detector_strings[i2c_detector_idx].c_str();
+
+        /*-------------------------------------------------*\
+        | Check if this detector is enabled                 |
+        \*-------------------------------------------------*/
+        bool this_device_enabled = true;
+        if(detector_settings.contains("detectors") && detector_settings["detectors"].contains(detector_name))
+        {
+            this_device_enabled = detector_settings["detectors"][detector_name];
+        }
+
+        LOG_DEBUG("[%s] is %s", detector_name, ((this_device_enabled == true) ? "enabled" : "disabled"));
+
+        if(!this_device_enabled)
+        {
+            continue;
+        }
+
+        for(unsigned int bus = 0; bus < busses.size(); bus++)
+        {
+            I2CDeviceDetectorFunction   detector    = i2c_device_detectors[i2c_detector_idx];
+            i2c_smbus_interface*        bus_ptr     = busses[bus];
+
+            AddDetectionJob("I2C:" + std::to_string(bus), detector_name, "I2C:" + std::to_string(bus) + "/" + detector_name, [detector, bus_ptr](std::vector<RGBController*>&)
+            {
+                std::vector<i2c_smbus_interface*> job_busses(1, bus_ptr);
+
+                detector(job_busses);
+            });
+        }
+    }
+
+    /*-------------------------------------------------*\
+    | Queue i2c PCI device detectors on each matching   |
+    | bus, in the same group as that bus's other jobs   |
+    \*-------------------------------------------------*/
+    for(unsigned int i2c_detector_idx = 0; i2c_detector_idx < i2c_pci_device_detectors.size(); i2c_detector_idx++)
+    {
+        I2CPCIDeviceDetectorBlock& pci_detector  = i2c_pci_device_detectors[i2c_detector_idx];
+        const char*                detector_name = pci_detector.name.c_str();
+
+        /*-------------------------------------------------*\
+        | Check if this detector is enabled                 |
+        \*-------------------------------------------------*/
+        bool this_device_enabled = true;
+        if(detector_settings.contains("detectors") && detector_settings["detectors"].contains(detector_name))
+        {
+            this_device_enabled = detector_settings["detectors"][detector_name];
+        }
 
+        LOG_DEBUG("[%s] is %s", detector_name, ((this_device_enabled == true) ? "enabled" : "disabled"));
+
+        if(!this_device_enabled)
+        {
+            continue;
+        }
+
+        for(unsigned int bus = 0; bus < busses.size(); bus++)
+        {
+            if(busses[bus]->pci_vendor           == pci_detector.ven_id    &&
+               busses[bus]->pci_device           == pci_detector.dev_id    &&
+               busses[bus]->pci_subsystem_vendor == pci_detector.subven_id &&
+               busses[bus]->pci_subsystem_device == pci_detector.subdev_id)
+            {
+                i2c_smbus_interface* bus_ptr = busses[bus];
+
+                AddDetectionJob("I2C:" + std::to_string(bus), detector_name, "I2C:" + std::to_string(bus) + "/" + detector_name, [pci_detector, bus_ptr](std::vector<RGBController*>&)
+                {
+                    pci_detector.function(bus_ptr, pci_detector.i2c_addr, pci_detector.name);
+                });
+            }
+        }
+    }
+
+    /*-------------------------------------------------*\
+    | Queue HID detectors                               |
+    \*-------------------------------------------------*/
     if(hid_safe_mode)
     {
         /*-----------------------------------------------------------------------------*\
-        | Loop through all available detectors.  If all required information matches,   |
-        | run the detector                                                              |
+        | In safe mode only the registered VID/PIDs are enumerated, once each, and all  |
+        | of them run in turn in a single group                                         |
         \*-----------------------------------------------------------------------------*/
-        for(unsigned int hid_detector_idx = 0; hid_detector_idx < hid_device_detectors.size() && detection_is_required.load(); hid_detector_idx++)
+        for(unsigned int hid_detector_idx = 0; hid_detector_idx < hid_device_detectors.size(); hid_detector_idx++)
         {
-            hid_devices = hid_enumerate(hid_device_detectors[hid_detector_idx].address >> 16, hid_device_detectors[hid_detector_idx].address & 0x0000FFFF);
-
-            LOG_VERBOSE("Trying to run detector for [%s] (for 0x%08hx)", hid_device_detectors[hid_detector_idx].name.c_str(), hid_device_detectors[hid_detector_idx].address);
-
-            current_hid_device = hid_devices;
+            unsigned int                        address             = hid_device_detectors[hid_detector_idx].address;
+            const std::vector<unsigned int>&    address_detectors   = hid_device_detector_index[address];
+            std::vector<HIDDeviceDetectorBlock> enabled_detectors;
 
-            while(current_hid_device)
+            /*-------------------------------------------------*\
+            | Only queue each VID/PID at its first detector     |
+            \*-------------------------------------------------*/
+            if(address_detectors[0] != hid_detector_idx)
             {
-                unsigned int addr = (current_hid_device->vendor_id << 16) | current_hid_device->product_id;
+                continue;
+            }
 
-                if(( (     hid_device_detectors[hid_detector_idx].address    == addr                                 ) )
-#ifdef USE_HID_USAGE
-                && ( (     hid_device_detectors[hid_detector_idx].usage_page == HID_USAGE_PAGE_ANY                   )
-                  || (     hid_device_detectors[hid_detector_idx].usage_page == current_hid_device->usage_page       ) )
-                && ( (     hid_device_detectors[hid_detector_idx].usage      == HID_USAGE_ANY                        )
-                  || (     hid_device_detectors[hid_detector_idx].usage      == current_hid_device->usage            ) )
-                && ( (     hid_device_detectors[hid_detector_idx].interface  == HID_INTERFACE_ANY                    )
-                  || (     hid_device_detectors[hid_detector_idx].interface  == current_hid_device->interface_number ) )
-#else
-                && ( (     hid_device_detectors[hid_detector_idx].interface  == HID_INTERFACE_ANY                    )
-                  || (     hid_device_detectors[hid_detector_idx].interface  == current_hid_device->interface_number ) )
-#endif
-                )
+            for(unsigned int address_detector_idx = 0; address_detector_idx < address_detectors.size(); address_detector_idx++)
+            {
+                HIDDeviceDetectorBlock& hid_detector  = hid_device_detectors[address_detectors[address_detector_idx]];
+                const char*             detector_name = hid_detector.name.c_str();
+
+                /*-------------------------------------------------*\
+                | Check if this detector is enabled                 |
+                \*-------------------------------------------------*/
+                bool this_device_enabled = true;
+                if(detector_settings.contains("detectors") && detector_settings["detectors"].contains(detector_name))
                 {
-                    detection_string = hid_device_detectors[hid_detector_idx].name.c_str();
-
-                    /*-------------------------------------------------*\
-                    | Check if this detector is enabled or needs to be  |
-                    | added to the settings list                        |
-                    \*-------------------------------------------------*/
-                    bool this_device_enabled = true;
-                    if(detector_settings.contains("detectors") && detector_settings["detectors"].contains(detection_string))
-                    {
-                        this_device_enabled = detector_settings["detectors"][detection_string];
-                    }
+                    this_device_enabled = detector_settings["detectors"][detector_name];
+                }
 
-                    LOG_DEBUG("[%s] is %s", detection_string, ((this_device_enabled == true) ? "enabled" : "disabled"));
+                LOG_DEBUG("[%s] is %s", detector_name, ((this_device_enabled == true) ? "enabled" : "disabled"));
 
-                    if(this_device_enabled)
-                    {
-                        DetectionProgressChanged();
+                if(this_device_enabled)
+                {
+                    enabled_detectors.push_back(hid_detector);
+                }
+            }
 
-                        hid_device_detectors[hid_detector_idx].function(current_hid_device, hid_device_detectors[hid_detector_idx].name);
+            if(enabled_detectors.empty())
+            {
+                continue;
+            }
 
-                        /*-------------------------------------------------*\
-                        | If the device list size has changed, call the     |
-                        | device list changed callbacks                     |
-                        \*-------------------------------------------------*/
-                        if(rgb_controllers_hw.size() != prev_count)
-                        {
-                            /*-------------------------------------------------*\
-                            | First, load sizes for the new controllers         |
-                            \*-------------------------------------------------*/
-                            for(unsigned int controller_size_idx = prev_count; controller_size_idx < rgb_controllers_hw.size(); controller_size_idx++)
-                            {
-                                profile_manager->LoadDeviceFromListWithOptions(rgb_controllers_sizes, size_used, rgb_controllers_hw[controller_size_idx], true, false);
-                            }
-
-                            UpdateDeviceList();
-                        }
-                        else
+            AddDetectionJob("HID", hid_device_detectors[hid_detector_idx].name.c_str(), "", [enabled_detectors, address](std::vector<RGBController*>&)
+            {
+                hid_device_info* safe_hid_devices = hid_enumerate(address >> 16, address & 0x0000FFFF);
+
+                for(hid_device_info* safe_hid_device = safe_hid_devices; safe_hid_device; safe_hid_device = safe_hid_device->next)
+                {
+                    for(unsigned int enabled_idx = 0; enabled_idx < enabled_detectors.size(); enabled_idx++)
+                    {
+                        if(HIDDetectorMatches(enabled_detectors[enabled_idx], safe_hid_device))
                         {
-                            LOG_DEBUG("[%s] no devices found", detection_string);
-                        }
-                        prev_count = rgb_controllers_hw.size();
+                            LOG_VERBOSE("Trying to run detector for [%s] (for 0x%08hx)", enabled_detectors[enabled_idx].name.c_str(), address);
 
-                        LOG_TRACE("[%s] detection end", detection_string);
+                            enabled_detectors[enabled_idx].function(safe_hid_device, enabled_detectors[enabled_idx].name);
+                        }
                     }
                 }
 
-                current_hid_device = current_hid_device->next;
-            }
-
-            hid_free_enumeration(hid_devices);
+                hid_free_enumeration(safe_hid_devices);
+            });
         }
     }
     else
     {
-        /*-------------------------------------------------*\
-        | Iterate through all devices in list and run       |
-        | detectors                                         |
-        \*-------------------------------------------------*/
-        hid_device_count = 0;
+        /*-----------------------------------------------------------------------------*\
+        | Enumerate all HID devices once and queue a job for each detector that         |
+        | matches, looking the detectors up by VID/PID.  Devices are grouped by vendor  |
+        | ID, as detectors open sibling interfaces of composite devices and some share  |
+        | state between product IDs.                                                    |
+        \*-----------------------------------------------------------------------------*/
+        hid_devices = hid_enumerate(0, 0);
 
-        while(current_hid_device)
+        for(current_hid_device = hid_devices; current_hid_device; current_hid_device = current_hid_device->next)
         {
             if(LogManager::get()->getLoglevel() >= LL_DEBUG)
             {
@@ -1114,143 +1939,210 @@ void ResourceManager::DetectDevicesThreadFunction()
                 const char* prod_name = wchar_to_char(current_hid_device->product_string);
                 LOG_DEBUG("[%04X:%04X U=%04X P=0x%04X I=%d] %-25s - %s", current_hid_device->vendor_id, current_hid_device->product_id, current_hid_device->usage, current_hid_device->usage_page, current_hid_device->interface_number, manu_name, prod_name);
             }
-            detection_string = "";
-            DetectionProgressChanged();
-            
+
             unsigned int addr = (current_hid_device->vendor_id << 16) | current_hid_device->product_id;
 
-            /*-----------------------------------------------------------------------------*\
-            | Loop through all available detectors.  If all required information matches,   |
-            | run the detector                                                              |
-            \*-----------------------------------------------------------------------------*/
-            for(unsigned int hid_detector_idx = 0; hid_detector_idx < hid_device_detectors.size() && detection_is_required.load(); hid_detector_idx++)
-            {
-                if(( (     hid_device_detectors[hid_detector_idx].address    == addr                                 ) )
-#ifdef USE_HID_USAGE
-                && ( (     hid_device_detectors[hid_detector_idx].usage_page == HID_USAGE_PAGE_ANY                   )
-                  || (     hid_device_detectors[hid_detector_idx].usage_page == current_hid_device->usage_page       ) )
-                && ( (     hid_device_detectors[hid_detector_idx].usage      == HID_USAGE_ANY                        )
-                  || (     hid_device_detectors[hid_detector_idx].usage      == current_hid_device->usage            ) )
-                && ( (     hid_device_detectors[hid_detector_idx].interface  == HID_INTERFACE_ANY                    )
-                  || (     hid_device_detectors[hid_detector_idx].interface  == current_hid_device->interface_number ) )
-#else
-                && ( (     hid_device_detectors[hid_detector_idx].interface  == HID_INTERFACE_ANY                    )
-                  || (     hid_device_detectors[hid_detector_idx].interface  == current_hid_device->interface_number ) )
-#endif
-                )
-                {
-                    detection_string = hid_device_detectors[hid_detector_idx].name.c_str();
-
-                    /*-------------------------------------------------*\
-                    | Check if this detector is enabled or needs to be  |
-                    | added to the settings list                        |
-                    \*-------------------------------------------------*/
-                    bool this_device_enabled = true;
-                    if(detector_settings.contains("detectors") && detector_settings["detectors"].contains(detection_string))
-                    {
-                        this_device_enabled = detector_settings["detectors"][detection_string];
-                    }
+            std::string hid_device_key = GetHIDDeviceCacheKey(current_hid_device);
 
-                    LOG_DEBUG("[%s] is %s", detection_string, ((this_device_enabled == true) ? "enabled" : "disabled"));
+            HIDDeviceDetectorIndex::const_iterator index_it = hid_device_detector_index.find(addr);
 
-                    if(this_device_enabled)
-                    {
-                        DetectionProgressChanged();
+            if(index_it == hid_device_detector_index.end())
+            {
+                continue;
+            }
 
-                        hid_device_detectors[hid_detector_idx].function(current_hid_device, hid_device_detectors[hid_detector_idx].name);
+            for(unsigned int address_detector_idx = 0; address_detector_idx < index_it->second.size(); address_detector_idx++)
+            {
+                HIDDeviceDetectorBlock& hid_detector  = hid_device_detectors[index_it->second[address_detector_idx]];
+                const char*             detector_name = hid_detector.name.c_str();
 
-                        if(rgb_controllers_hw.size() != prev_count)
-                        {
-                            LOG_VERBOSE("[%s] successfully added", detection_string);
-                        }
-                        else
-                        {
-                            LOG_INFO("[%s] is not initialized", detection_string);
-                        }
-                    }
+                if(!HIDDetectorMatches(hid_detector, current_hid_device))
+                {
+                    continue;
                 }
-            }
 
-            /*-------------------------------------------------*\
-            | Update detection percent                          |
-            \*-------------------------------------------------*/
-            hid_device_count++;
+                /*-------------------------------------------------*\
+                | Check if this detector is enabled                 |
+                \*-------------------------------------------------*/
+                bool this_device_enabled = true;
+                if(detector_settings.contains("detectors") && detector_settings["detectors"].contains(detector_name))
+                {
+                    this_device_enabled = detector_settings["detectors"][detector_name];
+                }
 
-            percent = (i2c_device_detectors.size() + i2c_pci_device_detectors.size() + hid_device_count) / percent_denominator;
+                LOG_DEBUG("[%s] is %s", detector_name, ((this_device_enabled == true) ? "enabled" : "disabled"));
+
+                if(!this_device_enabled)
+                {
+                    continue;
+                }
 
-            detection_percent = percent * 100.0f;
+                hid_device_info* hid_device = current_hid_device;
 
-            /*-------------------------------------------------*\
-            | Move on to the next HID device                    |
-            \*-------------------------------------------------*/
-            current_hid_device = current_hid_device->next;
+                AddDetectionJob("HID:" + std::to_string(current_hid_device->vendor_id), detector_name, hid_device_key + "/" + detector_name, [hid_detector, hid_device](std::vector<RGBController*>&)
+                {
+                    hid_detector.function(hid_device, hid_detector.name);
+                });
+            }
         }
+    }
+
+    /*-------------------------------------------------*\
+    | Queue other detectors, each in its own group as   |
+    | they talk to separate network or serial devices   |
+    \*-------------------------------------------------*/
+    for(unsigned int detector_idx = 0; detector_idx < device_detectors.size(); detector_idx++)
+    {
+        const char* detector_name = device_detector_strings[detector_idx].c_str();
 
         /*-------------------------------------------------*\
-        | Done using the device list, free it               |
+        | Check if this detector is enabled                 |
         \*-------------------------------------------------*/
-        hid_free_enumeration(hid_devices);
+        bool this_device_enabled = true;
+        if(detector_settings.contains("detectors") && detector_settings["detectors"].contains(detector_name))
+        {
+            this_device_enabled = detector_settings["detectors"][detector_name];
+        }
+
+        LOG_DEBUG("[%s] is %s", detector_name, ((this_device_enabled == true) ? "enabled" : "disabled"));
+
+        if(!this_device_enabled)
+        {
+            continue;
+        }
+
+        AddDetectionJob(std::string("Detector:") + detector_name, detector_name, "", device_detectors[detector_idx]);
     }
 
     /*-------------------------------------------------*\
-    | Detect other devices                              |
+    | Run the jobs                                      |
     \*-------------------------------------------------*/
     LOG_INFO("------------------------------------------------------");
-    LOG_INFO("|              Detecting other devices               |");
+    LOG_INFO("|                 Detecting devices                  |");
+    if (hid_safe_mode)
+    LOG_INFO("|                with HID safe mode                  |");
     LOG_INFO("------------------------------------------------------");
 
-    for(unsigned int detector_idx = 0; detector_idx < device_detectors.size() && detection_is_required.load(); detector_idx++)
+    /*-------------------------------------------------*\
+    | On the first detection after startup, skip the    |
+    | cached jobs that found nothing last time this     |
+    | system was detected.  Rescans run everything.     |
+    \*-------------------------------------------------*/
+    bool            cache_enabled   = true;
+    unsigned int    skipped_count   = 0;
+
+    if(detector_settings.contains("detection_cache"))
     {
-        detection_string = device_detector_strings[detector_idx].c_str();
+        cache_enabled = detector_settings["detection_cache"];
+    }
 
-        /*-------------------------------------------------*\
-        | Check if this detector is enabled                 |
-        \*-------------------------------------------------*/
-        bool this_device_enabled = true;
-        if(detector_settings.contains("detectors") && detector_settings["detectors"].contains(detection_string))
+    if(cache_enabled)
+    {
+        detection_cache.Load(GetConfigurationDirectory() + "DetectionCache.json", GetDetectionFingerprint());
+
+        if(!detection_cache_used && detection_cache.GetValid())
         {
-            this_device_enabled = detector_settings["detectors"][detection_string];
+            for(unsigned int job_idx = 0; job_idx < detection_jobs.size(); job_idx++)
+            {
+                if(detection_jobs[job_idx].cache_key.empty())
+                {
+                    continue;
+                }
+
+                detection_jobs[job_idx].cached_count = detection_cache.GetControllerCount(detection_jobs[job_idx].cache_key);
+
+                if(detection_jobs[job_idx].cached_count == 0)
+                {
+                    detection_jobs[job_idx].skipped = true;
+                    skipped_count++;
+                }
+            }
         }
+    }
+
+    detection_cache_used = true;
+
+    LOG_INFO("Running %d detection jobs in %d groups on up to %d threads, %d skipped by the detection cache", (int)detection_jobs.size(), (int)detection_groups.size(), (int)thread_count, (int)skipped_count);
 
-        LOG_DEBUG("[%s] is %s", detection_string, ((this_device_enabled == true) ? "enabled" : "disabled"));
+    bool cache_mismatch = RunDetectionJobs(thread_count, size_used);
 
-        if(this_device_enabled)
+    /*-------------------------------------------------*\
+    | If the hardware no longer matches the cache, run  |
+    | the skipped jobs as well, then put the list back  |
+    | in job order                                      |
+    \*-------------------------------------------------*/
+    if(cache_mismatch && (skipped_count > 0) && detection_is_required.load())
+    {
+        LOG_INFO("Detection cache does not match the hardware, running the skipped detectors");
+
+        for(unsigned int job_idx = 0; job_idx < detection_jobs.size(); job_idx++)
         {
-            DetectionProgressChanged();
-            
-            device_detectors[detector_idx](rgb_controllers_hw);
+            if(detection_jobs[job_idx].skipped)
+            {
+                detection_jobs[job_idx].skipped = false;
+                detection_jobs[job_idx].done    = false;
+                detection_jobs[job_idx].added   = false;
+            }
         }
 
-        /*-------------------------------------------------*\
-        | If the device list size has changed, call the     |
-        | device list changed callbacks                     |
-        \*-------------------------------------------------*/
-        if(rgb_controllers_hw.size() != prev_count)
+        RunDetectionJobs(thread_count, size_used);
+
+        std::vector<RGBController*> job_controllers;
+
+        for(unsigned int job_idx = 0; job_idx < detection_jobs.size(); job_idx++)
         {
-            /*-------------------------------------------------*\
-            | First, load sizes for the new controllers         |
-            \*-------------------------------------------------*/
-            for(unsigned int controller_size_idx = prev_count; controller_size_idx < rgb_controllers_hw.size(); controller_size_idx++)
+            job_controllers.insert(job_controllers.end(), detection_jobs[job_idx].registered.begin(), detection_jobs[job_idx].registered.end());
+            job_controllers.insert(job_controllers.end(), detection_jobs[job_idx].detected.begin(), detection_jobs[job_idx].detected.end());
+        }
+
+        DeviceListChangeMutex.lock();
+
+        for(unsigned int controller_idx = 0; controller_idx < job_controllers.size(); controller_idx++)
+        {
+            std::vector<RGBController*>::iterator hw_it = std::find(rgb_controllers_hw.begin(), rgb_controllers_hw.end(), job_controllers[controller_idx]);
+
+            if(hw_it != rgb_controllers_hw.end())
             {
-                profile_manager->LoadDeviceFromListWithOptions(rgb_controllers_sizes, size_used, rgb_controllers_hw[controller_size_idx], true, false);
+                rgb_controllers_hw.erase(hw_it);
             }
-
-            UpdateDeviceList();
         }
-        else
+
+        rgb_controllers_hw.insert(rgb_controllers_hw.end(), job_controllers.begin(), job_controllers.end());
+
+        DeviceListChangeMutex.unlock();
+
+        UpdateDeviceList();
+    }
+
+    /*-------------------------------------------------*\
+    | Save what each job found, unless detection was    |
+    | stopped part way                                  |
+    \*-------------------------------------------------*/
+    if(cache_enabled && detection_is_required.load())
+    {
+        for(unsigned int job_idx = 0; job_idx < detection_jobs.size(); job_idx++)
         {
-            LOG_DEBUG("[%s] no devices found", detection_string);
+            DetectionJob& job = detection_jobs[job_idx];
+
+            if(!job.cache_key.empty())
+            {
+                detection_cache.SetControllerCount(job.cache_key, (unsigned int)(job.registered.size() + job.detected.size()));
+            }
         }
-        prev_count = rgb_controllers_hw.size();
 
-        LOG_TRACE("[%s] detection end", detection_string);
+        detection_cache.Save();
+    }
 
-        /*-------------------------------------------------*\
-        | Update detection percent                          |
-        \*-------------------------------------------------*/
-        percent = (i2c_device_detectors.size() + hid_device_count + detector_idx + 1.0f) / percent_denominator;
+    detection_jobs.clear();
+    detection_groups.clear();
+    detection_group_keys.clear();
 
-        detection_percent = percent * 100.0f;
+    /*-------------------------------------------------*\
+    | Done using the device list, free it               |
+    \*-------------------------------------------------*/
+    if(hid_devices != NULL)
+    {
+        hid_free_enumeration(hid_devices);
     }
 
     /*-------------------------------------------------*\
@@ -1312,6 +2204,7 @@ void ResourceManager::StopDeviceDetection()
 void ResourceManager::UpdateDetectorSettings()
 {
     json                detector_settings;
+    const char*         detector_name;
     bool                save_settings       = false;
     
     /*-------------------------------------------------*\
@@ -1326,11 +2219,11 @@ void ResourceManager::UpdateDetectorSettings()
     \*-------------------------------------------------*/
     for(unsigned int i2c_detector_idx = 0; i2c_detector_idx < i2c_device_detectors.size(); i2c_detector_idx++)
     {
-        detection_string = i2c_device_detector_strings[i2c_detector_idx].c_str();
+        detector_name = i2c_device_detector_strings[i2c_detector_idx].c_str();
 
-        if(!(detector_settings.contains("detectors") && detector_settings["detectors"].contains(detection_string)))
+        if(!(detector_settings.contains("detectors") && detector_settings["detectors"].contains(detector_name)))
         {
-            detector_settings["detectors"][detection_string] = true;
+            detector_settings["detectors"][detector_name] = true;
             save_settings = true;
         }
     }
@@ -1341,11 +2234,11 @@ void ResourceManager::UpdateDetectorSettings()
     \*-------------------------------------------------*/
     for(unsigned int hid_detector_idx = 0; hid_detector_idx < hid_device_detectors.size(); hid_detector_idx++)
     {
-        detection_string = hid_device_detectors[hid_detector_idx].name.c_str();
+        detector_name = hid_device_detectors[hid_detector_idx].name.c_str();
         
-        if(!(detector_settings.contains("detectors") && detector_settings["detectors"].contains(detection_string)))
+        if(!(detector_settings.contains("detectors") && detector_settings["detectors"].contains(detector_name)))
         {
-            detector_settings["detectors"][detection_string] = true;
+            detector_settings["detectors"][detector_name] = true;
             save_settings = true;
         }
     }
@@ -1356,21 +2249,21 @@ void ResourceManager::UpdateDetectorSettings()
     \*-------------------------------------------------*/
     for(unsigned int detector_idx = 0; detector_idx < device_detectors.size(); detector_idx++)
     {
-        detection_string = device_detector_strings[detector_idx].c_str();
+        detector_name = device_detector_strings[detector_idx].c_str();
 
-        if(!(detector_settings.contains("detectors") && detector_settings["detectors"].contains(detection_string)))
+        if(!(detector_settings.contains("detectors") && detector_settings["detectors"].contains(detector_name)))
         {
             /*-------------------------------------------------*\
             | Default the OpenRazer detector to disabled, as it |
             | overrides RazerController when enabled            |
             \*-------------------------------------------------*/
-            if(strcmp(detection_string, "OpenRazer") == 0 || strcmp(detection_string, "OpenRazer-Win32") == 0)
+            if(strcmp(detector_name, "OpenRazer") == 0 || strcmp(detector_name, "OpenRazer-Win32") == 0)
             {
-                detector_settings["detectors"][detection_string] = false;
+                detector_settings["detectors"][detector_name] = false;
             }
             else
             {
-                detector_settings["detectors"][detection_string] = true;
+                detector_settings["detectors"][detector_name] = true;
             }
             save_settings = true;
         }
@@ -1390,4 +2283,12 @@ void ResourceManager::WaitForDeviceDetection()
 {
     DetectDeviceMutex.lock();
     DetectDeviceMutex.unlock();
+
+    /*-------------------------------------------------*\
+    | Also wait for the controllers detection found to  |
+    | be populated                                      |
+    \*-------------------------------------------------*/
+    std::unique_lock<std::mutex> populate_lock(PopulateMutex);
+
+    PopulateCV.wait(populate_lock, [this]{ return(populate_queue.empty() && populate_active.empty()); });
 }
@@ -11,13 +11,20 @@
 
 #pragma once
 
+#include <atomic>
+#include <condition_variable>
+#include <map>
 #include <memory>
+#include <mutex>
 #include <vector>
 #include <functional>
 #include <thread>
 #include <string>
+#include <unordered_map>
 
 #include "i2c_smbus.h"
+#include "DetectionCache.h"
+#include "HotplugMonitor.h"
 #include "NetworkClient.h"
 #include "NetworkServer.h"
 #include "ProfileManager.h"
@@ -30,6 +37,13 @@
 
 #define CONTROLLER_LIST_HID 0
 
+/*---------------------------------------------------------*\
+| Default number of detection worker threads.  Detectors    |
+| mostly wait on device timeouts, so this can exceed the    |
+| number of CPU cores                                       |
+\*---------------------------------------------------------*/
+#define DETECTION_DEFAULT_THREADS   8
+
 struct hid_device_info;
 
 typedef std::function<bool()>                                                   I2CBusDetectorFunction;
@@ -50,6 +64,19 @@ typedef struct
     int                         usage;
 } HIDDeviceDetectorBlock;
 
+/*---------------------------------------------------------*\
+| HID detector indices by VID/PID address, in registration  |
+| order                                                     |
+\*---------------------------------------------------------*/
+typedef std::unordered_map<unsigned int, std::vector<unsigned int>> HIDDeviceDetectorIndex;
+
+typedef struct
+{
+    std::string                     name;
+    DeviceDetectorFunction          function;
+    unsigned int                    address;
+} SerialDeviceDetectorBlock;
+
 typedef struct
 {
     std::string                     name;
@@ -61,6 +88,29 @@ typedef struct
     uint8_t                         i2c_addr;
 } I2CPCIDeviceDetectorBlock;
 
+/*---------------------------------------------------------*\
+| One detector run on one resource.  Controllers the        |
+| detector registers or adds to its list are held here      |
+| until every earlier job has finished, so the device list  |
+| order does not depend on which thread finishes first.     |
+|                                                           |
+| Jobs with a cache key record how many controllers they    |
+| found in the detection cache.  cached_count is the number |
+| found last time, or -1 if unknown.                        |
+\*---------------------------------------------------------*/
+typedef struct
+{
+    const char*                 name;
+    DeviceDetectorFunction      function;
+    std::string                 cache_key;
+    int                         cached_count;
+    std::vector<RGBController*> registered;
+    std::vector<RGBController*> detected;
+    bool                        skipped;
+    bool                        done;
+    bool                        added;
+} DetectionJob;
+
 typedef void (*DeviceListChangeCallback)(void *);
 typedef void (*DetectionProgressCallback)(void *);
 typedef void (*DetectionStartCallback)(void *);
@@ -124,6 +174,7 @@ public:
     
     void RegisterI2CBusDetector         (I2CBusDetectorFunction     detector);
     void RegisterDeviceDetector         (std::string name, DeviceDetectorFunction     detector);
+    void RegisterSerialDeviceDetector   (std::string name, DeviceDetectorFunction     detector, uint16_t vid, uint16_t pid);
     void RegisterI2CDeviceDetector      (std::string name, I2CDeviceDetectorFunction  detector);
     void RegisterI2CPCIDeviceDetector   (std::string name, I2CPCIDeviceDetectorFunction detector, uint16_t ven_id, uint16_t dev_id, uint16_t subven_id, uint16_t subdev_id, uint8_t i2c_addr);
     void RegisterHIDDeviceDetector      (std::string name,
@@ -167,6 +218,7 @@ public:
 
     void ProcessPreDetectionHooks();
     void ProcessDynamicDetectors();
+    void ProcessHotplugEvents(std::vector<HotplugEvent>& events);
     void UpdateDeviceList();
     void DeviceListChanged();
     void DetectionProgressChanged();
@@ -184,6 +236,15 @@ public:
 
 private:
     void DetectDevicesThreadFunction();
+    void DetectionWorkerThreadFunction();
+    void AddDetectionJob(const std::string& group, const char* name, const std::string& cache_key, DeviceDetectorFunction function);
+    bool RunDetectionJobs(unsigned int thread_count, std::vector<bool>& size_used);
+    void QueuePopulate(RGBController *rgb_controller);
+    void CancelPopulate(RGBController *rgb_controller);
+    void PopulateWorkerThreadFunction();
+    std::string GetDetectionFingerprint();
+    void AddRGBController(RGBController *rgb_controller);
+    void RemoveRGBController(RGBController *rgb_controller);
     void UpdateDetectorSettings();
     void SetupConfigurationDirectory();
 
@@ -234,11 +295,13 @@ private:
     \*-------------------------------------------------------------------------------------*/
     std::vector<DeviceDetectorFunction>         device_detectors;
     std::vector<std::string>                    device_detector_strings;
+    std::vector<SerialDeviceDetectorBlock>      serial_device_detectors;
     std::vector<I2CBusDetectorFunction>         i2c_bus_detectors;
     std::vector<I2CDeviceDetectorFunction>      i2c_device_detectors;
     std::vector<std::string>                    i2c_device_detector_strings;
     std::vector<I2CPCIDeviceDetectorBlock>      i2c_pci_device_detectors;
     std::vector<HIDDeviceDetectorBlock>         hid_device_detectors;
+    HIDDeviceDetectorIndex                      hid_device_detector_index;
     std::vector<DynamicDetectorFunction>        dynamic_detectors;
     std::vector<std::string>                    dynamic_detector_strings;
     std::vector<PreDetectionHookFunction>       pre_detection_hooks;
@@ -253,7 +316,45 @@ private:
 
     std::atomic<bool>                           detection_is_required;
     std::atomic<unsigned int>                   detection_percent;
-    const char*                                 detection_string;
+    std::atomic<const char*>                    detection_string;
+
+    /*-------------------------------------------------------------------------------------*\
+    | Detection Jobs                                                                        |
+    |   Jobs in the same group share a resource (an SMBus, a HID vendor) and run in order   |
+    |   on one worker thread.  Separate groups run in parallel.                             |
+    \*-------------------------------------------------------------------------------------*/
+    std::vector<DetectionJob>                   detection_jobs;
+    std::vector<std::vector<unsigned int>>      detection_groups;
+    std::map<std::string, unsigned int>         detection_group_keys;
+    std::atomic<unsigned int>                   detection_next_group;
+    std::mutex                                  DetectionJobMutex;
+    std::condition_variable                     DetectionJobCV;
+
+    /*-------------------------------------------------------------------------------------*\
+    | Detection Cache                                                                       |
+    |   Only the first detection after startup skips jobs from the cache; a rescan runs     |
+    |   every detector and refreshes it                                                     |
+    \*-------------------------------------------------------------------------------------*/
+    DetectionCache                              detection_cache;
+    bool                                        detection_cache_used;
+
+    /*-------------------------------------------------------------------------------------*\
+    | Hotplug Monitor                                                                       |
+    \*-------------------------------------------------------------------------------------*/
+    HotplugMonitor*                             hotplug_monitor;
+
+    /*-------------------------------------------------------------------------------------*\
+    | Deferred Population                                                                   |
+    |   Controllers registered unpopulated are queued here and populated on worker threads, |
+    |   started as needed up to the default detection thread count                          |
+    \*-------------------------------------------------------------------------------------*/
+    std::vector<RGBController*>                 populate_queue;
+    std::vector<RGBController*>                 populate_active;
+    std::vector<std::thread*>                   populate_threads;
+    unsigned int                                populate_idle_threads;
+    bool                                        populate_stopping;
+    std::mutex                                  PopulateMutex;
+    std::condition_variable                     PopulateCV;
     
     /*-------------------------------------------------------------------------------------*\
     | Device List Changed Callback                                                          |
@@ -27,6 +27,8 @@ SettingsManager::~SettingsManager()
 
 json SettingsManager::GetSettings(std::string settings_key)
 {
+    std::lock_guard<std::mutex> settings_lock(SettingsMutex);
+
     /*---------------------------------------------------------*\
     | Check to see if the key exists in the settings store and  |
     | return the settings associated with the key if it exists  |
@@ -47,11 +49,15 @@ json SettingsManager::GetSettings(std::string settings_key)
 
 void SettingsManager::SetSettings(std::string settings_key, json new_settings)
 {
+    std::lock_guard<std::mutex> settings_lock(SettingsMutex);
+
     settings_data[settings_key] = new_settings;
 }
 
 void SettingsManager::LoadSettings(std::string filename)
 {
+    std::lock_guard<std::mutex> settings_lock(SettingsMutex);
+
     /*---------------------------------------------------------*\
     | Clear any stored settings before loading                  |
     \*---------------------------------------------------------*/
@@ -94,6 +100,8 @@ void SettingsManager::LoadSettings(std::string filename)
 
 void SettingsManager::SaveSettings()
 {
+    std::lock_guard<std::mutex> settings_lock(SettingsMutex);
+
     std::ofstream settings_file(settings_filename, std::ios::out | std::ios::binary);
 
     if(settings_file)
@@ -13,6 +13,8 @@
 
 #include "json.hpp"
 
+#include <mutex>
+
 using json = nlohmann::json;
 
 class SettingsManagerInterface
@@ -41,6 +43,11 @@ public:
     void    SaveSettings() override;
 
 private:
+    /*---------------------------------------------------------*\
+    | Settings are read and written from detection jobs running |
+    | in parallel, so all access goes through SettingsMutex     |
+    \*---------------------------------------------------------*/
+    std::mutex  SettingsMutex;
     json        settings_data;
     json        settings_prototype;
     std::string settings_filename;
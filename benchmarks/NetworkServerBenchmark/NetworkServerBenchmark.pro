@@ -0,0 +1,56 @@
+#-----------------------------------------------------------------------------------------------#
+# NetworkServer Benchmark QMake Project                                                         #
+#                                                                                               #
+#   Measures SDK server CPU use and thread count as the number of streaming clients grows      #
+#-----------------------------------------------------------------------------------------------#
+
+QT      -=                                                                                      \
+    core                                                                                        \
+    gui                                                                                         \
+
+CONFIG  +=  c++17                                                                               \
+            console                                                                             \
+
+CONFIG  -=  app_bundle                                                                          \
+
+TARGET      = NetworkServerBenchmark
+TEMPLATE    = app
+
+DEFINES +=                                                                                      \
+    VERSION_STRING=\\"\"\"benchmark\\"\"\"                                                      \
+    GIT_COMMIT_ID=\\"\"\"\\"\"\"                                                                \
+    GIT_COMMIT_DATE=\\"\"\"\\"\"\"                                                              \
+
+INCLUDEPATH +=                                                                                  \
+    ../..                                                                                       \
+    ../../dependencies/json                                                                     \
+    ../../i2c_smbus                                                                             \
+    ../../net_port                                                                              \
+    ../../RGBController                                                                         \
+
+HEADERS +=                                                                                      \
+    ../../LogManager.h                                                                          \
+    ../../NetworkColorDelta.h                                                                   \
+    ../../NetworkPacketReader.h                                                                 \
+    ../../NetworkPacketWriter.h                                                                 \
+    ../../NetworkPoller.h                                                                       \
+    ../../NetworkProtocol.h                                                                     \
+    ../../NetworkServer.h                                                                       \
+    ../../RGBController/RGBController.h                                                         \
+    ../../RGBController/RGBControllerDispatcher.h                                               \
+    ../../RGBController/RGBController_Dummy.h                                                   \
+
+SOURCES +=                                                                                      \
+    main.cpp                                                                                    \
+    ../../LogManager.cpp                                                                        \
+    ../../NetworkColorDelta.cpp                                                                 \
+    ../../NetworkPacketReader.cpp                                                               \
+    ../../NetworkPacketWriter.cpp                                                               \
+    ../../NetworkPoller.cpp                                                                     \
+    ../../NetworkProtocol.cpp                                                                   \
+    ../../NetworkServer.cpp                                                                     \
+    ../../RGBController/RGBController.cpp                                                       \
+    ../../RGBController/RGBControllerDispatcher.cpp                                             \
+    ../../RGBController/RGBController_Dummy.cpp                                                 \
+
+unix:LIBS += -lpthread
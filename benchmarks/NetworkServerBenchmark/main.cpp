@@ -0,0 +1,273 @@
+/*-----------------------------------------*\
+|  main.cpp                                 |
+|                                           |
+|  Benchmark for the SDK server.  Streams   |
+|  color updates from a growing number of   |
+|  clients in a child process and reports   |
+|  the server's CPU use, CPU time per       |
+|  packet and thread count for each run.    |
+\*-----------------------------------------*/
+
+#include "NetworkServer.h"
+#include "RGBController_Dummy.h"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <signal.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#define BENCHMARK_PORT          16742
+#define BENCHMARK_DEVICES       8
+#define BENCHMARK_LEDS          300
+#define BENCHMARK_FPS           60
+#define BENCHMARK_SECONDS       3
+
+static const unsigned int client_counts[] =
+{
+    1,
+    4,
+    16,
+    64,
+};
+
+static double GetProcessCPUSeconds()
+{
+    struct rusage usage;
+
+    getrusage(RUSAGE_SELF, &usage);
+
+    return((usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) + ((usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6));
+}
+
+static int GetProcessThreadCount()
+{
+    FILE *  status_file  = fopen("/proc/self/status", "r");
+    char    line[256];
+    int     thread_count = -1;
+
+    if(status_file == NULL)
+    {
+        return(-1);
+    }
+
+    while(fgets(line, sizeof(line), status_file) != NULL)
+    {
+        if(sscanf(line, "Threads: %d", &thread_count) == 1)
+        {
+            break;
+        }
+    }
+
+    fclose(status_file);
+
+    return(thread_count);
+}
+
+static unsigned long long GetFramesSubmitted(std::vector<RGBController *>& controllers)
+{
+    unsigned long long frames = 0;
+
+    for(std::size_t controller_idx = 0; controller_idx < controllers.size(); controller_idx++)
+    {
+        RGBControllerStats stats;
+
+        controllers[controller_idx]->GetStats(stats);
+
+        frames += stats.frames_submitted;
+    }
+
+    return(frames);
+}
+
+/*---------------------------------------------------------*\
+| Runs in the child process.  Connects the clients and has  |
+| each one send an UpdateLEDs packet for every device at    |
+| the target frame rate.                                    |
+\*---------------------------------------------------------*/
+static void RunClients(unsigned int client_count)
+{
+    std::vector<SOCKET> client_socks;
+
+    for(unsigned int client_idx = 0; client_idx < client_count; client_idx++)
+    {
+        SOCKET      client_sock = socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in server_addr;
+
+        memset(&server_addr, 0, sizeof(server_addr));
+
+        server_addr.sin_family      = AF_INET;
+        server_addr.sin_port        = htons(BENCHMARK_PORT);
+        server_addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+        if(connect(client_sock, (sockaddr *)&server_addr, sizeof(server_addr)) == SOCKET_ERROR)
+        {
+            printf("Error: client %u could not connect\n", client_idx);
+            _exit(1);
+        }
+
+        client_socks.push_back(client_sock);
+    }
+
+    /*-----------------------------------------------------*\
+    | Build one UpdateLEDs packet per device                |
+    \*-----------------------------------------------------*/
+    std::vector<std::vector<unsigned char>> packets(BENCHMARK_DEVICES);
+
+    for(unsigned int device_idx = 0; device_idx < BENCHMARK_DEVICES; device_idx++)
+    {
+        unsigned int    data_size   = sizeof(unsigned int) + sizeof(unsigned short) + (BENCHMARK_LEDS * sizeof(RGBColor));
+        unsigned short  num_colors  = BENCHMARK_LEDS;
+        NetPacketHeader header;
+
+        memcpy(header.pkt_magic, "ORGB", sizeof(header.pkt_magic));
+
+        header.pkt_dev_idx  = device_idx;
+        header.pkt_id       = NET_PACKET_ID_RGBCONTROLLER_UPDATELEDS;
+        header.pkt_size     = data_size;
+
+        packets[device_idx].resize(sizeof(NetPacketHeader) + data_size);
+
+        unsigned char * packet = packets[device_idx].data();
+
+        memcpy(packet, &header, sizeof(NetPacketHeader));
+        memcpy(packet + sizeof(NetPacketHeader), &data_size, sizeof(data_size));
+        memcpy(packet + sizeof(NetPacketHeader) + sizeof(data_size), &num_colors, sizeof(num_colors));
+    }
+
+    /*-----------------------------------------------------*\
+    | Give the server time to register the connections      |
+    \*-----------------------------------------------------*/
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+    std::chrono::steady_clock::time_point next_frame = std::chrono::steady_clock::now();
+    std::chrono::steady_clock::duration   frame_time = std::chrono::microseconds(1000000 / BENCHMARK_FPS);
+
+    for(unsigned int frame_idx = 0; frame_idx < (BENCHMARK_FPS * BENCHMARK_SECONDS); frame_idx++)
+    {
+        for(unsigned int client_idx = 0; client_idx < client_count; client_idx++)
+        {
+            for(unsigned int device_idx = 0; device_idx < BENCHMARK_DEVICES; device_idx++)
+            {
+                send(client_socks[client_idx], (const char *)packets[device_idx].data(), packets[device_idx].size(), MSG_NOSIGNAL);
+            }
+        }
+
+        next_frame += frame_time;
+
+        std::this_thread::sleep_until(next_frame);
+    }
+
+    for(unsigned int client_idx = 0; client_idx < client_count; client_idx++)
+    {
+        closesocket(client_socks[client_idx]);
+    }
+
+    _exit(0);
+}
+
+int main()
+{
+    std::vector<RGBController *> controllers;
+
+    for(unsigned int device_idx = 0; device_idx < BENCHMARK_DEVICES; device_idx++)
+    {
+        RGBController_Dummy * controller = new RGBController_Dummy();
+        zone                  new_zone;
+
+        controller->name        = "Benchmark Device " + std::to_string(device_idx);
+
+        new_zone.name           = "Strip";
+        new_zone.type           = ZONE_TYPE_LINEAR;
+        new_zone.leds_min       = BENCHMARK_LEDS;
+        new_zone.leds_max       = BENCHMARK_LEDS;
+        new_zone.leds_count     = BENCHMARK_LEDS;
+        new_zone.matrix_map     = NULL;
+
+        controller->zones.push_back(new_zone);
+
+        for(unsigned int led_idx = 0; led_idx < BENCHMARK_LEDS; led_idx++)
+        {
+            led new_led;
+
+            new_led.name = "LED " + std::to_string(led_idx);
+
+            controller->leds.push_back(new_led);
+        }
+
+        controller->SetupColors();
+
+        controllers.push_back(controller);
+    }
+
+    signal(SIGPIPE, SIG_IGN);
+
+    NetworkServer server(controllers);
+
+    server.SetPort(BENCHMARK_PORT);
+    server.StartServer();
+
+    while(server.GetOnline() && !server.GetListening())
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    if(!server.GetOnline())
+    {
+        return(1);
+    }
+
+    printf("%d devices, %d LEDs each, %d FPS per client, %s backend\n\n", BENCHMARK_DEVICES, BENCHMARK_LEDS, BENCHMARK_FPS, server.GetUsingEpoll() ? "epoll" : "poll");
+    printf("%8s %12s %10s %14s %8s\n", "clients", "packets/s", "CPU %", "CPU us/packet", "threads");
+
+    for(std::size_t count_idx = 0; count_idx < (sizeof(client_counts) / sizeof(client_counts[0])); count_idx++)
+    {
+        unsigned int client_count = client_counts[count_idx];
+
+        pid_t client_pid = fork();
+
+        if(client_pid == 0)
+        {
+            RunClients(client_count);
+        }
+
+        /*-------------------------------------------------*\
+        | Start measuring once every client is connected    |
+        \*-------------------------------------------------*/
+        while(server.GetNumClients() < client_count)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+
+        int threads = GetProcessThreadCount();
+
+        std::chrono::steady_clock::time_point start_time   = std::chrono::steady_clock::now();
+        double                                start_cpu    = GetProcessCPUSeconds();
+        unsigned long long                    start_frames = GetFramesSubmitted(controllers);
+
+        waitpid(client_pid, NULL, 0);
+
+        /*-------------------------------------------------*\
+        | Let the server drain what the clients sent        |
+        \*-------------------------------------------------*/
+        while(server.GetNumClients() > 0)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+
+        double             wall_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+        double             cpu_time  = GetProcessCPUSeconds() - start_cpu;
+        unsigned long long frames    = GetFramesSubmitted(controllers) - start_frames;
+
+        printf("%8u %12.0f %10.2f %14.2f %8d\n", client_count, frames / wall_time, (cpu_time * 100.0) / wall_time, (frames > 0) ? ((cpu_time * 1e6) / frames) : 0.0, threads);
+    }
+
+    server.StopServer();
+
+    return(0);
+}
@@ -0,0 +1,29 @@
+#-----------------------------------------------------------------------------------------------#
+# RGBColorConvert Benchmark QMake Project                                                       #
+#                                                                                               #
+#   Times the color conversion kernels at every SIMD level supported by the CPU                #
+#-----------------------------------------------------------------------------------------------#
+
+QT      -=                                                                                      \
+    core                                                                                        \
+    gui                                                                                         \
+
+CONFIG  +=  c++17                                                                               \
+            console                                                                             \
+
+CONFIG  -=  app_bundle                                                                          \
+
+TARGET      = RGBColorConvertBenchmark
+TEMPLATE    = app
+
+INCLUDEPATH +=                                                                                  \
+    ../../RGBController                                                                         \
+
+HEADERS +=                                                                                      \
+    ../../RGBController/RGBColorConvert.h                                                       \
+
+SOURCES +=                                                                                      \
+    main.cpp                                                                                    \
+    ../../RGBController/RGBColorConvert.cpp                                                     \
+
+unix:LIBS += -lpthread
@@ -0,0 +1,88 @@
+/*-----------------------------------------*\
+|  main.cpp                                 |
+|                                           |
+|  Benchmark for the RGBColorConvert        |
+|  kernels.  Runs each kernel on a 1000 LED |
+|  frame at every supported SIMD level and  |
+|  reports the time per frame and the CPU   |
+|  share of a 60 FPS stream.                |
+\*-----------------------------------------*/
+
+#include "RGBColorConvert.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#define BENCHMARK_LEDS          1000
+#define BENCHMARK_ITERATIONS    20000
+#define BENCHMARK_FPS           60
+
+static const char* level_names[] =
+{
+    "scalar",
+    "sse2",
+    "ssse3",
+    "avx2",
+    "neon",
+};
+
+static volatile unsigned char sink;
+
+template<typename F>
+static double TimeKernel(F kernel)
+{
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    for(unsigned int iteration = 0; iteration < BENCHMARK_ITERATIONS; iteration++)
+    {
+        kernel();
+    }
+
+    std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+
+    return(std::chrono::duration<double, std::nano>(end - start).count() / BENCHMARK_ITERATIONS);
+}
+
+static void Report(const char* kernel_name, int level, double ns_per_frame)
+{
+    double cpu_percent = (ns_per_frame * BENCHMARK_FPS) / 1e7;
+
+    printf("%-12s %-8s %10.1f ns/frame %10.5f %% CPU at %d FPS\n", kernel_name, level_names[level], ns_per_frame, cpu_percent, BENCHMARK_FPS);
+}
+
+int main()
+{
+    std::vector<RGBColor>       colors(BENCHMARK_LEDS);
+    std::vector<unsigned char>  packed(BENCHMARK_LEDS * 3);
+
+    srand(1);
+
+    for(unsigned int led_idx = 0; led_idx < BENCHMARK_LEDS; led_idx++)
+    {
+        colors[led_idx] = ToRGBColor(rand() & 0xFF, rand() & 0xFF, rand() & 0xFF);
+    }
+
+    int max_level = RGBColorGetSIMDLevel();
+
+    for(int level = RGBCOLOR_SIMD_SCALAR; level <= max_level; level++)
+    {
+        RGBColorSetSIMDLevel(level);
+
+        /*-------------------------------------------------*\
+        | Skip levels this CPU does not have                |
+        \*-------------------------------------------------*/
+        if(RGBColorGetSIMDLevel() != level)
+        {
+            continue;
+        }
+
+        Report("pack-grb", level, TimeKernel([&]()
+        {
+            RGBColorPack(&colors[0], BENCHMARK_LEDS, &packed[0], RGBCOLOR_ORDER_GRB);
+            sink = packed[0];
+        }));
+    }
+
+    return(0);
+}
@@ -0,0 +1,64 @@
+#-----------------------------------------------------------------------------------------------#
+# SDK Load Benchmark QMake Project                                                              #
+#                                                                                               #
+#   Drives an SDK server with NetworkClient connections and reports throughput, latency and     #
+#   server CPU time per frame                                                                   #
+#-----------------------------------------------------------------------------------------------#
+
+QT      -=                                                                                      \
+    core                                                                                        \
+    gui                                                                                         \
+
+CONFIG  +=  c++17                                                                               \
+            console                                                                             \
+
+CONFIG  -=  app_bundle                                                                          \
+
+TARGET      = SDKLoadBenchmark
+TEMPLATE    = app
+
+DEFINES +=                                                                                      \
+    VERSION_STRING=\\"\"\"benchmark\\"\"\"                                                      \
+    GIT_COMMIT_ID=\\"\"\"\\"\"\"                                                                \
+    GIT_COMMIT_DATE=\\"\"\"\\"\"\"                                                              \
+
+INCLUDEPATH +=                                                                                  \
+    ../..                                                                                       \
+    ../../dependencies/json                                                                     \
+    ../../i2c_smbus                                                                             \
+    ../../net_port                                                                              \
+    ../../RGBController                                                                         \
+
+HEADERS +=                                                                                      \
+    ../../LogManager.h                                                                          \
+    ../../NetworkClient.h                                                                       \
+    ../../NetworkColorDelta.h                                                                   \
+    ../../NetworkPacketReader.h                                                                 \
+    ../../NetworkPacketWriter.h                                                                 \
+    ../../NetworkPoller.h                                                                       \
+    ../../NetworkProtocol.h                                                                     \
+    ../../NetworkServer.h                                                                       \
+    ../../net_port/net_port.h                                                                   \
+    ../../RGBController/RGBController.h                                                         \
+    ../../RGBController/RGBControllerBuffer.h                                                   \
+    ../../RGBController/RGBControllerDispatcher.h                                               \
+    ../../RGBController/RGBController_Dummy.h                                                   \
+    ../../RGBController/RGBController_Network.h                                                 \
+
+SOURCES +=                                                                                      \
+    main.cpp                                                                                    \
+    ../../LogManager.cpp                                                                        \
+    ../../NetworkClient.cpp                                                                     \
+    ../../NetworkColorDelta.cpp                                                                 \
+    ../../NetworkPacketReader.cpp                                                               \
+    ../../NetworkPacketWriter.cpp                                                               \
+    ../../NetworkPoller.cpp                                                                     \
+    ../../NetworkProtocol.cpp                                                                   \
+    ../../NetworkServer.cpp                                                                     \
+    ../../net_port/net_port.cpp                                                                 \
+    ../../RGBController/RGBController.cpp                                                       \
+    ../../RGBController/RGBControllerDispatcher.cpp                                             \
+    ../../RGBController/RGBController_Dummy.cpp                                                 \
+    ../../RGBController/RGBController_Network.cpp                                               \
+
+unix:LIBS += -lpthread
@@ -0,0 +1,476 @@
+/*-----------------------------------------*\
+|  main.cpp                                 |
+|                                           |
+|  Load generator for the SDK server.       |
+|  Drives a server of Dummy devices from    |
+|  NetworkClient connections in a child     |
+|  process and reports frame throughput,    |
+|  end to end latency and server CPU time   |
+|  per frame.                               |
+\*-----------------------------------------*/
+
+#include "NetworkClient.h"
+#include "NetworkServer.h"
+#include "RGBController_Dummy.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <signal.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#define BENCHMARK_DEFAULT_PORT      16743
+
+typedef struct
+{
+    unsigned int    clients;
+    unsigned int    devices;
+    unsigned int    leds;
+    unsigned int    fps;
+    unsigned int    seconds;
+    unsigned short  port;
+    bool            udp;
+} BenchmarkConfig;
+
+/*---------------------------------------------------------*\
+| Sent by the client process over its pipe                  |
+\*---------------------------------------------------------*/
+typedef struct
+{
+    unsigned long long  frames_sent;
+    double              client_seconds;
+} BenchmarkClientResult;
+
+static std::mutex           LatencyMutex;
+static std::vector<double>  latencies_us;
+
+/*---------------------------------------------------------*\
+| Frames carry the steady clock time they were submitted at |
+| in their first two colors.  The steady clock is shared by |
+| all processes, so the server side can work out latency.   |
+\*---------------------------------------------------------*/
+static unsigned long long GetTimestamp()
+{
+    return((unsigned long long)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+static double GetProcessCPUSeconds()
+{
+    struct rusage usage;
+
+    getrusage(RUSAGE_SELF, &usage);
+
+    return((usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) + ((usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6));
+}
+
+/*---------------------------------------------------------*\
+| Dummy device that records the latency of every frame it   |
+| is asked to show                                          |
+\*---------------------------------------------------------*/
+class RGBController_Benchmark : public RGBController_Dummy
+{
+public:
+    void DeviceUpdateLEDs()
+    {
+        RecordLatency();
+    }
+
+    void UpdateZoneLEDs(int /*zone*/)
+    {
+        RecordLatency();
+    }
+
+    void UpdateSingleLED(int /*led*/)
+    {
+        RecordLatency();
+    }
+
+private:
+    void RecordLatency()
+    {
+        unsigned long long              now         = GetTimestamp();
+        const std::vector<RGBColor>&    frame       = GetFrameColors();
+
+        if(frame.size() < 2)
+        {
+            return;
+        }
+
+        unsigned long long              timestamp   = ((unsigned long long)frame[1] << 32) | frame[0];
+
+        if((timestamp == 0) || (timestamp > now))
+        {
+            return;
+        }
+
+        LatencyMutex.lock();
+        latencies_us.push_back((now - timestamp) / 1000.0);
+        LatencyMutex.unlock();
+    }
+};
+
+static void PrintUsage()
+{
+    printf("Usage: SDKLoadBenchmark [options]\n\n");
+    printf("  --clients N   SDK client connections (default 4)\n");
+    printf("  --devices N   Dummy devices on the server (default 8)\n");
+    printf("  --leds N      LEDs per device (default 300)\n");
+    printf("  --fps N       Frames per second per client, 0 for as fast as possible (default 60)\n");
+    printf("  --seconds N   Length of the run (default 5)\n");
+    printf("  --port N      Server port (default %d)\n", BENCHMARK_DEFAULT_PORT);
+    printf("  --udp         Send LED updates over the UDP channel\n");
+}
+
+static bool ParseArguments(int argc, char* argv[], BenchmarkConfig& config)
+{
+    config.clients  = 4;
+    config.devices  = 8;
+    config.leds     = 300;
+    config.fps      = 60;
+    config.seconds  = 5;
+    config.port     = BENCHMARK_DEFAULT_PORT;
+    config.udp      = false;
+
+    for(int arg_idx = 1; arg_idx < argc; arg_idx++)
+    {
+        std::string arg = argv[arg_idx];
+
+        if(arg == "--udp")
+        {
+            config.udp = true;
+            continue;
+        }
+
+        if((arg_idx + 1) >= argc)
+        {
+            return(false);
+        }
+
+        unsigned int value = (unsigned int)strtoul(argv[++arg_idx], NULL, 10);
+
+        if(arg == "--clients")
+        {
+            config.clients = value;
+        }
+        else if(arg == "--devices")
+        {
+            config.devices = value;
+        }
+        else if(arg == "--leds")
+        {
+            config.leds = value;
+        }
+        else if(arg == "--fps")
+        {
+            config.fps = value;
+        }
+        else if(arg == "--seconds")
+        {
+            config.seconds = value;
+        }
+        else if(arg == "--port")
+        {
+            config.port = (unsigned short)value;
+        }
+        else
+        {
+            return(false);
+        }
+    }
+
+    /*-----------------------------------------------------*\
+    | Two LEDs are needed for the timestamp                 |
+    \*-----------------------------------------------------*/
+    return((config.clients > 0) && (config.devices > 0) && (config.leds >= 2) && (config.seconds > 0));
+}
+
+/*---------------------------------------------------------*\
+| Runs in the child process.  Waits for the server, then    |
+| connects the clients and has each one update every device |
+| at the target frame rate.                                 |
+\*---------------------------------------------------------*/
+static void RunClients(const BenchmarkConfig& config, int ready_fd, int result_fd)
+{
+    char ready;
+
+    if(read(ready_fd, &ready, 1) != 1)
+    {
+        _exit(1);
+    }
+
+    std::vector<std::vector<RGBController *> *> client_controllers;
+    std::vector<NetworkClient *>                clients;
+
+    for(unsigned int client_idx = 0; client_idx < config.clients; client_idx++)
+    {
+        std::vector<RGBController *> * controllers = new std::vector<RGBController *>();
+        NetworkClient *                client      = new NetworkClient(*controllers);
+
+        client->SetPort(config.port);
+        client->SetName("SDK Load Benchmark");
+        client->SetUDPChannel(config.udp);
+        client->StartClient();
+
+        client_controllers.push_back(controllers);
+        clients.push_back(client);
+    }
+
+    /*-----------------------------------------------------*\
+    | Wait for every client to receive the device list      |
+    \*-----------------------------------------------------*/
+    for(unsigned int client_idx = 0; client_idx < config.clients; client_idx++)
+    {
+        while(!clients[client_idx]->GetOnline() || (clients[client_idx]->server_controllers.size() < config.devices))
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+    }
+
+    if(write(result_fd, &ready, 1) != 1)
+    {
+        _exit(1);
+    }
+
+    std::chrono::steady_clock::time_point start_time  = std::chrono::steady_clock::now();
+    std::chrono::steady_clock::time_point end_time    = start_time + std::chrono::seconds(config.seconds);
+    std::chrono::steady_clock::time_point next_frame  = start_time;
+    std::chrono::steady_clock::duration   frame_time  = std::chrono::microseconds((config.fps > 0) ? (1000000 / config.fps) : 0);
+    unsigned long long                    frames_sent = 0;
+    unsigned int                          frame_idx   = 0;
+
+    while(std::chrono::steady_clock::now() < end_time)
+    {
+        for(unsigned int client_idx = 0; client_idx < config.clients; client_idx++)
+        {
+            for(unsigned int device_idx = 0; device_idx < config.devices; device_idx++)
+            {
+                RGBController *     controller  = clients[client_idx]->server_controllers[device_idx];
+                unsigned long long  timestamp   = GetTimestamp();
+
+                /*-----------------------------------------*\
+                | Change every LED so the whole frame is    |
+                | sent, then stamp it                       |
+                \*-----------------------------------------*/
+                std::fill(controller->colors.begin(), controller->colors.end(), ToRGBColor(frame_idx & 0xFF, client_idx & 0xFF, device_idx & 0xFF));
+
+                controller->colors[0] = (RGBColor)(timestamp & 0xFFFFFFFF);
+                controller->colors[1] = (RGBColor)(timestamp >> 32);
+
+                controller->UpdateLEDs();
+
+                frames_sent++;
+            }
+        }
+
+        frame_idx++;
+
+        if(config.fps > 0)
+        {
+            next_frame += frame_time;
+
+            std::this_thread::sleep_until(next_frame);
+        }
+    }
+
+    BenchmarkClientResult result;
+
+    result.frames_sent    = frames_sent;
+    result.client_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+
+    if(write(result_fd, &result, sizeof(result)) != sizeof(result))
+    {
+        _exit(1);
+    }
+
+    for(unsigned int client_idx = 0; client_idx < config.clients; client_idx++)
+    {
+        clients[client_idx]->StopClient();
+    }
+
+    _exit(0);
+}
+
+static double GetPercentile(const std::vector<double>& sorted, double percentile)
+{
+    if(sorted.empty())
+    {
+        return(0.0);
+    }
+
+    std::size_t index = (std::size_t)(percentile * (sorted.size() - 1));
+
+    return(sorted[index]);
+}
+
+int main(int argc, char* argv[])
+{
+    BenchmarkConfig config;
+
+    if(!ParseArguments(argc, argv, config))
+    {
+        PrintUsage();
+        return(1);
+    }
+
+    /*-----------------------------------------------------*\
+    | Start the client process before any thread exists, so |
+    | it does not inherit locks or a half started           |
+    | dispatcher from the server                            |
+    \*-----------------------------------------------------*/
+    int ready_pipe[2];
+    int result_pipe[2];
+
+    if((pipe(ready_pipe) != 0) || (pipe(result_pipe) != 0))
+    {
+        return(1);
+    }
+
+    signal(SIGPIPE, SIG_IGN);
+
+    pid_t client_pid = fork();
+
+    if(client_pid == 0)
+    {
+        close(ready_pipe[1]);
+        close(result_pipe[0]);
+
+        RunClients(config, ready_pipe[0], result_pipe[1]);
+    }
+
+    close(ready_pipe[0]);
+    close(result_pipe[1]);
+
+    std::vector<RGBController *> controllers;
+
+    for(unsigned int device_idx = 0; device_idx < config.devices; device_idx++)
+    {
+        RGBController_Benchmark *   controller = new RGBController_Benchmark();
+        zone                        new_zone;
+
+        controller->name        = "Benchmark Device " + std::to_string(device_idx);
+        controller->location    = "Benchmark " + std::to_string(device_idx);
+
+        new_zone.name           = "Strip";
+        new_zone.type           = ZONE_TYPE_LINEAR;
+        new_zone.leds_min       = config.leds;
+        new_zone.leds_max       = config.leds;
+        new_zone.leds_count     = config.leds;
+        new_zone.matrix_map     = NULL;
+
+        controller->zones.push_back(new_zone);
+
+        for(unsigned int led_idx = 0; led_idx < config.leds; led_idx++)
+        {
+            led new_led;
+
+            new_led.name = "LED " + std::to_string(led_idx);
+
+            controller->leds.push_back(new_led);
+        }
+
+        controller->SetupColors();
+
+        controllers.push_back(controller);
+    }
+
+    NetworkServer server(controllers);
+
+    server.SetPort(config.port);
+    server.StartServer();
+
+    while(server.GetOnline() && !server.GetListening())
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    if(!server.GetOnline())
+    {
+        kill(client_pid, SIGKILL);
+        return(1);
+    }
+
+    /*-----------------------------------------------------*\
+    | Let the clients connect and start measuring once they |
+    | have all synced                                       |
+    \*-----------------------------------------------------*/
+    char ready = 1;
+
+    if((write(ready_pipe[1], &ready, 1) != 1) || (read(result_pipe[0], &ready, 1) != 1))
+    {
+        kill(client_pid, SIGKILL);
+        return(1);
+    }
+
+    LatencyMutex.lock();
+    latencies_us.clear();
+    LatencyMutex.unlock();
+
+    std::chrono::steady_clock::time_point start_time = std::chrono::steady_clock::now();
+    double                                start_cpu  = GetProcessCPUSeconds();
+
+    BenchmarkClientResult result;
+
+    if(read(result_pipe[0], &result, sizeof(result)) != sizeof(result))
+    {
+        kill(client_pid, SIGKILL);
+        return(1);
+    }
+
+    /*-----------------------------------------------------*\
+    | Let the server drain what the clients sent            |
+    \*-----------------------------------------------------*/
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+    double  wall_time   = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+    double  cpu_time    = GetProcessCPUSeconds() - start_cpu;
+
+    waitpid(client_pid, NULL, 0);
+
+    /*-----------------------------------------------------*\
+    | StopServer deletes the poller, so read the backend    |
+    | first                                                 |
+    \*-----------------------------------------------------*/
+    bool    using_epoll = server.GetUsingEpoll();
+
+    server.StopServer();
+
+    LatencyMutex.lock();
+    std::vector<double> sorted = latencies_us;
+    LatencyMutex.unlock();
+
+    std::sort(sorted.begin(), sorted.end());
+
+    unsigned long long frames_shown = sorted.size();
+
+    printf("%u clients, %u devices, %u LEDs each, ", config.clients, config.devices, config.leds);
+
+    if(config.fps > 0)
+    {
+        printf("%u FPS per client, ", config.fps);
+    }
+    else
+    {
+        printf("unthrottled, ");
+    }
+
+    printf("%s, %s backend\n\n", config.udp ? "UDP" : "TCP", using_epoll ? "epoll" : "poll");
+
+    printf("Frames sent             %12llu (%.0f/s)\n", result.frames_sent, result.frames_sent / result.client_seconds);
+    printf("Frames shown            %12llu (%.0f/s)\n", frames_shown, frames_shown / wall_time);
+    printf("Frames coalesced        %11.1f%%\n", (result.frames_sent > 0) ? (100.0 * (1.0 - ((double)frames_shown / result.frames_sent))) : 0.0);
+    printf("Latency p50             %12.1f us\n", GetPercentile(sorted, 0.50));
+    printf("Latency p99             %12.1f us\n", GetPercentile(sorted, 0.99));
+    printf("Latency max             %12.1f us\n", GetPercentile(sorted, 1.00));
+    printf("Server CPU              %11.1f%%\n", (cpu_time * 100.0) / wall_time);
+    printf("Server CPU per frame    %12.2f us\n", (frames_shown > 0) ? ((cpu_time * 1e6) / frames_shown) : 0.0);
+
+    return(0);
+}
@@ -383,6 +383,7 @@ void OptionHelp()
     help_text += "--server                                 Starts the SDK's server\n";
     help_text += "--server-port                            Sets the SDK's server port. Default: 6742 (1024-65535)\n";
     help_text += "-l,  --list-devices                      Lists every compatible device with their number\n";
+    help_text += "--stats                                  Prints frame rate, latency and transport time statistics for every device\n";
     help_text += "-d,  --device [0-9]                      Selects device to apply colors and/or effect to, or applies to all devices if omitted\n";
     help_text += "                                           Can be specified multiple times with different modes and colors\n";
     help_text += "-z,  --zone [0-9]                        Selects zone to apply colors and/or sizes to, or applies to all zones in device if omitted\n";
@@ -538,6 +539,59 @@ void OptionListDevices(std::vector<RGBController *> &rgb_controllers)
     }
 }
 
+void OptionStats(std::vector<RGBController *> &rgb_controllers)
+{
+    ResourceManager::get()->WaitForDeviceDetection();
+
+    std::vector<NetworkClient*>& clients = ResourceManager::get()->GetClients();
+
+    for(std::size_t controller_idx = 0; controller_idx < rgb_controllers.size(); controller_idx++)
+    {
+        RGBController *     controller  = rgb_controllers[controller_idx];
+        RGBControllerStats  stats;
+        bool                stats_valid = false;
+        bool                remote      = false;
+
+        /*---------------------------------------------------------*\
+        | Controllers from an SDK client report the server's stats  |
+        \*---------------------------------------------------------*/
+        for(std::size_t client_idx = 0; client_idx < clients.size(); client_idx++)
+        {
+            for(std::size_t server_idx = 0; server_idx < clients[client_idx]->server_controllers.size(); server_idx++)
+            {
+                if(clients[client_idx]->server_controllers[server_idx] == controller)
+                {
+                    remote      = true;
+                    stats_valid = clients[client_idx]->GetControllerStats((unsigned int)server_idx, stats);
+                }
+            }
+        }
+
+        if(!remote)
+        {
+            controller->GetStats(stats);
+            stats_valid = true;
+        }
+
+        std::cout << controller_idx << ": " << controller->name << std::endl;
+
+        if(!stats_valid)
+        {
+            std::cout << "  Statistics not supported by server" << std::endl << std::endl;
+            continue;
+        }
+
+        std::cout << "  Frame rate:     " << stats.frame_rate << " fps" << std::endl;
+        std::cout << "  Frames:         " << stats.frames_sent << " sent, "
+                                          << stats.frames_submitted << " submitted, "
+                                          << stats.frames_dropped << " dropped, "
+                                          << stats.frames_partial << " partial" << std::endl;
+        std::cout << "  Latency:        " << RGBControllerHistogramToString(stats.update_latency) << std::endl;
+        std::cout << "  Transport:      " << RGBControllerHistogramToString(stats.transport_time) << std::endl;
+        std::cout << std::endl;
+    }
+}
+
 bool OptionDevice(int *current_device, std::string argument, Options *options, std::vector<RGBController *> &rgb_controllers)
 {
     ResourceManager::get()->WaitForDeviceDetection();
@@ -739,6 +793,15 @@ int ProcessOptions(int argc, char *argv[], Options *options, std::vector<RGBCont
             exit(0);
         }
 
+        /*---------------------------------------------------------*\
+        | --stats (no arguments)                                    |
+        \*---------------------------------------------------------*/
+        else if(option == "--stats")
+        {
+            OptionStats(rgb_controllers);
+            exit(0);
+        }
+
         /*---------------------------------------------------------*\
         | -d / --device                                             |
         \*---------------------------------------------------------*/
@@ -18,6 +18,15 @@ OpenRGBDeviceInfoPage::OpenRGBDeviceInfoPage(RGBController *dev, QWidget *parent
     ui->VersionValue->setText(QString::fromStdString(dev->version));
     ui->LocationValue->setText(QString::fromStdString(dev->location));
     ui->SerialValue->setText(QString::fromStdString(dev->serial));
+
+    /*-----------------------------------------------------*\
+    | Refresh the frame timing statistics once per second   |
+    \*-----------------------------------------------------*/
+    UpdateStats();
+
+    stats_timer = new QTimer(this);
+    connect(stats_timer, SIGNAL(timeout()), this, SLOT(UpdateStats()));
+    stats_timer->start(1000);
 }
 
 OpenRGBDeviceInfoPage::~OpenRGBDeviceInfoPage()
@@ -29,3 +38,19 @@ RGBController* OpenRGBDeviceInfoPage::GetController()
 {
     return controller;
 }
+
+void OpenRGBDeviceInfoPage::UpdateStats()
+{
+    RGBControllerStats stats;
+
+    controller->GetStats(stats);
+
+    ui->FrameRateValue->setText(QString::number(stats.frame_rate, 'f', 1) + " fps");
+    ui->FramesValue->setText(QString("%1 sent, %2 submitted, %3 dropped, %4 partial")
+                             .arg(stats.frames_sent)
+                             .arg(stats.frames_submitted)
+                             .arg(stats.frames_dropped)
+                             .arg(stats.frames_partial));
+    ui->LatencyValue->setText(QString::fromStdString(RGBControllerHistogramToString(stats.update_latency)));
+    ui->TransportValue->setText(QString::fromStdString(RGBControllerHistogramToString(stats.transport_time)));
+}
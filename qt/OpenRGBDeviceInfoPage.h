@@ -2,6 +2,7 @@
 #define OPENRGBDEVICEINFOPAGE_H
 
 #include <QFrame>
+#include <QTimer>
 #include "RGBController.h"
 #include "ui_OpenRGBDeviceInfoPage.h"
 
@@ -19,9 +20,13 @@ public:
 
     RGBController* GetController();
 
+private slots:
+    void UpdateStats();
+
 private:
     RGBController*                  controller;
     Ui::OpenRGBDeviceInfoPageUi*    ui;
+    QTimer*                         stats_timer;
 };
 
 #endif // OPENRGBDEVICEINFOPAGE_H